@@ -0,0 +1,210 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+#include <render/render_graph.h>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint64 frames = 40;
+
+  TransientResourceDesc makeTarget(HeapUsage usage)
+  {
+    TransientResourceDesc desc;
+    desc.width = 1280;
+    desc.height = 720;
+    desc.usage = usage;
+    desc.size = alignUp(uint64(1280) * 720 * 4, GpuMemoryAllocator::default_placement_alignment);
+    return desc;
+  }
+
+  RenderGraph::ExecuteFunction record(uint32 command_count)
+  {
+    return [command_count](CommandList& command_list, const RenderGraph&)
+    {
+      for (uint32 i = 0; i < command_count; ++i)
+      {
+        if (command_list.getType() == CommandListType::Direct)
+        {
+          command_list.drawInstanced(3, 1, 0, 0);
+        }
+        else
+        {
+          command_list.dispatch(80, 45, 1);
+        }
+      }
+    };
+  }
+
+  // Deferred frame: SSAO, light culling and particle simulation may run on the compute queue.
+  void buildFrame(RenderGraph& graph, ResourceId back_buffer, bool async)
+  {
+    CommandListType compute = async ? CommandListType::Compute : CommandListType::Direct;
+    RenderGraphResource output = graph.importResource("Back buffer", back_buffer, ResourceState::RenderTarget, ResourceState::RenderTarget);
+    RenderGraphResource depth = graph.createResource("Depth", makeTarget(HeapUsage::RenderTargets));
+    RenderGraphResource normals = graph.createResource("Normals", makeTarget(HeapUsage::RenderTargets));
+    RenderGraphResource shadows = graph.createResource("Shadow map", makeTarget(HeapUsage::RenderTargets));
+    RenderGraphResource occlusion = graph.createResource("Occlusion", makeTarget(HeapUsage::Textures));
+    RenderGraphResource lights = graph.createResource("Light lists", makeTarget(HeapUsage::Textures));
+    RenderGraphResource particles = graph.createResource("Particles", makeTarget(HeapUsage::Textures));
+    RenderGraphResource lit = graph.createResource("Lit", makeTarget(HeapUsage::RenderTargets));
+    RenderGraphResource bloom = graph.createResource("Bloom", makeTarget(HeapUsage::RenderTargets));
+
+    particles = graph.addPass("Particle simulation", record(40)).setQueue(compute).write(particles, ResourceState::UnorderedAccess);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("G-buffer", record(60));
+      depth = pass.write(depth, ResourceState::DepthWrite);
+      normals = pass.write(normals, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("SSAO", record(50));
+      pass.setQueue(compute);
+      pass.read(depth, ResourceState::NonPixelShaderResource);
+      pass.read(normals, ResourceState::NonPixelShaderResource);
+      occlusion = pass.write(occlusion, ResourceState::UnorderedAccess);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Light culling", record(30));
+      pass.setQueue(compute);
+      pass.read(depth, ResourceState::NonPixelShaderResource);
+      lights = pass.write(lights, ResourceState::UnorderedAccess);
+    }
+    shadows = graph.addPass("Shadows", record(80)).write(shadows, ResourceState::DepthWrite);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Lighting", record(60));
+      pass.read(depth, ResourceState::PixelShaderResource);
+      pass.read(normals, ResourceState::PixelShaderResource);
+      pass.read(shadows, ResourceState::PixelShaderResource);
+      pass.read(occlusion, ResourceState::PixelShaderResource);
+      pass.read(lights, ResourceState::PixelShaderResource);
+      lit = pass.write(lit, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Particles", record(20));
+      pass.read(particles, ResourceState::NonPixelShaderResource);
+      lit = pass.write(lit, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Bloom", record(30));
+      pass.read(lit, ResourceState::PixelShaderResource);
+      bloom = pass.write(bloom, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Tonemap", record(10));
+      pass.read(lit, ResourceState::PixelShaderResource);
+      pass.read(bloom, ResourceState::PixelShaderResource);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+  }
+
+  void checkSynchronization()
+  {
+    RenderGraph graph;
+    buildFrame(graph, 1, true);
+    check("frame compiles", graph.compile());
+    const RenderGraph::Stats& stats = graph.getStats();
+    // SSAO waits for the G-buffer, lighting for light culling, which covers SSAO and the particle
+    // simulation, and the graphics queue has then already joined the compute queue.
+    check("only necessary waits remain", stats.sync_points == 2 && stats.cross_queue_dependencies > stats.sync_points);
+    check("async passes share one batch until a wait", graph.getPassBatch(1) != graph.getPassBatch(2) && graph.getPassBatch(2) == graph.getPassBatch(3));
+    check("async passes run on the compute queue", graph.getBatch(graph.getPassBatch(2)).queue == CommandListType::Compute);
+    uint32 compute_batches = 0;
+    for (uint32 batch = 0; batch < graph.getBatchCount(); ++batch)
+    {
+      compute_batches += graph.getBatch(batch).queue == CommandListType::Compute;
+      check("batches wait only for earlier batches", graph.getBatch(batch).wait_count == 0 || batch > 0);
+    }
+    check("compute work is submitted in two batches", compute_batches == 2);
+
+    // A wait for a queue that already waited for a third one covers that one too.
+    graph.reset();
+    RenderGraphResource output = graph.importResource("Back buffer", 1, ResourceState::RenderTarget, ResourceState::RenderTarget);
+    RenderGraphResource vertices = graph.createResource("Vertices", makeTarget(HeapUsage::Buffers));
+    RenderGraphResource indices = graph.createResource("Indices", makeTarget(HeapUsage::Buffers));
+    RenderGraphResource skinned = graph.createResource("Skinned", makeTarget(HeapUsage::Buffers));
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Upload", nullptr);
+      pass.setQueue(CommandListType::Copy);
+      vertices = pass.write(vertices, ResourceState::CopyDest);
+      indices = pass.write(indices, ResourceState::CopyDest);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Skinning", nullptr);
+      pass.setQueue(CommandListType::Compute);
+      pass.read(vertices, ResourceState::NonPixelShaderResource);
+      skinned = pass.write(skinned, ResourceState::UnorderedAccess);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Draw", nullptr);
+      pass.read(skinned, ResourceState::VertexAndConstantBuffer);
+      pass.read(indices, ResourceState::IndexBuffer);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+    check("three queue graph compiles", graph.compile());
+    check("transitive waits are dropped", graph.getStats().sync_points == 2);
+  }
+
+  struct FrameResult
+  {
+    double milliseconds;
+    NullDeviceResources::Stats stats;
+    RenderGraph::Stats graph;
+  };
+
+  FrameResult benchmarkFrames(const char* name, bool async)
+  {
+    NullDeviceResources::Settings settings;
+    settings.gpu_time_per_command = std::chrono::microseconds(20);
+    NullDeviceResources device_resources(settings);
+    device_resources.setFrameCount(2);
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    RenderGraph graph;
+    ResourceId next_resource = 1000;
+    auto realize = [&next_resource](const char*, const TransientResourceDesc&, ResourceState, uint64) { return next_resource++; };
+    auto frame = [&](uint64)
+    {
+      device_resources.beginFrame();
+      graph.reset();
+      buildFrame(graph, device_resources.getCurrentBackBuffer(), async);
+      graph.compile();
+      graph.realize(realize);
+      device_resources.executeRenderGraph(graph);
+      device_resources.endFrame(true, false);
+    };
+
+    // Warm up, then measure the GPU bound frame rate.
+    for (uint64 i = 0; i < 4; ++i)
+    {
+      frame(i);
+    }
+    device_resources.flush();
+    device_resources.resetStats();
+    BenchmarkResult result = runBenchmark(name, frames, frame);
+    device_resources.flush();
+
+    return FrameResult { result.seconds * 1e3 / frames, device_resources.getStats(), graph.getStats() };
+  }
+}
+
+int main()
+{
+  checkSynchronization();
+  Log::info("Async compute checks: %s\n", checks_passed ? "passed" : "failed");
+
+  Log::info("Deferred frame, 380 commands of 20 us GPU time each:\n");
+  FrameResult serial = benchmarkFrames("Graphics queue only", false);
+  FrameResult async = benchmarkFrames("SSAO, light culling and particles async", true);
+
+  for (const FrameResult* result : { &serial, &async })
+  {
+    double graphics = result->stats.queue_busy_time[getQueueIndex(CommandListType::Direct)].count() * 1e-6 / frames;
+    double compute = result->stats.queue_busy_time[getQueueIndex(CommandListType::Compute)].count() * 1e-6 / frames;
+    Log::info("    %.2f ms/frame, graphics %.2f ms, compute %.2f ms, %u batches, %u sync points for %u cross queue dependencies\n",
+      result->milliseconds, graphics, compute, result->graph.batches, result->graph.sync_points, result->graph.cross_queue_dependencies);
+  }
+  Log::info("Async speedup: %.2fx\n", serial.milliseconds / async.milliseconds);
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <common/log.h>
+#include <common/timer.h>
+
+namespace engine
+{
+  struct BenchmarkResult
+  {
+    uint64 iterations { 0 };
+    double seconds { 0.0 };
+
+    double nanosecondsPerIteration() const { return iterations ? seconds * 1e9 / iterations : 0.0; }
+    double iterationsPerSecond() const { return seconds > 0.0 ? iterations / seconds : 0.0; }
+  };
+
+  // Self-checks of a benchmark, any failed one is logged and makes main return 1.
+  inline bool checks_passed = true;
+
+  inline void check(const char* name, bool condition)
+  {
+    if (!condition)
+    {
+      Log::error("Check failed: %s\n", name);
+      checks_passed = false;
+    }
+  }
+
+  template<typename T>
+  inline void doNotOptimize(const T& value)
+  {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+  }
+
+  // Runs function(iteration) the given number of times and prints the cost per iteration.
+  template<typename Function>
+  BenchmarkResult runBenchmark(const char* name, uint64 iterations, Function&& function)
+  {
+    Timer timer;
+    for (uint64 i = 0; i < iterations; ++i)
+    {
+      function(i);
+    }
+
+    BenchmarkResult result { iterations, timer.getElapsedSeconds() };
+    Log::info("%-56s %12.1f ns/op %14.0f op/s\n", name, result.nanosecondsPerIteration(), result.iterationsPerSecond());
+
+    return result;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "benchmark.h"
+
+#include <common/binary_log.h>
+#include <common/log_checked.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  // Sustained tracing: every thread logs as fast as it can, the time includes the final flush so
+  // the rate is what the log thread keeps up with rather than what fits into the rings.
+  double traceFromThreads(uint32 thread_count, uint32 records_per_thread)
+  {
+    std::vector<std::thread> threads;
+    Timer timer;
+
+    for (uint32 t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back([=]()
+      {
+        for (uint32 i = 0; i < records_per_thread; ++i)
+        {
+          LOG_INFO("thread %u job %u: %.3f ms, %d items, queue %s\n", t, i, i * 1e-3, int32(i & 1023), "render");
+        }
+      });
+    }
+
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+    Log::flush();
+
+    return double(thread_count) * records_per_thread / timer.getElapsedSeconds();
+  }
+
+  uint64 countRecords(const std::string& path)
+  {
+    BinaryLogReader reader;
+    BinaryLogReader::Message message;
+    uint64 count = 0;
+    if (reader.open(path))
+    {
+      while (reader.next(message))
+      {
+        count++;
+      }
+    }
+    return count;
+  }
+}
+
+int main()
+{
+  const uint32 records_per_thread = 100000;
+  const std::string path = "binary_log_benchmark.blog";
+  FILE* sink = std::tmpfile();
+  if (!sink)
+  {
+    LOG_ERROR("Can't create a temporary file for the log output.\n");
+    return 1;
+  }
+
+  for (uint32 thread_count : { 1u, 2u, 4u })
+  {
+    Log::setOutput(sink, sink);
+    Log::setAsync(true);
+    double text_rate = traceFromThreads(thread_count, records_per_thread);
+
+    Log::setBinaryOutput(path);
+    double binary_rate = traceFromThreads(thread_count, records_per_thread);
+    Log::setAsync(false);
+    Log::setOutput(nullptr, nullptr);
+
+    uint64 decoded = countRecords(path);
+    LOG_INFO("%u threads: text %6.2f M records/s, binary %6.2f M records/s, %llu of %llu records decoded\n",
+      thread_count, text_rate * 1e-6, binary_rate * 1e-6, decoded, uint64(thread_count) * records_per_thread);
+  }
+
+  std::remove(path.c_str());
+  fclose(sink);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 material_count = 1000;
+  constexpr uint32 textures_per_material = 3;
+  constexpr uint32 draws_per_frame = 2000;
+  constexpr uint32 frames = 500;
+
+  struct Material
+  {
+    DescriptorAllocation views;
+    BindlessIndex indices[textures_per_material];
+  };
+
+  struct Draw
+  {
+    uint32 material;
+    uint32 index_count;
+  };
+
+  struct Result
+  {
+    double nanoseconds_per_draw;
+    double bytes_per_draw;
+    double descriptors_copied_per_frame;
+    uint64 failed_allocations;
+  };
+
+  // Records frames of draws with three textures each. Without bindless every draw stages a table
+  // of its views and binds it, with bindless it passes the indices as root constants.
+  Result recordFrames(bool bindless)
+  {
+    NullDeviceResources device_resources;
+    device_resources.setFrameCount(3);
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    DescriptorAllocator& descriptors = device_resources.getDescriptorAllocator();
+    ShaderVisibleDescriptorHeap& heap = descriptors.getResourceHeap();
+    BindlessTable& table = device_resources.getBindlessTable();
+
+    std::vector<Material> materials(material_count);
+    for (Material& material : materials)
+    {
+      material.views = descriptors.getStaging(DescriptorHeapType::CbvSrvUav).allocate(textures_per_material);
+      for (uint32 i = 0; i < textures_per_material; ++i)
+      {
+        material.indices[i] = table.add(material.views.getCpuHandle(i));
+      }
+    }
+
+    std::mt19937 random(9);
+    std::vector<Draw> draws(draws_per_frame);
+    for (Draw& draw : draws)
+    {
+      draw = { static_cast<uint32>(random() % material_count), 36 + static_cast<uint32>(random() % 3000) };
+    }
+
+    const uint32 root_textures = 0;
+    const uint32 root_table = 1;
+    CpuDescriptorHandle sources[textures_per_material];
+
+    device_resources.resetStats();
+    BenchmarkResult result = runBenchmark(bindless ? "Bindless, indices in root constants" : "Descriptor table per draw", frames, [&](uint64)
+    {
+      CommandList& command_list = device_resources.beginFrame();
+      if (bindless)
+      {
+        command_list.setGraphicsRootDescriptorTable(root_table, table.getTableStart());
+      }
+
+      for (const Draw& draw : draws)
+      {
+        const Material& material = materials[draw.material];
+        if (bindless)
+        {
+          command_list.setGraphicsRoot32BitConstants(root_textures, textures_per_material, material.indices, 0);
+        }
+        else
+        {
+          for (uint32 i = 0; i < textures_per_material; ++i)
+          {
+            sources[i] = material.views.getCpuHandle(i);
+          }
+          command_list.setGraphicsRootDescriptorTable(root_table, heap.stageTable(sources, textures_per_material).getGpuHandle());
+        }
+        command_list.drawIndexedInstanced(draw.index_count, 1, 0, 0, 0);
+      }
+
+      device_resources.endFrame(false, false);
+    });
+    device_resources.flush();
+
+    const NullDeviceResources::Stats& stats = device_resources.getStats();
+    return Result { result.nanosecondsPerIteration() / draws_per_frame, double(stats.bytes_recorded) / (double(frames) * draws_per_frame), double(stats.descriptors_copied) / frames,
+      heap.getFailedAllocations() };
+  }
+}
+
+int main()
+{
+  Log::info("%u draws per frame, %u textures each, %u materials:\n", draws_per_frame, textures_per_material, material_count);
+  Result tables = recordFrames(false);
+  Result bindless = recordFrames(true);
+
+  Log::info("%-40s %8s %12s %16s\n", "", "ns/draw", "bytes/draw", "copied/frame");
+  Log::info("%-40s %8.1f %12.1f %16.1f\n", "Descriptor table per draw", tables.nanoseconds_per_draw, tables.bytes_per_draw, tables.descriptors_copied_per_frame);
+  Log::info("%-40s %8.1f %12.1f %16.1f\n", "Bindless", bindless.nanoseconds_per_draw, bindless.bytes_per_draw, bindless.descriptors_copied_per_frame);
+
+  return tables.failed_allocations == 0 && bindless.failed_allocations == 0 ? 0 : 1;
+}
\ No newline at end of file
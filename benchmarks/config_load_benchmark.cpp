@@ -0,0 +1,146 @@
+#include "benchmark.h"
+
+#include <config.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  // Stand-in for the streaming and material settings the config is expected to grow into.
+  struct StreamingEntry
+  {
+    std::string name;
+    std::string path;
+    uint32 priority {0};
+    float lod_bias {0.0f};
+    bool resident {false};
+    std::vector<uint32> dependencies;
+  };
+
+  ENGINE_REFLECT(StreamingEntry, name, path, priority, lod_bias, resident, dependencies);
+
+  struct LargeConfig
+  {
+    Data engine;
+    std::vector<StreamingEntry> streaming;
+  };
+
+  ENGINE_REFLECT(LargeConfig, engine, streaming);
+
+  // Same schema, different in-code default.
+  struct QueueSettings
+  {
+    uint32 frame_queue_size {2};
+  };
+
+  ENGINE_REFLECT(QueueSettings, frame_queue_size);
+
+  struct ChangedQueueSettings
+  {
+    uint32 frame_queue_size {3};
+  };
+
+  ENGINE_REFLECT(ChangedQueueSettings, frame_queue_size);
+
+  void writeLargeConfig(const std::string& path, uint32 entry_count)
+  {
+    LargeConfig config;
+    config.engine.application_settings.name = "benchmark";
+    for (uint32 i = 0; i < entry_count; ++i)
+    {
+      StreamingEntry entry;
+      entry.name = "asset_" + std::to_string(i);
+      entry.path = "resources/streaming/group_" + std::to_string(i % 64) + "/asset_" + std::to_string(i) + ".bin";
+      entry.priority = i % 7;
+      entry.lod_bias = 0.25f * (i % 5);
+      entry.resident = (i % 3) == 0;
+      entry.dependencies = { i / 2, i / 3, i / 5 };
+      config.streaming.push_back(entry);
+    }
+
+    std::ofstream(path) << nlohmann::json(config).dump(2);
+    // Backdated, caches are only written for sources that have settled.
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::seconds(10));
+  }
+
+  void checkChangedDefaults(const std::string& path)
+  {
+    std::ofstream(path) << "{}";
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::seconds(10));
+    std::remove(getConfigCachePath(path).c_str());
+
+    QueueSettings settings;
+    ConfigSource first = loadConfigFile(path, settings);
+    ConfigSource second = loadConfigFile(path, settings);
+    check("defaults: cache is built and used", first == ConfigSource::Json && second == ConfigSource::Cache);
+
+    ChangedQueueSettings changed;
+    ConfigSource after_change = loadConfigFile(path, changed);
+    check("defaults: changed default invalidates the cache", after_change == ConfigSource::Json && changed.frame_queue_size == 3);
+
+    std::remove(getConfigCachePath(path).c_str());
+    std::remove(path.c_str());
+  }
+}
+
+int main()
+{
+  const std::string path = "config_load_benchmark.json";
+
+  for (uint32 entry_count : { 0u, 100u, 1000u, 10000u })
+  {
+    writeLargeConfig(path, entry_count);
+    std::remove(getConfigCachePath(path).c_str());
+
+    ConfigSourceStamp stamp;
+    getConfigSourceStamp(path, stamp);
+    uint64 iterations = entry_count >= 10000 ? 10 : entry_count >= 1000 ? 50 : 500;
+
+    LargeConfig config;
+    char name[96];
+    snprintf(name, sizeof(name), "%u entries, %llu KB: json dom", entry_count, stamp.size / 1024);
+    BenchmarkResult dom = runBenchmark(name, iterations, [&](uint64)
+    {
+      std::ifstream file_stream(path);
+      nlohmann::json json_file;
+      file_stream >> json_file;
+      config = json_file.get<LargeConfig>();
+    });
+
+    snprintf(name, sizeof(name), "%u entries: json reader", entry_count);
+    BenchmarkResult json = runBenchmark(name, iterations, [&](uint64) { loadConfigFile(path, config, false); });
+
+    // First load builds the cache.
+    ConfigSource first = loadConfigFile(path, config);
+    snprintf(name, sizeof(name), "%u entries: binary cache", entry_count);
+    BenchmarkResult cache = runBenchmark(name, iterations * 10, [&](uint64) { loadConfigFile(path, config); });
+
+    snprintf(name, sizeof(name), "%u entries: cache validation only", entry_count);
+    runBenchmark(name, iterations * 10, [&](uint64)
+    {
+      ConfigSourceStamp current;
+      MappedFile file;
+      const uint8* payload = nullptr;
+      uint64 payload_size = 0;
+      getConfigSourceStamp(path, current);
+      doNotOptimize(openConfigCache(getConfigCachePath(path), getConfigCacheHash<LargeConfig>(), current, file, payload, payload_size));
+    });
+
+    bool cached = first == ConfigSource::Json && loadConfigFile(path, config) == ConfigSource::Cache && config.streaming.size() == entry_count;
+    Log::info("  json reader %.1fx faster than dom, cache %.1fx faster than json reader%s\n", dom.nanosecondsPerIteration() / json.nanosecondsPerIteration(),
+      json.nanosecondsPerIteration() / cache.nanosecondsPerIteration(), cached ? "" : ", cache was not used");
+  }
+
+  std::remove(getConfigCachePath(path).c_str());
+  std::remove(path.c_str());
+
+  checkChangedDefaults(path);
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "benchmark.h"
+
+#include <config.h>
+#include <config_watcher.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace engine;
+
+namespace
+{
+  void writeConfig(const std::string& path, const Data& data)
+  {
+    // Written next to the config and renamed over it, the way most editors save.
+    std::string temporary_path = path + ".tmp";
+    std::ofstream(temporary_path) << nlohmann::json(data).dump(2);
+    std::rename(temporary_path.c_str(), path.c_str());
+  }
+}
+
+int main()
+{
+  const std::string path = "config_reload_benchmark.json";
+  Data data;
+  data.application_settings.name = "benchmark";
+  writeConfig(path, data);
+
+  ConfigWatcher<Data> watcher;
+  if (!watcher.start(path, data))
+  {
+    Log::error("Can't watch %s\n", path.c_str());
+    return 1;
+  }
+
+  uint32 frame_count_changes = 0;
+  uint32 other_changes = 0;
+  watcher.onChange([](const Data& config) -> const auto& { return config.render_settings.frame_count; }, [&](uint32, uint32) { frame_count_changes++; });
+  watcher.onChange([](const Data& config) -> const auto& { return config.application_settings.worker_count; }, [&](uint32, uint32) { other_changes++; });
+
+  // What every frame pays while nothing changes.
+  runBenchmark("ConfigWatcher::update, file unchanged", 1000000, [&](uint64) { doNotOptimize(watcher.update()); });
+
+  // Parse, diff and dispatch without the watcher's settle time.
+  runBenchmark("ConfigWatcher::reload, one field changed", 200, [&](uint64 i)
+  {
+    data.render_settings.frame_count = 2 + (i & 1);
+    writeConfig(path, data);
+    watcher.reload();
+  });
+
+  // From the save to the callback, with update() called at 1 kHz.
+  const uint32 edits = 5;
+  double total_latency = 0.0;
+  for (uint32 i = 0; i < edits; ++i)
+  {
+    uint32 changes_before = frame_count_changes;
+    data.render_settings.frame_count = 4 + (i & 1);
+    writeConfig(path, data);
+
+    Timer timer;
+    while (frame_count_changes == changes_before && timer.getElapsedSeconds() < 2.0)
+    {
+      watcher.update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    total_latency += timer.getElapsedSeconds();
+  }
+
+  Log::info("save to callback: %.1f ms average over %u edits, %u frame_count callbacks, %u unrelated callbacks\n",
+    total_latency * 1e3 / edits, edits, frame_count_changes, other_changes);
+
+  watcher.stop();
+  std::remove(getConfigCachePath(path).c_str());
+  std::remove(path.c_str());
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 live_count = 20000;
+  constexpr uint32 churn_operations = 1000000;
+  constexpr uint32 tables_per_frame = 1000;
+  constexpr uint32 descriptors_per_table = 8;
+
+  // Baseline for single descriptors: a stack of free indices.
+  struct FreeStack
+  {
+    std::vector<uint32> free_indices;
+    uint32 next { 0 };
+
+    uint32 allocate()
+    {
+      if (free_indices.empty())
+      {
+        return next++;
+      }
+      uint32 index = free_indices.back();
+      free_indices.pop_back();
+      return index;
+    }
+
+    void free(uint32 index) { free_indices.push_back(index); }
+  };
+
+  // Mostly single views, some small tables of views created together.
+  uint32 randomCount(std::mt19937& random)
+  {
+    uint32 roll = random() % 100;
+    if (roll < 80)
+    {
+      return 1;
+    }
+    return roll < 95 ? 2 + random() % 7 : 9 + random() % 56;
+  }
+
+  CreateDescriptorHeap makeFakeHeaps()
+  {
+    auto next_id = std::make_shared<DescriptorHeapId>(0);
+    return [next_id](const DescriptorHeapDesc& desc)
+    {
+      DescriptorHeapInfo info;
+      info.id = (*next_id)++;
+      info.cpu_start = CpuDescriptorHandle { uint64(info.id + 1) << 32 };
+      info.increment = 32;
+      info.capacity = desc.capacity;
+      return info;
+    };
+  }
+
+  void benchmarkStaging()
+  {
+    std::mt19937 random(5);
+    std::vector<uint32> counts(live_count + churn_operations);
+    std::vector<uint32> victims(churn_operations);
+    for (uint32& count : counts)
+    {
+      count = randomCount(random);
+    }
+    for (uint32& victim : victims)
+    {
+      victim = random() % live_count;
+    }
+
+    StagingDescriptorAllocator staging;
+    staging.initialize(DescriptorHeapType::CbvSrvUav, makeFakeHeaps());
+    std::vector<DescriptorAllocation> live(live_count);
+    for (uint32 i = 0; i < live_count; ++i)
+    {
+      live[i] = staging.allocate(counts[i]);
+    }
+
+    Log::info("Free and allocate one range, %u live, 1 to 64 descriptors:\n", live_count);
+    runBenchmark("StagingDescriptorAllocator", churn_operations, [&](uint64 operation)
+    {
+      DescriptorAllocation& allocation = live[victims[operation]];
+      staging.free(allocation);
+      allocation = staging.allocate(counts[live_count + operation]);
+    });
+
+    uint32 capacity = staging.getHeapCount() * StagingDescriptorAllocator::default_heap_capacity;
+    Log::info("After churn: %u heaps, %u of %u descriptors allocated (%.1f%%), %u free ranges, largest %u\n", staging.getHeapCount(), staging.getAllocatedCount(), capacity,
+      100.0 * staging.getAllocatedCount() / capacity, staging.getFreeRangeCount(), staging.getLargestFreeRange());
+
+    StagingDescriptorAllocator singles;
+    singles.initialize(DescriptorHeapType::CbvSrvUav, makeFakeHeaps());
+    FreeStack stack;
+    for (uint32 i = 0; i < live_count; ++i)
+    {
+      live[i] = singles.allocate(1);
+      stack.allocate();
+    }
+
+    Log::info("Free and allocate one descriptor, %u live:\n", live_count);
+    runBenchmark("StagingDescriptorAllocator", churn_operations, [&](uint64 operation)
+    {
+      DescriptorAllocation& allocation = live[victims[operation]];
+      singles.free(allocation);
+      allocation = singles.allocate(1);
+    });
+    runBenchmark("free index stack", churn_operations, [&](uint64 operation)
+    {
+      stack.free(victims[operation]);
+      doNotOptimize(stack.allocate());
+    });
+  }
+
+  // Records frames that each stage tables_per_frame transient tables, flushing after every
+  // table or once per frame.
+  bool benchmarkTables(bool flush_per_table)
+  {
+    NullDeviceResources device_resources;
+    device_resources.setFrameCount(3);
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    DescriptorAllocator& descriptors = device_resources.getDescriptorAllocator();
+    StagingDescriptorAllocator& staging = descriptors.getStaging(DescriptorHeapType::CbvSrvUav);
+    ShaderVisibleDescriptorHeap& heap = descriptors.getResourceHeap();
+
+    // Views of one material are created together, a table mixes three materials.
+    std::vector<DescriptorAllocation> materials(256);
+    for (DescriptorAllocation& material : materials)
+    {
+      material = staging.allocate(4);
+    }
+
+    const uint32 frames = 500;
+    std::vector<CpuDescriptorHandle> sources(descriptors_per_table);
+    runBenchmark(flush_per_table ? "Frame, one CopyDescriptors per table" : "Frame, one batched CopyDescriptors", frames, [&](uint64)
+    {
+      device_resources.beginFrame();
+      for (uint32 table = 0; table < tables_per_frame; ++table)
+      {
+        const DescriptorAllocation& first = materials[(table * 7) % materials.size()];
+        const DescriptorAllocation& second = materials[(table * 13 + 1) % materials.size()];
+        for (uint32 i = 0; i < 4; ++i)
+        {
+          sources[i] = first.getCpuHandle(i);
+          sources[4 + i] = second.getCpuHandle(i);
+        }
+        doNotOptimize(heap.stageTable(sources.data(), descriptors_per_table).gpu);
+        if (flush_per_table)
+        {
+          heap.flushCopies();
+        }
+      }
+      device_resources.endFrame(false, false);
+    });
+    device_resources.flush();
+
+    const NullDeviceResources::Stats& stats = device_resources.getStats();
+    Log::info("  %.1f CopyDescriptors calls per frame, %llu transient allocations failed\n", double(stats.descriptor_copy_calls) / frames, heap.getFailedAllocations());
+    return heap.getFailedAllocations() == 0 && stats.descriptors_copied == uint64(frames) * tables_per_frame * descriptors_per_table;
+  }
+}
+
+int main()
+{
+  benchmarkStaging();
+
+  Log::info("%u transient tables of %u descriptors per frame, 3 frames in flight:\n", tables_per_frame, descriptors_per_table);
+  bool passed = benchmarkTables(true);
+  passed = benchmarkTables(false) && passed;
+
+  return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "benchmark.h"
+
+#include <jobs/job_system.h>
+#include <memory/frame_allocator.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 frame_count = 3;
+  constexpr uint32 frames = 500;
+  constexpr uint32 draws_per_frame = 10000;
+
+  struct DrawPacket
+  {
+    uint32 mesh;
+    uint32 material;
+    float transform[10];
+  };
+
+  // Every draw is its own allocation, the way a naive draw list or culling result grows.
+  template<typename Allocate, typename Release>
+  void buildDrawList(std::vector<DrawPacket*>& draws, Allocate&& allocate, Release&& release)
+  {
+    draws.clear();
+    for (uint32 i = 0; i < draws_per_frame; ++i)
+    {
+      DrawPacket* draw = allocate();
+      draw->mesh = i;
+      draw->material = i & 63;
+      draws.push_back(draw);
+    }
+    doNotOptimize(draws.back()->mesh);
+
+    for (DrawPacket* draw : draws)
+    {
+      release(draw);
+    }
+  }
+
+  // Vectors grown without reserve, a few per frame.
+  template<typename Vector>
+  void growVectors(Vector&& make_vector)
+  {
+    for (uint32 list = 0; list < 8; ++list)
+    {
+      auto values = make_vector();
+      for (uint32 i = 0; i < draws_per_frame / 8; ++i)
+      {
+        values.push_back(i);
+      }
+      doNotOptimize(values.back());
+    }
+  }
+}
+
+int main()
+{
+  std::vector<DrawPacket*> draws;
+  draws.reserve(draws_per_frame);
+
+  Log::info("%u allocations of %zu bytes per frame:\n", draws_per_frame, sizeof(DrawPacket));
+  runBenchmark("new/delete", frames, [&](uint64)
+  {
+    buildDrawList(draws, []() { return new DrawPacket; }, [](DrawPacket* draw) { delete draw; });
+  });
+  runBenchmark("malloc/free", frames, [&](uint64)
+  {
+    buildDrawList(draws, []() { return static_cast<DrawPacket*>(std::malloc(sizeof(DrawPacket))); }, [](DrawPacket* draw) { std::free(draw); });
+  });
+
+  LinearAllocator linear_allocator;
+  runBenchmark("LinearAllocator", frames, [&](uint64)
+  {
+    linear_allocator.reset();
+    buildDrawList(draws, [&]() { return linear_allocator.create<DrawPacket>(); }, [](DrawPacket*) {});
+  });
+
+  FrameAllocator frame_allocator;
+  frame_allocator.setFrameCount(frame_count);
+  runBenchmark("FrameAllocator", frames, [&](uint64 frame)
+  {
+    frame_allocator.beginFrame(frame % frame_count);
+    buildDrawList(draws, [&]() { return frame_allocator.create<DrawPacket>(); }, [](DrawPacket*) {});
+  });
+
+  Log::info("8 vectors of %u elements grown per frame:\n", draws_per_frame / 8);
+  runBenchmark("std::vector", frames, [&](uint64)
+  {
+    growVectors([]() { return std::vector<uint32>(); });
+  });
+  runBenchmark("LinearVector", frames, [&](uint64)
+  {
+    linear_allocator.reset();
+    growVectors([&]() { return LinearVector<uint32>(ArenaAllocator<uint32, LinearAllocator>(linear_allocator)); });
+  });
+  runBenchmark("FrameVector", frames, [&](uint64 frame)
+  {
+    frame_allocator.beginFrame(frame % frame_count);
+    growVectors([&]() { return FrameVector<uint32>(ArenaAllocator<uint32, FrameAllocator>(frame_allocator)); });
+  });
+
+  JobSystem job_system;
+  job_system.initialize(JobSystem::getDefaultWorkerCount());
+  std::vector<DrawPacket*> parallel_draws(draws_per_frame);
+
+  Log::info("%u allocations per frame from %u threads:\n", draws_per_frame, job_system.getConcurrency());
+  runBenchmark("malloc/free", frames, [&](uint64)
+  {
+    job_system.parallelFor(draws_per_frame, [&](uint32 begin, uint32 end)
+    {
+      for (uint32 i = begin; i < end; ++i)
+      {
+        parallel_draws[i] = static_cast<DrawPacket*>(std::malloc(sizeof(DrawPacket)));
+        parallel_draws[i]->mesh = i;
+      }
+    });
+    for (DrawPacket* draw : parallel_draws)
+    {
+      std::free(draw);
+    }
+  });
+  runBenchmark("FrameAllocator", frames, [&](uint64 frame)
+  {
+    frame_allocator.beginFrame(frame % frame_count);
+    job_system.parallelFor(draws_per_frame, [&](uint32 begin, uint32 end)
+    {
+      for (uint32 i = begin; i < end; ++i)
+      {
+        parallel_draws[i] = frame_allocator.create<DrawPacket>();
+        parallel_draws[i]->mesh = i;
+      }
+    });
+  });
+  job_system.shutdown();
+
+  Log::info("FrameAllocator peak %zu bytes, LinearAllocator peak %zu bytes\n", frame_allocator.getPeak(), linear_allocator.getPeak());
+  return 0;
+}
\ No newline at end of file
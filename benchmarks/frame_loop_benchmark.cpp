@@ -0,0 +1,66 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+
+using namespace engine;
+
+namespace
+{
+  void recordDraws(CommandList& command_list, uint32 draw_count)
+  {
+    const Viewport viewport { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    const ScissorRect scissor { 0, 0, 1280, 720 };
+
+    command_list.setViewport(viewport);
+    command_list.setScissorRect(scissor);
+    command_list.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+
+    for (uint32 draw = 0; draw < draw_count; ++draw)
+    {
+      command_list.setGraphicsRoot32BitConstants(0, 1, &draw, 0);
+      command_list.drawIndexedInstanced(36, 1, 0, 0, 0);
+    }
+  }
+
+  void benchmarkFrames(const char* name, const NullDeviceResources::Settings& settings, uint32 draw_count, uint64 frames, uint32 frame_count = 3)
+  {
+    NullDeviceResources device_resources(settings);
+    device_resources.setFrameCount(frame_count);
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    auto result = runBenchmark(name, frames, [&](uint64)
+    {
+      CommandList& command_list = device_resources.beginFrame();
+      recordDraws(command_list, draw_count);
+      device_resources.endFrame(true, false);
+    });
+    device_resources.flush();
+
+    const auto& stats = device_resources.getStats();
+    Log::info("    %.1f commands/frame, %.1f KB/frame, %.1f M commands/s, blocked on fences %.1f%% of the time\n",
+      double(stats.commands) / stats.frames, stats.bytes_recorded / 1024.0 / stats.frames,
+      stats.commands / result.seconds * 1e-6, 100.0 * stats.fence_wait_time.count() * 1e-9 / result.seconds);
+    Log::info("    allocators grew %llu times, peak allocator size %.1f KB\n",
+      device_resources.getAllocatorGrowthCount(), device_resources.getPeakAllocatorSize() / 1024.0);
+  }
+}
+
+int main()
+{
+  NullDeviceResources::Settings idle_gpu;
+  benchmarkFrames("empty frame, idle GPU", idle_gpu, 0, 200000);
+  benchmarkFrames("1k draws, idle GPU", idle_gpu, 1000, 20000);
+  benchmarkFrames("10k draws, idle GPU", idle_gpu, 10000, 2000);
+
+  NullDeviceResources::Settings busy_gpu;
+  busy_gpu.gpu_time_per_submit = std::chrono::milliseconds(2);
+  benchmarkFrames("1k draws, 2 ms GPU frame", busy_gpu, 1000, 500);
+
+  // Latency against throughput: fewer frames in flight block the CPU on the GPU more often.
+  busy_gpu.gpu_time_per_submit = std::chrono::microseconds(500);
+  benchmarkFrames("1k draws, 0.5 ms GPU frame, 1 frame in flight", busy_gpu, 1000, 2000, 1);
+  benchmarkFrames("1k draws, 0.5 ms GPU frame, 2 frames in flight", busy_gpu, 1000, 2000, 2);
+  benchmarkFrames("1k draws, 0.5 ms GPU frame, 4 frames in flight", busy_gpu, 1000, 2000, 4);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "benchmark.h"
+
+#include <jobs/job_system.h>
+#include <render/fence_timeline.h>
+#include <render/null_device_resources.h>
+
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  // Virtual GPU queue: submissions complete after their cost, in order, starting once the GPU is free.
+  class SimulatedGpuClock
+  {
+  public:
+    void submit(uint64 value, uint64 now, uint64 cost)
+    {
+      busy_until = std::max(busy_until, now) + cost;
+      completion_times.push_back({ value, busy_until });
+    }
+
+    uint64 getCompletedValue(uint64 now) const
+    {
+      uint64 completed = 0;
+      for (const auto& completion : completion_times)
+      {
+        if (completion.time <= now)
+        {
+          completed = completion.value;
+        }
+      }
+      return completed;
+    }
+
+    uint64 getCompletionTime(uint64 value) const
+    {
+      for (const auto& completion : completion_times)
+      {
+        if (completion.value >= value)
+        {
+          return completion.time;
+        }
+      }
+      return 0;
+    }
+
+  private:
+    struct Completion
+    {
+      uint64 value;
+      uint64 time;
+    };
+
+    uint64 busy_until { 0 };
+    std::vector<Completion> completion_times;
+  };
+
+  struct SimulationResult
+  {
+    double blocked_ms_per_frame { 0.0 };
+    double reclaimed_ms_per_frame { 0.0 };
+    double frame_ms { 0.0 };
+  };
+
+  // Runs frames in virtual time. Blocking pacing mirrors the old endFrame: wait for the fence of the
+  // next back buffer. Latency pacing only waits when max_frame_latency frames are queued and spends
+  // the wait on idle work items of idle_work_ns each.
+  SimulationResult simulate(bool blocking, uint64 cpu_ns, uint64 gpu_ns, uint32 max_frame_latency, uint64 idle_work_ns)
+  {
+    constexpr uint32 frames = 1000;
+    constexpr uint32 back_buffers = 3;
+
+    SimulatedGpuClock gpu;
+    FenceTimeline timeline;
+    std::vector<uint64> frame_values(back_buffers, 0);
+
+    uint64 now = 0;
+    uint64 blocked = 0;
+    uint64 reclaimed = 0;
+
+    for (uint32 frame = 0; frame < frames; ++frame)
+    {
+      if (!blocking)
+      {
+        uint64 required = timeline.getFrameLatencyValue(max_frame_latency);
+        timeline.updateCompleted(gpu.getCompletedValue(now));
+        while (!timeline.isComplete(required))
+        {
+          uint64 remaining = gpu.getCompletionTime(required) - now;
+          if (remaining >= idle_work_ns)
+          {
+            now += idle_work_ns;
+            reclaimed += idle_work_ns;
+          }
+          else
+          {
+            now += remaining;
+            blocked += remaining;
+          }
+          timeline.updateCompleted(gpu.getCompletedValue(now));
+        }
+      }
+
+      now += cpu_ns;
+      uint64 value = timeline.signalFrame();
+      gpu.submit(value, now, gpu_ns);
+      frame_values[frame % back_buffers] = value;
+
+      if (blocking)
+      {
+        uint64 wait_value = frame_values[(frame + 1) % back_buffers];
+        uint64 completion = gpu.getCompletionTime(wait_value);
+        if (wait_value != 0 && completion > now)
+        {
+          blocked += completion - now;
+          now = completion;
+        }
+      }
+    }
+
+    return { blocked * 1e-6 / frames, reclaimed * 1e-6 / frames, now * 1e-6 / frames };
+  }
+
+  void simulatedClock()
+  {
+    struct Scenario
+    {
+      const char* name;
+      uint64 cpu_ns;
+      uint64 gpu_ns;
+    };
+
+    const Scenario scenarios[] = {
+      { "CPU bound (4 ms CPU, 2 ms GPU)", 4000000, 2000000 },
+      { "balanced (4 ms CPU, 4 ms GPU)", 4000000, 4000000 },
+      { "GPU bound (2 ms CPU, 8 ms GPU)", 2000000, 8000000 },
+    };
+
+    Log::info("Simulated GPU clock, 100 us idle work items:\n");
+    for (const Scenario& scenario : scenarios)
+    {
+      SimulationResult blocking = simulate(true, scenario.cpu_ns, scenario.gpu_ns, 2, 100000);
+      SimulationResult latency = simulate(false, scenario.cpu_ns, scenario.gpu_ns, 2, 100000);
+      Log::info("  %-34s blocking: %.2f ms/frame blocked | max latency 2: %.2f ms/frame blocked, %.2f ms/frame reclaimed, frame %.2f ms\n",
+        scenario.name, blocking.blocked_ms_per_frame, latency.blocked_ms_per_frame, latency.reclaimed_ms_per_frame, latency.frame_ms);
+    }
+  }
+
+  void nullBackend(const char* name, FramePacingMode mode)
+  {
+    constexpr uint32 frames = 100;
+
+    NullDeviceResources::Settings settings;
+    settings.gpu_time_per_submit = std::chrono::milliseconds(4);
+    NullDeviceResources device_resources(settings);
+    device_resources.setFramePacing(mode, 2);
+
+    // No workers: streaming jobs only make progress when the render thread has nothing else to do.
+    JobSystem job_system;
+    job_system.initialize(0);
+    device_resources.setIdleWork([&]() { return job_system.runPendingJob(); });
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    std::atomic<uint32> jobs_done { 0 };
+    JobCounter counter;
+    for (uint32 i = 0; i < 4000; ++i)
+    {
+      job_system.run([&jobs_done]()
+      {
+        auto end = Timer::Clock::now() + std::chrono::microseconds(100);
+        while (Timer::Clock::now() < end)
+        {
+        }
+        jobs_done++;
+      }, &counter);
+    }
+
+    Timer timer;
+    for (uint32 frame = 0; frame < frames; ++frame)
+    {
+      device_resources.beginFrame();
+      auto end = Timer::Clock::now() + std::chrono::milliseconds(1);
+      while (Timer::Clock::now() < end)
+      {
+      }
+      device_resources.endFrame(false, false);
+    }
+    double seconds = timer.getElapsedSeconds();
+    uint32 jobs_in_frames = jobs_done.load();
+
+    device_resources.flush();
+    job_system.wait(counter);
+    job_system.shutdown();
+
+    const auto& stats = device_resources.getFramePacingStats();
+    Log::info("  %-34s %.2f ms/frame, blocked %.2f ms/frame, reclaimed %.2f ms/frame (%u streaming jobs done)\n",
+      name, seconds * 1e3 / frames, stats.blocked_time.count() * 1e-6 / frames, stats.idle_work_time.count() * 1e-6 / frames, jobs_in_frames);
+  }
+}
+
+int main()
+{
+  simulatedClock();
+
+  Log::info("Null backend, 1 ms CPU frame, 4 ms GPU frame:\n");
+  nullBackend("blocking", FramePacingMode::Blocking);
+  nullBackend("max latency", FramePacingMode::MaxLatency);
+  nullBackend("waitable object", FramePacingMode::WaitableObject);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "benchmark.h"
+
+#include <frame_pipeline.h>
+#include <render/null_device_resources.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+
+using namespace engine;
+
+namespace
+{
+  constexpr double run_seconds = 1.0;
+
+  // Stands in for the OS message pump: a resize message every 10 ms while the window is dragged,
+  // and a 100 ms modal loop in the middle of the run during which no other message is dispatched.
+  class FakeEventSource
+  {
+  public:
+    explicit FakeEventSource(std::function<void(uint32, uint32)> on_resize)
+      : on_resize(std::move(on_resize))
+    {
+    }
+
+    bool pump()
+    {
+      const double now = timer.getElapsedSeconds();
+      if (now >= run_seconds)
+      {
+        return false;
+      }
+
+      if (!modal_loop_done && now >= run_seconds * 0.5)
+      {
+        modal_loop_done = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return true;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      size = (size % 64) + 1;
+      on_resize(640 + size, 480 + size);
+      resize_events++;
+
+      return true;
+    }
+
+    uint32 resize_events { 0 };
+
+  private:
+    std::function<void(uint32, uint32)> on_resize;
+    Timer timer;
+    uint32 size { 0 };
+    bool modal_loop_done { false };
+  };
+
+  void simulate()
+  {
+    // About half a millisecond of game logic.
+    auto end = Timer::Clock::now() + std::chrono::microseconds(500);
+    while (Timer::Clock::now() < end)
+    {
+    }
+  }
+
+  struct FrameGaps
+  {
+    uint64 last_frame { 0 };
+    uint64 max_gap { 0 };
+
+    void frame()
+    {
+      uint64 now = Timer::nowNanoseconds();
+      if (last_frame != 0)
+      {
+        max_gap = std::max(max_gap, now - last_frame);
+      }
+      last_frame = now;
+    }
+  };
+
+  NullDeviceResources::Settings gpuSettings()
+  {
+    NullDeviceResources::Settings settings;
+    settings.gpu_time_per_submit = std::chrono::milliseconds(1);
+    return settings;
+  }
+
+  void runSerial()
+  {
+    NullDeviceResources device_resources(gpuSettings());
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 640, 480, false });
+
+    FrameGaps gaps;
+    uint64 frames = 0;
+    FakeEventSource events([&](uint32 width, uint32 height) { device_resources.resize(width, height); });
+
+    // Today's loop: pumping, updating and rendering all happen on one thread.
+    while (events.pump())
+    {
+      simulate();
+      device_resources.render(false, false);
+      gaps.frame();
+      frames++;
+    }
+    device_resources.flush();
+
+    Log::info("serial:    %llu frames, %u resizes, longest frame gap %.1f ms\n", frames, events.resize_events, gaps.max_gap * 1e-6);
+  }
+
+  void runThreaded(uint32 frame_queue_size)
+  {
+    NullDeviceResources device_resources(gpuSettings());
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 640, 480, false });
+
+    FrameGaps gaps;
+    uint32 resizes = 0;
+
+    FramePipeline::Callbacks callbacks;
+    callbacks.simulate = [](FramePacket&) { simulate(); };
+    callbacks.render = [&](const FramePacket&)
+    {
+      device_resources.render(false, false);
+      gaps.frame();
+    };
+    callbacks.resize = [&](uint32 width, uint32 height)
+    {
+      device_resources.resize(width, height);
+      resizes++;
+    };
+
+    FramePipeline pipeline(frame_queue_size, callbacks);
+    FakeEventSource events([&](uint32 width, uint32 height) { pipeline.requestResize(width, height); });
+    pipeline.run([&]() { return events.pump(); });
+    device_resources.flush();
+
+    Log::info("threaded (queue %u): %llu frames, %u resize events coalesced into %u resizes, longest frame gap %.1f ms\n",
+      frame_queue_size, pipeline.getRenderedFrames(), events.resize_events, resizes, gaps.max_gap * 1e-6);
+  }
+
+  // The pump blocks like GetMessage, only wake_pump lets it see that a render callback threw.
+  void checkFailureWakesPump()
+  {
+    std::mutex mutex;
+    std::condition_variable woken;
+    bool wake = false;
+
+    FramePipeline::Callbacks callbacks;
+    callbacks.simulate = [](FramePacket&) {};
+    callbacks.render = [](const FramePacket& packet)
+    {
+      if (packet.frame_number == 10)
+      {
+        throw std::runtime_error("render failed");
+      }
+    };
+    callbacks.resize = [](uint32, uint32) {};
+    callbacks.wake_pump = [&]()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      wake = true;
+      woken.notify_one();
+    };
+
+    bool rethrown = false;
+    bool timed_out = false;
+    FramePipeline pipeline(2, callbacks);
+    try
+    {
+      pipeline.run([&]()
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        timed_out = !woken.wait_for(lock, std::chrono::seconds(5), [&]() { return wake; });
+        wake = false;
+        return !timed_out;
+      });
+    }
+    catch (const std::runtime_error&)
+    {
+      rethrown = true;
+    }
+
+    check("failure: blocked pump is woken", !timed_out);
+    check("failure: exception is rethrown by run", rethrown);
+  }
+}
+
+int main()
+{
+  runSerial();
+  runThreaded(1);
+  runThreaded(2);
+  runThreaded(3);
+  checkFailureWakesPump();
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "benchmark.h"
+
+#include <render/frame_capture.h>
+#include <render/null_device_resources.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 object_count = 2000;
+
+  struct alignas(16) ObjectConstants
+  {
+    float transform[16];
+  };
+
+  // Uploads, state changes and indexed draws of object_count objects, then a compute pass on the
+  // async queue the frame's last pass waits for.
+  void recordFrame(DeviceResources& device_resources, CommandList& command_list, RenderGraph& graph)
+  {
+    const Viewport viewport { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    const ScissorRect scissor { 0, 0, 1280, 720 };
+    const CpuDescriptorHandle back_buffer_view = device_resources.getCurrentBackBufferView();
+    const VertexBufferView vertex_buffers[] = { { 0x200000000ull, 65536, 32 }, { 0x200010000ull, 65536, 16 } };
+
+    UploadAllocation staging = device_resources.getUploadRing().allocate(65536);
+    ResourceBarrier barrier = ResourceBarrier::transition(1000, ResourceState::GenericRead, ResourceState::CopyDest);
+    command_list.resourceBarrier(&barrier, 1);
+    command_list.copyBufferRegion(1000, 0, staging.resource, staging.offset, 65536);
+    barrier = ResourceBarrier::transition(1000, ResourceState::CopyDest, ResourceState::GenericRead);
+    command_list.resourceBarrier(&barrier, 1);
+
+    command_list.setRenderTargets(&back_buffer_view, 1, nullptr);
+    command_list.setViewport(viewport);
+    command_list.setScissorRect(scissor);
+    command_list.setGraphicsRootSignature(1);
+    command_list.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+    command_list.setVertexBuffers(0, vertex_buffers, 2);
+    command_list.setIndexBuffer(IndexBufferView { 0x200020000ull, 65536, false });
+    for (uint32 object = 0; object < object_count; ++object)
+    {
+      if (object % 100 == 0)
+      {
+        command_list.setPipelineState(object / 100);
+        command_list.setGraphicsRootDescriptorTable(2, GpuDescriptorHandle { 0x100000000ull + object * 32 });
+      }
+
+      ObjectConstants constants {};
+      constants.transform[0] = constants.transform[5] = constants.transform[10] = constants.transform[15] = 1.0f;
+      command_list.setGraphicsRootConstantBufferView(1, device_resources.getUploadRing().upload(constants).gpu_address);
+      command_list.setGraphicsRoot32BitConstants(0, 1, &object, 0);
+      command_list.drawIndexedInstanced(36, 1, 0, 0, 0);
+    }
+
+    graph.reset();
+    RenderGraphResource output = graph.importResource("Back buffer", device_resources.getCurrentBackBuffer(), ResourceState::RenderTarget, ResourceState::RenderTarget);
+    RenderGraphResource histogram = graph.createResource("Histogram", TransientResourceDesc { 256, 1, 1, 1, 0, 1, HeapUsage::Buffers, 65536 });
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Histogram", [](CommandList& list, const RenderGraph&) { list.dispatch(16, 9, 1); });
+      pass.setQueue(CommandListType::Compute);
+      histogram = pass.write(histogram, ResourceState::UnorderedAccess);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Exposure", [](CommandList& list, const RenderGraph&) { list.drawInstanced(3, 1, 0, 0); });
+      pass.read(histogram, ResourceState::PixelShaderResource);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+    graph.compile();
+    graph.realize([](const char*, const TransientResourceDesc&, ResourceState, uint64) { return ResourceId(2000); });
+    device_resources.executeRenderGraph(graph);
+  }
+
+  // Records the frame anew every iteration, what replay is compared against.
+  void recordFrame(DeviceResources& device_resources, RenderGraph& graph)
+  {
+    CommandList& command_list = device_resources.beginFrame();
+    recordFrame(device_resources, command_list, graph);
+    device_resources.endFrame(false, false);
+  }
+
+  void checkCapture(const FrameCapture& capture, uint32 recorded_commands)
+  {
+    const FrameCaptureHeader& header = capture.getHeader();
+    check("every recorded command is captured", header.command_count == recorded_commands);
+    check("captured frame has queue synchronization", header.event_count > header.command_list_count);
+
+    const char* path = "frame_replay_benchmark.capture";
+    FrameCapture loaded;
+    check("capture saves and loads", capture.save(path) && loaded.load(path));
+    check("loaded capture matches", loaded.getSize() == capture.getSize() && std::memcmp(loaded.getData(), capture.getData(), capture.getSize()) == 0);
+    std::remove(path);
+
+    std::vector<uint8> damaged(capture.getData(), capture.getData() + capture.getSize());
+    check("truncated capture is rejected", !loaded.load(damaged.data(), damaged.size() - 8));
+    damaged[0] = 'X';
+    check("foreign data is rejected", !loaded.load(damaged.data(), damaged.size()));
+
+    // The frame starts with a submit whose first packet is the back buffer barrier.
+    const uint64 event_offset = sizeof(FrameCaptureHeader);
+    const uint64 packet_offset = event_offset + sizeof(FrameCapture::Event) + sizeof(uint64);
+    auto damage = [&](uint64 offset, const void* value, uint64 size)
+    {
+      damaged.assign(capture.getData(), capture.getData() + capture.getSize());
+      std::memcpy(damaged.data() + offset, value, size);
+      return !loaded.load(damaged.data(), damaged.size());
+    };
+    const uint8 bad_queue = 7;
+    const uint16 bad_type = 999;
+    const uint16 bad_count = 50;
+    check("unknown queue is rejected", damage(event_offset + offsetof(FrameCapture::Event, queue), &bad_queue, sizeof(bad_queue)));
+    check("unknown signaled queue is rejected", damage(event_offset + offsetof(FrameCapture::Event, signaled_queue), &bad_queue, sizeof(bad_queue)));
+    check("unknown command is rejected", damage(packet_offset + offsetof(CommandHeader, type), &bad_type, sizeof(bad_type)));
+    check("packet shorter than its elements is rejected", damage(packet_offset + offsetof(CommandHeader, count), &bad_count, sizeof(bad_count)));
+
+    // Replaying into a recorder gives back the captured packets, with the back buffer swapped.
+    // Upload ring addresses move to where replay uploaded the captured bytes.
+    CommandReplayer replayer;
+    replayer.setBackBuffer(header.back_buffer, header.back_buffer_view, 7, CpuDescriptorHandle { 8 });
+    UploadRemap upload_remap = capture.getUploadRemap();
+    upload_remap.replayed.gpu_address = 0x900000000ull;
+    upload_remap.replayed.resource = 9;
+    upload_remap.replayed.offset = 0x10000;
+    replayer.setUploadRemap(upload_remap);
+    check("frame's uploads are captured", header.upload_size >= object_count * sizeof(ObjectConstants));
+    CommandStream stream;
+    NullCommandList recorder(CommandListType::Direct);
+    FrameCapture::Reader reader(capture);
+    FrameCapture::Event event;
+    bool identical = true;
+    bool remapped = false;
+    bool constants_remapped = true;
+    bool copy_remapped = false;
+    while (reader.next(event))
+    {
+      for (uint32 i = 0; event.type == FrameCapture::EventType::Submit && i < event.list_count; ++i)
+      {
+        const uint8* data;
+        uint64 size;
+        if (!reader.nextCommandList(data, size))
+        {
+          identical = false;
+          break;
+        }
+        recorder.reset(&stream);
+        replayer.replay(data, size, recorder);
+        recorder.close();
+        identical &= stream.getSize() == size;
+
+        CommandStreamReader replayed(stream.getData(), stream.getSize());
+        CommandHeader command;
+        const uint8* payload;
+        while (replayed.next(command, payload))
+        {
+          if (command.type == CommandType::ClearRenderTargetView)
+          {
+            remapped = CommandStreamReader::read<ClearRenderTargetViewCommand>(payload).rtv.ptr == 8;
+          }
+          else if (command.type == CommandType::SetGraphicsRootConstantBufferView)
+          {
+            // The captured bytes at the replayed address hold the object's transform.
+            uint64 offset = CommandStreamReader::read<SetGraphicsRootConstantBufferViewCommand>(payload).address - upload_remap.replayed.gpu_address;
+            float scale = 0.0f;
+            if (offset + sizeof(ObjectConstants) <= header.upload_size)
+            {
+              std::memcpy(&scale, capture.getUploadData() + offset, sizeof(scale));
+            }
+            constants_remapped &= scale == 1.0f;
+          }
+          else if (command.type == CommandType::CopyBufferRegion)
+          {
+            auto copy = CommandStreamReader::read<CopyBufferRegionCommand>(payload);
+            copy_remapped = copy.src == 9 && copy.src_offset >= 0x10000 && copy.src_offset + copy.size <= 0x10000 + header.upload_size;
+          }
+        }
+      }
+    }
+    check("replayed streams match the capture", identical);
+    check("back buffer is remapped", remapped);
+    check("constant buffer addresses are remapped to the replayed uploads", constants_remapped);
+    check("copies from the upload ring are remapped", copy_remapped);
+  }
+}
+
+int main()
+{
+  NullDeviceResources device_resources;
+  device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+  RenderGraph graph;
+
+  for (uint32 i = 0; i < 4; ++i)
+  {
+    recordFrame(device_resources, graph);
+  }
+  device_resources.resetStats();
+  recordFrame(device_resources, graph);
+  const uint64 recorded_commands = device_resources.getStats().commands;
+  const uint64 recorded_bytes = device_resources.getStats().bytes_recorded;
+
+  FrameCapture capture;
+  device_resources.captureNextFrame(capture);
+  device_resources.resetStats();
+  recordFrame(device_resources, graph);
+  check("captured frame submits what it records", device_resources.getStats().commands == recorded_commands);
+  const uint64 captured_submits = device_resources.getStats().submits;
+  checkCapture(capture, static_cast<uint32>(recorded_commands));
+
+  device_resources.resetStats();
+  device_resources.replayFrame(capture, false, false);
+  const NullDeviceResources::Stats& replay_stats = device_resources.getStats();
+  check("replay submits the captured commands", replay_stats.commands == recorded_commands && replay_stats.bytes_recorded == recorded_bytes);
+  check("replay keeps the submissions", replay_stats.submits == captured_submits && replay_stats.queue_waits > 0);
+  device_resources.flush();
+  Log::info("Frame replay checks: %s\n", checks_passed ? "passed" : "failed");
+
+  Log::info("Frame of %u commands, %.1f KB captured:\n", capture.getHeader().command_count, capture.getSize() / 1024.0);
+  const uint64 frames = 2000;
+  BenchmarkResult recorded = runBenchmark("record and submit", frames, [&](uint64) { recordFrame(device_resources, graph); });
+  BenchmarkResult captured = runBenchmark("record, capture and submit", frames, [&](uint64)
+  {
+    device_resources.captureNextFrame(capture);
+    recordFrame(device_resources, graph);
+  });
+  device_resources.resetStats();
+  BenchmarkResult replayed = runBenchmark("replay", frames, [&](uint64) { device_resources.replayFrame(capture, false, false); });
+  device_resources.flush();
+  Log::info("    replay submits %.1f M commands/s, %.2fx the cost of recording the frame live\n",
+    device_resources.getStats().commands / replayed.seconds * 1e-6, replayed.nanosecondsPerIteration() / recorded.nanosecondsPerIteration());
+  Log::info("    capturing costs %.1f us/frame\n", (captured.nanosecondsPerIteration() - recorded.nanosecondsPerIteration()) * 1e-3);
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
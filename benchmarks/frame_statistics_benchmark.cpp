@@ -0,0 +1,72 @@
+#include "benchmark.h"
+
+#include <profiler/frame_statistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  // Steadily rising or falling frame times keep every entry of the rolling extremes alive.
+  void checkMonotonicFrames()
+  {
+    const uint32 frame_count = 3000;
+    const uint32 first = frame_count - FrameStatistics::window_size;
+    FrameStatistics rising;
+    FrameStatistics falling;
+    for (uint32 frame = 0; frame < frame_count; ++frame)
+    {
+      rising.addFrame((10.0 + frame * 0.001) * 1e-3);
+      falling.addFrame((21.0 - frame * 0.001) * 1e-3);
+    }
+
+    auto near = [](double value, double milliseconds) { return std::abs(value - milliseconds) < 1e-4; };
+    check("rolling minimum of rising frame times", near(rising.getMin(), 10.0 + first * 0.001));
+    check("rolling maximum of rising frame times", near(rising.getMax(), 10.0 + (frame_count - 1) * 0.001));
+    check("rolling maximum of falling frame times", near(falling.getMax(), 21.0 - first * 0.001));
+    check("rolling minimum of falling frame times", near(falling.getMin(), 21.0 - (frame_count - 1) * 0.001));
+  }
+}
+
+int main()
+{
+  checkMonotonicFrames();
+
+  // 60 Hz frames with jitter and a 50 ms stutter every 500 frames.
+  const uint32 frame_count = 1 << 20;
+  std::mt19937 random(42);
+  std::normal_distribution<double> jitter(16.6e-3, 0.8e-3);
+  std::vector<double> frame_times(frame_count);
+  for (uint32 frame = 0; frame < frame_count; ++frame)
+  {
+    frame_times[frame] = frame % 500 == 499 ? 50e-3 : std::max(1e-3, jitter(random));
+  }
+
+  FrameStatistics statistics;
+  runBenchmark("FrameStatistics::addFrame", frame_count, [&](uint64 frame)
+  {
+    statistics.addFrame(frame_times[frame]);
+  });
+
+  FrameTimeSummary summary;
+  runBenchmark("FrameStatistics::getSummary", 100000, [&](uint64)
+  {
+    summary = statistics.getSummary();
+    doNotOptimize(summary);
+  });
+  statistics.logSummary();
+
+  // Exact percentiles of the same window for comparison with the histogram.
+  std::vector<double> window(frame_times.end() - FrameStatistics::window_size, frame_times.end());
+  std::sort(window.begin(), window.end());
+  auto exact = [&](double fraction) { return window[std::max<size_t>(1, size_t(std::ceil(fraction * window.size()))) - 1] * 1e3; };
+  Log::info("    exact ms: min %.2f p50 %.2f p95 %.2f p99 %.2f max %.2f, expected ~%u hitches\n",
+    window.front() * 1e3, exact(0.5), exact(0.95), exact(0.99), window.back() * 1e3, frame_count / 500);
+  check("rolling extremes match the window", std::abs(statistics.getMin() - window.front() * 1e3) < 1e-4 && std::abs(statistics.getMax() - window.back() * 1e3) < 1e-4);
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
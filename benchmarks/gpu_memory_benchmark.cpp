@@ -0,0 +1,326 @@
+#include "benchmark.h"
+
+#include <memory/tlsf_allocator.h>
+#include <render/gpu_memory_allocator.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint64 heap_capacity = 256 * 1024 * 1024;
+  constexpr uint64 granularity = 256;
+  // Address space only, large enough that the churn never runs out.
+  constexpr uint64 churn_capacity = 64ull * 1024 * 1024 * 1024;
+
+  // The usual best fit: free ranges by size for the search and by offset for merging.
+  class MapAllocator
+  {
+  public:
+    explicit MapAllocator(uint64 capacity)
+    {
+      insert(0, capacity);
+    }
+
+    uint64 allocate(uint64 size)
+    {
+      auto fit = by_size.lower_bound(size);
+      if (fit == by_size.end())
+      {
+        return ~0ull;
+      }
+
+      uint64 offset = fit->second;
+      uint64 free_size = fit->first;
+      by_size.erase(fit);
+      by_offset.erase(offset);
+      if (free_size > size)
+      {
+        insert(offset + size, free_size - size);
+      }
+      return offset;
+    }
+
+    void free(uint64 offset, uint64 size)
+    {
+      auto next = by_offset.lower_bound(offset);
+      if (next != by_offset.end() && offset + size == next->first)
+      {
+        size += next->second;
+        erase(next);
+      }
+
+      auto previous = by_offset.lower_bound(offset);
+      if (previous != by_offset.begin())
+      {
+        --previous;
+        if (previous->first + previous->second == offset)
+        {
+          offset = previous->first;
+          size += previous->second;
+          erase(previous);
+        }
+      }
+
+      insert(offset, size);
+    }
+
+  private:
+    void insert(uint64 offset, uint64 size)
+    {
+      by_offset.emplace(offset, size);
+      by_size.emplace(size, offset);
+    }
+
+    void erase(std::map<uint64, uint64>::iterator range)
+    {
+      auto sizes = by_size.equal_range(range->second);
+      for (auto it = sizes.first; it != sizes.second; ++it)
+      {
+        if (it->second == range->first)
+        {
+          by_size.erase(it);
+          break;
+        }
+      }
+      by_offset.erase(range);
+    }
+
+  private:
+    std::multimap<uint64, uint64> by_size;
+    std::map<uint64, uint64> by_offset;
+  };
+
+  struct LiveBlock
+  {
+    uint64 offset;
+    uint64 size;
+    uint32 block;
+  };
+
+  // Mostly small buffers with the odd large texture.
+  uint64 randomSize(std::mt19937& random)
+  {
+    uint32 roll = random() % 100;
+    if (roll < 70)
+    {
+      return 256 + random() % (64 * 1024);
+    }
+    if (roll < 95)
+    {
+      return 64 * 1024 + random() % (1024 * 1024);
+    }
+    return 1024 * 1024 + random() % (8 * 1024 * 1024);
+  }
+
+  bool fuzzTlsf(uint32 operations)
+  {
+    std::mt19937 random(7);
+    TlsfAllocator allocator(heap_capacity, granularity);
+    std::vector<LiveBlock> live;
+
+    for (uint32 operation = 0; operation < operations; ++operation)
+    {
+      if (!live.empty() && (random() % 100 < 45 || live.size() > 2000))
+      {
+        uint32 index = random() % live.size();
+        allocator.free(live[index].block);
+        live[index] = live.back();
+        live.pop_back();
+      }
+      else
+      {
+        uint64 size = randomSize(random);
+        uint64 alignment = uint64(1) << (random() % 23);
+        TlsfAllocator::Allocation allocation = allocator.allocate(size, alignment);
+        if (allocation.isValid())
+        {
+          if (allocation.offset % alignment != 0 || allocator.getSize(allocation.block) < size)
+          {
+            Log::error("Misplaced allocation of %llu bytes at %llu.\n", size, allocation.offset);
+            return false;
+          }
+          live.push_back({ allocation.offset, allocator.getSize(allocation.block), allocation.block });
+        }
+      }
+
+      if (operation % 1000 == 0)
+      {
+        std::vector<LiveBlock> sorted = live;
+        std::sort(sorted.begin(), sorted.end(), [](const LiveBlock& a, const LiveBlock& b) { return a.offset < b.offset; });
+        for (size_t i = 1; i < sorted.size(); ++i)
+        {
+          if (sorted[i - 1].offset + sorted[i - 1].size > sorted[i].offset)
+          {
+            Log::error("Overlapping allocations at %llu.\n", sorted[i].offset);
+            return false;
+          }
+        }
+        if (!allocator.validate())
+        {
+          Log::error("TLSF invariants broken after %u operations.\n", operation);
+          return false;
+        }
+      }
+    }
+
+    for (const LiveBlock& block : live)
+    {
+      allocator.free(block.block);
+    }
+    return allocator.validate() && allocator.getFreeBlockCount() == 1 && allocator.getLargestFreeBlock() == allocator.getCapacity();
+  }
+
+  // Keeps live_count allocations alive and replaces a random one per operation.
+  void benchmarkChurn(uint32 live_count, uint32 operations)
+  {
+    std::mt19937 random(11);
+    std::vector<uint64> sizes(operations + live_count);
+    std::vector<uint32> victims(operations);
+    for (uint64& size : sizes)
+    {
+      size = alignUp(randomSize(random), granularity);
+    }
+    for (uint32& victim : victims)
+    {
+      victim = random() % live_count;
+    }
+
+    TlsfAllocator tlsf(churn_capacity, granularity);
+    std::vector<uint32> tlsf_blocks(live_count);
+    for (uint32 i = 0; i < live_count; ++i)
+    {
+      tlsf_blocks[i] = tlsf.allocate(sizes[i]).block;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "TlsfAllocator, %u live", live_count);
+    runBenchmark(name, operations, [&](uint64 operation)
+    {
+      uint32 victim = victims[operation];
+      tlsf.free(tlsf_blocks[victim]);
+      tlsf_blocks[victim] = tlsf.allocate(sizes[live_count + operation]).block;
+    });
+
+    MapAllocator map(churn_capacity);
+    std::vector<uint64> map_offsets(live_count);
+    std::vector<uint64> map_sizes(sizes.begin(), sizes.begin() + live_count);
+    for (uint32 i = 0; i < live_count; ++i)
+    {
+      map_offsets[i] = map.allocate(sizes[i]);
+    }
+
+    snprintf(name, sizeof(name), "std::map best fit, %u live", live_count);
+    runBenchmark(name, operations, [&](uint64 operation)
+    {
+      uint32 victim = victims[operation];
+      map.free(map_offsets[victim], map_sizes[victim]);
+      map_sizes[victim] = sizes[live_count + operation];
+      map_offsets[victim] = map.allocate(map_sizes[victim]);
+    });
+  }
+
+  void printStats(const char* label, const GpuMemoryAllocator::PoolStats& stats)
+  {
+    Log::info("%-24s %3u heaps %6u allocations %8.1f MB used of %8.1f MB, largest free %6.1f MB\n", label, stats.heap_count, stats.allocation_count, stats.used / 1048576.0, stats.capacity / 1048576.0,
+      stats.largest_free_block / 1048576.0);
+  }
+
+  bool simulateHeaps()
+  {
+    uint32 live_heaps = 0;
+    HeapId next_heap = 0;
+    GpuMemoryAllocator allocator;
+    allocator.initialize([&](const HeapDesc&) { live_heaps++; return next_heap++; }, [&](HeapId) { live_heaps--; });
+
+    // Streams textures in, then evicts most of them at random.
+    std::mt19937 random(3);
+    std::vector<GpuAllocation> textures;
+    for (uint32 i = 0; i < 2000; ++i)
+    {
+      uint64 size = alignUp(uint64(64 * 1024 + random() % (2 * 1024 * 1024)), GpuMemoryAllocator::default_placement_alignment);
+      textures.push_back(allocator.allocate(HeapType::Default, HeapUsage::Textures, size));
+    }
+    // A render target larger than a heap and an MSAA one.
+    GpuAllocation dedicated = allocator.allocate(HeapType::Default, HeapUsage::RenderTargets, 96 * 1024 * 1024);
+    GpuAllocation msaa = allocator.allocate(HeapType::Default, HeapUsage::RenderTargets, 8 * 1024 * 1024, GpuMemoryAllocator::msaa_placement_alignment);
+    bool passed = allocator.getRange(dedicated) && allocator.getRange(msaa) && allocator.getRange(msaa)->offset % GpuMemoryAllocator::msaa_placement_alignment == 0;
+    // Alignments above what the pool places get dedicated heaps, freeing them destroys the heaps.
+    uint32 heaps_before = live_heaps;
+    GpuAllocation large_msaa = allocator.allocate(HeapType::Default, HeapUsage::RenderTargets, 100 * 1024 * 1024, GpuMemoryAllocator::msaa_placement_alignment);
+    GpuAllocation aligned_texture = allocator.allocate(HeapType::Default, HeapUsage::Textures, 4 * 1024 * 1024, GpuMemoryAllocator::msaa_placement_alignment);
+    passed = passed && allocator.getRange(large_msaa) && allocator.getRange(aligned_texture) && live_heaps == heaps_before + 2;
+    allocator.free(large_msaa);
+    allocator.free(aligned_texture);
+    passed = passed && live_heaps == heaps_before;
+
+    std::shuffle(textures.begin(), textures.end(), random);
+    for (uint32 i = 0; i < 1400; ++i)
+    {
+      allocator.free(textures[i]);
+    }
+    textures.erase(textures.begin(), textures.begin() + 1400);
+    printStats("Textures fragmented", allocator.getPoolStats(HeapType::Default, HeapUsage::Textures));
+
+    Timer timer;
+    std::vector<GpuAllocationMove> moves = allocator.beginDefragmentation(HeapType::Default, HeapUsage::Textures, ~0ull);
+    double plan_time = timer.getElapsedSeconds();
+    uint64 moved = 0;
+    for (const GpuAllocationMove& move : moves)
+    {
+      const GpuHeapRange* range = allocator.getRange(move.allocation);
+      passed = passed && range && range->heap == move.destination.heap && range->offset == move.destination.offset;
+      moved += move.source.size;
+    }
+    allocator.endDefragmentation(moves);
+    Log::info("Defragmentation planned %zu moves, %.1f MB, in %.3f ms\n", moves.size(), moved / 1048576.0, plan_time * 1000.0);
+    printStats("Textures compacted", allocator.getPoolStats(HeapType::Default, HeapUsage::Textures));
+
+    // Live ranges of a heap may not overlap after the moves.
+    std::map<std::pair<HeapId, uint64>, uint64> ranges;
+    for (GpuAllocation texture : textures)
+    {
+      const GpuHeapRange* range = allocator.getRange(texture);
+      passed = passed && range;
+      if (range)
+      {
+        ranges[{ range->heap, range->offset }] = range->size;
+      }
+    }
+    for (auto it = ranges.begin(); it != ranges.end() && std::next(it) != ranges.end(); ++it)
+    {
+      auto next = std::next(it);
+      passed = passed && (it->first.first != next->first.first || it->first.second + it->second <= next->first.second);
+    }
+
+    for (GpuAllocation texture : textures)
+    {
+      allocator.free(texture);
+    }
+    allocator.free(dedicated);
+    allocator.free(msaa);
+    // One empty heap stays per used pool.
+    passed = passed && live_heaps == 2;
+    allocator.shutdown();
+    return passed && live_heaps == 0;
+  }
+}
+
+int main()
+{
+  bool fuzz_passed = fuzzTlsf(200000);
+  Log::info("TLSF fuzz test: %s\n", fuzz_passed ? "passed" : "failed");
+
+  Log::info("Free and allocate one range, sizes from 256 bytes to 9 MB:\n");
+  benchmarkChurn(100, 1000000);
+  benchmarkChurn(10000, 1000000);
+
+  bool heaps_passed = simulateHeaps();
+  Log::info("Simulated heaps: %s\n", heaps_passed ? "passed" : "failed");
+
+  return fuzz_passed && heaps_passed ? 0 : 1;
+}
\ No newline at end of file
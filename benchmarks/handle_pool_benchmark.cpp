@@ -0,0 +1,192 @@
+#include "benchmark.h"
+
+#include <common/handle_pool.h>
+#include <jobs/job_system.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 object_count = 10000;
+
+  struct Mesh
+  {
+    float bounds[6];
+    uint32 vertex_count;
+    uint32 index_count;
+    uint64 vertex_buffer;
+    uint64 index_buffer;
+    uint32 material;
+  };
+
+  Mesh makeMesh(uint32 i)
+  {
+    Mesh mesh {};
+    mesh.bounds[0] = static_cast<float>(i % 100);
+    mesh.bounds[3] = mesh.bounds[0] + 1.0f;
+    mesh.vertex_count = i;
+    mesh.index_count = i * 3;
+    return mesh;
+  }
+
+  // A culling pass: indices drawn by meshes overlapping a slab.
+  uint64 countVisible(const Mesh& mesh)
+  {
+    return mesh.bounds[3] >= 25.0f && mesh.bounds[0] <= 75.0f ? mesh.index_count : 0;
+  }
+}
+
+int main()
+{
+  std::mt19937 random(42);
+  std::vector<uint32> order(object_count);
+  for (uint32 i = 0; i < object_count; ++i)
+  {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), random);
+
+  HandlePool<Mesh> pool;
+  std::vector<HandlePool<Mesh>::HandleType> handles(object_count);
+  std::unordered_map<uint32, Mesh> map;
+  std::vector<std::unique_ptr<Mesh>> pointers(object_count);
+
+  Log::info("Create and destroy %u meshes:\n", object_count);
+  runBenchmark("HandlePool", 200, [&](uint64)
+  {
+    for (uint32 i = 0; i < object_count; ++i)
+    {
+      handles[i] = pool.create(makeMesh(i));
+    }
+    for (uint32 i : order)
+    {
+      pool.destroy(handles[i]);
+    }
+  });
+  runBenchmark("std::unordered_map", 200, [&](uint64)
+  {
+    for (uint32 i = 0; i < object_count; ++i)
+    {
+      map.emplace(i, makeMesh(i));
+    }
+    for (uint32 i : order)
+    {
+      map.erase(i);
+    }
+  });
+  runBenchmark("new/delete", 200, [&](uint64)
+  {
+    for (uint32 i = 0; i < object_count; ++i)
+    {
+      pointers[i].reset(new Mesh(makeMesh(i)));
+    }
+    for (uint32 i : order)
+    {
+      pointers[i].reset();
+    }
+  });
+
+  // Fill in shuffled order so neither side is laid out in lookup order.
+  for (uint32 i : order)
+  {
+    handles[i] = pool.create(makeMesh(i));
+    map.emplace(i, makeMesh(i));
+    pointers[i].reset(new Mesh(makeMesh(i)));
+  }
+
+  Log::info("Look up %u meshes in random order:\n", object_count);
+  runBenchmark("HandlePool", 500, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (uint32 i : order)
+    {
+      sum += pool.get(handles[i])->vertex_count;
+    }
+    doNotOptimize(sum);
+  });
+  runBenchmark("std::unordered_map", 500, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (uint32 i : order)
+    {
+      sum += map.find(i)->second.vertex_count;
+    }
+    doNotOptimize(sum);
+  });
+  runBenchmark("new/delete", 500, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (uint32 i : order)
+    {
+      sum += pointers[i]->vertex_count;
+    }
+    doNotOptimize(sum);
+  });
+
+  Log::info("Cull %u meshes:\n", object_count);
+  runBenchmark("HandlePool", 2000, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (const Mesh& mesh : pool)
+    {
+      sum += countVisible(mesh);
+    }
+    doNotOptimize(sum);
+  });
+  runBenchmark("std::unordered_map", 2000, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (const auto& [id, mesh] : map)
+    {
+      sum += countVisible(mesh);
+    }
+    doNotOptimize(sum);
+  });
+  runBenchmark("new/delete", 2000, [&](uint64)
+  {
+    uint64 sum = 0;
+    for (const auto& mesh : pointers)
+    {
+      sum += countVisible(*mesh);
+    }
+    doNotOptimize(sum);
+  });
+
+  // Stale handles have to be rejected, not resolve to whatever reused the slot.
+  uint32 stale_hits = 0;
+  for (uint32 i = 0; i < object_count; i += 2)
+  {
+    pool.destroy(handles[i]);
+  }
+  for (uint32 i = 0; i < object_count; i += 2)
+  {
+    pool.create(makeMesh(i));
+    stale_hits += pool.get(handles[i]) != nullptr;
+  }
+  Log::info("Stale handles resolved: %u\n", stale_hits);
+
+  JobSystem job_system;
+  job_system.initialize(JobSystem::getDefaultWorkerCount());
+  std::vector<uint64> sums(object_count);
+  runBenchmark("HandlePool, parallel lookups from jobs", 500, [&](uint64)
+  {
+    job_system.parallelFor(object_count, [&](uint32 begin, uint32 end)
+    {
+      for (uint32 i = begin; i < end; ++i)
+      {
+        const Mesh* mesh = pool.get(handles[order[i]]);
+        sums[i] = mesh ? mesh->vertex_count : 0;
+      }
+    });
+  });
+  job_system.shutdown();
+  doNotOptimize(sums[object_count / 2]);
+
+  return stale_hits == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "benchmark.h"
+
+#include <jobs/job_system.h>
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 job_batch = 2048;
+
+  // Every external thread past max_external_threads runs its jobs inline instead of getting a slot.
+  void checkExternalThreads()
+  {
+    JobSystem job_system;
+    job_system.initialize(1);
+    std::atomic<uint32> executed { 0 };
+    std::vector<std::thread> threads;
+    for (uint32 i = 0; i < JobSystem::max_external_threads + 4; ++i)
+    {
+      threads.emplace_back([&]()
+      {
+        JobCounter counter;
+        for (uint32 job = 0; job < 64; ++job)
+        {
+          job_system.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        }
+        job_system.wait(counter);
+        job_system.runPendingJob();
+      });
+    }
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+    job_system.shutdown();
+
+    check("jobs of threads past max_external_threads run", executed == (JobSystem::max_external_threads + 4) * 64);
+  }
+
+  void checkShutdownRunsQueuedJobs()
+  {
+    // Without workers every job stays queued until shutdown.
+    JobSystem job_system;
+    job_system.initialize(0);
+    std::atomic<uint32> executed { 0 };
+    JobCounter counter;
+    for (uint32 job = 0; job < 64; ++job)
+    {
+      job_system.run([&]()
+      {
+        executed.fetch_add(1, std::memory_order_relaxed);
+        job_system.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+      }, &counter);
+    }
+    job_system.shutdown();
+    check("shutdown runs queued jobs and the jobs they submit", counter.isDone() && executed == 128);
+
+    JobCounter after;
+    job_system.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &after);
+    job_system.wait(after);
+    check("jobs submitted after shutdown run inline", after.isDone() && executed == 129);
+  }
+
+  void checkWaitForIdle()
+  {
+    JobSystem job_system;
+    job_system.initialize(0);
+    std::atomic<uint32> executed { 0 };
+    for (uint32 job = 0; job < 16; ++job)
+    {
+      job_system.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, nullptr);
+    }
+    bool was_idle = job_system.isIdle();
+    job_system.waitForIdle();
+    check("waitForIdle runs the queued jobs", !was_idle && job_system.isIdle() && executed == 16);
+    job_system.shutdown();
+  }
+
+  // Roughly a microsecond of arithmetic.
+  float smallWork(uint32 seed)
+  {
+    float value = static_cast<float>(seed);
+    for (uint32 i = 0; i < 200; ++i)
+    {
+      value = std::sqrt(value * 1.0001f + 1.0f);
+    }
+    return value;
+  }
+
+  double benchmarkJobs(JobSystem& job_system, const char* name, uint64 job_count, bool small)
+  {
+    std::atomic<uint32> sink { 0 };
+
+    auto result = runBenchmark(name, job_count / job_batch, [&](uint64)
+    {
+      JobCounter counter;
+      for (uint32 i = 0; i < job_batch; ++i)
+      {
+        if (small)
+        {
+          job_system.run([&sink, i]() { sink.fetch_add(static_cast<uint32>(smallWork(i)), std::memory_order_relaxed); }, &counter);
+        }
+        else
+        {
+          job_system.run([]() {}, &counter);
+        }
+      }
+      job_system.wait(counter);
+    });
+    doNotOptimize(sink.load());
+
+    return result.iterationsPerSecond() * job_batch;
+  }
+
+  double benchmarkParallelFor(JobSystem& job_system, const char* name, uint32 element_count)
+  {
+    std::vector<float> values(element_count);
+
+    auto result = runBenchmark(name, 20, [&](uint64)
+    {
+      job_system.parallelFor(element_count, [&](uint32 begin, uint32 end)
+      {
+        for (uint32 i = begin; i < end; ++i)
+        {
+          values[i] = smallWork(i) * 0.01f;
+        }
+      });
+    });
+    doNotOptimize(values[element_count / 2]);
+
+    return result.iterationsPerSecond();
+  }
+}
+
+int main()
+{
+  checkExternalThreads();
+  checkShutdownRunsQueuedJobs();
+  checkWaitForIdle();
+  const uint32 max_threads = std::max(4u, std::thread::hardware_concurrency());
+  Log::info("Hardware threads: %u\n", std::thread::hardware_concurrency());
+
+  double empty_baseline = 0.0;
+  double small_baseline = 0.0;
+  double parallel_for_baseline = 0.0;
+
+  for (uint32 threads = 1; threads <= max_threads; threads *= 2)
+  {
+    JobSystem job_system;
+    job_system.initialize(threads - 1);
+    Log::info("-- %u threads\n", job_system.getConcurrency());
+
+    double empty = benchmarkJobs(job_system, "2048 empty jobs", 200 * job_batch, false);
+    double small = benchmarkJobs(job_system, "2048 small (~1us) jobs", 20 * job_batch, true);
+    double parallel_for = benchmarkParallelFor(job_system, "parallelFor over 20k elements", 20000);
+
+    if (threads == 1)
+    {
+      empty_baseline = empty;
+      small_baseline = small;
+      parallel_for_baseline = parallel_for;
+    }
+
+    Log::info("   empty jobs: %.2f M jobs/s (x%.2f), small jobs: %.2f M jobs/s (x%.2f), parallelFor x%.2f\n",
+      empty * 1e-6, empty / empty_baseline, small * 1e-6, small / small_baseline, parallel_for / parallel_for_baseline);
+
+    job_system.shutdown();
+  }
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "benchmark.h"
+
+#include <common/log_checked.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  // Frame loops log in short bursts. Every thread logs a burst of typical frame lines, then all of
+  // them wait until the output caught up. Returns the average time a thread spent inside Log::info.
+  template<bool Checked>
+  double logFromThreads(uint32 thread_count, uint32 bursts, uint32 burst_size)
+  {
+    std::vector<std::thread> threads;
+    std::vector<double> seconds(thread_count);
+    std::atomic<uint32> finished_bursts { 0 };
+
+    for (uint32 t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back([&, t]()
+      {
+        for (uint32 burst = 0; burst < bursts; ++burst)
+        {
+          Timer timer;
+          for (uint32 i = 0; i < burst_size; ++i)
+          {
+            if constexpr (Checked)
+            {
+              LOG_INFO("thread %u frame %u: %.3f ms, %d draws, pass %s\n", t, burst, 16.6 + i * 1e-3, int32(1000 + i), "gbuffer");
+            }
+            else
+            {
+              Log::info("thread %u frame %u: %.3f ms, %d draws, pass %s\n", t, burst, 16.6 + i * 1e-3, 1000 + i, "gbuffer");
+            }
+          }
+          seconds[t] += timer.getElapsedSeconds();
+
+          // Stands in for the rest of the frame.
+          finished_bursts.fetch_add(1);
+          while (finished_bursts.load() < (burst + 1) * thread_count)
+          {
+            std::this_thread::yield();
+          }
+          if (t == 0)
+          {
+            Log::flush();
+          }
+        }
+      });
+    }
+
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    double total = 0.0;
+    for (double s : seconds)
+    {
+      total += s;
+    }
+
+    return total * 1e9 / (double(thread_count) * bursts * burst_size);
+  }
+
+  // Stops async logging while other threads keep logging, every line has to reach the output once.
+  void checkStopWhileLogging()
+  {
+    const uint32 thread_count = 4;
+    const uint32 lines_per_thread = 2000;
+    bool complete = true;
+    for (uint32 trial = 0; trial < 20; ++trial)
+    {
+      FILE* sink = std::tmpfile();
+      if (!sink)
+      {
+        check("stop: temporary file", false);
+        return;
+      }
+
+      Log::setOutput(sink, sink);
+      Log::setAsync(true);
+      std::vector<std::thread> threads;
+      for (uint32 t = 0; t < thread_count; ++t)
+      {
+        threads.emplace_back([t]()
+        {
+          for (uint32 i = 0; i < lines_per_thread; ++i)
+          {
+            LOG_INFO("thread %u line %u\n", t, i);
+          }
+        });
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100 * trial));
+      Log::setAsync(false);
+      for (std::thread& thread : threads)
+      {
+        thread.join();
+      }
+      Log::setOutput(nullptr, nullptr);
+
+      uint32 lines = 0;
+      std::rewind(sink);
+      for (int c = std::fgetc(sink); c != EOF; c = std::fgetc(sink))
+      {
+        lines += c == '\n';
+      }
+      fclose(sink);
+      complete = complete && lines == thread_count * lines_per_thread;
+    }
+
+    check("stop: lines logged while async logging stops are written", complete);
+  }
+}
+
+int main()
+{
+  const uint32 bursts = 200;
+  const uint32 burst_size = 64;
+  FILE* sink = std::tmpfile();
+  if (!sink)
+  {
+    Log::error("Can't create a temporary file for the log output.\n");
+    return 1;
+  }
+
+  for (uint32 thread_count : { 1u, 2u, 4u, 8u })
+  {
+    Log::setOutput(sink, sink);
+    double sync_cost = logFromThreads<false>(thread_count, bursts, burst_size);
+
+    Log::setAsync(true);
+    double async_cost = logFromThreads<false>(thread_count, bursts, burst_size);
+    double checked_cost = logFromThreads<true>(thread_count, bursts, burst_size);
+    Log::setAsync(false);
+
+    Log::setOutput(nullptr, nullptr);
+    Log::info("%u threads, bursts of %u lines: vfprintf %7.1f ns/call, async %7.1f ns/call, async LOG_INFO %7.1f ns/call\n",
+      thread_count, burst_size, sync_cost, async_cost, checked_cost);
+  }
+
+  fclose(sink);
+
+  checkStopWhileLogging();
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
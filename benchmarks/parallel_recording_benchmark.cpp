@@ -0,0 +1,151 @@
+#include "benchmark.h"
+
+#include <jobs/job_system.h>
+#include <render/null_device_resources.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 draws_per_list = 1000;
+  constexpr uint32 frames = 100;
+
+  struct DrawConstants
+  {
+    uint32 material;
+    uint32 transform;
+  };
+
+  void recordDraws(CommandList& command_list, uint32 begin, uint32 end)
+  {
+    VertexBufferView vertex_buffer {};
+    command_list.setPipelineState(0);
+    command_list.setGraphicsRootSignature(0);
+    command_list.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+    for (uint32 draw = begin; draw < end; ++draw)
+    {
+      DrawConstants constants { draw % 64, draw };
+      vertex_buffer.location = 0x100000000ull + draw * 4096ull;
+      command_list.setVertexBuffers(0, &vertex_buffer, 1);
+      command_list.setGraphicsRoot32BitConstants(0, 2, &constants, 0);
+      command_list.drawIndexedInstanced(36, 1, 0, 0, 0);
+    }
+  }
+
+  // Records draw_count draws per frame, on the frame's own list or split into lists of
+  // draws_per_list recorded by the job system.
+  bool recordFrames(uint32 draw_count, uint32 thread_count)
+  {
+    NullDeviceResources device_resources;
+    device_resources.setFrameCount(3);
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    JobSystem job_system;
+    job_system.initialize(thread_count - 1);
+
+    uint32 list_count = (draw_count + draws_per_list - 1) / draws_per_list;
+    char name[96];
+    snprintf(name, sizeof(name), "%6u draws, %u threads", draw_count, thread_count);
+
+    BenchmarkResult result = runBenchmark(name, frames, [&](uint64)
+    {
+      CommandList& frame_list = device_resources.beginFrame();
+      if (thread_count == 1)
+      {
+        recordDraws(frame_list, 0, draw_count);
+      }
+      else
+      {
+        job_system.parallelFor(list_count, 1, [&](uint32 begin, uint32 end)
+        {
+          for (uint32 list = begin; list < end; ++list)
+          {
+            CommandList& command_list = device_resources.acquireCommandList(list);
+            recordDraws(command_list, list * draws_per_list, std::min(draw_count, (list + 1) * draws_per_list));
+            command_list.close();
+          }
+        });
+      }
+      device_resources.endFrame(false, false);
+    });
+    job_system.shutdown();
+    device_resources.flush();
+
+    // Every draw must reach the queue, 3 commands each.
+    const NullDeviceResources::Stats& stats = device_resources.getStats();
+    Log::info("  %.1f M draws/s, %.1f lists per submit\n", draw_count * result.iterationsPerSecond() / 1e6, double(stats.command_lists) / stats.submits);
+    return stats.commands >= uint64(frames) * draw_count * 3;
+  }
+
+  // Threads come and go like job system workers across restarts, more of them over time than the
+  // pool has slots, and once more at the same time than it has slots.
+  void checkThreadTurnover()
+  {
+    NullDeviceResources device_resources;
+    device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+    uint32 draws = 0;
+    const uint32 rounds[] = { 40, 40, 40, CommandListPool::max_threads + 6 };
+    for (uint32 thread_count : rounds)
+    {
+      device_resources.beginFrame();
+      std::atomic<uint32> recorded { 0 };
+      std::vector<std::thread> threads;
+      for (uint32 i = 0; i < thread_count; ++i)
+      {
+        threads.emplace_back([&, i]()
+        {
+          CommandList& command_list = device_resources.acquireCommandList(i);
+          command_list.drawInstanced(3, 1, 0, 0);
+          command_list.close();
+          // Every thread of the round stays alive until all of them recorded.
+          recorded.fetch_add(1);
+          while (recorded.load() < thread_count)
+          {
+            std::this_thread::yield();
+          }
+        });
+      }
+      for (std::thread& thread : threads)
+      {
+        thread.join();
+      }
+      device_resources.endFrame(false, false);
+      draws += thread_count;
+    }
+    device_resources.flush();
+
+    // Besides the draws every frame records a barrier and a clear first and a barrier last.
+    check("every thread's list is submitted", device_resources.getStats().commands == draws + 3ull * std::size(rounds));
+  }
+}
+
+int main()
+{
+  checkThreadTurnover();
+
+  uint32 concurrency = JobSystem::getDefaultWorkerCount() + 1;
+  std::vector<uint32> thread_counts { 1, 2, 4 };
+  if (concurrency > 4)
+  {
+    thread_counts.push_back(concurrency);
+  }
+
+  Log::info("Recording on %u hardware threads:\n", concurrency);
+  bool passed = true;
+  for (uint32 draw_count : { 10000u, 100000u })
+  {
+    for (uint32 thread_count : thread_counts)
+    {
+      passed = recordFrames(draw_count, thread_count) && passed;
+    }
+  }
+
+  return passed && checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "benchmark.h"
+
+#include <profiler/profiler.h>
+#include <render/null_device_resources.h>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  uint64 work(uint64 value)
+  {
+    doNotOptimize(value);
+    return value + 1;
+  }
+
+  // More short-lived threads than Profiler::max_threads, as worker restarts create them.
+  void checkThreadTurnover()
+  {
+    Profiler::clear();
+    const uint32 rounds = 4;
+    const uint32 threads_per_round = 40;
+    for (uint32 round = 0; round < rounds; ++round)
+    {
+      std::vector<std::thread> threads;
+      for (uint32 i = 0; i < threads_per_round; ++i)
+      {
+        threads.emplace_back([]() { Profiler::record("turnover", Profiler::now(), Profiler::now()); });
+      }
+      for (std::thread& thread : threads)
+      {
+        thread.join();
+      }
+    }
+
+    const char* path = "profiler_benchmark_turnover.json";
+    check("rings of exited threads are reused and keep their events", Profiler::getEventCount() == rounds * threads_per_round);
+    check("trace with exited threads exports", Profiler::exportChromeTrace(path));
+    std::remove(path);
+    Profiler::clear();
+  }
+}
+
+int main()
+{
+#if !defined(ENGINE_PROFILER)
+  Log::info("Profiler is compiled out, PROFILE_SCOPE costs nothing.\n");
+#endif
+  checkThreadTurnover();
+
+  const uint64 iterations = 10000000;
+  uint64 value = 0;
+
+  auto baseline = runBenchmark("empty loop", iterations, [&](uint64)
+  {
+    value = work(value);
+  });
+
+  auto scoped = runBenchmark("loop with PROFILE_SCOPE", iterations, [&](uint64)
+  {
+    PROFILE_SCOPE("scope");
+    value = work(value);
+  });
+
+  auto nested = runBenchmark("loop with 4 nested PROFILE_SCOPEs", iterations / 4, [&](uint64)
+  {
+    PROFILE_SCOPE("outer");
+    {
+      PROFILE_SCOPE("middle");
+      {
+        PROFILE_SCOPE("inner");
+        {
+          PROFILE_SCOPE("innermost");
+          value = work(value);
+        }
+      }
+    }
+  });
+
+  auto clock = runBenchmark("Profiler::now", iterations, [&](uint64)
+  {
+    doNotOptimize(Profiler::now());
+  });
+
+  // Virtual machines often trap the TSC read, so report the recording cost on its own as well.
+  double scope_cost = scoped.nanosecondsPerIteration() - baseline.nanosecondsPerIteration();
+  Log::info("    cost per scope %.1f ns (single), %.1f ns (nested), %.1f ns of it outside the two clock reads\n",
+    scope_cost, (nested.nanosecondsPerIteration() - baseline.nanosecondsPerIteration()) / 4.0,
+    scope_cost - 2.0 * clock.nanosecondsPerIteration());
+
+  // A realistic trace: the null backend frame loop with its own scopes.
+  Profiler::clear();
+  NullDeviceResources device_resources;
+  device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+  for (uint32 frame = 0; frame < 1000; ++frame)
+  {
+    PROFILE_SCOPE("frame");
+    device_resources.render(false, false);
+  }
+  device_resources.flush();
+
+  const char* path = "profiler_benchmark_trace.json";
+  Timer timer;
+  bool exported = Profiler::exportChromeTrace(path);
+  Log::info("    exported %llu events to %s in %.1f ms (%s)\n", Profiler::getEventCount(), path, timer.getElapsedSeconds() * 1e3, exported ? "ok" : "failed");
+  std::remove(path);
+
+  doNotOptimize(value);
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+#include <render/render_graph.h>
+
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 pass_count = 100;
+  constexpr ResourceId back_buffer = 1;
+
+  TransientResourceDesc makeTarget(uint32 width, uint32 height, uint32 bytes_per_pixel)
+  {
+    TransientResourceDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.size = alignUp(uint64(width) * height * bytes_per_pixel, GpuMemoryAllocator::default_placement_alignment);
+    return desc;
+  }
+
+  void checkGraph()
+  {
+    RenderGraph graph;
+    TransientResourceDesc target = makeTarget(1920, 1080, 4);
+
+    // Culling: nothing reads the debug view.
+    RenderGraphResource output = graph.importResource("Back buffer", back_buffer, ResourceState::Present, ResourceState::Present);
+    RenderGraphResource scene = graph.createResource("Scene", target);
+    RenderGraphResource debug = graph.createResource("Debug", target);
+    scene = graph.addPass("Scene", nullptr).write(scene, ResourceState::RenderTarget);
+    graph.addPass("Debug", nullptr).write(debug, ResourceState::RenderTarget);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Compose", nullptr);
+      pass.read(scene, ResourceState::PixelShaderResource);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+    check("graph compiles", graph.compile());
+    check("unused passes are culled", graph.isCulled(1) && !graph.isCulled(0) && graph.getStats().culled_passes == 1);
+    check("culled resources take no memory", graph.getStats().transient_resources == 1 && graph.getHeapSize(HeapUsage::RenderTargets) == target.size);
+    uint32 count = 0;
+    const ResourceBarrier* barriers = graph.getPassBarriers(2, count);
+    check("imported resources transition from their state", count == 2 && barriers[1].resource == 0 && barriers[1].state_before == ResourceState::Present);
+
+    // Scheduling: the blur reads the first version, so it runs before the overlay modifies it.
+    graph.reset();
+    output = graph.importResource("Back buffer", back_buffer, ResourceState::Present, ResourceState::Present);
+    RenderGraphResource color = graph.createResource("Color", target);
+    RenderGraphResource blurred = graph.createResource("Blurred", target);
+    RenderGraphResource first = graph.addPass("Lighting", nullptr).write(color, ResourceState::RenderTarget);
+    RenderGraphResource overlaid = graph.addPass("Overlay", nullptr).write(first, ResourceState::RenderTarget);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Blur", nullptr);
+      pass.read(first, ResourceState::PixelShaderResource);
+      blurred = pass.write(blurred, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Compose", nullptr);
+      pass.read(overlaid, ResourceState::PixelShaderResource);
+      pass.read(blurred, ResourceState::PixelShaderResource);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+    check("graph with a write after read compiles", graph.compile());
+    const std::vector<uint32>& schedule = graph.getSchedule();
+    check("readers run before the next write", schedule.size() == 4 && schedule[0] == 0 && schedule[1] == 2 && schedule[2] == 1 && schedule[3] == 3);
+
+    // Passes that both read what the other one modifies can't be ordered.
+    graph.reset();
+    RenderGraphResource a = graph.createResource("A", target);
+    RenderGraphResource b = graph.createResource("B", target);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("First", nullptr);
+      pass.read(a, ResourceState::PixelShaderResource);
+      pass.write(b, ResourceState::RenderTarget);
+      pass.setSideEffects();
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Second", nullptr);
+      pass.read(b, ResourceState::PixelShaderResource);
+      pass.write(a, ResourceState::RenderTarget);
+      pass.setSideEffects();
+    }
+    check("cycles are reported", !graph.compile());
+
+    // Aliasing: the bloom targets live after the shadow map is done with its memory.
+    graph.reset();
+    output = graph.importResource("Back buffer", back_buffer, ResourceState::Present, ResourceState::Present);
+    RenderGraphResource shadow = graph.createResource("Shadow", target);
+    RenderGraphResource lit = graph.createResource("Lit", target);
+    RenderGraphResource bloom = graph.createResource("Bloom", target);
+    shadow = graph.addPass("Shadow", nullptr).write(shadow, ResourceState::DepthWrite);
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Lighting", nullptr);
+      pass.read(shadow, ResourceState::PixelShaderResource);
+      lit = pass.write(lit, ResourceState::RenderTarget);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Bloom", nullptr);
+      pass.read(lit, ResourceState::PixelShaderResource);
+      bloom = pass.write(bloom, ResourceState::UnorderedAccess);
+    }
+    {
+      RenderGraphPassBuilder pass = graph.addPass("Compose", nullptr);
+      pass.read(lit, ResourceState::PixelShaderResource);
+      pass.read(bloom, ResourceState::PixelShaderResource);
+      pass.write(output, ResourceState::RenderTarget);
+    }
+    check("aliased graph compiles", graph.compile());
+    check("disjoint lifetimes share memory", graph.getHeapOffset(bloom) == graph.getHeapOffset(shadow) && graph.getHeapSize(HeapUsage::RenderTargets) == 2 * target.size);
+    barriers = graph.getPassBarriers(2, count);
+    check("reused memory gets an aliasing barrier", graph.getStats().aliasing_barriers == 1 && count > 0 && barriers[0].type == BarrierType::Aliasing && barriers[0].resource == 1 && barriers[0].resource_after == 3);
+    check("transitions to later uses are split", graph.getStats().split_barriers > 0);
+
+    // Execution translates to the realized resources.
+    graph.realize([](const char*, const TransientResourceDesc&, ResourceState, uint64 offset) { return static_cast<ResourceId>(100 + offset / GpuMemoryAllocator::default_placement_alignment); });
+    CommandStream stream;
+    NullCommandList command_list(CommandListType::Direct);
+    command_list.reset(&stream);
+    graph.execute(command_list);
+    command_list.close();
+    check("the bloom target is realized in the shadow map's memory", graph.getResource(bloom) == graph.getResource(shadow));
+    check("barriers are recorded", stream.getCommandCount() > 0);
+  }
+
+  TransientResourceDesc makeDesc(std::mt19937& random, bool compute)
+  {
+    static const uint32 sizes[] = { 1920, 960, 480, 240 };
+    uint32 width = sizes[random() % 4];
+    TransientResourceDesc desc = makeTarget(width, width * 9 / 16, random() % 2 ? 8 : 4);
+    desc.usage = compute ? HeapUsage::Textures : HeapUsage::RenderTargets;
+    return desc;
+  }
+
+  // A frame of pass_count passes: every pass reads up to three results of the passes shortly
+  // before it and writes a new target, compute passes sometimes modify a result in place. A few
+  // debug passes nobody reads get culled. The last pass composes into the back buffer.
+  void buildFrame(RenderGraph& graph, uint32 seed)
+  {
+    std::mt19937 random(seed);
+    std::vector<RenderGraphResource> results;
+    RenderGraphResource output = graph.importResource("Back buffer", back_buffer, ResourceState::Present, ResourceState::Present);
+
+    for (uint32 i = 0; i + 1 < pass_count; ++i)
+    {
+      bool compute = random() % 4 == 0;
+      bool debug = random() % 20 == 0;
+      RenderGraphPassBuilder pass = graph.addPass("Pass", nullptr);
+      uint32 read_count = results.empty() ? 0 : 1 + random() % 3;
+      for (uint32 read = 0; read < read_count; ++read)
+      {
+        uint32 window = std::min<uint32>(static_cast<uint32>(results.size()), 8);
+        pass.read(results[results.size() - 1 - random() % window], compute ? ResourceState::NonPixelShaderResource : ResourceState::PixelShaderResource);
+      }
+
+      if (compute && !results.empty() && random() % 2)
+      {
+        results.back() = pass.write(results.back(), ResourceState::UnorderedAccess);
+        continue;
+      }
+
+      RenderGraphResource created = graph.createResource("Target", makeDesc(random, compute));
+      created = pass.write(created, compute ? ResourceState::UnorderedAccess : ResourceState::RenderTarget);
+      if (!debug)
+      {
+        results.push_back(created);
+      }
+    }
+
+    RenderGraphPassBuilder compose = graph.addPass("Compose", nullptr);
+    compose.read(results.back(), ResourceState::PixelShaderResource);
+    compose.read(results[results.size() / 2], ResourceState::PixelShaderResource);
+    compose.write(output, ResourceState::RenderTarget);
+  }
+}
+
+int main()
+{
+  checkGraph();
+  Log::info("Render graph checks: %s\n", checks_passed ? "passed" : "failed");
+
+  RenderGraph graph;
+  buildFrame(graph, 23);
+  if (!graph.compile())
+  {
+    return 1;
+  }
+
+  Log::info("%u passes:\n", pass_count);
+  runBenchmark("Compile", 20000, [&](uint64) { graph.compile(); });
+  BenchmarkResult frame = runBenchmark("Reset, build and compile", 20000, [&](uint64)
+  {
+    graph.reset();
+    buildFrame(graph, 23);
+    graph.compile();
+  });
+
+  const RenderGraph::Stats& stats = graph.getStats();
+  uint64 heap_size = 0;
+  for (uint64 size : stats.heap_sizes)
+  {
+    heap_size += size;
+  }
+  Log::info("culled %u of %u passes, %u transients\n", stats.culled_passes, stats.passes, stats.transient_resources);
+  Log::info("transient memory %.1f MB, aliased into %.1f MB of heaps\n", stats.transient_size / (1024.0 * 1024.0), heap_size / (1024.0 * 1024.0));
+  Log::info("%u barriers, %u of them split, %u aliasing\n", stats.barriers, stats.split_barriers, stats.aliasing_barriers);
+
+  if (frame.nanosecondsPerIteration() > 100000.0)
+  {
+    Log::error("Compiling %u passes took longer than 100 us.\n", pass_count);
+  }
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "benchmark.h"
+
+#include <render/null_device_resources.h>
+#include <render/resource_state_tracker.h>
+
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 resource_count = 64;
+  constexpr uint32 pass_count = 40;
+
+  void checkTracker()
+  {
+    ResourceStateTracker tracker;
+    std::vector<ResourceBarrier> barriers;
+
+    tracker.registerResource(0, ResourceState::Common);
+    tracker.require(0, ResourceState::Present);
+    check("redundant transitions are elided", tracker.flush(barriers) == 0);
+
+    tracker.registerResource(1, ResourceState::RenderTarget);
+    tracker.require(1, ResourceState::PixelShaderResource);
+    tracker.require(1, ResourceState::NonPixelShaderResource);
+    barriers.clear();
+    check("reads of one pass combine", tracker.flush(barriers) == 1 && barriers[0].state_after == (ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource));
+    tracker.require(1, ResourceState::PixelShaderResource);
+    check("combined reads satisfy each read", tracker.flush(barriers) == 0);
+
+    tracker.registerResource(2, ResourceState::Common);
+    tracker.require(2, ResourceState::CopyDest);
+    tracker.require(2, ResourceState::Common);
+    check("a round trip within a batch cancels out", tracker.flush(barriers) == 0 && tracker.getState(2) == ResourceState::Common);
+
+    tracker.registerResource(3, ResourceState::RenderTarget);
+    tracker.prepare(3, ResourceState::PixelShaderResource);
+    barriers.clear();
+    check("prepare begins a split barrier", tracker.flush(barriers) == 1 && barriers[0].flags == BarrierFlags::BeginOnly);
+    tracker.require(3, ResourceState::PixelShaderResource);
+    barriers.clear();
+    check("require ends the split barrier", tracker.flush(barriers) == 1 && barriers[0].flags == BarrierFlags::EndOnly && barriers[0].state_before == ResourceState::RenderTarget);
+
+    tracker.prepare(3, ResourceState::RenderTarget);
+    tracker.require(3, ResourceState::RenderTarget);
+    barriers.clear();
+    check("a split within one batch becomes a plain barrier", tracker.flush(barriers) == 1 && barriers[0].flags == BarrierFlags::None);
+
+    tracker.registerResource(4, ResourceState::Common, 4);
+    tracker.require(4, ResourceState::RenderTarget, 1);
+    barriers.clear();
+    check("subresources transition alone", tracker.flush(barriers) == 1 && barriers[0].subresource == 1 && tracker.getState(4, 0) == ResourceState::Common);
+    tracker.require(4, ResourceState::PixelShaderResource);
+    barriers.clear();
+    check("diverged subresources each get a barrier", tracker.flush(barriers) == 4 && barriers[1].state_before == ResourceState::RenderTarget);
+    check("subresources rejoin", tracker.getState(4, 3) == ResourceState::PixelShaderResource);
+
+    tracker.registerResource(5, ResourceState::UnorderedAccess);
+    tracker.require(5, ResourceState::UnorderedAccess);
+    tracker.require(5, ResourceState::UnorderedAccess);
+    barriers.clear();
+    check("unordered access writes get one UAV barrier per batch", tracker.flush(barriers) == 1 && barriers[0].type == BarrierType::UnorderedAccess);
+
+    tracker.registerResource(6, ResourceState::RenderTarget);
+    tracker.registerResource(7, ResourceState::RenderTarget);
+    tracker.prepare(6, ResourceState::PixelShaderResource);
+    tracker.prepare(7, ResourceState::PixelShaderResource);
+    tracker.unregisterResource(6);
+    barriers.clear();
+    check("unregistering drops a split begun in the batch", tracker.flush(barriers) == 1 && barriers[0].resource == 7 && barriers[0].flags == BarrierFlags::BeginOnly);
+    tracker.unregisterResource(7);
+    barriers.clear();
+    check("unregistering ends a split begun earlier", tracker.flush(barriers) == 1 && barriers[0].resource == 7 && barriers[0].flags == BarrierFlags::EndOnly
+      && barriers[0].state_before == ResourceState::RenderTarget && barriers[0].state_after == ResourceState::PixelShaderResource);
+  }
+
+  struct Pass
+  {
+    std::vector<uint32> reads;
+    std::vector<uint32> writes;
+    bool compute;
+  };
+
+  // Passes read what earlier passes wrote, like a post processing chain.
+  std::vector<Pass> makePasses()
+  {
+    std::mt19937 random(21);
+    std::vector<Pass> passes(pass_count);
+    for (uint32 i = 0; i < pass_count; ++i)
+    {
+      Pass& pass = passes[i];
+      pass.compute = random() % 3 == 0;
+      for (uint32 read = 0; read < 3; ++read)
+      {
+        pass.reads.push_back(random() % resource_count);
+      }
+      pass.writes.push_back(random() % resource_count);
+      if (random() % 2)
+      {
+        pass.writes.push_back(random() % resource_count);
+      }
+    }
+    return passes;
+  }
+
+  ResourceState getWriteState(const Pass& pass) { return pass.compute ? ResourceState::UnorderedAccess : ResourceState::RenderTarget; }
+  ResourceState getReadState(const Pass& pass) { return pass.compute ? ResourceState::NonPixelShaderResource : ResourceState::PixelShaderResource; }
+}
+
+int main()
+{
+  checkTracker();
+  Log::info("Tracker checks: %s\n", checks_passed ? "passed" : "failed");
+
+  std::vector<Pass> passes = makePasses();
+  CommandStream stream;
+  NullCommandList command_list(CommandListType::Direct);
+
+  // Hand written: every pass moves what it uses out of common and back, one call per barrier.
+  uint64 manual_barriers = 0;
+  Log::info("%u passes over %u textures:\n", pass_count, resource_count);
+  runBenchmark("Hand written barriers", 20000, [&](uint64)
+  {
+    command_list.reset(&stream);
+    for (const Pass& pass : passes)
+    {
+      for (int direction = 0; direction < 2; ++direction)
+      {
+        for (uint32 resource : pass.reads)
+        {
+          ResourceBarrier barrier = direction == 0 ? ResourceBarrier::transition(resource, ResourceState::Common, getReadState(pass)) : ResourceBarrier::transition(resource, getReadState(pass), ResourceState::Common);
+          command_list.resourceBarrier(&barrier, 1);
+          manual_barriers++;
+        }
+        for (uint32 resource : pass.writes)
+        {
+          ResourceBarrier barrier = direction == 0 ? ResourceBarrier::transition(resource, ResourceState::Common, getWriteState(pass)) : ResourceBarrier::transition(resource, getWriteState(pass), ResourceState::Common);
+          command_list.resourceBarrier(&barrier, 1);
+          manual_barriers++;
+        }
+        if (direction == 0)
+        {
+          command_list.dispatch(1, 1, 1);
+        }
+      }
+    }
+    command_list.close();
+  });
+  uint64 manual_calls = manual_barriers;
+
+  ResourceStateTracker tracker;
+  for (uint32 resource = 0; resource < resource_count; ++resource)
+  {
+    tracker.registerResource(resource, ResourceState::Common);
+  }
+
+  runBenchmark("ResourceStateTracker", 20000, [&](uint64)
+  {
+    command_list.reset(&stream);
+    for (uint32 i = 0; i < pass_count; ++i)
+    {
+      const Pass& pass = passes[i];
+      for (uint32 resource : pass.reads)
+      {
+        tracker.require(resource, getReadState(pass));
+      }
+      for (uint32 resource : pass.writes)
+      {
+        tracker.require(resource, getWriteState(pass));
+      }
+      // What the next pass reads can start transitioning now.
+      if (i + 1 < pass_count)
+      {
+        for (uint32 resource : passes[i + 1].reads)
+        {
+          bool used = false;
+          for (uint32 other : pass.reads)
+          {
+            used = used || other == resource;
+          }
+          for (uint32 other : pass.writes)
+          {
+            used = used || other == resource;
+          }
+          if (!used)
+          {
+            tracker.prepare(resource, getReadState(passes[i + 1]));
+          }
+        }
+      }
+      tracker.flush(command_list);
+      command_list.dispatch(1, 1, 1);
+    }
+    command_list.close();
+  });
+
+  const ResourceStateTracker::Stats& stats = tracker.getStats();
+  double frames = 20000.0;
+  Log::info("%-24s %10s %10s %10s\n", "per frame", "barriers", "calls", "split");
+  Log::info("%-24s %10.1f %10.1f %10.1f\n", "Hand written", manual_barriers / frames, manual_calls / frames, 0.0);
+  Log::info("%-24s %10.1f %10.1f %10.1f\n", "ResourceStateTracker", stats.barriers / frames, stats.flushes / frames, stats.split_barriers / frames);
+  Log::info("Requirements elided: %.1f%%\n", 100.0 * stats.elided / stats.requests);
+
+  return checks_passed ? 0 : 1;
+}
\ No newline at end of file
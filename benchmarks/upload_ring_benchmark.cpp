@@ -0,0 +1,174 @@
+#include "benchmark.h"
+
+#include <jobs/job_system.h>
+#include <render/null_device_resources.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+  constexpr uint32 draws_per_frame = 3000;
+  constexpr uint64 upload_buffer_size = 4 * 1024 * 1024;
+
+  struct alignas(16) ObjectConstants
+  {
+    float world[16];
+    uint64 frame;
+    uint32 draw;
+  };
+
+  struct RecordedFrame
+  {
+    uint64 frame;
+    std::vector<ObjectConstants*> constants;
+  };
+
+  // Baseline: the same ring bump behind a mutex.
+  struct LockedBump
+  {
+    std::mutex mutex;
+    std::vector<uint8> memory = std::vector<uint8>(upload_buffer_size);
+    uint64 head { 0 };
+
+    uint8* allocate(uint64 size)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      uint64 offset = alignUp(head, UploadRing::constant_buffer_alignment) % upload_buffer_size;
+      if (offset + size > upload_buffer_size)
+      {
+        offset = 0;
+      }
+      head = offset + size;
+      return memory.data() + offset;
+    }
+  };
+
+  // Frames still on the GPU must see the constants they were recorded with.
+  uint32 countOverwrittenConstants(std::deque<RecordedFrame>& recorded_frames, uint32 frames_in_flight)
+  {
+    while (recorded_frames.size() > frames_in_flight)
+    {
+      recorded_frames.pop_front();
+    }
+
+    uint32 overwritten = 0;
+    for (const RecordedFrame& recorded : recorded_frames)
+    {
+      for (const ObjectConstants* constants : recorded.constants)
+      {
+        overwritten += constants->frame != recorded.frame;
+      }
+    }
+    return overwritten;
+  }
+}
+
+int main()
+{
+  NullDeviceResources::Settings settings;
+  settings.gpu_time_per_submit = std::chrono::microseconds(500);
+
+  NullDeviceResources device_resources(settings);
+  device_resources.setFrameCount(3);
+  device_resources.setUploadBufferSize(upload_buffer_size);
+  device_resources.loadPipeline(SurfaceDesc { nullptr, 1280, 720, false });
+
+  UploadRing& upload_ring = device_resources.getUploadRing();
+  std::deque<RecordedFrame> recorded_frames;
+  uint32 overwritten = 0;
+  uint64 peak_used = 0;
+
+  Log::info("%u constant buffers of %zu bytes per frame, 0.5 ms GPU frame, %u frames in flight:\n", draws_per_frame, sizeof(ObjectConstants), device_resources.getFrameCount());
+  runBenchmark("UploadRing frame", 2000, [&](uint64 frame)
+  {
+    CommandList& command_list = device_resources.beginFrame();
+    overwritten += countOverwrittenConstants(recorded_frames, device_resources.getFramesInFlight());
+
+    RecordedFrame& recorded = recorded_frames.emplace_back();
+    recorded.frame = frame;
+    for (uint32 draw = 0; draw < draws_per_frame; ++draw)
+    {
+      ObjectConstants constants {};
+      constants.frame = frame;
+      constants.draw = draw;
+      UploadAllocation allocation = upload_ring.upload(constants);
+      if (allocation.isValid())
+      {
+        command_list.setGraphicsRootConstantBufferView(1, allocation.gpu_address);
+        recorded.constants.push_back(reinterpret_cast<ObjectConstants*>(allocation.cpu_address));
+      }
+    }
+    peak_used = std::max(peak_used, upload_ring.getUsed());
+
+    device_resources.endFrame(false, false);
+  });
+  device_resources.flush();
+  Log::info("    peak %.1f KB of %.1f KB, %llu failed allocations, %u overwritten while in flight\n",
+    peak_used / 1024.0, upload_buffer_size / 1024.0, upload_ring.getFailedAllocations(), overwritten);
+
+  bool passed = overwritten == 0 && upload_ring.getFailedAllocations() == 0;
+
+  // Allocation cost alone on a ring of its own, retired every frame.
+  std::vector<uint8> memory(upload_buffer_size);
+  UploadRing ring;
+  ring.initialize(UploadMemory { memory.data(), 0x100000000ull, invalid_id, upload_buffer_size });
+
+  ObjectConstants constants {};
+  uint64 fence_value = 0;
+  Log::info("%u allocations per frame:\n", draws_per_frame);
+  runBenchmark("UploadRing::upload", 2000, [&](uint64)
+  {
+    for (uint32 draw = 0; draw < draws_per_frame; ++draw)
+    {
+      doNotOptimize(ring.upload(constants).gpu_address);
+    }
+    ring.endFrame(++fence_value);
+    ring.retire(fence_value);
+  });
+
+  LockedBump locked_bump;
+  runBenchmark("mutex and bump", 2000, [&](uint64)
+  {
+    for (uint32 draw = 0; draw < draws_per_frame; ++draw)
+    {
+      uint8* cpu_address = locked_bump.allocate(sizeof(ObjectConstants));
+      std::memcpy(cpu_address, &constants, sizeof(constants));
+      doNotOptimize(cpu_address);
+    }
+  });
+
+  JobSystem job_system;
+  job_system.initialize(JobSystem::getDefaultWorkerCount());
+  Log::info("%u allocations per frame from %u threads:\n", draws_per_frame, job_system.getConcurrency());
+  runBenchmark("UploadRing::upload", 2000, [&](uint64)
+  {
+    job_system.parallelFor(draws_per_frame, [&](uint32 begin, uint32 end)
+    {
+      for (uint32 draw = begin; draw < end; ++draw)
+      {
+        doNotOptimize(ring.upload(constants).gpu_address);
+      }
+    });
+    ring.endFrame(++fence_value);
+    ring.retire(fence_value);
+  });
+  runBenchmark("mutex and bump", 2000, [&](uint64)
+  {
+    job_system.parallelFor(draws_per_frame, [&](uint32 begin, uint32 end)
+    {
+      for (uint32 draw = begin; draw < end; ++draw)
+      {
+        uint8* cpu_address = locked_bump.allocate(sizeof(ObjectConstants));
+        std::memcpy(cpu_address, &constants, sizeof(constants));
+        doNotOptimize(cpu_address);
+      }
+    });
+  });
+  job_system.shutdown();
+
+  return passed && ring.getFailedAllocations() == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -1,7 +1,17 @@
 #pragma once
 
 #include <common/pch.h>
+#include <config.h>
+#include <config_watcher.h>
 #include <device_resources.h>
+#include <frame_pipeline.h>
+#include <jobs/job_system.h>
+#include <profiler/frame_statistics.h>
+#include <common/timer.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace engine
 {
@@ -13,23 +23,45 @@ namespace engine
     
     void run();
 
+    JobSystem& getJobSystem() { return job_system; }
+    const FrameStatistics& getFrameStatistics() const { return frame_statistics; }
+
   private:
+    void runThreaded();
     void initialize();
     void update();
     void render();
     void destroy();
 
+    void watchConfig();
+    void applyPendingSettings();
+
     void resizeWindow(uint32 width, uint32 height);
 
     static LRESULT CALLBACK wndProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
 
   private:
     class Window* window { nullptr };
-    DeviceResources device_resources;
+    std::unique_ptr<DeviceResources> device_resources;
+    JobSystem job_system;
+    std::unique_ptr<FramePipeline> frame_pipeline;
     HINSTANCE instance;
 
     bool tearing_supported;
-    bool vsync;
     int cmd_show;
+    uint32 worker_count;
+    bool threaded_rendering;
+    uint32 frame_queue_size;
+    std::string trace_path;
+    FrameStatistics frame_statistics;
+    Timer frame_timer;
+    RenderSettingsData render_settings;
+
+    ConfigWatcher<Data> config_watcher;
+    // Settings changed by a reload that render() applies between frames, it owns the device.
+    std::mutex pending_settings_mutex;
+    std::atomic<bool> has_pending_settings { false };
+    RenderSettingsData pending_render_settings;
+    uint32 pending_worker_count { 0 };
   };
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <common/binary_log.h>
+#include <common/log_format.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+  // Deferred logging backend. Producers pack the arguments into a record in their own single
+  // producer ring, a background thread merges the rings by timestamp, formats and writes in batches.
+  // A producer only waits when its ring is full.
+  class AsyncLog
+  {
+  public:
+    static const uint32 records_per_thread = 1024;
+    static const uint32 max_threads = 64;
+
+    AsyncLog();
+    ~AsyncLog();
+
+    void start();
+    // Drains everything logged before the call.
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Returns false when the calling thread could not get a ring, the caller logs synchronously then.
+    bool push(LogLevel level, const char* format, va_list args);
+    // Reserves a record in the calling thread's ring with timestamp, level and format filled in, the
+    // caller packs the payload and commits it. Returns nullptr when push would have failed.
+    LogRecord* beginRecord(LogLevel level, const char* format);
+    void commitRecord(LogRecord* record);
+    // Blocks until everything pushed before the call has been written.
+    void flush();
+
+    // While a binary output is open every record goes there unformatted, warnings and errors are
+    // still written to the console as text. An empty path closes it.
+    bool setBinaryOutput(const std::string& path);
+    bool hasBinaryOutput();
+
+    uint64 getWrittenCount() const { return written_records.load(std::memory_order_relaxed); }
+    uint64 getFullWaitCount() const { return full_waits.load(std::memory_order_relaxed); }
+
+  private:
+    struct ThreadQueue
+    {
+      alignas(64) std::atomic<uint64> write_index { 0 };
+      // Set between beginRecord and commitRecord, stop waits for it before the final drain.
+      std::atomic<bool> writing { false };
+      alignas(64) std::atomic<uint64> read_index { 0 };
+      std::atomic<bool> owned { true };
+      LogRecord records[records_per_thread];
+    };
+
+    ThreadQueue* acquireQueue();
+    void consumerMain();
+    uint32 drain();
+    uint32 drainLocked();
+    void wake();
+
+  private:
+    std::unique_ptr<ThreadQueue> queues[max_threads];
+    std::atomic<uint32> queue_count { 0 };
+    std::mutex registration_mutex;
+    uint32 instance_id;
+
+    std::atomic<bool> running { false };
+    std::thread consumer;
+    std::mutex wake_mutex;
+    std::condition_variable wake_condition;
+    std::condition_variable drained_condition;
+    uint64 drain_cycles { 0 };
+    bool wake_requested { false };
+
+    // Held by drain, it runs on the consumer thread and once more in stop.
+    std::mutex drain_mutex;
+    BinaryLogWriter binary_output;
+    std::vector<const LogRecord*> batch;
+    std::string output[2];
+
+    std::atomic<uint64> written_records { 0 };
+    std::atomic<uint64> full_waits { 0 };
+  };
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <common/reflection.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace engine
+{
+  // Compact native-endian encoding of reflected types: arithmetic values as their bytes, enums as
+  // their underlying type, strings and vectors as a uint32 count followed by the elements and
+  // reflected structs as their fields in declaration order. There are no names or tags, readers
+  // have to check the schema hash of the writer first.
+  class BinaryWriter
+  {
+  public:
+    explicit BinaryWriter(std::vector<uint8>& buffer)
+      : buffer(buffer)
+    {
+    }
+
+    template<typename T>
+    void write(const T& value)
+    {
+      if constexpr (is_reflected_v<T>)
+      {
+        reflectFields(value, [this](const char*, const auto& field) { write(field); });
+      }
+      else if constexpr (std::is_same_v<T, std::string>)
+      {
+        write(static_cast<uint32>(value.size()));
+        writeBytes(value.data(), value.size());
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        write(static_cast<uint32>(value.size()));
+        for (const auto& element : value)
+        {
+          write(element);
+        }
+      }
+      else if constexpr (std::is_enum_v<T>)
+      {
+        write(static_cast<std::underlying_type_t<T>>(value));
+      }
+      else
+      {
+        static_assert(std::is_arithmetic_v<T>, "Type can't be written to a binary archive.");
+        writeBytes(&value, sizeof(T));
+      }
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+      const uint8* bytes = static_cast<const uint8*>(data);
+      buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+  private:
+    std::vector<uint8>& buffer;
+  };
+
+  // Reads what BinaryWriter wrote. Every read is bounds checked, after the first failure the reader
+  // stays failed and leaves the remaining values untouched.
+  class BinaryReader
+  {
+  public:
+    BinaryReader(const uint8* data, uint64 size)
+      : data(data)
+      , size(size)
+    {
+    }
+
+    template<typename T>
+    bool read(T& value)
+    {
+      if constexpr (is_reflected_v<T>)
+      {
+        reflectFields(value, [this](const char*, auto& field) { read(field); });
+      }
+      else if constexpr (std::is_same_v<T, std::string>)
+      {
+        uint32 length = 0;
+        if (read(length) && checkAvailable(length))
+        {
+          value.assign(reinterpret_cast<const char*>(data + offset), length);
+          offset += length;
+        }
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        uint32 count = 0;
+        // Every element takes at least a byte, which bounds the allocation for damaged counts.
+        if (read(count) && checkAvailable(count))
+        {
+          value.resize(count);
+          for (uint32 i = 0; i < count && !failed; ++i)
+          {
+            read(value[i]);
+          }
+        }
+      }
+      else if constexpr (std::is_enum_v<T>)
+      {
+        std::underlying_type_t<T> underlying {};
+        if (read(underlying))
+        {
+          value = static_cast<T>(underlying);
+        }
+      }
+      else
+      {
+        static_assert(std::is_arithmetic_v<T>, "Type can't be read from a binary archive.");
+        if (checkAvailable(sizeof(T)))
+        {
+          memcpy(&value, data + offset, sizeof(T));
+          offset += sizeof(T);
+        }
+      }
+
+      return !failed;
+    }
+
+    bool hasFailed() const { return failed; }
+    bool isAtEnd() const { return offset == size; }
+
+  private:
+    bool checkAvailable(uint64 bytes)
+    {
+      failed = failed || bytes > size - offset;
+      return !failed;
+    }
+
+  private:
+    const uint8* data;
+    uint64 size;
+    uint64 offset { 0 };
+    bool failed { false };
+  };
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <common/log_format.h>
+#include <common/mapped_file.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace engine
+{
+  // Binary log file: a BinaryLogHeader followed by unaligned records, each starting with its uint16
+  // size and uint8 kind. A format record (uint32 id, terminated text) interns a format string the
+  // first time it is used, a message record (uint8 level, uint8 truncated, uint32 format id,
+  // uint64 timestamp) is followed by the packed arguments. A zero size ends the log.
+  struct BinaryLogHeader
+  {
+    static constexpr char magic_value[8] = { 'E', 'N', 'G', 'B', 'L', 'O', 'G', '\0' };
+    static const uint32 current_version = 1;
+
+    char magic[8];
+    uint32 version;
+    uint32 header_size;
+    uint64 start_timestamp;
+  };
+
+  enum class BinaryLogRecordKind : uint8
+  {
+    End = 0,
+    Format = 1,
+    Message = 2
+  };
+
+  // Appends records to a memory-mapped file that grows in chunks, single threaded.
+  class BinaryLogWriter
+  {
+  public:
+    static const uint64 default_chunk_size = 64ull << 20;
+
+    ~BinaryLogWriter();
+
+    bool open(const std::string& path, uint64 chunk_size = default_chunk_size);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    bool write(const LogRecord& record);
+
+    uint64 getMessageCount() const { return message_count; }
+    uint64 getFormatCount() const { return format_count; }
+    uint64 getSize() const { return offset; }
+
+  private:
+    uint32 intern(const LogRecord& record, const char* format);
+    bool writeFormat(uint32 id, const char* format);
+    bool reserve(uint64 size);
+
+  private:
+    MappedFile file;
+    uint64 chunk_size { default_chunk_size };
+    uint64 offset { 0 };
+    uint64 message_count { 0 };
+    uint64 format_count { 0 };
+
+    // Static formats are interned by address, copied formats by text.
+    std::unordered_map<const char*, uint32> pointer_ids;
+    std::unordered_map<std::string, uint32> text_ids;
+  };
+
+  class BinaryLogReader
+  {
+  public:
+    struct Message
+    {
+      uint64 timestamp;
+      LogLevel level;
+      bool truncated;
+      const char* format;
+      const uint8* arguments;
+      uint32 size;
+    };
+
+    bool open(const std::string& path);
+    // Returns false at the end of the log, getError() tells a clean end from a damaged file.
+    bool next(Message& message);
+
+    uint64 getStartTimestamp() const { return start_timestamp; }
+    const std::string& getError() const { return error; }
+
+  private:
+    bool fail(const std::string& message);
+
+  private:
+    MappedFile file;
+    uint64 offset { 0 };
+    uint64 start_timestamp { 0 };
+    std::unordered_map<uint32, const char*> formats;
+    std::string error;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <string>
+
+namespace engine
+{
+  // Tells whether a file may have changed. Watches the file's directory, since editors often save
+  // by renaming a new file over the old one: inotify on Linux, a change notification on Windows and
+  // comparing size and modification time elsewhere. False positives are possible, callers compare
+  // the file itself before acting.
+  class FileWatcher
+  {
+  public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watch(const std::string& path);
+    void stop();
+    bool isWatching() const { return watching; }
+
+    // Never blocks, returns true once for any number of changes since the previous call.
+    bool poll();
+
+  private:
+    std::string path;
+    std::string file_name;
+    bool watching { false };
+
+#if defined(_WIN32)
+    void* change_handle { nullptr };
+#elif defined(__linux__)
+    int inotify_descriptor { -1 };
+#else
+    uint64 last_size { 0 };
+    int64 last_time { 0 };
+#endif
+  };
+}
\ No newline at end of file
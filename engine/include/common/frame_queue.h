@@ -0,0 +1,82 @@
+#pragma once
+
+#include <common/semaphore.h>
+
+#include <cassert>
+#include <vector>
+
+namespace engine
+{
+  // Bounded single-producer single-consumer queue of in-place packets. The producer blocks once
+  // capacity packets are in flight, the consumer blocks while the queue is empty. The fast path
+  // is a pair of atomic operations, threads only sleep when they actually have to wait.
+  template<typename T>
+  class FrameQueue
+  {
+  public:
+    explicit FrameQueue(uint32 capacity)
+      : packets(capacity)
+      , free_slots(static_cast<int32>(capacity))
+      , filled_slots(0)
+    {
+      assert(capacity > 0);
+    }
+
+    // Producer: returns the next packet to fill, nullptr once the queue is closed.
+    T* beginWrite()
+    {
+      free_slots.wait();
+      if (closed.load(std::memory_order_acquire))
+      {
+        free_slots.signal();
+        return nullptr;
+      }
+
+      return &packets[write_index];
+    }
+
+    void endWrite()
+    {
+      write_index = (write_index + 1) % packets.size();
+      filled_slots.signal();
+    }
+
+    // Consumer: returns the oldest packet, nullptr once the queue is closed.
+    T* beginRead()
+    {
+      filled_slots.wait();
+      if (closed.load(std::memory_order_acquire))
+      {
+        filled_slots.signal();
+        return nullptr;
+      }
+
+      return &packets[read_index];
+    }
+
+    void endRead()
+    {
+      read_index = (read_index + 1) % packets.size();
+      free_slots.signal();
+    }
+
+    // Wakes both sides, every following begin call returns nullptr.
+    void close()
+    {
+      closed.store(true, std::memory_order_release);
+      free_slots.signal();
+      filled_slots.signal();
+    }
+
+    uint32 getCapacity() const { return static_cast<uint32>(packets.size()); }
+
+  private:
+    std::vector<T> packets;
+    Semaphore free_slots;
+    Semaphore filled_slots;
+    std::atomic<bool> closed { false };
+
+    alignas(64) size_t write_index { 0 };
+    alignas(64) size_t read_index { 0 };
+  };
+}
\ No newline at end of file
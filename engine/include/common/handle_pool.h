@@ -0,0 +1,197 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+  // 32-bit reference into a HandlePool: 20 bits slot index, 12 bits generation. The tag keeps
+  // handles of different pools apart.
+  template<typename Tag>
+  struct Handle
+  {
+    static constexpr uint32 index_bits = 20;
+    static constexpr uint32 index_mask = (1u << index_bits) - 1;
+    static constexpr uint32 generation_mask = (1u << (32 - index_bits)) - 1;
+    static constexpr uint32 invalid_value = ~0u;
+
+    uint32 value { invalid_value };
+
+    Handle() = default;
+    explicit Handle(uint32 value)
+      : value(value)
+    {
+    }
+
+    Handle(uint32 index, uint32 generation)
+      : value((generation << index_bits) | index)
+    {
+    }
+
+    uint32 getIndex() const { return value & index_mask; }
+    uint32 getGeneration() const { return value >> index_bits; }
+    bool isValid() const { return value != invalid_value; }
+
+    bool operator==(Handle other) const { return value == other.value; }
+    bool operator!=(Handle other) const { return value != other.value; }
+  };
+
+  // Objects addressed by generational handles. Objects are stored densely, iteration walks a plain
+  // array, and destroy moves the last object into the hole. Slots are indexed by the handle and
+  // recycled through a free list, every reuse bumps the slot's generation so handles to destroyed
+  // objects are detected. A slot whose generation would wrap is retired instead of reused.
+  // create, destroy and lookup are O(1).
+  //
+  // Not synchronized and there is no state shared between pools. Lookups and iteration only read,
+  // jobs may run them in parallel as long as no create or destroy runs at the same time.
+  template<typename T, typename Tag = T>
+  class HandlePool
+  {
+  public:
+    using HandleType = Handle<Tag>;
+
+    // The all-ones index belongs to the invalid handle.
+    static constexpr uint32 max_slots = HandleType::index_mask;
+
+    void reserve(uint32 capacity)
+    {
+      objects.reserve(capacity);
+      object_slots.reserve(capacity);
+      slots.reserve(capacity);
+    }
+
+    template<typename... Arguments>
+    HandleType create(Arguments&&... arguments)
+    {
+      uint32 index = free_slot;
+      if (index != invalid_index)
+      {
+        free_slot = slots[index].next_free;
+      }
+      else
+      {
+        assert(slots.size() < max_slots && "Handle pool is full.");
+        index = static_cast<uint32>(slots.size());
+        slots.push_back(Slot {});
+      }
+
+      Slot& slot = slots[index];
+      slot.object_index = static_cast<uint32>(objects.size());
+      objects.emplace_back(std::forward<Arguments>(arguments)...);
+      object_slots.push_back(index);
+
+      return HandleType(index, slot.generation);
+    }
+
+    // Returns false for stale or invalid handles.
+    bool destroy(HandleType handle)
+    {
+      Slot* slot = findSlot(handle);
+      if (!slot)
+      {
+        return false;
+      }
+
+      uint32 object_index = slot->object_index;
+      uint32 last_index = static_cast<uint32>(objects.size() - 1);
+      if (object_index != last_index)
+      {
+        objects[object_index] = std::move(objects[last_index]);
+        object_slots[object_index] = object_slots[last_index];
+        slots[object_slots[object_index]].object_index = object_index;
+      }
+      objects.pop_back();
+      object_slots.pop_back();
+
+      slot->object_index = invalid_index;
+      slot->generation = (slot->generation + 1) & HandleType::generation_mask;
+      if (slot->generation != 0)
+      {
+        slot->next_free = free_slot;
+        free_slot = handle.getIndex();
+      }
+
+      return true;
+    }
+
+    // Null for stale or invalid handles. The pointer is valid until the next create or destroy.
+    T* get(HandleType handle)
+    {
+      Slot* slot = findSlot(handle);
+      return slot ? &objects[slot->object_index] : nullptr;
+    }
+
+    const T* get(HandleType handle) const
+    {
+      return const_cast<HandlePool*>(this)->get(handle);
+    }
+
+    bool isValid(HandleType handle) const { return get(handle) != nullptr; }
+
+    void clear()
+    {
+      objects.clear();
+      object_slots.clear();
+      // Every slot moves on to the next generation, old handles stay detectable.
+      free_slot = invalid_index;
+      for (uint32 index = static_cast<uint32>(slots.size()); index-- > 0;)
+      {
+        Slot& slot = slots[index];
+        if (slot.object_index != invalid_index)
+        {
+          slot.object_index = invalid_index;
+          slot.generation = (slot.generation + 1) & HandleType::generation_mask;
+        }
+        if (slot.generation != 0)
+        {
+          slot.next_free = free_slot;
+          free_slot = index;
+        }
+      }
+    }
+
+    // Dense iteration, destroy changes the order.
+    T* begin() { return objects.data(); }
+    T* end() { return objects.data() + objects.size(); }
+    const T* begin() const { return objects.data(); }
+    const T* end() const { return objects.data() + objects.size(); }
+    T& operator[](uint32 index) { return objects[index]; }
+    const T& operator[](uint32 index) const { return objects[index]; }
+    // Handle of the object at a dense index.
+    HandleType getHandle(uint32 index) const { return HandleType(object_slots[index], slots[object_slots[index]].generation); }
+
+    uint32 size() const { return static_cast<uint32>(objects.size()); }
+    bool empty() const { return objects.empty(); }
+
+  private:
+    static constexpr uint32 invalid_index = ~0u;
+
+    struct Slot
+    {
+      uint32 object_index { invalid_index };
+      uint32 generation { 1 };
+      uint32 next_free { invalid_index };
+    };
+
+    Slot* findSlot(HandleType handle)
+    {
+      uint32 index = handle.getIndex();
+      if (index >= slots.size())
+      {
+        return nullptr;
+      }
+
+      Slot& slot = slots[index];
+      return slot.generation == handle.getGeneration() && slot.object_index != invalid_index ? &slot : nullptr;
+    }
+
+  private:
+    std::vector<T> objects;
+    std::vector<uint32> object_slots;
+    std::vector<Slot> slots;
+    uint32 free_slot { invalid_index };
+  };
+}
\ No newline at end of file
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <common/json_reader.h>
+#include <common/mapped_file.h>
+#include <common/reflection.h>
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace engine
+{
+  struct JsonIssue
+  {
+    enum class Kind
+    {
+      Syntax,
+      Type,
+      UnknownKey
+    };
+
+    Kind kind;
+    JsonPosition position;
+    // Dotted member path, array elements as [index].
+    std::string path;
+    std::string message;
+
+    bool isError() const { return kind != Kind::UnknownKey; }
+    // "line:column: path: message", parts that do not apply are left out.
+    std::string toString() const;
+  };
+
+  // Reads JSON straight into reflected types, see common/reflection.h. Members are matched by name,
+  // missing ones keep their current value and unknown ones are reported and skipped. A value of the
+  // wrong type is reported and skipped as well, the rest of the document is still read. Syntax
+  // errors end the read.
+  class JsonDeserializer
+  {
+  public:
+    static const uint32 max_path_depth = 32;
+
+    explicit JsonDeserializer(JsonReader& reader)
+      : reader(reader)
+    {
+    }
+
+    // Reads a whole document, returns false on syntax or type errors.
+    template<typename T>
+    bool read(T& value)
+    {
+      readValue(value);
+      reader.finish();
+      if (reader.hasError())
+      {
+        report(JsonIssue::Kind::Syntax, reader.getErrorPosition(), reader.getError().c_str());
+      }
+
+      return !hasErrors();
+    }
+
+    const std::vector<JsonIssue>& getIssues() const { return issues; }
+    bool hasErrors() const { return error_count > 0; }
+
+  private:
+    struct PathSegment
+    {
+      std::string_view key;
+      uint32 index;
+    };
+
+    template<typename T>
+    void readValue(T& value)
+    {
+      JsonValueType type = reader.peek();
+      if (type == JsonValueType::Invalid)
+      {
+        // Lets the reader produce the syntax error.
+        reader.skipValue();
+        return;
+      }
+
+      if constexpr (is_reflected_v<T>)
+      {
+        if (type != JsonValueType::Object)
+        {
+          return mismatch("an object");
+        }
+
+        std::string_view key;
+        reader.beginObject();
+        while (reader.nextMember(key))
+        {
+          pushPath(key, 0);
+          bool found = false;
+          reflectFields(value, [&](const char* name, auto& field)
+          {
+            if (!found && key == name)
+            {
+              found = true;
+              readValue(field);
+            }
+          });
+          if (!found)
+          {
+            report(JsonIssue::Kind::UnknownKey, reader.getTokenPosition(), "unknown key");
+            reader.skipValue();
+          }
+          popPath();
+        }
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        if (type != JsonValueType::Array)
+        {
+          return mismatch("an array");
+        }
+
+        value.clear();
+        reader.beginArray();
+        for (uint32 index = 0; reader.nextElement(); ++index)
+        {
+          pushPath(std::string_view(), index);
+          value.emplace_back();
+          readValue(value.back());
+          popPath();
+        }
+      }
+      else if constexpr (std::is_same_v<T, std::string>)
+      {
+        if (type != JsonValueType::String)
+        {
+          return mismatch("a string");
+        }
+        reader.readString(value);
+      }
+      else if constexpr (std::is_same_v<T, bool>)
+      {
+        if (type != JsonValueType::Bool)
+        {
+          return mismatch("true or false");
+        }
+        reader.readBool(value);
+      }
+      else if constexpr (std::is_enum_v<T> && is_reflected_enum_v<T>)
+      {
+        if (type != JsonValueType::String)
+        {
+          return mismatch("an enum name");
+        }
+
+        std::string_view name;
+        if (reader.readString(name))
+        {
+          for (const auto& [enum_value, enum_name] : reflectEnumValues(T {}))
+          {
+            if (name == enum_name)
+            {
+              value = enum_value;
+              return;
+            }
+          }
+          report(JsonIssue::Kind::Type, reader.getTokenPosition(), "unknown enum value");
+        }
+      }
+      else if constexpr (std::is_enum_v<T>)
+      {
+        std::underlying_type_t<T> underlying = static_cast<std::underlying_type_t<T>>(value);
+        readValue(underlying);
+        value = static_cast<T>(underlying);
+      }
+      else
+      {
+        static_assert(std::is_arithmetic_v<T>, "Type can't be read from JSON, reflect it with ENGINE_REFLECT.");
+        if (type != JsonValueType::Number)
+        {
+          return mismatch("a number");
+        }
+
+        std::string_view text;
+        if (reader.readNumber(text))
+        {
+          readNumber(text, value);
+        }
+      }
+    }
+
+    template<typename T>
+    void readNumber(std::string_view text, T& value)
+    {
+      const char* end = text.data() + text.size();
+      if constexpr (std::is_floating_point_v<T>)
+      {
+        double parsed = 0.0;
+        auto result = std::from_chars(text.data(), end, parsed);
+        if (result.ec != std::errc() || result.ptr != end || std::abs(parsed) > static_cast<double>(std::numeric_limits<T>::max()))
+        {
+          return report(JsonIssue::Kind::Type, reader.getTokenPosition(), "number out of range");
+        }
+        value = static_cast<T>(parsed);
+      }
+      else
+      {
+        T parsed = 0;
+        auto result = std::from_chars(text.data(), end, parsed);
+        if (result.ptr != end && result.ec == std::errc())
+        {
+          return report(JsonIssue::Kind::Type, reader.getTokenPosition(), "expected an integer");
+        }
+        if (result.ec != std::errc())
+        {
+          return report(JsonIssue::Kind::Type, reader.getTokenPosition(), text[0] == '-' && std::is_unsigned_v<T> ? "expected an unsigned integer" : "integer out of range");
+        }
+        value = parsed;
+      }
+    }
+
+    void mismatch(const char* expected);
+    void report(JsonIssue::Kind kind, JsonPosition position, const char* message);
+    void pushPath(std::string_view key, uint32 index);
+    void popPath();
+
+  private:
+    JsonReader& reader;
+    std::vector<JsonIssue> issues;
+    uint32 error_count { 0 };
+
+    // Keys are views into the input, escaped keys may be overwritten by a later escaped string.
+    PathSegment path[max_path_depth];
+    uint32 path_depth { 0 };
+  };
+
+  // Reads a JSON file through a read-only mapping.
+  template<typename T>
+  bool readJsonFile(const std::string& path, T& value, std::vector<JsonIssue>& issues)
+  {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::Read))
+    {
+      issues.push_back({ JsonIssue::Kind::Syntax, JsonPosition { 0, 0 }, std::string(), "can't open " + path });
+      return false;
+    }
+
+    JsonReader reader(reinterpret_cast<const char*>(file.data()), file.size());
+    JsonDeserializer deserializer(reader);
+    bool result = deserializer.read(value);
+    issues = deserializer.getIssues();
+
+    return result;
+  }
+}
\ No newline at end of file
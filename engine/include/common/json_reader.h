@@ -0,0 +1,89 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <string>
+#include <string_view>
+
+namespace engine
+{
+  enum class JsonValueType
+  {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object,
+    Invalid
+  };
+
+  // 1-based, columns count bytes.
+  struct JsonPosition
+  {
+    uint32 line { 1 };
+    uint32 column { 1 };
+  };
+
+  // Pull tokenizer over a JSON text in memory, the caller walks the structure it expects and never
+  // gets a tree. Strings without escapes are handed out as views into the input. The first syntax
+  // error sticks: every later call fails and getError() tells where it happened.
+  class JsonReader
+  {
+  public:
+    static const uint32 max_depth = 256;
+
+    JsonReader(const char* data, size_t size);
+
+    // Type of the next value without consuming it.
+    JsonValueType peek();
+
+    bool beginObject();
+    // Reads the next key and its ':', returns false once the closing '}' was consumed.
+    bool nextMember(std::string_view& key);
+    bool beginArray();
+    // Returns false once the closing ']' was consumed.
+    bool nextElement();
+
+    bool readNull();
+    bool readBool(bool& value);
+    // The number token as written, conversion is up to the caller.
+    bool readNumber(std::string_view& text);
+    bool readString(std::string& value);
+    // Escaped strings are decoded into a scratch buffer that the next escaped string reuses.
+    bool readString(std::string_view& value);
+    bool skipValue();
+    // Only whitespace may follow the document.
+    bool finish();
+
+    // Start of the value or key read or peeked last.
+    JsonPosition getTokenPosition() const { return token_position; }
+
+    bool hasError() const { return !error.empty(); }
+    const std::string& getError() const { return error; }
+    JsonPosition getErrorPosition() const { return error_position; }
+
+  private:
+    bool skipWhitespace();
+    bool expect(char c);
+    bool beginToken();
+    bool scanString(std::string_view& raw, bool& escaped);
+    bool decodeString(std::string_view raw, std::string& output);
+    bool skipValue(uint32 depth);
+    bool fail(const char* message);
+    JsonPosition getPosition(size_t offset) const;
+
+  private:
+    const char* data;
+    size_t size;
+    size_t offset { 0 };
+    size_t line_start { 0 };
+    uint32 line { 1 };
+    bool expect_first { false };
+
+    JsonPosition token_position;
+    std::string scratch;
+    std::string error;
+    JsonPosition error_position;
+  };
+}
\ No newline at end of file
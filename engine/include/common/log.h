@@ -1,12 +1,57 @@
 #pragma once
 
+#include <common/types.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+#if defined(__GNUC__)
+#define LOG_PRINTF_FORMAT(format_index, first_argument) __attribute__((format(printf, format_index, first_argument)))
+#else
+#define LOG_PRINTF_FORMAT(format_index, first_argument)
+#endif
+
 namespace engine
 {
+  struct LogRecord;
+
+  enum class LogLevel : uint8
+  {
+    Info,
+    Warning,
+    Error
+  };
+
   class Log
   {
   public:
-    static void info(const char* format, ...);
-    static void warning(const char* format, ...);
-    static void error(const char* format, ...);
+    // Formats known at compile time should go through the checked LOG_* macros in common/log_checked.h,
+    // these scan the format at runtime and remain for existing callers and runtime formats.
+    static void info(const char* format, ...) LOG_PRINTF_FORMAT(1, 2);
+    static void warning(const char* format, ...) LOG_PRINTF_FORMAT(1, 2);
+    static void error(const char* format, ...) LOG_PRINTF_FORMAT(1, 2);
+    static void write(LogLevel level, const char* format, va_list args);
+
+    // Records with pre-packed arguments. beginRecord returns nullptr when logging is synchronous,
+    // the caller packs into its own record and passes it to writeRecord instead.
+    static LogRecord* beginRecord(LogLevel level, const char* format);
+    static void commitRecord(LogRecord* record);
+    static void writeRecord(const LogRecord& record);
+
+    // Async logging moves formatting and console output to a background thread, the call only packs
+    // the arguments. Disabling it drains everything logged so far.
+    static void setAsync(bool enabled);
+    static bool isAsync();
+    // Returns once everything logged before the call has been written.
+    static void flush();
+
+    // Writes records unformatted to a binary file for tools/log_decoder, only warnings and errors
+    // still reach the console. Enables async logging, an empty path or disabling async closes the file.
+    static bool setBinaryOutput(const std::string& path);
+
+    // Info goes to stdout and warnings and errors to stderr unless redirected.
+    static void setOutput(FILE* info_stream, FILE* error_stream);
+    static FILE* getStream(LogLevel level);
   };
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <common/log.h>
+#include <common/log_format.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace engine
+{
+  namespace detail
+  {
+    // Compile-time twin of findLogFormatSpec: one entry per consumed argument, '*' widths and
+    // precisions included.
+    template<uint32 Capacity>
+    struct LogFormatDescriptor
+    {
+      uint32 count { 0 };
+      LogArgumentType types[Capacity] = {};
+      LogArgumentLength lengths[Capacity] = {};
+      char conversions[Capacity] = {};
+    };
+
+    constexpr bool isLogFlag(char c)
+    {
+      return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0' || c == '\'';
+    }
+
+    constexpr bool isLogDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    constexpr uint32 countLogConversions(const char* format)
+    {
+      uint32 count = 0;
+      for (; *format; ++format)
+      {
+        if (*format == '%')
+        {
+          count += 2;
+        }
+      }
+      return count;
+    }
+
+    template<uint32 Capacity>
+    constexpr LogFormatDescriptor<Capacity> parseLogFormat(const char* format)
+    {
+      LogFormatDescriptor<Capacity> descriptor;
+      const char* c = format;
+
+      while (*c)
+      {
+        if (*c++ != '%')
+        {
+          continue;
+        }
+        if (*c == '%')
+        {
+          c++;
+          continue;
+        }
+
+        while (isLogFlag(*c))
+        {
+          c++;
+        }
+        if (*c == '*')
+        {
+          descriptor.types[descriptor.count] = LogArgumentType::Int;
+          descriptor.conversions[descriptor.count++] = '*';
+          c++;
+        }
+        while (isLogDigit(*c))
+        {
+          c++;
+        }
+        if (*c == '.')
+        {
+          c++;
+          if (*c == '*')
+          {
+            descriptor.types[descriptor.count] = LogArgumentType::Int;
+            descriptor.conversions[descriptor.count++] = '*';
+            c++;
+          }
+          while (isLogDigit(*c))
+          {
+            c++;
+          }
+        }
+
+        LogArgumentLength length = LogArgumentLength::Default;
+        switch (*c)
+        {
+        case 'h': length = c[1] == 'h' ? LogArgumentLength::Char : LogArgumentLength::Short; c += c[1] == 'h' ? 2 : 1; break;
+        case 'l': length = c[1] == 'l' ? LogArgumentLength::LongLong : LogArgumentLength::Long; c += c[1] == 'l' ? 2 : 1; break;
+        case 'j': length = LogArgumentLength::IntMax; c++; break;
+        case 'z': length = LogArgumentLength::Size; c++; break;
+        case 't': length = LogArgumentLength::PtrDiff; c++; break;
+        case 'L': length = LogArgumentLength::LongDouble; c++; break;
+        default: break;
+        }
+
+        LogArgumentType type = LogArgumentType::None;
+        switch (*c)
+        {
+        case 'd': case 'i': case 'c': type = LogArgumentType::Int; break;
+        case 'u': case 'o': case 'x': case 'X': type = LogArgumentType::Unsigned; break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+          type = length == LogArgumentLength::LongDouble ? LogArgumentType::LongDouble : LogArgumentType::Double;
+          break;
+        case 's': type = LogArgumentType::String; break;
+        case 'p': type = LogArgumentType::Pointer; break;
+        case 'n': type = LogArgumentType::WriteCount; break;
+        default: break;
+        }
+
+        // Unsupported conversions are kept as None so the argument check rejects them.
+        descriptor.types[descriptor.count] = type;
+        descriptor.lengths[descriptor.count] = length;
+        descriptor.conversions[descriptor.count++] = *c;
+        if (*c)
+        {
+          c++;
+        }
+      }
+
+      return descriptor;
+    }
+
+    template<typename T>
+    constexpr bool isLogString()
+    {
+      using Decayed = std::decay_t<T>;
+      return std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*>
+        || std::is_same_v<Decayed, std::string> || std::is_same_v<Decayed, std::string_view>;
+    }
+
+    constexpr size_t getLogIntegerSize(LogArgumentLength length)
+    {
+      switch (length)
+      {
+      case LogArgumentLength::Long: return sizeof(long);
+      case LogArgumentLength::LongLong: return sizeof(long long);
+      case LogArgumentLength::IntMax: return sizeof(intmax_t);
+      case LogArgumentLength::Size: return sizeof(size_t);
+      case LogArgumentLength::PtrDiff: return sizeof(ptrdiff_t);
+      case LogArgumentLength::LongDouble: return 0;
+      default: return sizeof(int);
+      }
+    }
+
+    // Integers must fit the size the length modifier implies, 64-bit values need "ll".
+    template<typename T>
+    constexpr bool isLogArgumentCompatible(LogArgumentType type, LogArgumentLength length, char conversion)
+    {
+      using Decayed = std::decay_t<T>;
+      switch (type)
+      {
+      case LogArgumentType::Int:
+      case LogArgumentType::Unsigned:
+        if (conversion == '*')
+        {
+          return std::is_integral_v<Decayed> && sizeof(Decayed) <= sizeof(int);
+        }
+        return (std::is_integral_v<Decayed> || std::is_enum_v<Decayed>) && sizeof(Decayed) <= getLogIntegerSize(length);
+      case LogArgumentType::Double:
+        return std::is_same_v<Decayed, float> || std::is_same_v<Decayed, double>;
+      case LogArgumentType::LongDouble:
+        return std::is_same_v<Decayed, long double>;
+      case LogArgumentType::String:
+        return length == LogArgumentLength::Default && isLogString<T>();
+      case LogArgumentType::Pointer:
+        return std::is_pointer_v<Decayed> || std::is_null_pointer_v<Decayed>;
+      default:
+        return false;
+      }
+    }
+
+    template<typename T, uint32 Capacity>
+    constexpr bool isLogArgumentCompatible(const LogFormatDescriptor<Capacity>& descriptor, size_t index)
+    {
+      // Out of range arguments are reported by the count check.
+      return index >= descriptor.count || isLogArgumentCompatible<T>(descriptor.types[index], descriptor.lengths[index], descriptor.conversions[index]);
+    }
+
+    template<bool Matches, size_t ArgumentIndex>
+    struct LogArgumentCheck
+    {
+      static_assert(Matches, "Log argument does not match its format conversion, ArgumentIndex is its zero based position.");
+      static constexpr bool value = Matches;
+    };
+
+    template<typename T>
+    inline void packLogArgument(LogPayloadWriter& writer, LogArgumentType type, LogArgumentLength length, const T& value)
+    {
+      using Decayed = std::decay_t<T>;
+      if constexpr (std::is_enum_v<Decayed>)
+      {
+        packLogArgument(writer, type, length, static_cast<std::underlying_type_t<Decayed>>(value));
+      }
+      else if constexpr (std::is_integral_v<Decayed>)
+      {
+        // Same conversions printf applies: reinterpretation for "%u" and narrowing for "hh" and "h".
+        if (type == LogArgumentType::Int)
+        {
+          int64 packed = static_cast<int64>(value);
+          packed = length == LogArgumentLength::Char ? static_cast<signed char>(packed) : length == LogArgumentLength::Short ? static_cast<short>(packed) : packed;
+          writer.write(packed);
+        }
+        else
+        {
+          uint64 packed = std::is_same_v<Decayed, bool> ? static_cast<uint64>(value) : static_cast<uint64>(static_cast<std::make_unsigned_t<std::conditional_t<std::is_same_v<Decayed, bool>, int, Decayed>>>(value));
+          packed = length == LogArgumentLength::Char ? static_cast<unsigned char>(packed) : length == LogArgumentLength::Short ? static_cast<unsigned short>(packed) : packed;
+          writer.write(packed);
+        }
+      }
+      else if constexpr (std::is_floating_point_v<Decayed>)
+      {
+        if (type == LogArgumentType::LongDouble)
+        {
+          writer.write(static_cast<long double>(value));
+        }
+        else
+        {
+          writer.write(static_cast<double>(value));
+        }
+      }
+      else if constexpr (std::is_same_v<Decayed, std::string> || std::is_same_v<Decayed, std::string_view>)
+      {
+        writer.writeString(value.data(), value.size());
+      }
+      else if constexpr (std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*>)
+      {
+        if (type == LogArgumentType::String)
+        {
+          writer.writeString(value);
+        }
+        else
+        {
+          writer.write<uint64>(reinterpret_cast<uintptr_t>(value));
+        }
+      }
+      else
+      {
+        writer.write<uint64>(reinterpret_cast<uintptr_t>(static_cast<const void*>(value)));
+      }
+    }
+
+    template<typename Format, typename... Arguments, size_t... Indices>
+    inline void logChecked(LogLevel level, std::index_sequence<Indices...>, const Arguments&... arguments)
+    {
+      static constexpr auto descriptor = parseLogFormat<countLogConversions(Format::get()) + 1>(Format::get());
+      static_assert(descriptor.count == sizeof...(Arguments), "Log argument count does not match the format string.");
+      static_assert((LogArgumentCheck<isLogArgumentCompatible<Arguments>(descriptor, Indices), Indices>::value && ... && true));
+
+      LogRecord local_record;
+      LogRecord* record = Log::beginRecord(level, Format::get());
+      LogRecord& target = record ? *record : local_record;
+
+      LogPayloadWriter writer(target.payload, LogRecord::payload_capacity);
+      if constexpr (descriptor.count == sizeof...(Arguments))
+      {
+        (packLogArgument(writer, descriptor.types[Indices], descriptor.lengths[Indices], arguments), ...);
+      }
+      target.size = static_cast<uint16>(writer.getSize());
+      target.truncated = writer.isTruncated();
+
+      if (record)
+      {
+        Log::commitRecord(record);
+      }
+      else
+      {
+        local_record.format = Format::get();
+        local_record.level = level;
+        local_record.inline_format = false;
+        Log::writeRecord(local_record);
+      }
+    }
+
+    template<typename Format, typename... Arguments>
+    inline void logChecked(LogLevel level, const char*, const Arguments&... arguments)
+    {
+      logChecked<Format>(level, std::index_sequence_for<Arguments...>(), arguments...);
+    }
+  }
+}
+
+#define LOG_FORMAT_STRING(format, ...) format
+
+// The format has to be a string literal, it is parsed at compile time and every argument is checked
+// against its conversion. The call only copies the arguments, formatting happens on the log thread.
+#define LOG_MESSAGE(level, ...) \
+  do \
+  { \
+    struct LogFormat \
+    { \
+      static constexpr const char* get() { return LOG_FORMAT_STRING(__VA_ARGS__, 0); } \
+    }; \
+    ::engine::detail::logChecked<LogFormat>(level, __VA_ARGS__); \
+  } while (false)
+
+#define LOG_INFO(...) LOG_MESSAGE(::engine::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_MESSAGE(::engine::LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_MESSAGE(::engine::LogLevel::Error, __VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <common/types.h>
+#include <common/log.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <string>
+
+namespace engine
+{
+  enum class LogArgumentType : uint8
+  {
+    None,         // "%%" or a malformed conversion, consumes nothing
+    Int,
+    Unsigned,
+    Double,
+    LongDouble,
+    String,
+    Pointer,
+    WriteCount    // "%n", the pointer is consumed and ignored
+  };
+
+  enum class LogArgumentLength : uint8
+  {
+    Default,
+    Char,
+    Short,
+    Long,
+    LongLong,
+    IntMax,
+    Size,
+    PtrDiff,
+    LongDouble
+  };
+
+  // One printf conversion, [begin, end) points into the format string.
+  struct LogFormatSpec
+  {
+    const char* begin { nullptr };
+    const char* end { nullptr };
+    LogArgumentType type { LogArgumentType::None };
+    LogArgumentLength length { LogArgumentLength::Default };
+    char conversion { 0 };
+    bool width_argument { false };
+    bool precision_argument { false };
+  };
+
+  // A record with an inline format carries a copy of the format string (16-bit length, bytes and the
+  // terminator) ahead of the arguments, format is only valid otherwise. Formats of unknown lifetime
+  // have to be copied since formatting happens later.
+  struct LogRecord
+  {
+    static const uint32 payload_capacity = 232;
+
+    uint64 timestamp;
+    const char* format;
+    uint16 size;
+    LogLevel level;
+    bool truncated;
+    bool inline_format;
+    uint8 payload[payload_capacity];
+  };
+
+  // Appends packed arguments, see packLogArguments for the layout. Once a value does not fit the
+  // writer is truncated and ignores everything after it.
+  class LogPayloadWriter
+  {
+  public:
+    LogPayloadWriter(uint8* buffer, uint32 capacity)
+      : buffer(buffer)
+      , capacity(capacity)
+    {
+    }
+
+    template<typename T>
+    void write(const T& value)
+    {
+      if (truncated || size + sizeof(T) > capacity)
+      {
+        truncated = true;
+        return;
+      }
+
+      memcpy(buffer + size, &value, sizeof(T));
+      size += sizeof(T);
+    }
+
+    // Strings are cut to the space left rather than dropped.
+    void writeString(const char* text, size_t length)
+    {
+      if (truncated || size + sizeof(uint16) > capacity)
+      {
+        truncated = true;
+        return;
+      }
+
+      size_t available = capacity - size - sizeof(uint16);
+      uint16 stored = static_cast<uint16>(std::min<size_t>(std::min<size_t>(length, available), 0xffff));
+      truncated = stored < length;
+
+      memcpy(buffer + size, &stored, sizeof(stored));
+      size += sizeof(stored);
+      memcpy(buffer + size, text, stored);
+      size += stored;
+    }
+
+    void writeString(const char* text)
+    {
+      writeString(text ? text : "", text ? strlen(text) : 0);
+    }
+
+    uint32 getSize() const { return size; }
+    bool isTruncated() const { return truncated; }
+
+  private:
+    uint8* buffer;
+    uint32 capacity;
+    uint32 size { 0 };
+    bool truncated { false };
+  };
+
+  // Finds the next conversion at or after format, returns false when there is none.
+  bool findLogFormatSpec(const char* format, LogFormatSpec& spec);
+
+  // Deferred formatting stores printf arguments in the order the format string consumes them:
+  // integers (and '*' widths) widened to 64 bits, doubles as double, long doubles as long double,
+  // pointers as 64 bits and strings inlined as a 16-bit length followed by the bytes.
+  // Returns the packed size, truncated is set when the arguments did not fit.
+  uint32 packLogArguments(const char* format, va_list args, uint8* buffer, uint32 capacity, bool& truncated);
+
+  // Appends the text printf would have produced for the packed arguments.
+  void formatLogArguments(const char* format, const uint8* payload, uint32 size, bool truncated, std::string& output);
+
+  // Packs a copied format and its arguments, for formats that may not outlive the record.
+  void packLogRecordInline(LogRecord& record, const char* format, va_list args);
+  // Resolves inline formats, arguments and size are set to the packed arguments.
+  const char* getLogRecordFormat(const LogRecord& record, const uint8*& arguments, uint32& size);
+  void formatLogRecord(const LogRecord& record, std::string& output);
+}
\ No newline at end of file
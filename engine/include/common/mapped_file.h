@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <string>
+
+namespace engine
+{
+  // Memory-mapped file. Read mode maps the whole file, write mode creates or truncates it to the
+  // requested size and can grow it later, which remaps and invalidates earlier data() pointers.
+  class MappedFile
+  {
+  public:
+    enum class Mode
+    {
+      Read,
+      Write
+    };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, Mode mode, uint64 size = 0);
+    bool resize(uint64 size);
+    // Writes dirty pages back, blocking until they reached the file.
+    bool flush();
+    // A non-zero final_size truncates a written file before closing, dropping unused preallocated space.
+    void close(uint64 final_size = 0);
+
+    bool isOpen() const { return data_pointer != nullptr; }
+    uint8* data() const { return data_pointer; }
+    uint64 size() const { return mapped_size; }
+
+  private:
+    bool map();
+    void unmap();
+
+  private:
+    uint8* data_pointer { nullptr };
+    uint64 mapped_size { 0 };
+    Mode mode { Mode::Read };
+
+#if defined(_WIN32)
+    void* file_handle { nullptr };
+    void* mapping_handle { nullptr };
+#else
+    int file_descriptor { -1 };
+#endif
+  };
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <common/types.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace engine
+{
+  template<typename T>
+  constexpr bool isPowerOfTwo(T value)
+  {
+    return value != 0 && (value & (value - 1)) == 0;
+  }
+
+  // Alignment must be a power of two.
+  template<typename T>
+  constexpr T alignUp(T value, T alignment)
+  {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  template<typename T>
+  constexpr T alignDown(T value, T alignment)
+  {
+    return value & ~(alignment - 1);
+  }
+
+  template<typename T>
+  constexpr T divideRoundingUp(T value, T divisor)
+  {
+    return (value + divisor - 1) / divisor;
+  }
+
+  constexpr uint64 nextPowerOfTwo(uint64 value)
+  {
+    if (value <= 1)
+    {
+      return 1;
+    }
+
+    value--;
+    value |= value >> 1;
+    value |= value >> 2;
+    value |= value >> 4;
+    value |= value >> 8;
+    value |= value >> 16;
+    value |= value >> 32;
+    return value + 1;
+  }
+
+  // Index of the most significant set bit, value must not be zero.
+  inline uint32 findMostSignificantBit(uint64 value)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+  }
+
+  // Index of the least significant set bit, value must not be zero.
+  inline uint32 findLeastSignificantBit(uint64 value)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return __builtin_ctzll(value);
+#endif
+  }
+
+  template<typename T>
+  constexpr T clamp(T value, T min_value, T max_value)
+  {
+    return value < min_value ? min_value : (value > max_value ? max_value : value);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <common/types.h>
+#include <json.hpp>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Declares the fields of a struct once for every consumer: the nlohmann JSON conversions,
+// reflectFields, which calls visitor(name, field) for each field in declaration order, and
+// reflectFieldPairs, which walks the same field of two objects together.
+#define ENGINE_REFLECT(Type, ...) \
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Type, __VA_ARGS__) \
+  template<typename Visitor> \
+  inline void reflectFields(Type& reflect_object, Visitor&& reflect_visitor) { NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(ENGINE_REFLECT_FIELD, __VA_ARGS__)) } \
+  template<typename Visitor> \
+  inline void reflectFields(const Type& reflect_object, Visitor&& reflect_visitor) { NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(ENGINE_REFLECT_FIELD, __VA_ARGS__)) } \
+  template<typename Visitor> \
+  inline void reflectFieldPairs(const Type& reflect_first, const Type& reflect_second, Visitor&& reflect_visitor) { NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(ENGINE_REFLECT_FIELD_PAIR, __VA_ARGS__)) }
+
+#define ENGINE_REFLECT_FIELD(field) reflect_visitor(#field, reflect_object.field);
+#define ENGINE_REFLECT_FIELD_PAIR(field) reflect_visitor(#field, reflect_first.field, reflect_second.field);
+
+// Names enum values for JSON, takes the same { { value, "name" }, ... } list as NLOHMANN_JSON_SERIALIZE_ENUM.
+#define ENGINE_REFLECT_ENUM(Type, ...) \
+  NLOHMANN_JSON_SERIALIZE_ENUM(Type, __VA_ARGS__) \
+  inline const auto& reflectEnumValues(Type) \
+  { \
+    static const std::pair<Type, const char*> reflect_values[] = __VA_ARGS__; \
+    return reflect_values; \
+  }
+
+namespace engine
+{
+  namespace detail
+  {
+    struct NullFieldVisitor
+    {
+      template<typename T>
+      void operator()(const char*, T&) const
+      {
+      }
+    };
+  }
+
+  template<typename T, typename = void>
+  struct IsReflected : std::false_type
+  {
+  };
+
+  template<typename T>
+  struct IsReflected<T, std::void_t<decltype(reflectFields(std::declval<T&>(), std::declval<detail::NullFieldVisitor&>()))>> : std::true_type
+  {
+  };
+
+  template<typename T>
+  inline constexpr bool is_reflected_v = IsReflected<T>::value;
+
+  template<typename T, typename = void>
+  struct IsReflectedEnum : std::false_type
+  {
+  };
+
+  template<typename T>
+  struct IsReflectedEnum<T, std::void_t<decltype(reflectEnumValues(std::declval<T>()))>> : std::true_type
+  {
+  };
+
+  template<typename T>
+  inline constexpr bool is_reflected_enum_v = IsReflectedEnum<T>::value;
+
+  template<typename T>
+  struct IsVector : std::false_type
+  {
+  };
+
+  template<typename T, typename Allocator>
+  struct IsVector<std::vector<T, Allocator>> : std::true_type
+  {
+  };
+
+  // FNV-1a over field names and value kinds, changes whenever a reflected layout does: a field is
+  // added, removed, renamed, reordered or changes its type. Values of reflected enums are included.
+  template<typename T>
+  uint64 getSchemaHash();
+
+  namespace detail
+  {
+    inline uint64 hashSchema(uint64 hash, const void* data, size_t size)
+    {
+      const uint8* bytes = static_cast<const uint8*>(data);
+      for (size_t i = 0; i < size; ++i)
+      {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+      }
+      return hash;
+    }
+
+    inline uint64 hashSchema(uint64 hash, const char* text)
+    {
+      return hashSchema(hash, text, std::char_traits<char>::length(text) + 1);
+    }
+
+    template<typename T>
+    uint64 computeSchemaHash()
+    {
+      uint64 hash = 0xcbf29ce484222325ull;
+      if constexpr (is_reflected_v<T>)
+      {
+        T object {};
+        hash = hashSchema(hash, "{");
+        reflectFields(object, [&](const char* name, auto& field)
+        {
+          uint64 field_hash = getSchemaHash<std::decay_t<decltype(field)>>();
+          hash = hashSchema(hashSchema(hash, name), &field_hash, sizeof(field_hash));
+        });
+        hash = hashSchema(hash, "}");
+      }
+      else if constexpr (std::is_same_v<T, std::string>)
+      {
+        hash = hashSchema(hash, "string");
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        uint64 element_hash = getSchemaHash<typename T::value_type>();
+        hash = hashSchema(hashSchema(hash, "vector"), &element_hash, sizeof(element_hash));
+      }
+      else if constexpr (std::is_enum_v<T>)
+      {
+        uint64 underlying_hash = getSchemaHash<std::underlying_type_t<T>>();
+        hash = hashSchema(hashSchema(hash, "enum"), &underlying_hash, sizeof(underlying_hash));
+        if constexpr (is_reflected_enum_v<T>)
+        {
+          for (const auto& [value, name] : reflectEnumValues(T {}))
+          {
+            auto underlying = static_cast<std::underlying_type_t<T>>(value);
+            hash = hashSchema(hashSchema(hash, &underlying, sizeof(underlying)), name);
+          }
+        }
+      }
+      else
+      {
+        static_assert(std::is_arithmetic_v<T>, "Reflected fields have to be arithmetic, enums, strings, vectors or reflected structs.");
+        const char kind[] = { std::is_same_v<T, bool> ? 'b' : std::is_floating_point_v<T> ? 'f' : std::is_signed_v<T> ? 'i' : 'u', char('0' + sizeof(T)), '\0' };
+        hash = hashSchema(hash, kind);
+      }
+      return hash;
+    }
+  }
+
+  template<typename T>
+  uint64 getSchemaHash()
+  {
+    static const uint64 hash = detail::computeSchemaHash<T>();
+    return hash;
+  }
+
+  // Member-wise comparison, reflected structs don't need an operator==.
+  template<typename T>
+  bool reflectEquals(const T& first, const T& second)
+  {
+    if constexpr (is_reflected_v<T>)
+    {
+      bool equal = true;
+      reflectFieldPairs(first, second, [&](const char*, const auto& a, const auto& b) { equal = equal && reflectEquals(a, b); });
+      return equal;
+    }
+    else if constexpr (IsVector<T>::value)
+    {
+      if (first.size() != second.size())
+      {
+        return false;
+      }
+      for (size_t i = 0; i < first.size(); ++i)
+      {
+        if (!reflectEquals(first[i], second[i]))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    else
+    {
+      return first == second;
+    }
+  }
+
+  namespace detail
+  {
+    template<typename T, typename Visitor>
+    void diffFields(const T& previous, const T& current, std::string& path, Visitor& visitor)
+    {
+      if constexpr (is_reflected_v<T>)
+      {
+        reflectFieldPairs(previous, current, [&](const char* name, const auto& a, const auto& b)
+        {
+          size_t length = path.size();
+          if (length > 0)
+          {
+            path += '.';
+          }
+          path += name;
+          diffFields(a, b, path, visitor);
+          path.resize(length);
+        });
+      }
+      else if (!reflectEquals(previous, current))
+      {
+        visitor(path);
+      }
+    }
+  }
+
+  // Calls visitor(path) for every changed field below reflected structs, with dotted paths such as
+  // "render_settings.frame_count". Vectors count as one field.
+  template<typename T, typename Visitor>
+  void forEachChangedField(const T& previous, const T& current, Visitor&& visitor)
+  {
+    std::string path;
+    detail::diffFields(previous, current, path, visitor);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <cassert>
+
+namespace engine
+{
+  // Fixed capacity ring that overwrites the oldest element once full.
+  // Elements are indexed from the oldest (0) to the newest (size() - 1).
+  template<typename T, uint32 Capacity>
+  class RingBuffer
+  {
+  public:
+    void push(const T& value)
+    {
+      elements[head] = value;
+      head = (head + 1) % Capacity;
+      if (count < Capacity)
+      {
+        count++;
+      }
+    }
+
+    void clear()
+    {
+      head = 0;
+      count = 0;
+    }
+
+    const T& operator[](uint32 index) const
+    {
+      assert(index < count);
+      return elements[(head + Capacity - count + index) % Capacity];
+    }
+
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    uint32 size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+    static constexpr uint32 capacity() { return Capacity; }
+
+  private:
+    T elements[Capacity] = {};
+    uint32 head { 0 };
+    uint32 count { 0 };
+  };
+}
\ No newline at end of file
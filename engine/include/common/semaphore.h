@@ -0,0 +1,27 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace engine
+{
+  // Counting semaphore that only touches the mutex when a thread actually has to sleep.
+  class Semaphore
+  {
+  public:
+    explicit Semaphore(int32 initial_count = 0);
+
+    void signal(int32 count = 1);
+    void wait();
+    bool tryWait();
+
+  private:
+    std::atomic<int32> count;
+    int32 wakeups { 0 };
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <common/types.h>
+
+#include <chrono>
+
+namespace engine
+{
+  // Monotonic timer for frame timing and profiling, independent of the platform layer.
+  class Timer
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    Timer();
+
+    void reset();
+    double tick();
+
+    double getElapsedSeconds() const;
+    std::chrono::nanoseconds getElapsed() const { return Clock::now() - start_time; }
+    double getDeltaSeconds() const { return delta_seconds; }
+
+    static uint64 nowNanoseconds();
+
+  private:
+    Clock::time_point start_time;
+    Clock::time_point last_tick_time;
+    double delta_seconds;
+  };
+}
\ No newline at end of file
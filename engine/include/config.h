@@ -1,7 +1,9 @@
 #pragma once
 
-#include <common/pch.h>
-#include <json.hpp>
+#include <common/reflection.h>
+#include <config_cache.h>
+
+#include <string>
 
 namespace engine
 {
@@ -10,23 +12,72 @@ namespace engine
     std::string name;
     uint32 window_width {1280};
     uint32 window_height {768};
+    // Job system worker threads, 0 picks one per hardware thread besides the main thread.
+    uint32 worker_count {0};
+    // Simulate and render on their own threads while the main thread only pumps window messages.
+    bool threaded_rendering {false};
+    // Frame packets between simulation and render threads, the simulation runs up to size - 1 frames ahead.
+    uint32 frame_queue_size {2};
+    // Chrome trace written on exit when the profiler is compiled in, empty disables it.
+    std::string trace_path;
+    // Seconds between frame time summaries in the log, 0 disables them.
+    double stats_report_interval {1.0};
+    // Format and write log messages on a background thread.
+    bool async_logging {true};
+    // Binary log for tools/log_decoder, info messages then skip the console. Empty disables it.
+    std::string binary_log_path;
+    // Reload config.json while running when it changes, see Application::watchConfig for what applies live.
+    bool config_hot_reload {true};
+  };
+
+  ENGINE_REFLECT(ApplicationSettingsData, name, window_width, window_height, worker_count, threaded_rendering, frame_queue_size, trace_path, stats_report_interval, async_logging, binary_log_path, config_hot_reload);
+
+  enum class FramePacingMode
+  {
+    // Wait for the next back buffer's fence at the end of every frame.
+    Blocking,
+    // Only wait when max_frame_latency frames are in flight, run idle work while waiting.
+    MaxLatency,
+    // Like MaxLatency, but also wait on the swap chain's frame latency waitable object.
+    WaitableObject,
   };
 
-  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(ApplicationSettingsData, name, window_width, window_height);
+  ENGINE_REFLECT_ENUM(FramePacingMode, {
+    { FramePacingMode::Blocking, "blocking" },
+    { FramePacingMode::MaxLatency, "max_latency" },
+    { FramePacingMode::WaitableObject, "waitable_object" },
+  });
+
+  struct RenderSettingsData
+  {
+    FramePacingMode frame_pacing {FramePacingMode::Blocking};
+    uint32 max_frame_latency {2};
+    uint32 swap_chain_buffer_count {3};
+    uint32 frame_count {3};
+    bool vsync {true};
+  };
+
+  ENGINE_REFLECT(RenderSettingsData, frame_pacing, max_frame_latency, swap_chain_buffer_count, frame_count, vsync);
+
+  // Clamps counts DeviceResources can't run with into its limits, logging a warning for each.
+  void validateRenderSettings(RenderSettingsData& settings);
 
   struct Data
   {
     ApplicationSettingsData application_settings;
+    RenderSettingsData render_settings;
   };
 
-  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Data, application_settings);
+  ENGINE_REFLECT(Data, application_settings, render_settings);
 
   class Config
   {
   public:
-    bool Load(const std::string& path);
+    // Goes through the binary cache next to the file unless use_cache is off, see loadConfigFile.
+    bool Load(const std::string& path, bool use_cache = true);
 
   public:
     Data data;
+    ConfigSource source {ConfigSource::Json};
   };
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <common/binary_archive.h>
+#include <common/json_deserializer.h>
+#include <common/mapped_file.h>
+
+#include <string>
+#include <vector>
+
+namespace engine
+{
+  // Binary copy of a parsed JSON config, written next to it on the first load. It is only used
+  // while its header matches: same format version, same schema hash and defaults of the loaded type
+  // and the same size and modification time of the JSON file it was built from.
+  struct ConfigCacheHeader
+  {
+    static constexpr char magic_value[8] = { 'E', 'N', 'G', 'C', 'F', 'G', '\0', '\0' };
+    // Bump when the encoding changes or values of an enum without ENGINE_REFLECT_ENUM are reordered.
+    static const uint32 current_version = 1;
+
+    char magic[8];
+    uint32 version;
+    uint32 header_size;
+    uint64 schema_hash;
+    uint64 source_size;
+    int64 source_time;
+    uint64 payload_size;
+  };
+
+  struct ConfigSourceStamp
+  {
+    uint64 size { 0 };
+    int64 time { 0 };
+  };
+
+  enum class ConfigSource
+  {
+    Json,
+    Cache
+  };
+
+  std::string getConfigCachePath(const std::string& path);
+  bool getConfigSourceStamp(const std::string& path, ConfigSourceStamp& stamp);
+  // Modification times are coarse, a file saved again within the same tick keeps its stamp if the size
+  // did not change either. Caches are only written for sources older than a second, which a later
+  // save can't share a stamp with.
+  bool isConfigSourceSettled(const ConfigSourceStamp& stamp);
+
+  // Maps the cache and checks its header, payload points into file on success.
+  bool openConfigCache(const std::string& path, uint64 schema_hash, const ConfigSourceStamp& stamp, MappedFile& file, const uint8*& payload, uint64& payload_size);
+  // Writes through a temporary file and a rename, a concurrent reader never sees a partial cache.
+  bool writeConfigCache(const std::string& path, uint64 schema_hash, const ConfigSourceStamp& stamp, const std::vector<uint8>& payload);
+  // Logs unknown keys as warnings, throws std::runtime_error listing the errors if there are any.
+  void checkConfigIssues(const std::string& path, const std::vector<JsonIssue>& issues);
+
+  // Schema hash of T folded with its encoded defaults. The cache holds values merged over the
+  // defaults, a changed default has to invalidate it even for files that don't set that key.
+  template<typename T>
+  uint64 getConfigCacheHash()
+  {
+    static const uint64 hash = []
+    {
+      std::vector<uint8> defaults;
+      BinaryWriter writer(defaults);
+      writer.write(T {});
+      return detail::hashSchema(getSchemaHash<T>(), defaults.data(), defaults.size());
+    }();
+    return hash;
+  }
+
+  template<typename T>
+  bool loadConfigCache(const std::string& path, const ConfigSourceStamp& stamp, T& value)
+  {
+    MappedFile file;
+    const uint8* payload = nullptr;
+    uint64 payload_size = 0;
+    if (!openConfigCache(path, getConfigCacheHash<T>(), stamp, file, payload, payload_size))
+    {
+      return false;
+    }
+
+    // Read into a copy, a damaged cache must not leave value half overwritten.
+    T cached {};
+    BinaryReader reader(payload, payload_size);
+    if (!reader.read(cached) || !reader.isAtEnd())
+    {
+      return false;
+    }
+
+    value = std::move(cached);
+    return true;
+  }
+
+  template<typename T>
+  bool saveConfigCache(const std::string& path, const ConfigSourceStamp& stamp, const T& value)
+  {
+    std::vector<uint8> payload;
+    BinaryWriter writer(payload);
+    writer.write(value);
+
+    return writeConfigCache(path, getConfigCacheHash<T>(), stamp, payload);
+  }
+
+  // Loads value from a JSON file, through its binary cache when the cache is up to date. A stale or
+  // missing cache is rebuilt after parsing the JSON. Members missing from the JSON keep the values
+  // value had, syntax and type errors throw, see checkConfigIssues.
+  template<typename T>
+  ConfigSource loadConfigFile(const std::string& path, T& value, bool use_cache = true)
+  {
+    ConfigSourceStamp stamp;
+    bool has_stamp = use_cache && getConfigSourceStamp(path, stamp);
+    std::string cache_path = has_stamp ? getConfigCachePath(path) : std::string();
+
+    if (has_stamp && loadConfigCache(cache_path, stamp, value))
+    {
+      return ConfigSource::Cache;
+    }
+
+    // Parsed into a copy so a throwing load leaves value as it was.
+    T parsed = value;
+    std::vector<JsonIssue> issues;
+    readJsonFile(path, parsed, issues);
+    checkConfigIssues(path, issues);
+    value = std::move(parsed);
+
+    if (has_stamp && isConfigSourceSettled(stamp))
+    {
+      // A read-only resource directory only costs the cache.
+      saveConfigCache(cache_path, stamp, value);
+    }
+
+    return ConfigSource::Json;
+  }
+}
\ No newline at end of file
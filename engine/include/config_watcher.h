@@ -0,0 +1,127 @@
+#pragma once
+
+#include <common/file_watcher.h>
+#include <common/log_checked.h>
+#include <common/timer.h>
+#include <config_cache.h>
+
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+  // Reloads a config when its file changes and tells subscribers which fields did. Everything runs in
+  // update() on the calling thread, callbacks may touch whatever that thread owns. A reload that
+  // fails to parse is logged and the current value is kept.
+  template<typename T>
+  class ConfigWatcher
+  {
+  public:
+    // Poll the file watcher at most this often, update() is meant to be called every frame.
+    static const uint64 poll_interval_ns = 100'000'000;
+    // Reload only once the file stopped changing for this long, editors may save in several writes.
+    static const uint64 settle_time_ns = 50'000'000;
+
+    // Changes are reported relative to current, the value the caller runs with.
+    bool start(const std::string& path, const T& current)
+    {
+      this->path = path;
+      value = current;
+      change_time = 0;
+      next_poll_time = 0;
+      return file_watcher.watch(path);
+    }
+
+    void stop()
+    {
+      file_watcher.stop();
+    }
+
+    // callback(value, previous) runs after a reload that changed the member selector picks, selector
+    // gets the whole config and returns a reference into it: [](const Data& data) -> const auto& { ... }.
+    template<typename Selector, typename Callback>
+    void onChange(Selector selector, Callback callback)
+    {
+      subscribers.push_back([selector, callback](const T& current, const T& previous)
+      {
+        const auto& field = selector(current);
+        const auto& previous_field = selector(previous);
+        if (!reflectEquals(field, previous_field))
+        {
+          callback(field, previous_field);
+        }
+      });
+    }
+
+    // Returns true when a reload changed the value.
+    bool update()
+    {
+      uint64 now = Timer::nowNanoseconds();
+      if (now >= next_poll_time)
+      {
+        next_poll_time = now + poll_interval_ns;
+        if (file_watcher.poll())
+        {
+          change_time = now;
+        }
+      }
+
+      if (change_time == 0 || now - change_time < settle_time_ns)
+      {
+        return false;
+      }
+      change_time = 0;
+
+      return reload();
+    }
+
+    // Reloads right away, whether the file changed or not.
+    bool reload()
+    {
+      T loaded {};
+      try
+      {
+        loadConfigFile(path, loaded);
+      }
+      catch (const std::exception& exception)
+      {
+        LOG_ERROR("Config reload failed, keeping the current settings. %s\n", exception.what());
+        return false;
+      }
+
+      std::string changes;
+      forEachChangedField(value, loaded, [&](const std::string& field_path)
+      {
+        changes += changes.empty() ? field_path : ", " + field_path;
+      });
+      if (changes.empty())
+      {
+        return false;
+      }
+
+      LOG_INFO("Config reloaded, changed %s\n", changes);
+
+      T previous = std::exchange(value, std::move(loaded));
+      for (const auto& subscriber : subscribers)
+      {
+        subscriber(value, previous);
+      }
+
+      return true;
+    }
+
+    const T& get() const { return value; }
+    bool isWatching() const { return file_watcher.isWatching(); }
+
+  private:
+    std::string path;
+    T value {};
+    FileWatcher file_watcher;
+    uint64 change_time { 0 };
+    uint64 next_poll_time { 0 };
+    std::vector<std::function<void(const T& current, const T& previous)>> subscribers;
+  };
+}
\ No newline at end of file
@@ -1,61 +1,242 @@
 #pragma once
 
-#include <common/pch.h>
+#include <common/types.h>
+#include <config.h>
+#include <memory/frame_allocator.h>
+#include <render/bindless_table.h>
+#include <render/command_list.h>
+#include <render/command_list_pool.h>
+#include <render/descriptor_allocator.h>
+#include <render/fence_timeline.h>
+#include <render/frame_capture.h>
+#include <render/gpu_memory_allocator.h>
+#include <render/render_graph.h>
+#include <render/render_limits.h>
+#include <render/resource_state_tracker.h>
+#include <render/upload_ring.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace engine
 {
-  using namespace Microsoft::WRL;
+  struct SurfaceDesc
+  {
+    void* native_window { nullptr };
+    uint32 width { 0 };
+    uint32 height { 0 };
+    bool use_warp { false };
+  };
 
+  struct FramePacingStats
+  {
+    uint64 blocking_waits { 0 };
+    std::chrono::nanoseconds blocked_time { 0 };
+    // Work done instead of blocking on the GPU.
+    uint64 idle_work_items { 0 };
+    std::chrono::nanoseconds idle_work_time { 0 };
+  };
+
+  // Frame logic shared by every backend. Backends implement the device, queue, swap chain and
+  // fence primitives, DeviceResources drives them in the same order the D3D12 sample does.
   class DeviceResources
   {
   public:
-    void loadPipeline(const class Window& window);
+    virtual ~DeviceResources() = default;
+
+    void loadPipeline(const SurfaceDesc& surface);
+    virtual bool checkTearingSupport() = 0;
+
+    // CPU frames that may be recorded ahead of the GPU, each owns a command allocator and a fence value.
+    // Independent of the swap chain buffer count. Both setters may be called at any time between
+    // frames, after loadPipeline they flush the GPU and recreate the affected resources.
+    void setFrameCount(uint32 frames_in_flight);
+    void setSwapChainBufferCount(uint32 buffer_count);
+    uint32 getFrameCount() const { return frame_count; }
+    uint32 getSwapChainBufferCount() const { return swap_chain_buffer_count; }
+    uint32 getFrameIndex() const { return frame_index; }
+    // Transient CPU memory of the frame being recorded, valid until the frame's fence retires.
+    FrameAllocator& getFrameAllocator() { return frame_allocator; }
+    // Per-frame GPU visible data, reclaimed when the frame's fence retires.
+    UploadRing& getUploadRing() { return upload_ring; }
+    // Has to be set before loadPipeline, a power of two of at least UploadRing::max_alignment.
+    void setUploadBufferSize(uint64 size);
+    // Placement of resources in shared heaps, created by loadPipeline.
+    GpuMemoryAllocator& getGpuMemoryAllocator() { return gpu_memory_allocator; }
+    // Staging and shader visible descriptor heaps. Transient tables are reclaimed with the frame's
+    // fence, queued copies are flushed by endFrame before the frame is submitted.
+    DescriptorAllocator& getDescriptorAllocator() { return descriptor_allocator; }
+    // Shader resources by stable index. Command lists from beginFrame already have its heap set.
+    BindlessTable& getBindlessTable() { return bindless_table; }
+    // States of the back buffers and every resource registered with it, in submission order.
+    ResourceStateTracker& getResourceStateTracker() { return resource_state_tracker; }
+    // Has to be set before loadPipeline.
+    void setDescriptorSettings(const DescriptorAllocator::Settings& settings);
+
+    // WaitableObject pacing has to be selected before loadPipeline, it changes how the swap chain is created.
+    // The latency can change at any time.
+    void setFramePacing(FramePacingMode mode, uint32 max_frame_latency);
+    // Called instead of blocking while the CPU waits for the GPU, returns false when there is nothing left to do.
+    void setIdleWork(std::function<bool()> idle_work);
+
+    // Polls the fence once, then counts frames submitted but not finished on the GPU.
+    uint32 getFramesInFlight();
+    const FramePacingStats& getFramePacingStats() const { return frame_pacing_stats; }
+    void resetFramePacingStats() { frame_pacing_stats = {}; }
+
+    // Waits for the frame's resources to retire, resets its command list and frame arena, transitions the back buffer
+    // to a render target and clears it.
+    CommandList& beginFrame();
+    // A list for recording on the calling thread between beginFrame and endFrame, thread safe.
+    // The caller closes it, endFrame submits it after the beginFrame list, sorted by order.
+    CommandList& acquireCommandList(uint32 order);
+
+    // Submits what the frame recorded so far, then the graph's batches on their queues with the waits
+    // between them. The graphics queue joins the async queues before the frame's fence, later
+    // recording goes to a new frame list. Imported resources have to end in the states the
+    // tracker knows.
+    void executeRenderGraph(RenderGraph& graph);
+
+    // Transitions the back buffer to present, submits and presents. Blocking pacing also waits for
+    // the next frame's fence here.
+    void endFrame(bool vsync, bool tearing_supported);
+
+    // Captures the next frame, from beginFrame to endFrame, into capture. Lists of a captured frame
+    // record into the capture and replay into the backend's lists when closed, which costs extra CPU.
+    void captureNextFrame(FrameCapture& capture);
+    // Submits a captured frame in place of beginFrame and endFrame, rendering to the current back
+    // buffer. Paces, retires, signals and presents like a recorded frame. Only frames captured on this
+    // device replay, the resources, pipelines and descriptors they use have to be alive.
+    void replayFrame(const FrameCapture& capture, bool vsync, bool tearing_supported);
+
     void render(bool vsync, bool tearing_supported);
     void resize(uint32 width, uint32 height);
     void flush();
 
-    bool checkTearingSupport();
-
-    inline HANDLE getFenceEvent() const { return fence_event; }
+    uint32 getCurrentBackBufferIndex() const { return current_back_buffer_index; }
+    ResourceId getCurrentBackBuffer() const { return getBackBuffer(current_back_buffer_index); }
+    CpuDescriptorHandle getCurrentBackBufferView() const { return getBackBufferView(current_back_buffer_index); }
 
   public:
-    static const uint8 num_frames = 3;
+    static const uint32 max_frame_count = RenderLimits::max_frame_count;
+    static const uint32 max_swap_chain_buffers = RenderLimits::max_swap_chain_buffers;
+    static const uint32 infinite_timeout = 0xffffffff;
 
-  private:
-    void enableDebugLayer();
-    ComPtr<IDXGIAdapter4> getAdapter(bool use_warp);
-    ComPtr<ID3D12Device2> createDevice(ComPtr<IDXGIAdapter4> adapter);
-    ComPtr<ID3D12CommandQueue> createCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
-    ComPtr<IDXGISwapChain4> createSwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> command_queue, uint32 width, uint32 height, uint32 buffer_count);
-    ComPtr<ID3D12DescriptorHeap> createDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32 num_descriptors);
-    ComPtr<ID3D12CommandAllocator> createCommandAllocator(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
-    ComPtr<ID3D12GraphicsCommandList> createCommandList(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandAllocator> command_allocator, D3D12_COMMAND_LIST_TYPE type);
-
-    ComPtr<ID3D12Fence> createFence(ComPtr<ID3D12Device2> device);
-    HANDLE createEventHandle();
-    uint64 signal(ComPtr<ID3D12CommandQueue> command_queue, ComPtr<ID3D12Fence> fence, uint64& fence_value);
-    void waitForFenceValue(ComPtr<ID3D12Fence> fence, uint64 fence_value, HANDLE fence_event, std::chrono::milliseconds duration = std::chrono::milliseconds::max());
-    void flush(ComPtr<ID3D12CommandQueue> command_queue, ComPtr<ID3D12Fence> fence, uint64& fence_value, HANDLE fence_event);
-
-    void updateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swap_chain, ComPtr<ID3D12DescriptorHeap> descriptor_heap);
+  protected:
+    // Creates device, queue, fence and a swap chain with swap_chain_buffer_count buffers.
+    virtual void createDeviceResources(const SurfaceDesc& surface) = 0;
+    // Recreates per-frame resources for frame_count frames, only called when the GPU is idle.
+    virtual void resizeFrameResources(uint32 frame_count) = 0;
+    virtual CommandList& resetCommandList(uint32 frame_index) = 0;
+    // Called from any recording thread, the result starts closed.
+    virtual std::unique_ptr<CommandContext> createCommandContext(CommandListType type) = 0;
+    // Every queue has a fence of its own, the direct queue's is the frame fence.
+    virtual void executeCommandLists(CommandListType queue, CommandList* const* command_lists, uint32 count) = 0;
+    virtual void signalQueue(CommandListType queue, uint64 value) = 0;
+    virtual uint64 getCompletedFenceValue(CommandListType queue) = 0;
+    // Holds queue back on the GPU until the fence of signaled_queue reaches value, the CPU goes on.
+    virtual void waitForQueue(CommandListType queue, CommandListType signaled_queue, uint64 value) = 0;
+    // Waits on the CPU for the direct queue.
+    virtual void waitForFenceValue(uint64 value) = 0;
+    virtual void present(uint32 sync_interval, bool allow_tearing) = 0;
+    // Resizes to swap_chain_buffer_count buffers of the given size, only called when the GPU is idle.
+    virtual void resizeSwapChain(uint32 width, uint32 height) = 0;
+    virtual uint32 queryCurrentBackBufferIndex() = 0;
+    virtual ResourceId getBackBuffer(uint32 index) const = 0;
+    virtual CpuDescriptorHandle getBackBufferView(uint32 index) const = 0;
+    // Waits on the swap chain's frame latency object, a timeout of 0 only polls it.
+    virtual bool waitForFrameLatencyObject(uint32 timeout_milliseconds) = 0;
+    // Called by setFramePacing when max_frame_latency changes after loadPipeline.
+    virtual void updateMaximumFrameLatency() = 0;
+    // Creates a persistently mapped buffer the GPU can read, called once by loadPipeline.
+    virtual UploadMemory createUploadMemory(uint64 size) = 0;
+    // Heaps for the GpuMemoryAllocator, invalid_id when the device is out of memory.
+    virtual HeapId createHeap(const HeapDesc& desc) = 0;
+    virtual void destroyHeap(HeapId heap) = 0;
+    // Descriptor heaps live as long as the device, staging ones may be created while recording.
+    virtual DescriptorHeapInfo createDescriptorHeap(const DescriptorHeapDesc& desc) = 0;
+    virtual void copyDescriptors(DescriptorHeapType type, const DescriptorCopyBatch& batch) = 0;
+
+    uint64 signal();
+    bool isFenceComplete(uint64 value);
 
   private:
-    bool is_initialized;
-
-    ComPtr<ID3D12Device2> device;
-    ComPtr<ID3D12CommandQueue> command_queue;
-    ComPtr<IDXGISwapChain4> swap_chain;
-    ComPtr<ID3D12Resource> back_buffers[num_frames];
-    ComPtr<ID3D12GraphicsCommandList> command_list;
-    ComPtr<ID3D12CommandAllocator> command_allocators[num_frames];
-    ComPtr<ID3D12DescriptorHeap> RTV_descriptor_heap;
-
-    uint RTV_descriptor_size;
-    uint current_back_buffer_index;
-
-    ComPtr<ID3D12Fence> fence;
-    uint64 fence_value = 0;
-    uint64 frame_fence_values[num_frames] = {};
-    HANDLE fence_event;
+    class FrameQueues;
+
+    struct QueueContexts
+    {
+      std::vector<std::unique_ptr<CommandContext>> contexts;
+      uint32 used { 0 };
+    };
+
+    struct ReplaySignal
+    {
+      CommandListType queue;
+      uint64 captured_value;
+      uint64 value;
+    };
+
+    // Waits for the frame's resources and recycles its allocators.
+    void prepareFrame();
+    // Signals the frame's fence, presents and moves on to the next frame.
+    void finishFrame(bool vsync, bool tearing_supported);
+    // An open list of the frame for the queue, kept until the frame's fence retires.
+    CommandList& acquireQueueCommandList(CommandListType queue);
+    // Ends the capture with the upload ring data the frame wrote.
+    void captureUploads();
+    // Wraps the list when the frame is captured.
+    CommandList& captureCommandList(CommandList& command_list);
+    // Lists may be capture lists, they are replaced by the lists they wrap.
+    void submitCommandLists(CommandListType queue, CommandList** command_lists, uint32 count);
+    // Signals the next fence value of the queue and returns it.
+    uint64 signalNextValue(CommandListType queue);
+    void registerBackBuffers();
+    void waitForFrameLatency();
+    void waitForFenceValueTimed(uint64 value);
+    bool runIdleWork();
+
+  protected:
+    bool is_initialized { false };
+    uint32 width { 0 };
+    uint32 height { 0 };
+    uint32 swap_chain_buffer_count { 3 };
+    uint32 current_back_buffer_index { 0 };
+
+    uint32 frame_count { 3 };
+    uint32 frame_index { 0 };
+    CommandList* frame_command_list { nullptr };
+    CommandListPool command_list_pool;
+    std::vector<CommandList*> submitted_command_lists;
+    // Per frame and queue.
+    std::vector<QueueContexts> queue_contexts;
+    // Last values signaled on the async queues, the direct queue's are in fence_timeline.
+    uint64 queue_fence_values[queue_count] = {};
+    FrameAllocator frame_allocator;
+    UploadRing upload_ring;
+    uint64 upload_buffer_size { 8 * 1024 * 1024 };
+    GpuMemoryAllocator gpu_memory_allocator;
+    DescriptorAllocator descriptor_allocator;
+    BindlessTable bindless_table;
+    ResourceStateTracker resource_state_tracker;
+    DescriptorAllocator::Settings descriptor_settings;
+
+    FramePacingMode frame_pacing { FramePacingMode::Blocking };
+    uint32 max_frame_latency { 2 };
+    std::function<bool()> idle_work;
+    FramePacingStats frame_pacing_stats;
+
+    FenceTimeline fence_timeline;
+    std::vector<uint64> frame_fence_values;
+
+    FrameCapture* next_capture { nullptr };
+    FrameCapture* capture { nullptr };
+    std::mutex capture_mutex;
+    std::vector<std::unique_ptr<CaptureCommandList>> capture_lists;
+    std::vector<const CommandStream*> capture_streams;
+    CommandReplayer replayer;
+    std::vector<ReplaySignal> replay_signals;
   };
 }
\ No newline at end of file
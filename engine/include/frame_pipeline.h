@@ -0,0 +1,71 @@
+#pragma once
+
+#include <common/frame_queue.h>
+
+#include <exception>
+#include <functional>
+#include <thread>
+
+namespace engine
+{
+  // Everything the render thread needs from one simulation step.
+  struct FramePacket
+  {
+    uint64 frame_number { 0 };
+    double simulation_time { 0.0 };
+    double delta_seconds { 0.0 };
+  };
+
+  // Runs simulation and render submission on their own threads, connected by a bounded FrameQueue,
+  // while the calling thread only pumps events. With a queue of N packets the simulation can run
+  // up to N - 1 frames ahead of the frame being rendered.
+  class FramePipeline
+  {
+  public:
+    struct Callbacks
+    {
+      std::function<void(FramePacket& packet)> simulate;
+      std::function<void(const FramePacket& packet)> render;
+      // Called on the render thread before the next frame.
+      std::function<void(uint32 width, uint32 height)> resize;
+      // Called on the failing thread once a callback threw. A pump that blocks waiting for events
+      // has to be woken here, run only returns after pump_events does.
+      std::function<void()> wake_pump;
+    };
+
+    FramePipeline(uint32 frame_queue_size, Callbacks callbacks);
+    ~FramePipeline();
+
+    // Pumps events on the calling thread until pump_events returns false, then stops both threads.
+    // Rethrows the first exception thrown by a callback.
+    void run(const std::function<bool()>& pump_events);
+
+    // Safe from any thread, only the latest size is applied.
+    void requestResize(uint32 width, uint32 height);
+
+    uint64 getSimulatedFrames() const { return simulated_frames.load(std::memory_order_relaxed); }
+    uint64 getRenderedFrames() const { return rendered_frames.load(std::memory_order_relaxed); }
+
+  private:
+    void start();
+    void stop();
+    void simulationMain();
+    void renderMain();
+    void fail();
+
+  private:
+    Callbacks callbacks;
+    FrameQueue<FramePacket> queue;
+
+    std::thread simulation_thread;
+    std::thread render_thread;
+    std::atomic<bool> running { false };
+    std::atomic<uint64> pending_resize { 0 };
+
+    std::atomic<uint64> simulated_frames { 0 };
+    std::atomic<uint64> rendered_frames { 0 };
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <jobs/work_stealing_deque.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace engine
+{
+  // Counts unfinished jobs. A job may wait on counters of other jobs, this is how dependencies are expressed.
+  struct JobCounter
+  {
+    std::atomic<int32> value { 0 };
+
+    bool isDone() const { return value.load(std::memory_order_acquire) == 0; }
+  };
+
+  struct alignas(64) Job
+  {
+    static constexpr uint32 payload_size = 40;
+
+    void (*entry)(void* payload) { nullptr };
+    JobCounter* counter { nullptr };
+    std::atomic<bool> in_use { false };
+    alignas(8) unsigned char payload[payload_size];
+  };
+
+  // Work-stealing scheduler. Every thread that submits jobs gets its own Chase-Lev deque and job pool,
+  // idle workers steal from the others. Threads waiting on a counter execute jobs instead of blocking.
+  class JobSystem
+  {
+  public:
+    JobSystem() = default;
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void initialize(uint32 worker_count);
+    // Runs the jobs still queued on the calling thread, jobs submitted afterwards run inline.
+    void shutdown();
+
+    // The closure is copied into the job, it must fit Job::payload_size bytes.
+    template<typename Function>
+    void run(Function&& function, JobCounter* counter);
+    void wait(JobCounter& counter);
+    // Executes one pending job on the calling thread, returns false when none was found.
+    bool runPendingJob();
+    // True while no job is queued or executing. Scans every job, meant for rare checks like restarts.
+    bool isIdle() const;
+    // Helps out until isIdle, other threads must not keep submitting meanwhile.
+    void waitForIdle();
+
+    // Calls function(begin, end) for batches of [0, count), the calling thread participates.
+    template<typename Function>
+    void parallelFor(uint32 count, uint32 batch_size, const Function& function);
+    template<typename Function>
+    void parallelFor(uint32 count, const Function& function);
+
+    // One worker per hardware thread besides the calling one.
+    static uint32 getDefaultWorkerCount();
+
+    uint32 getWorkerCount() const { return static_cast<uint32>(workers.size()); }
+    // Number of threads that execute jobs, workers plus the waiting thread.
+    uint32 getConcurrency() const { return getWorkerCount() + 1; }
+
+  public:
+    static constexpr uint32 max_external_threads = 8;
+    static const uint32 jobs_per_thread = 4096;
+
+  private:
+    static const uint32 invalid_slot = ~0u;
+
+    struct alignas(64) ThreadSlot
+    {
+      WorkStealingDeque<Job*, jobs_per_thread> deque;
+      std::unique_ptr<Job[]> jobs { new Job[jobs_per_thread] };
+      uint32 next_job { 0 };
+      uint32 random_state { 0 };
+    };
+
+    // Null for threads past max_external_threads and after shutdown, they run their jobs inline and can't steal.
+    ThreadSlot* getThreadSlot();
+    Job* allocateJob(ThreadSlot& slot);
+    void submit(ThreadSlot& slot, Job* job);
+    Job* findJob(ThreadSlot& slot);
+    void execute(Job* job);
+    void workerMain(uint32 slot_index);
+
+  private:
+    std::vector<std::thread> workers;
+    std::unique_ptr<ThreadSlot[]> slots;
+    uint32 slot_count { 0 };
+    std::atomic<uint32> registered_slots { 0 };
+    // Zero while not initialized.
+    uint32 instance_id { 0 };
+
+    std::atomic<bool> running { false };
+    std::atomic<uint32> sleeping_workers { 0 };
+    uint64 wake_epoch { 0 };
+    std::mutex wake_mutex;
+    std::condition_variable wake_condition;
+  };
+
+  template<typename Function>
+  void JobSystem::run(Function&& function, JobCounter* counter)
+  {
+    using Closure = std::decay_t<Function>;
+    static_assert(sizeof(Closure) <= Job::payload_size, "Job closure does not fit the job payload.");
+    static_assert(alignof(Closure) <= 8, "Job closure alignment is too large.");
+
+    ThreadSlot* slot = getThreadSlot();
+    if (!slot)
+    {
+      std::forward<Function>(function)();
+      return;
+    }
+
+    Job* job = allocateJob(*slot);
+    new (job->payload) Closure(std::forward<Function>(function));
+    job->entry = [](void* payload)
+    {
+      Closure* closure = static_cast<Closure*>(payload);
+      (*closure)();
+      closure->~Closure();
+    };
+    job->counter = counter;
+    if (counter)
+    {
+      counter->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    submit(*slot, job);
+  }
+
+  template<typename Function>
+  void JobSystem::parallelFor(uint32 count, uint32 batch_size, const Function& function)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    batch_size = std::max(1u, batch_size);
+    if (workers.empty() || count <= batch_size)
+    {
+      function(0u, count);
+      return;
+    }
+
+    JobCounter counter;
+    for (uint32 begin = 0; begin < count; begin += batch_size)
+    {
+      uint32 end = std::min(count, begin + batch_size);
+      run([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    wait(counter);
+  }
+
+  template<typename Function>
+  void JobSystem::parallelFor(uint32 count, const Function& function)
+  {
+    // A few batches per thread keep everyone busy without paying for a job per element.
+    const uint32 batch_count = getConcurrency() * 4;
+    parallelFor(count, (count + batch_count - 1) / batch_count, function);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <common/math.h>
+
+#include <atomic>
+
+namespace engine
+{
+  // Fixed capacity Chase-Lev deque. The owning thread pushes and pops at the bottom,
+  // any other thread may steal from the top. Follows "Correct and Efficient Work-Stealing
+  // for Weak Memory Models" (Le et al.), without the resizing.
+  template<typename T, uint32 Capacity>
+  class WorkStealingDeque
+  {
+    static_assert(isPowerOfTwo(Capacity), "Capacity must be a power of two.");
+
+  public:
+    // Owner only. Returns false when the deque is full.
+    bool push(T item)
+    {
+      int64 b = bottom.load(std::memory_order_relaxed);
+      int64 t = top.load(std::memory_order_acquire);
+      if (b - t >= static_cast<int64>(Capacity))
+      {
+        return false;
+      }
+
+      buffer[b & mask].store(item, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      bottom.store(b + 1, std::memory_order_relaxed);
+
+      return true;
+    }
+
+    // Owner only.
+    bool pop(T& item)
+    {
+      int64 b = bottom.load(std::memory_order_relaxed) - 1;
+      bottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64 t = top.load(std::memory_order_relaxed);
+
+      if (t > b)
+      {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+      }
+
+      item = buffer[b & mask].load(std::memory_order_relaxed);
+      if (t == b)
+      {
+        // Last element, race against thieves.
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+      }
+
+      return true;
+    }
+
+    // Any thread.
+    bool steal(T& item)
+    {
+      int64 t = top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64 b = bottom.load(std::memory_order_acquire);
+
+      if (t >= b)
+      {
+        return false;
+      }
+
+      item = buffer[t & mask].load(std::memory_order_relaxed);
+      return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+      return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr int64 mask = Capacity - 1;
+
+    alignas(64) std::atomic<int64> top { 0 };
+    alignas(64) std::atomic<int64> bottom { 0 };
+    alignas(64) std::atomic<T> buffer[Capacity] = {};
+  };
+}
\ No newline at end of file
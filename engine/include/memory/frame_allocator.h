@@ -0,0 +1,111 @@
+#pragma once
+
+#include <memory/linear_allocator.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine
+{
+  // Linear arenas for data that lives until the GPU finished the frame it was recorded for, one per
+  // frame in flight. beginFrame(frame_index) resets the frame's arena, so it must only be called once
+  // the frame's fence retired, DeviceResources::beginFrame does that. Any thread may allocate: each
+  // one carves 64 KB pages out of the current arena and bumps through them without atomics. Arenas
+  // that overflowed are regrown to their peak on the next reset.
+  class FrameAllocator
+  {
+  public:
+    static constexpr size_t page_size = 64 * 1024;
+    static constexpr size_t default_capacity = 1024 * 1024;
+
+    explicit FrameAllocator(size_t capacity = default_capacity);
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+    // Drops all arenas, nothing may be allocated from them anymore.
+    void setFrameCount(uint32 frame_count);
+    uint32 getFrameCount() const { return frame_count; }
+
+    // Not thread safe, no other thread may allocate while the frame changes.
+    void beginFrame(uint32 frame_index);
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+      ThreadPage& page = thread_page;
+      if (page.tag == frame_tag)
+      {
+        uint8* result = reinterpret_cast<uint8*>(alignUp(reinterpret_cast<uintptr_t>(page.cursor), alignment));
+        if (result + size <= page.end)
+        {
+          page.cursor = result + size;
+          return result;
+        }
+      }
+
+      return allocateSlow(size, alignment);
+    }
+
+    // Objects are never destroyed, only trivially destructible types can be created.
+    template<typename T, typename... Arguments>
+    T* create(Arguments&&... arguments)
+    {
+      static_assert(std::is_trivially_destructible_v<T>, "Arena objects are released without running destructors.");
+      return new (allocate(sizeof(T), alignof(T))) T(std::forward<Arguments>(arguments)...);
+    }
+
+    template<typename T>
+    T* allocateArray(size_t count)
+    {
+      return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Bytes handed out for the current frame, including the unused tails of thread pages.
+    size_t getUsed() const;
+    size_t getPeak() const;
+
+  private:
+    struct ThreadPage
+    {
+      uint64 tag { 0 };
+      uint8* cursor { nullptr };
+      uint8* end { nullptr };
+    };
+
+    struct Arena
+    {
+      uint8* block { nullptr };
+      size_t capacity { 0 };
+      std::atomic<size_t> offset { 0 };
+      size_t peak { 0 };
+
+      std::mutex overflow_mutex;
+      std::vector<uint8*> overflow_blocks;
+    };
+
+    void* allocateSlow(size_t size, size_t alignment);
+    uint8* allocateFromArena(size_t size);
+    void resetArena(Arena& arena);
+    void releaseArenas();
+
+  private:
+    static thread_local ThreadPage thread_page;
+
+    size_t initial_capacity;
+    std::unique_ptr<Arena[]> arenas;
+    uint32 frame_count { 0 };
+    Arena* current_arena { nullptr };
+    // Unique across all allocators and frames, thread pages with another tag are stale.
+    uint64 frame_tag;
+  };
+
+  // Defined inline so the fast path reads it without a TLS wrapper call.
+  inline thread_local FrameAllocator::ThreadPage FrameAllocator::thread_page;
+
+  template<typename T>
+  using FrameVector = std::vector<T, ArenaAllocator<T, FrameAllocator>>;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <common/math.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+  // Single threaded bump allocator. Individual allocations are never freed, reset() releases all of
+  // them at once. When the block runs out a twice as large one is chained, the next reset replaces
+  // the chain by one block large enough for the peak so steady state needs no heap calls.
+  // Alignments up to block_alignment are supported.
+  class LinearAllocator
+  {
+  public:
+    static constexpr size_t block_alignment = 64;
+    static constexpr size_t min_block_size = 64 * 1024;
+
+    explicit LinearAllocator(size_t capacity = 0);
+    ~LinearAllocator();
+
+    LinearAllocator(const LinearAllocator&) = delete;
+    LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+      // Blocks are block_alignment aligned, so aligning the offset aligns the address.
+      size_t offset = alignUp(used, alignment);
+      if (offset + size <= capacity)
+      {
+        used = offset + size;
+        return block + offset;
+      }
+
+      return allocateBlock(size, alignment);
+    }
+
+    // Objects are never destroyed, only trivially destructible types can be created.
+    template<typename T, typename... Arguments>
+    T* create(Arguments&&... arguments)
+    {
+      static_assert(std::is_trivially_destructible_v<T>, "Arena objects are released without running destructors.");
+      return new (allocate(sizeof(T), alignof(T))) T(std::forward<Arguments>(arguments)...);
+    }
+
+    template<typename T>
+    T* allocateArray(size_t count)
+    {
+      return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void reset();
+
+    size_t getUsed() const { return retired_used + used; }
+    size_t getPeak() const { return peak; }
+    // Blocks chained since the last reset, 0 once the allocator settled.
+    uint32 getOverflowCount() const { return static_cast<uint32>(retired_blocks.size()); }
+
+  private:
+    void* allocateBlock(size_t size, size_t alignment);
+
+  private:
+    uint8* block { nullptr };
+    size_t capacity { 0 };
+    size_t used { 0 };
+    size_t retired_used { 0 };
+    size_t peak { 0 };
+    std::vector<uint8*> retired_blocks;
+  };
+
+  // Adapts an arena (anything with allocate(size, alignment)) for STL containers. deallocate is a
+  // no-op, the memory comes back when the arena is reset, which must not happen before the container
+  // is gone or cleared.
+  template<typename T, typename Arena>
+  class ArenaAllocator
+  {
+  public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+      using other = ArenaAllocator<U, Arena>;
+    };
+
+    explicit ArenaAllocator(Arena& arena)
+      : arena(&arena)
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U, Arena>& other)
+      : arena(other.getArena())
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+      return static_cast<T*>(arena->allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    Arena* getArena() const { return arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U, Arena>& other) const { return arena == other.getArena(); }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U, Arena>& other) const { return arena != other.getArena(); }
+
+  private:
+    Arena* arena;
+  };
+
+  template<typename T>
+  using LinearVector = std::vector<T, ArenaAllocator<T, LinearAllocator>>;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <common/math.h>
+
+#include <vector>
+
+namespace engine
+{
+  // Two-level segregated fit allocator for address ranges it never touches, such as GPU heaps.
+  // Free blocks are kept in size classes: the first level splits by power of two, the second
+  // linearly into 32 classes, two bitmaps find a fitting class with a few bit scans. allocate and
+  // free are O(1), free merges with the neighbouring free blocks right away. Block bookkeeping
+  // lives on the CPU, offsets are multiples of the granularity.
+  class TlsfAllocator
+  {
+  public:
+    static constexpr uint32 invalid_block = ~0u;
+    static constexpr uint64 default_granularity = 256;
+
+    struct Allocation
+    {
+      uint64 offset { 0 };
+      uint32 block { invalid_block };
+
+      bool isValid() const { return block != invalid_block; }
+    };
+
+    TlsfAllocator() = default;
+    explicit TlsfAllocator(uint64 capacity, uint64 granularity = default_granularity);
+
+    // Forgets all allocations.
+    void reset(uint64 capacity, uint64 granularity = default_granularity);
+
+    // Alignment must be a power of two, sizes are rounded up to the granularity.
+    Allocation allocate(uint64 size, uint64 alignment = 1);
+    void free(uint32 block);
+
+    uint64 getSize(uint32 block) const { return blocks[block].size; }
+    uint64 getCapacity() const { return capacity; }
+    uint64 getUsed() const { return used; }
+    uint32 getAllocationCount() const { return allocation_count; }
+    bool isEmpty() const { return allocation_count == 0; }
+    // Walks the free lists, meant for statistics.
+    uint64 getLargestFreeBlock() const;
+    uint32 getFreeBlockCount() const;
+
+    // Checks the block and free list invariants, for tests and debugging.
+    bool validate() const;
+
+  private:
+    static constexpr uint32 second_level_bits = 5;
+    static constexpr uint32 second_level_count = 1u << second_level_bits;
+    static constexpr uint32 first_level_count = 64;
+
+    struct Block
+    {
+      uint64 offset;
+      uint64 size;
+      uint32 previous_physical;
+      uint32 next_physical;
+      uint32 previous_free;
+      uint32 next_free;
+      bool is_free;
+    };
+
+    void mapping(uint64 size, uint32& first_level, uint32& second_level) const;
+    uint32 findFreeBlock(uint64 size) const;
+    void insertFreeBlock(uint32 block);
+    void removeFreeBlock(uint32 block);
+    uint32 createBlock(uint64 offset, uint64 size);
+    void releaseBlock(uint32 block);
+    // Turns the first size bytes of a free block into their own block, returns the rest.
+    uint32 splitBlock(uint32 block, uint64 size);
+    void mergeBlocks(uint32 block, uint32 next);
+
+  private:
+    uint64 capacity { 0 };
+    uint64 granularity { default_granularity };
+    uint32 granularity_bits { 8 };
+    uint64 used { 0 };
+    uint32 allocation_count { 0 };
+
+    uint64 first_level_bitmap { 0 };
+    uint32 second_level_bitmaps[first_level_count] = {};
+    uint32 free_lists[first_level_count][second_level_count];
+
+    std::vector<Block> blocks;
+    std::vector<uint32> unused_blocks;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <common/types.h>
+#include <common/ring_buffer.h>
+
+namespace engine
+{
+  // All times in milliseconds. The 1% low is the frame rate of the 99th percentile frame time.
+  struct FrameTimeSummary
+  {
+    uint32 frames { 0 };
+    double min { 0.0 };
+    double average { 0.0 };
+    double p50 { 0.0 };
+    double p95 { 0.0 };
+    double p99 { 0.0 };
+    double max { 0.0 };
+    double average_fps { 0.0 };
+    double one_percent_low_fps { 0.0 };
+    uint64 hitches { 0 };
+  };
+
+  // Rolling statistics over the last window_size frame times. Recording a frame is O(1): min and max
+  // come from monotonic queues, the average from a running sum and percentiles from a log-scale
+  // histogram (1/16 octave buckets, ~4% resolution) that is only scanned when queried.
+  class FrameStatistics
+  {
+  public:
+    static const uint32 window_size = 1024;
+
+    void addFrame(double seconds);
+    void reset();
+
+    FrameTimeSummary getSummary() const;
+    double getPercentile(double fraction) const;
+    double getMin() const { return minimums.get(); }
+    double getMax() const { return maximums.get(); }
+    double getAverage() const { return frame_times.empty() ? 0.0 : sum / frame_times.size(); }
+
+    uint64 getFrameCount() const { return frame_count; }
+    uint64 getHitchCount() const { return hitch_count; }
+    bool wasLastFrameHitch() const { return last_frame_hitch; }
+
+    // A hitch is a frame slower than hitch_factor times the rolling median.
+    void setHitchFactor(double factor) { hitch_factor = factor; }
+    // Logs a summary line every interval seconds of recorded frame time, 0 disables it.
+    void setReportInterval(double seconds) { report_interval = seconds; }
+
+    void logSummary() const;
+
+  private:
+    static const uint32 buckets_per_octave = 16;
+    static const uint32 bucket_count = 16 * buckets_per_octave;
+    static constexpr double min_bucket_milliseconds = 1.0 / 16.0;
+
+    template<bool Maximum>
+    class RollingExtreme
+    {
+    public:
+      void push(uint64 index, float value)
+      {
+        // Expired entries leave first, so a full window of monotonic values never overwrites head.
+        while (count > 0 && entries[head].index + window_size <= index)
+        {
+          head = (head + 1) % window_size;
+          count--;
+        }
+
+        while (count > 0 && (Maximum ? entries[back()].value <= value : entries[back()].value >= value))
+        {
+          count--;
+        }
+
+        entries[(head + count) % window_size] = Entry { index, value };
+        count++;
+      }
+
+      void clear()
+      {
+        head = 0;
+        count = 0;
+      }
+
+      float get() const { return count > 0 ? entries[head].value : 0.0f; }
+
+    private:
+      struct Entry
+      {
+        uint64 index;
+        float value;
+      };
+
+      uint32 back() const { return (head + count - 1) % window_size; }
+
+      Entry entries[window_size];
+      uint32 head { 0 };
+      uint32 count { 0 };
+    };
+
+    static uint32 getBucket(float milliseconds);
+    static double getBucketValue(uint32 bucket);
+
+  private:
+    RingBuffer<float, window_size> frame_times;
+    RollingExtreme<false> minimums;
+    RollingExtreme<true> maximums;
+    uint32 histogram[bucket_count] = {};
+    double sum { 0.0 };
+
+    uint64 frame_count { 0 };
+    uint64 hitch_count { 0 };
+    bool last_frame_hitch { false };
+    double hitch_factor { 2.0 };
+    double median { 0.0 };
+
+    double report_interval { 0.0 };
+    double time_since_report { 0.0 };
+  };
+}
\ No newline at end of file
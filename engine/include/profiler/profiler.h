@@ -0,0 +1,91 @@
+#pragma once
+
+#include <common/types.h>
+#include <common/timer.h>
+
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ENGINE_PROFILER_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ENGINE_PROFILER_TSC
+#endif
+
+namespace engine
+{
+  // Hierarchical CPU profiler. Every thread records completed scopes into its own ring buffer without
+  // taking locks, the rings are only walked on export. Nesting is recovered from the timestamps.
+  class Profiler
+  {
+  public:
+    struct Event
+    {
+      const char* name;
+      uint64 begin;
+      uint64 end;
+    };
+
+    static const uint32 events_per_thread = 1 << 15;
+    // Threads recording at the same time, rings of exited threads go to new ones.
+    static const uint32 max_threads = 64;
+
+    // Raw timestamp: TSC ticks where available, steady clock nanoseconds otherwise.
+    static uint64 now()
+    {
+#if defined(ENGINE_PROFILER_TSC)
+      return __rdtsc();
+#else
+      return Timer::nowNanoseconds();
+#endif
+    }
+
+    // The name must outlive the profiler, string literals and __func__ are fine.
+    static void record(const char* name, uint64 begin, uint64 end);
+    static void setThreadName(const char* name);
+
+    // Chrome trace event JSON, opens in chrome://tracing and ui.perfetto.dev.
+    static bool exportChromeTrace(const std::string& path);
+
+    static uint64 getEventCount();
+    // Not synchronized with recording threads, call it while they are idle.
+    static void clear();
+  };
+
+  class ProfileScope
+  {
+  public:
+    explicit ProfileScope(const char* name)
+      : name(name)
+      , begin(Profiler::now())
+    {
+    }
+
+    ~ProfileScope()
+    {
+      Profiler::record(name, begin, Profiler::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+  private:
+    const char* name;
+    uint64 begin;
+  };
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Configure with -DENABLE_PROFILER=OFF to compile every scope out.
+#if defined(ENGINE_PROFILER)
+#define PROFILE_SCOPE(name) ::engine::ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD_NAME(name) ::engine::Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#endif
\ No newline at end of file
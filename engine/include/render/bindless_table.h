@@ -0,0 +1,56 @@
+#pragma once
+
+#include <render/descriptor_allocator.h>
+
+#include <deque>
+#include <vector>
+
+namespace engine
+{
+  using BindlessIndex = uint32;
+
+  // Global table of shader resource descriptors, a range of the persistent region of the shader
+  // visible heap. Resources are added once and keep their index, shaders take indices through root
+  // constants and index the heap directly, so draws never set up descriptor tables. Indices count
+  // from the start of the heap: the table bound once per command list starts there as well.
+  // Removed slots are reused once the fence of the frame that removed them retired. Not synchronized.
+  class BindlessTable
+  {
+  public:
+    static constexpr uint32 default_capacity = 16384;
+
+    // Invalid when the heap's persistent region has no room.
+    bool initialize(ShaderVisibleDescriptorHeap& heap, uint32 capacity = default_capacity);
+
+    // Copies a staging descriptor into a free slot, invalid_id when the table is full.
+    BindlessIndex add(CpuDescriptorHandle source);
+    // Replaces the descriptor of a slot the GPU doesn't read in frames in flight.
+    void update(BindlessIndex index, CpuDescriptorHandle source);
+    void remove(BindlessIndex index);
+
+    void endFrame(uint64 fence_value);
+    void retire(uint64 completed_fence_value);
+
+    // Root descriptor table covering the whole heap, for root signatures without direct heap indexing.
+    GpuDescriptorHandle getTableStart() const { return heap ? heap->getHeapInfo().gpu_start : GpuDescriptorHandle {}; }
+    uint32 getCapacity() const { return range.count; }
+    // Slots in use, including removed ones the GPU may still read.
+    uint32 getCount() const { return range.count - static_cast<uint32>(free_slots.size()); }
+
+  private:
+    struct PendingRemoval
+    {
+      uint64 fence_value;
+      uint32 slot;
+    };
+
+    static constexpr uint64 untagged_fence_value = ~0ull;
+
+  private:
+    ShaderVisibleDescriptorHeap* heap { nullptr };
+    DescriptorAllocation range;
+    // Popped from the back, filled so low slots go out first.
+    std::vector<uint32> free_slots;
+    std::deque<PendingRemoval> pending_removals;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <common/types.h>
+
+namespace engine
+{
+  // Backend-neutral handles. Backends map them to their native objects.
+  using ResourceId = uint32;
+  using PipelineId = uint32;
+  using RootSignatureId = uint32;
+  using GpuVirtualAddress = uint64;
+
+  constexpr uint32 invalid_id = ~0u;
+  constexpr uint32 all_subresources = 0xffffffff;
+
+  struct CpuDescriptorHandle
+  {
+    uint64 ptr { 0 };
+  };
+
+  struct GpuDescriptorHandle
+  {
+    uint64 ptr { 0 };
+  };
+
+  // Values match D3D12_COMMAND_LIST_TYPE.
+  enum class CommandListType : uint8
+  {
+    Direct = 0,
+    Compute = 2,
+    Copy = 3,
+  };
+
+  // Every list type has a queue of its own: graphics, async compute and copy.
+  constexpr uint32 queue_count = 3;
+  constexpr uint32 getQueueIndex(CommandListType type) { return type == CommandListType::Direct ? 0 : static_cast<uint32>(type) - 1; }
+
+  // Values match D3D12_RESOURCE_STATES so the D3D12 backend can cast them directly.
+  enum class ResourceState : uint32
+  {
+    Common = 0,
+    Present = 0,
+    VertexAndConstantBuffer = 0x1,
+    IndexBuffer = 0x2,
+    RenderTarget = 0x4,
+    UnorderedAccess = 0x8,
+    DepthWrite = 0x10,
+    DepthRead = 0x20,
+    NonPixelShaderResource = 0x40,
+    PixelShaderResource = 0x80,
+    IndirectArgument = 0x200,
+    CopyDest = 0x400,
+    CopySource = 0x800,
+    GenericRead = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+  };
+
+  constexpr ResourceState operator|(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32>(a) | static_cast<uint32>(b)); }
+  constexpr ResourceState operator&(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32>(a) & static_cast<uint32>(b)); }
+
+  // Values match D3D12_RESOURCE_BARRIER_FLAGS.
+  enum class BarrierFlags : uint8
+  {
+    None = 0,
+    BeginOnly = 1,
+    EndOnly = 2,
+  };
+
+  enum class BarrierType : uint8
+  {
+    Transition = 0,
+    Aliasing = 1,
+    UnorderedAccess = 2,
+  };
+
+  struct ResourceBarrier
+  {
+    BarrierType type { BarrierType::Transition };
+    BarrierFlags flags { BarrierFlags::None };
+    ResourceId resource { invalid_id };
+    // Only used by aliasing barriers, resource is the one aliased before.
+    ResourceId resource_after { invalid_id };
+    uint32 subresource { all_subresources };
+    ResourceState state_before { ResourceState::Common };
+    ResourceState state_after { ResourceState::Common };
+
+    static ResourceBarrier transition(ResourceId resource, ResourceState before, ResourceState after, uint32 subresource = all_subresources, BarrierFlags flags = BarrierFlags::None)
+    {
+      ResourceBarrier barrier;
+      barrier.type = BarrierType::Transition;
+      barrier.flags = flags;
+      barrier.resource = resource;
+      barrier.subresource = subresource;
+      barrier.state_before = before;
+      barrier.state_after = after;
+      return barrier;
+    }
+
+    static ResourceBarrier aliasing(ResourceId before, ResourceId after)
+    {
+      ResourceBarrier barrier;
+      barrier.type = BarrierType::Aliasing;
+      barrier.resource = before;
+      barrier.resource_after = after;
+      return barrier;
+    }
+
+    static ResourceBarrier unorderedAccess(ResourceId resource)
+    {
+      ResourceBarrier barrier;
+      barrier.type = BarrierType::UnorderedAccess;
+      barrier.resource = resource;
+      return barrier;
+    }
+  };
+
+  // Values match D3D_PRIMITIVE_TOPOLOGY.
+  enum class PrimitiveTopology : uint8
+  {
+    PointList = 1,
+    LineList = 2,
+    LineStrip = 3,
+    TriangleList = 4,
+    TriangleStrip = 5,
+  };
+
+  struct Viewport
+  {
+    float x { 0.0f };
+    float y { 0.0f };
+    float width { 0.0f };
+    float height { 0.0f };
+    float min_depth { 0.0f };
+    float max_depth { 1.0f };
+  };
+
+  struct ScissorRect
+  {
+    int32 left { 0 };
+    int32 top { 0 };
+    int32 right { 0 };
+    int32 bottom { 0 };
+  };
+
+  struct VertexBufferView
+  {
+    GpuVirtualAddress location { 0 };
+    uint32 size { 0 };
+    uint32 stride { 0 };
+  };
+
+  struct IndexBufferView
+  {
+    GpuVirtualAddress location { 0 };
+    uint32 size { 0 };
+    bool is_32bit { false };
+  };
+
+  // Backend-neutral mirror of ID3D12GraphicsCommandList. Everything the engine records goes through
+  // this interface, so the null backend can capture the whole frame without a GPU.
+  class CommandList
+  {
+  public:
+    virtual ~CommandList() = default;
+
+    virtual CommandListType getType() const = 0;
+    virtual void close() = 0;
+
+    virtual void resourceBarrier(const ResourceBarrier* barriers, uint32 count) = 0;
+    virtual void clearRenderTargetView(CpuDescriptorHandle rtv, const float color[4]) = 0;
+    virtual void setRenderTargets(const CpuDescriptorHandle* rtvs, uint32 count, const CpuDescriptorHandle* dsv) = 0;
+    virtual void setViewport(const Viewport& viewport) = 0;
+    virtual void setScissorRect(const ScissorRect& rect) = 0;
+
+    virtual void setPipelineState(PipelineId pipeline) = 0;
+    virtual void setGraphicsRootSignature(RootSignatureId root_signature) = 0;
+    virtual void setGraphicsRootDescriptorTable(uint32 root_index, GpuDescriptorHandle base_descriptor) = 0;
+    virtual void setGraphicsRoot32BitConstants(uint32 root_index, uint32 count, const void* data, uint32 offset) = 0;
+    virtual void setGraphicsRootConstantBufferView(uint32 root_index, GpuVirtualAddress address) = 0;
+
+    virtual void setPrimitiveTopology(PrimitiveTopology topology) = 0;
+    virtual void setVertexBuffers(uint32 start_slot, const VertexBufferView* views, uint32 count) = 0;
+    virtual void setIndexBuffer(const IndexBufferView& view) = 0;
+    virtual void drawInstanced(uint32 vertex_count, uint32 instance_count, uint32 start_vertex, uint32 start_instance) = 0;
+    virtual void drawIndexedInstanced(uint32 index_count, uint32 instance_count, uint32 start_index, int32 base_vertex, uint32 start_instance) = 0;
+    virtual void dispatch(uint32 groups_x, uint32 groups_y, uint32 groups_z) = 0;
+    virtual void copyBufferRegion(ResourceId dst, uint64 dst_offset, ResourceId src, uint64 src_offset, uint64 size) = 0;
+  };
+}
\ No newline at end of file
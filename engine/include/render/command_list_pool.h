@@ -0,0 +1,99 @@
+#pragma once
+
+#include <render/command_list.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine
+{
+  // A command list with an allocator of its own, created by the backend.
+  class CommandContext
+  {
+  public:
+    virtual ~CommandContext() = default;
+
+    virtual CommandList& getCommandList() = 0;
+    // Resets the allocator and opens the list, the GPU must be done with what it recorded.
+    virtual void reset() = 0;
+  };
+
+  class CommandListThreadRegistry;
+
+  // Command lists for recording on many threads. Every frame index keeps the contexts of each
+  // thread that recorded in it, acquire hands the calling thread one of its own and resets it there,
+  // so allocators are never shared between threads and reset in parallel. beginFrame recycles the
+  // contexts of a frame index once its fence retired. Lists are submitted sorted by the order passed
+  // to acquire, unique orders make the submission independent of which thread recorded what.
+  // Threads give their slot back when they exit, threads beyond max_threads share one under a lock.
+  class CommandListPool
+  {
+  public:
+    using CreateContext = std::function<std::unique_ptr<CommandContext>(CommandListType type)>;
+
+    static constexpr uint32 max_threads = 64;
+
+    void initialize(CreateContext create_context, uint32 frame_count);
+    // Drops all contexts, only called when the GPU is idle.
+    void setFrameCount(uint32 frame_count);
+
+    void beginFrame(uint32 frame_index);
+    // Thread safe between beginFrame and collect. The list is open, the caller closes it.
+    CommandList& acquire(uint32 order, CommandListType type = CommandListType::Direct);
+    // Appends the lists acquired this frame in submission order.
+    void collect(std::vector<CommandList*>& lists);
+
+    uint32 getAcquiredCount() const;
+    uint32 getContextCount() const { return context_count.load(std::memory_order_relaxed); }
+
+  private:
+    struct Entry
+    {
+      std::unique_ptr<CommandContext> context;
+      CommandListType type;
+      uint32 order;
+    };
+
+    // Only the thread owning the slot touches it while recording.
+    struct alignas(64) ThreadContexts
+    {
+      std::vector<Entry> entries;
+      uint32 used { 0 };
+    };
+
+    // The last slot is shared by the threads that found no free one.
+    static const uint32 overflow_thread = max_threads;
+
+    struct Frame
+    {
+      ThreadContexts threads[max_threads + 1];
+    };
+
+    struct Submission
+    {
+      uint32 order;
+      uint32 thread;
+      uint32 index;
+      CommandList* list;
+    };
+
+    uint32 getThreadIndex();
+
+  private:
+    CreateContext create_context;
+    std::vector<std::unique_ptr<Frame>> frames;
+    uint32 frame_index { 0 };
+    uint32 instance_id { 0 };
+    std::atomic<uint32> context_count { 0 };
+
+    std::shared_ptr<CommandListThreadRegistry> thread_registry;
+    // One past the highest slot handed out.
+    std::atomic<uint32> thread_count { 0 };
+    std::mutex overflow_mutex;
+
+    std::vector<Submission> submissions;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <render/command_stream.h>
+#include <render/upload_ring.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace engine
+{
+  // Records every call into the CommandStream it was reset with.
+  class CommandRecorder : public CommandList
+  {
+  public:
+    explicit CommandRecorder(CommandListType type);
+
+    void reset(CommandStream* allocator);
+    const CommandStream* getStream() const { return stream; }
+    bool isOpen() const { return is_open; }
+
+    CommandListType getType() const override { return type; }
+    void close() override;
+
+    void resourceBarrier(const ResourceBarrier* barriers, uint32 count) override;
+    void clearRenderTargetView(CpuDescriptorHandle rtv, const float color[4]) override;
+    void setRenderTargets(const CpuDescriptorHandle* rtvs, uint32 count, const CpuDescriptorHandle* dsv) override;
+    void setViewport(const Viewport& viewport) override;
+    void setScissorRect(const ScissorRect& rect) override;
+
+    void setPipelineState(PipelineId pipeline) override;
+    void setGraphicsRootSignature(RootSignatureId root_signature) override;
+    void setGraphicsRootDescriptorTable(uint32 root_index, GpuDescriptorHandle base_descriptor) override;
+    void setGraphicsRoot32BitConstants(uint32 root_index, uint32 count, const void* data, uint32 offset) override;
+    void setGraphicsRootConstantBufferView(uint32 root_index, GpuVirtualAddress address) override;
+
+    void setPrimitiveTopology(PrimitiveTopology topology) override;
+    void setVertexBuffers(uint32 start_slot, const VertexBufferView* views, uint32 count) override;
+    void setIndexBuffer(const IndexBufferView& view) override;
+    void drawInstanced(uint32 vertex_count, uint32 instance_count, uint32 start_vertex, uint32 start_instance) override;
+    void drawIndexedInstanced(uint32 index_count, uint32 instance_count, uint32 start_index, int32 base_vertex, uint32 start_instance) override;
+    void dispatch(uint32 groups_x, uint32 groups_y, uint32 groups_z) override;
+    void copyBufferRegion(ResourceId dst, uint64 dst_offset, ResourceId src, uint64 src_offset, uint64 size) override;
+
+  private:
+    CommandStream* stream { nullptr };
+    CommandListType type;
+    bool is_open { false };
+  };
+
+  // The upload ring range a frame wrote while it was recorded, and the allocation replay copied it to.
+  struct UploadRemap
+  {
+    ResourceId resource { invalid_id };
+    GpuVirtualAddress address { 0 };
+    // A power of two, the range at offset may wrap around the end of the buffer.
+    uint64 buffer_size { 0 };
+    uint64 offset { 0 };
+    uint64 size { 0 };
+    UploadAllocation replayed;
+  };
+
+  // Records a CommandStream into another list, of any backend. The back buffer of the recorded
+  // frame can be swapped for another one, in barriers and render target views, and addresses into
+  // its upload range moved to where replay uploaded it again.
+  class CommandReplayer
+  {
+  public:
+    void setBackBuffer(ResourceId recorded, CpuDescriptorHandle recorded_view, ResourceId replayed, CpuDescriptorHandle replayed_view);
+    // An empty range leaves every address as recorded.
+    void setUploadRemap(const UploadRemap& remap) { upload = remap; }
+    // Returns the number of commands recorded.
+    uint32 replay(const uint8* data, uint64 size, CommandList& command_list);
+
+  private:
+    ResourceId remap(ResourceId resource) const { return resource == recorded_back_buffer ? replayed_back_buffer : resource; }
+    CpuDescriptorHandle remap(CpuDescriptorHandle view) const { return view.ptr == recorded_view.ptr ? replayed_view : view; }
+    // Offset into the recorded range, or size when the buffer offset lies outside of it.
+    uint64 getUploadOffset(uint64 buffer_offset) const { return std::min((buffer_offset - upload.offset) & (upload.buffer_size - 1), upload.size); }
+    GpuVirtualAddress remapAddress(GpuVirtualAddress address) const;
+
+  private:
+    ResourceId recorded_back_buffer { invalid_id };
+    ResourceId replayed_back_buffer { invalid_id };
+    CpuDescriptorHandle recorded_view;
+    CpuDescriptorHandle replayed_view;
+    UploadRemap upload;
+
+    // Arrays are copied out of the stream, packets only guarantee 4 byte alignment for them.
+    std::vector<ResourceBarrier> barriers;
+    std::vector<CpuDescriptorHandle> render_targets;
+    std::vector<VertexBufferView> vertex_buffers;
+  };
+}
\ No newline at end of file
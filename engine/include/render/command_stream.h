@@ -0,0 +1,154 @@
+#pragma once
+
+#include <render/command_list.h>
+
+#include <cstring>
+#include <vector>
+
+namespace engine
+{
+  enum class CommandType : uint16
+  {
+    ResourceBarrier,
+    ClearRenderTargetView,
+    SetRenderTargets,
+    SetViewport,
+    SetScissorRect,
+    SetPipelineState,
+    SetGraphicsRootSignature,
+    SetGraphicsRootDescriptorTable,
+    SetGraphicsRoot32BitConstants,
+    SetGraphicsRootConstantBufferView,
+    SetPrimitiveTopology,
+    SetVertexBuffers,
+    SetIndexBuffer,
+    DrawInstanced,
+    DrawIndexedInstanced,
+    Dispatch,
+    CopyBufferRegion,
+    Count
+  };
+
+  // Every packet starts with a header, followed by a fixed payload and an optional array of
+  // count elements. Packets are padded to command_stream_alignment bytes.
+  struct CommandHeader
+  {
+    CommandType type;
+    uint16 count;
+    uint32 size;
+  };
+
+  constexpr uint32 command_stream_alignment = 8;
+
+  struct ClearRenderTargetViewCommand { CpuDescriptorHandle rtv; float color[4]; };
+  struct SetRenderTargetsCommand { CpuDescriptorHandle dsv; uint32 has_dsv; };
+  struct SetGraphicsRootDescriptorTableCommand { uint32 root_index; GpuDescriptorHandle base_descriptor; };
+  struct SetGraphicsRoot32BitConstantsCommand { uint32 root_index; uint32 offset; };
+  struct SetGraphicsRootConstantBufferViewCommand { uint32 root_index; GpuVirtualAddress address; };
+  struct SetVertexBuffersCommand { uint32 start_slot; };
+  struct DrawInstancedCommand { uint32 vertex_count; uint32 instance_count; uint32 start_vertex; uint32 start_instance; };
+  struct DrawIndexedInstancedCommand { uint32 index_count; uint32 instance_count; uint32 start_index; int32 base_vertex; uint32 start_instance; };
+  struct DispatchCommand { uint32 groups_x; uint32 groups_y; uint32 groups_z; };
+  struct CopyBufferRegionCommand { ResourceId dst; ResourceId src; uint64 dst_offset; uint64 src_offset; uint64 size; };
+
+  // Append-only byte stream of command packets. Like a D3D12 command allocator it keeps its memory
+  // between resets, growth_count tells how often recording had to hit the heap.
+  class CommandStream
+  {
+  public:
+    template<typename T>
+    void write(CommandType type, const T& payload)
+    {
+      writePacket(type, &payload, sizeof(T), nullptr, 0, 0);
+    }
+
+    template<typename T, typename E>
+    void write(CommandType type, const T& payload, const E* elements, uint32 count)
+    {
+      writePacket(type, &payload, sizeof(T), elements, static_cast<uint32>(sizeof(E)) * count, count);
+    }
+
+    template<typename E>
+    void writeArray(CommandType type, const E* elements, uint32 count)
+    {
+      writePacket(type, nullptr, 0, elements, static_cast<uint32>(sizeof(E)) * count, count);
+    }
+
+    void reset()
+    {
+      data.clear();
+      command_count = 0;
+    }
+
+    const uint8* getData() const { return data.data(); }
+    uint64 getSize() const { return data.size(); }
+    uint64 getCapacity() const { return data.capacity(); }
+    uint32 getCommandCount() const { return command_count; }
+    uint32 getGrowthCount() const { return growth_count; }
+
+  private:
+    void writePacket(CommandType type, const void* payload, uint32 payload_size, const void* elements, uint32 array_size, uint32 count)
+    {
+      const uint32 size = payload_size + array_size;
+      const uint64 packet_size = (sizeof(CommandHeader) + size + command_stream_alignment - 1) & ~uint64(command_stream_alignment - 1);
+      const uint64 offset = data.size();
+      if (offset + packet_size > data.capacity())
+      {
+        growth_count++;
+      }
+      data.resize(offset + packet_size);
+
+      uint8* packet = data.data() + offset;
+      CommandHeader header { type, static_cast<uint16>(count), size };
+      std::memcpy(packet, &header, sizeof(CommandHeader));
+      if (payload_size > 0)
+      {
+        std::memcpy(packet + sizeof(CommandHeader), payload, payload_size);
+      }
+      if (array_size > 0)
+      {
+        std::memcpy(packet + sizeof(CommandHeader) + payload_size, elements, array_size);
+      }
+      command_count++;
+    }
+
+  private:
+    std::vector<uint8> data;
+    uint32 command_count { 0 };
+    uint32 growth_count { 0 };
+  };
+
+  class CommandStreamReader
+  {
+  public:
+    CommandStreamReader(const uint8* data, uint64 size) : data(data), size(size) {}
+
+    // Returns false at the end of the stream. payload points at the fixed part of the packet.
+    bool next(CommandHeader& header, const uint8*& payload)
+    {
+      if (offset + sizeof(CommandHeader) > size)
+      {
+        return false;
+      }
+
+      std::memcpy(&header, data + offset, sizeof(CommandHeader));
+      payload = data + offset + sizeof(CommandHeader);
+      offset += (sizeof(CommandHeader) + header.size + command_stream_alignment - 1) & ~uint64(command_stream_alignment - 1);
+
+      return true;
+    }
+
+    template<typename T>
+    static T read(const uint8* payload)
+    {
+      T value;
+      std::memcpy(&value, payload, sizeof(T));
+      return value;
+    }
+
+  private:
+    const uint8* data;
+    uint64 size;
+    uint64 offset { 0 };
+  };
+}
\ No newline at end of file
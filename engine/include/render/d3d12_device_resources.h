@@ -0,0 +1,174 @@
+#pragma once
+
+#include <common/pch.h>
+#include <common/handle_pool.h>
+#include <device_resources.h>
+
+#include <memory>
+#include <vector>
+
+namespace engine
+{
+  using namespace Microsoft::WRL;
+
+  class D3D12DeviceResources;
+
+  class D3D12CommandList : public CommandList
+  {
+  public:
+    D3D12CommandList(const D3D12DeviceResources& owner, ComPtr<ID3D12GraphicsCommandList> command_list, CommandListType type);
+
+    void reset(ID3D12CommandAllocator* command_allocator);
+    ID3D12GraphicsCommandList* getNative() const { return command_list.Get(); }
+
+    CommandListType getType() const override { return type; }
+    void close() override;
+
+    void resourceBarrier(const ResourceBarrier* barriers, uint32 count) override;
+    void clearRenderTargetView(CpuDescriptorHandle rtv, const float color[4]) override;
+    void setRenderTargets(const CpuDescriptorHandle* rtvs, uint32 count, const CpuDescriptorHandle* dsv) override;
+    void setViewport(const Viewport& viewport) override;
+    void setScissorRect(const ScissorRect& rect) override;
+
+    void setPipelineState(PipelineId pipeline) override;
+    void setGraphicsRootSignature(RootSignatureId root_signature) override;
+    void setGraphicsRootDescriptorTable(uint32 root_index, GpuDescriptorHandle base_descriptor) override;
+    void setGraphicsRoot32BitConstants(uint32 root_index, uint32 count, const void* data, uint32 offset) override;
+    void setGraphicsRootConstantBufferView(uint32 root_index, GpuVirtualAddress address) override;
+
+    void setPrimitiveTopology(PrimitiveTopology topology) override;
+    void setVertexBuffers(uint32 start_slot, const VertexBufferView* views, uint32 count) override;
+    void setIndexBuffer(const IndexBufferView& view) override;
+    void drawInstanced(uint32 vertex_count, uint32 instance_count, uint32 start_vertex, uint32 start_instance) override;
+    void drawIndexedInstanced(uint32 index_count, uint32 instance_count, uint32 start_index, int32 base_vertex, uint32 start_instance) override;
+    void dispatch(uint32 groups_x, uint32 groups_y, uint32 groups_z) override;
+    void copyBufferRegion(ResourceId dst, uint64 dst_offset, ResourceId src, uint64 src_offset, uint64 size) override;
+
+  private:
+    const D3D12DeviceResources& owner;
+    ComPtr<ID3D12GraphicsCommandList> command_list;
+    CommandListType type;
+  };
+
+  class D3D12CommandContext : public CommandContext
+  {
+  public:
+    D3D12CommandContext(D3D12DeviceResources& owner, ComPtr<ID3D12CommandAllocator> command_allocator, std::unique_ptr<D3D12CommandList> command_list);
+
+    CommandList& getCommandList() override { return *command_list; }
+    void reset() override;
+
+  private:
+    D3D12DeviceResources& owner;
+    ComPtr<ID3D12CommandAllocator> command_allocator;
+    std::unique_ptr<D3D12CommandList> command_list;
+  };
+
+  class D3D12DeviceResources : public DeviceResources
+  {
+  public:
+    ~D3D12DeviceResources() override;
+
+    bool checkTearingSupport() override;
+
+    // Ids are generational handles, released ids are detected and resolve to null.
+    ResourceId registerResource(ComPtr<ID3D12Resource> resource);
+    PipelineId registerPipelineState(ComPtr<ID3D12PipelineState> pipeline_state);
+    RootSignatureId registerRootSignature(ComPtr<ID3D12RootSignature> root_signature);
+    // The GPU must be done with the object, the pool drops its reference right away.
+    void releaseResource(ResourceId id) { resources.destroy(ResourceHandle(id)); }
+    void releasePipelineState(PipelineId id) { pipeline_states.destroy(PipelineHandle(id)); }
+    void releaseRootSignature(RootSignatureId id) { root_signatures.destroy(RootSignatureHandle(id)); }
+
+    ID3D12Resource* getResource(ResourceId id) const { return getNative(resources, id); }
+    ID3D12PipelineState* getPipelineState(PipelineId id) const { return getNative(pipeline_states, id); }
+    ID3D12RootSignature* getRootSignature(RootSignatureId id) const { return getNative(root_signatures, id); }
+    ID3D12Device2* getDevice() const { return device.Get(); }
+    ID3D12Heap* getHeap(HeapId id) const { return getNative(heaps, id); }
+    ID3D12DescriptorHeap* getDescriptorHeap(DescriptorHeapId id) const { return getNative(descriptor_heaps, id); }
+
+    // Staging view to add to the BindlessTable or copy into tables, freed through the staging allocator.
+    DescriptorAllocation createShaderResourceView(ResourceId resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc = nullptr);
+
+    // Creates a resource at offset in the range of a GpuMemoryAllocator allocation and registers it.
+    // Render graph transients share one allocation per heap usage at the offsets it computes.
+    ResourceId createPlacedResource(GpuAllocation allocation, uint64 offset, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value = nullptr);
+
+    inline HANDLE getFenceEvent() const { return fence_event; }
+
+    // Sets the shader visible descriptor heaps, every list needs them after a reset.
+    void bindDescriptorHeaps(D3D12CommandList& command_list) const;
+
+  protected:
+    void createDeviceResources(const SurfaceDesc& surface) override;
+    void resizeFrameResources(uint32 frame_count) override;
+    CommandList& resetCommandList(uint32 frame_index) override;
+    std::unique_ptr<CommandContext> createCommandContext(CommandListType type) override;
+    void executeCommandLists(CommandListType queue, CommandList* const* command_lists, uint32 count) override;
+    void signalQueue(CommandListType queue, uint64 value) override;
+    uint64 getCompletedFenceValue(CommandListType queue) override;
+    void waitForQueue(CommandListType queue, CommandListType signaled_queue, uint64 value) override;
+    void waitForFenceValue(uint64 value) override;
+    void present(uint32 sync_interval, bool allow_tearing) override;
+    void resizeSwapChain(uint32 width, uint32 height) override;
+    uint32 queryCurrentBackBufferIndex() override;
+    ResourceId getBackBuffer(uint32 index) const override { return back_buffer_ids[index]; }
+    CpuDescriptorHandle getBackBufferView(uint32 index) const override;
+    bool waitForFrameLatencyObject(uint32 timeout_milliseconds) override;
+    void updateMaximumFrameLatency() override;
+    UploadMemory createUploadMemory(uint64 size) override;
+    HeapId createHeap(const HeapDesc& desc) override;
+    void destroyHeap(HeapId heap) override;
+    DescriptorHeapInfo createDescriptorHeap(const DescriptorHeapDesc& desc) override;
+    void copyDescriptors(DescriptorHeapType type, const DescriptorCopyBatch& batch) override;
+
+  private:
+    using ResourceHandle = HandlePool<ComPtr<ID3D12Resource>>::HandleType;
+    using PipelineHandle = HandlePool<ComPtr<ID3D12PipelineState>>::HandleType;
+    using RootSignatureHandle = HandlePool<ComPtr<ID3D12RootSignature>>::HandleType;
+    using HeapHandle = HandlePool<ComPtr<ID3D12Heap>>::HandleType;
+    using DescriptorHeapHandle = HandlePool<ComPtr<ID3D12DescriptorHeap>>::HandleType;
+
+    template<typename T>
+    static T* getNative(const HandlePool<ComPtr<T>>& pool, uint32 id)
+    {
+      const ComPtr<T>* object = pool.get(typename HandlePool<ComPtr<T>>::HandleType(id));
+      return object ? object->Get() : nullptr;
+    }
+
+    void enableDebugLayer();
+    ComPtr<IDXGIAdapter4> getAdapter(bool use_warp);
+    ComPtr<ID3D12Device2> createDevice(ComPtr<IDXGIAdapter4> adapter);
+    ComPtr<ID3D12CommandQueue> createCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
+    ComPtr<IDXGISwapChain4> createSwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> command_queue, uint32 width, uint32 height, uint32 buffer_count);
+    ComPtr<ID3D12DescriptorHeap> createDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32 num_descriptors, D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
+    ComPtr<ID3D12CommandAllocator> createCommandAllocator(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
+    ComPtr<ID3D12GraphicsCommandList> createCommandList(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandAllocator> command_allocator, D3D12_COMMAND_LIST_TYPE type);
+
+    ComPtr<ID3D12Fence> createFence(ComPtr<ID3D12Device2> device);
+    HANDLE createEventHandle();
+    void waitForFenceValue(ComPtr<ID3D12Fence> fence, uint64 fence_value, HANDLE fence_event, std::chrono::milliseconds duration = std::chrono::milliseconds::max());
+
+    void updateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swap_chain);
+
+  private:
+    ComPtr<ID3D12Device2> device;
+    // Graphics, async compute and copy queues, indexed by getQueueIndex.
+    ComPtr<ID3D12CommandQueue> command_queues[queue_count];
+    ComPtr<IDXGISwapChain4> swap_chain;
+    std::unique_ptr<D3D12CommandList> command_list;
+    std::vector<ComPtr<ID3D12CommandAllocator>> command_allocators;
+    DescriptorAllocation back_buffer_views;
+    std::vector<ResourceId> back_buffer_ids;
+
+    HandlePool<ComPtr<ID3D12Resource>> resources;
+    HandlePool<ComPtr<ID3D12PipelineState>> pipeline_states;
+    HandlePool<ComPtr<ID3D12RootSignature>> root_signatures;
+    HandlePool<ComPtr<ID3D12Heap>> heaps;
+    HandlePool<ComPtr<ID3D12DescriptorHeap>> descriptor_heaps;
+
+    ComPtr<ID3D12Fence> fences[queue_count];
+    HANDLE fence_event { nullptr };
+    HANDLE frame_latency_waitable_object { nullptr };
+  };
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <memory/tlsf_allocator.h>
+#include <render/command_list.h>
+
+#include <functional>
+#include <vector>
+
+namespace engine
+{
+  using DescriptorHeapId = uint32;
+
+  // Values match D3D12_DESCRIPTOR_HEAP_TYPE.
+  enum class DescriptorHeapType : uint8
+  {
+    CbvSrvUav = 0,
+    Sampler = 1,
+    Rtv = 2,
+    Dsv = 3,
+  };
+
+  struct DescriptorHeapDesc
+  {
+    DescriptorHeapType type { DescriptorHeapType::CbvSrvUav };
+    uint32 capacity { 0 };
+    bool shader_visible { false };
+  };
+
+  // A heap created by the backend: where it starts and the stride between its descriptors.
+  struct DescriptorHeapInfo
+  {
+    DescriptorHeapId id { invalid_id };
+    CpuDescriptorHandle cpu_start;
+    // Zero for CPU-only heaps.
+    GpuDescriptorHandle gpu_start;
+    uint32 increment { 0 };
+    uint32 capacity { 0 };
+  };
+
+  struct DescriptorAllocation
+  {
+    CpuDescriptorHandle cpu;
+    GpuDescriptorHandle gpu;
+    // Position in the heap, shaders index shader visible heaps with it.
+    uint32 index { 0 };
+    uint32 count { 0 };
+    uint32 increment { 0 };
+    // Staging heap and block within it, only for allocations that are freed one by one.
+    uint32 heap { invalid_id };
+    uint32 block { TlsfAllocator::invalid_block };
+
+    bool isValid() const { return count != 0; }
+    CpuDescriptorHandle getCpuHandle(uint32 offset = 0) const { return CpuDescriptorHandle { cpu.ptr + uint64(offset) * increment }; }
+    GpuDescriptorHandle getGpuHandle(uint32 offset = 0) const { return GpuDescriptorHandle { gpu.ptr + uint64(offset) * increment }; }
+  };
+
+  // Ranges for one CopyDescriptors call, laid out like its arguments: the destination ranges are
+  // filled from the concatenated source ranges.
+  struct DescriptorCopyBatch
+  {
+    std::vector<CpuDescriptorHandle> destination_starts;
+    std::vector<uint32> destination_sizes;
+    std::vector<CpuDescriptorHandle> source_starts;
+    std::vector<uint32> source_sizes;
+
+    bool empty() const { return destination_starts.empty(); }
+    void clear();
+  };
+
+  using CreateDescriptorHeap = std::function<DescriptorHeapInfo(const DescriptorHeapDesc& desc)>;
+  using CopyDescriptors = std::function<void(DescriptorHeapType type, const DescriptorCopyBatch& batch)>;
+
+  // CPU-only descriptors of one type: views are created here and copied into shader visible
+  // heaps when bound. Heaps are created on demand and never released, each is split by a
+  // TlsfAllocator so ranges are allocated and freed in O(1). Not synchronized.
+  class StagingDescriptorAllocator
+  {
+  public:
+    static constexpr uint32 default_heap_capacity = 4096;
+
+    void initialize(DescriptorHeapType type, CreateDescriptorHeap create_heap, uint32 heap_capacity = default_heap_capacity);
+
+    // Invalid when the backend couldn't create a heap or count exceeds the heap capacity.
+    DescriptorAllocation allocate(uint32 count = 1);
+    void free(const DescriptorAllocation& allocation);
+
+    DescriptorHeapType getType() const { return type; }
+    uint32 getHeapCount() const { return static_cast<uint32>(heaps.size()); }
+    uint32 getAllocatedCount() const;
+    // Free ranges and the largest of them across all heaps, a measure of fragmentation.
+    uint32 getFreeRangeCount() const;
+    uint32 getLargestFreeRange() const;
+
+  private:
+    struct Heap
+    {
+      DescriptorHeapInfo info;
+      TlsfAllocator allocator;
+    };
+
+    DescriptorAllocation makeAllocation(uint32 heap, const TlsfAllocator::Allocation& allocation, uint32 count) const;
+
+  private:
+    DescriptorHeapType type { DescriptorHeapType::CbvSrvUav };
+    CreateDescriptorHeap create_heap;
+    uint32 heap_capacity { default_heap_capacity };
+    std::vector<Heap> heaps;
+    uint32 search_start { 0 };
+  };
+
+  // The shader visible heap of one type that command lists bind. The first persistent_count
+  // descriptors are allocated and freed individually and stay where they are, the rest is a ring of
+  // transient tables that endFrame tags with the frame's fence and retire hands back, like the
+  // UploadRing. Tables are filled from staging descriptors, the copies are queued and issued as one
+  // CopyDescriptors call by flushCopies, which has to run before the command lists are submitted.
+  // Not synchronized.
+  class ShaderVisibleDescriptorHeap
+  {
+  public:
+    static const uint32 max_pending_frames = 16;
+
+    void initialize(DescriptorHeapType type, const DescriptorHeapInfo& heap, uint32 persistent_count, CopyDescriptors copy_descriptors);
+
+    // The GPU must be done with a persistent range before it is freed.
+    DescriptorAllocation allocatePersistent(uint32 count = 1);
+    void freePersistent(const DescriptorAllocation& allocation);
+    // Valid until the fence of the frame it was allocated in completes, invalid when the ring is full.
+    DescriptorAllocation allocateTransient(uint32 count);
+
+    // Queues copying count staging descriptors to destination, starting offset descriptors in.
+    void copy(const DescriptorAllocation& destination, uint32 offset, const CpuDescriptorHandle* sources, uint32 count);
+    // Allocates a transient table and queues copying the sources into it.
+    DescriptorAllocation stageTable(const CpuDescriptorHandle* sources, uint32 count);
+    void flushCopies();
+
+    void endFrame(uint64 fence_value);
+    void retire(uint64 completed_fence_value);
+
+    const DescriptorHeapInfo& getHeapInfo() const { return heap; }
+    uint32 getPersistentUsed() const { return static_cast<uint32>(persistent.getUsed()); }
+    // Descriptors held by frames in flight and the frame being recorded, including skipped ring tails.
+    uint32 getTransientUsed() const { return static_cast<uint32>(head - tail); }
+    uint64 getFailedAllocations() const { return failed_allocations; }
+    uint64 getCopyCallCount() const { return copy_call_count; }
+
+  private:
+    struct PendingFrame
+    {
+      uint64 fence_value;
+      uint64 head;
+    };
+
+    DescriptorAllocation makeAllocation(uint32 index, uint32 count) const;
+
+  private:
+    DescriptorHeapType type { DescriptorHeapType::CbvSrvUav };
+    DescriptorHeapInfo heap;
+    CopyDescriptors copy_descriptors;
+    DescriptorCopyBatch batch;
+    uint64 copy_call_count { 0 };
+
+    TlsfAllocator persistent;
+    uint32 persistent_count { 0 };
+
+    // Positions on the transient ring, they only grow.
+    uint32 transient_count { 0 };
+    uint64 head { 0 };
+    uint64 tail { 0 };
+    uint64 failed_allocations { 0 };
+
+    PendingFrame pending_frames[max_pending_frames] = {};
+    uint32 first_pending { 0 };
+    uint32 pending_count { 0 };
+  };
+
+  // Every descriptor heap of a device: staging allocators for all four types and shader visible
+  // heaps for CBV/SRV/UAV and samplers. Staging heaps appear on first use, shader visible ones are
+  // created by createShaderVisibleHeaps once the device exists.
+  class DescriptorAllocator
+  {
+  public:
+    struct Settings
+    {
+      uint32 staging_heap_capacity { StagingDescriptorAllocator::default_heap_capacity };
+      uint32 resource_heap_capacity { 65536 };
+      uint32 resource_persistent_count { 32768 };
+      // Taken from the front of the persistent region.
+      uint32 bindless_capacity { 16384 };
+      // D3D12 caps shader visible sampler heaps at 2048.
+      uint32 sampler_heap_capacity { 2048 };
+      uint32 sampler_persistent_count { 1024 };
+    };
+
+    void initialize(CreateDescriptorHeap create_heap, CopyDescriptors copy_descriptors, const Settings& settings);
+    void initialize(CreateDescriptorHeap create_heap, CopyDescriptors copy_descriptors) { initialize(std::move(create_heap), std::move(copy_descriptors), Settings {}); }
+    void createShaderVisibleHeaps();
+
+    StagingDescriptorAllocator& getStaging(DescriptorHeapType type) { return staging[static_cast<uint32>(type)]; }
+    ShaderVisibleDescriptorHeap& getResourceHeap() { return resource_heap; }
+    ShaderVisibleDescriptorHeap& getSamplerHeap() { return sampler_heap; }
+    const ShaderVisibleDescriptorHeap& getResourceHeap() const { return resource_heap; }
+    const ShaderVisibleDescriptorHeap& getSamplerHeap() const { return sampler_heap; }
+
+    void flushCopies();
+    void endFrame(uint64 fence_value);
+    void retire(uint64 completed_fence_value);
+
+  private:
+    Settings settings;
+    CreateDescriptorHeap create_heap;
+    CopyDescriptors copy_descriptors;
+
+    StagingDescriptorAllocator staging[4];
+    ShaderVisibleDescriptorHeap resource_heap;
+    ShaderVisibleDescriptorHeap sampler_heap;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <common/ring_buffer.h>
+#include <render/render_limits.h>
+
+#include <algorithm>
+
+namespace engine
+{
+  // CPU-side view of a queue fence: which values were signaled, which frames they belong to and
+  // the last value known to be complete. Pure bookkeeping, the owner feeds it completed values.
+  class FenceTimeline
+  {
+  public:
+    static const uint32 max_tracked_frames = RenderLimits::max_frame_latency;
+
+    uint64 signal()
+    {
+      return ++last_signaled_value;
+    }
+
+    uint64 signalFrame()
+    {
+      uint64 value = signal();
+      frame_values.push(value);
+      return value;
+    }
+
+    void updateCompleted(uint64 value)
+    {
+      completed_value = std::max(completed_value, value);
+    }
+
+    bool isComplete(uint64 value) const { return value <= completed_value; }
+
+    // Frames signaled but not complete, as of the last updateCompleted.
+    uint32 getFramesInFlight() const
+    {
+      uint32 frames = 0;
+      for (uint32 i = frame_values.size(); i > 0 && frame_values[i - 1] > completed_value; --i)
+      {
+        frames++;
+      }
+      return frames;
+    }
+
+    // Value that has to complete before another frame may be recorded without exceeding max_frame_latency.
+    uint64 getFrameLatencyValue(uint32 max_frame_latency) const
+    {
+      if (max_frame_latency == 0 || frame_values.size() < max_frame_latency)
+      {
+        return 0;
+      }
+      return frame_values[frame_values.size() - max_frame_latency];
+    }
+
+    uint64 getLastSignaledValue() const { return last_signaled_value; }
+    uint64 getCompletedValue() const { return completed_value; }
+
+  private:
+    uint64 last_signaled_value { 0 };
+    uint64 completed_value { 0 };
+    RingBuffer<uint64, max_tracked_frames> frame_values;
+  };
+}
\ No newline at end of file
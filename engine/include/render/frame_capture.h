@@ -0,0 +1,131 @@
+#pragma once
+
+#include <render/command_recorder.h>
+#include <render/upload_ring.h>
+
+#include <string>
+#include <vector>
+
+namespace engine
+{
+  struct FrameCaptureHeader
+  {
+    static constexpr char magic_value[8] = { 'E', 'N', 'G', 'F', 'R', 'A', 'M', 'E' };
+    // Bump when the event layout or a command payload changes.
+    static const uint32 current_version = 2;
+
+    char magic[8];
+    uint32 version;
+    uint32 header_size;
+    ResourceId back_buffer;
+    uint32 event_count;
+    CpuDescriptorHandle back_buffer_view;
+    uint32 command_list_count;
+    uint32 command_count;
+
+    // Upload ring the frame was recorded with and the range of it the frame wrote, see UploadRemap.
+    ResourceId upload_resource;
+    uint32 reserved;
+    GpuVirtualAddress upload_address;
+    uint64 upload_buffer_size;
+    uint64 upload_offset;
+    uint64 upload_size;
+  };
+
+  // The command lists of one frame and the queue synchronization between them in submission order,
+  // serialized into one byte buffer that can be saved and loaded again. Lists keep their
+  // CommandStream packets. The bytes the frame wrote to the upload ring follow the events, replay
+  // uploads them again and points constant buffer, vertex, index and copy source addresses there.
+  // Other resources, pipelines and descriptors are stored by id and handle, so a capture can only be
+  // replayed on the device that recorded it while those objects are alive, with their contents then.
+  class FrameCapture
+  {
+  public:
+    enum class EventType : uint8
+    {
+      Submit,
+      Signal,
+      Wait,
+    };
+
+    // Submit events are followed by list_count lists, each a uint64 size and the stream padded to
+    // command_stream_alignment bytes.
+    struct Event
+    {
+      EventType type;
+      CommandListType queue;
+      CommandListType signaled_queue;
+      uint8 reserved;
+      uint32 list_count;
+      uint64 value;
+    };
+
+    class Reader
+    {
+    public:
+      explicit Reader(const FrameCapture& capture);
+
+      // Returns false after the last event, lists of a submit have to be read before the next one.
+      bool next(Event& event);
+      // False when the capture ends before the list.
+      bool nextCommandList(const uint8*& data, uint64& size);
+
+    private:
+      const uint8* data;
+      uint64 size;
+      uint64 offset;
+    };
+
+    FrameCapture();
+
+    // Starts an empty capture of a frame rendering to back_buffer.
+    void reset(ResourceId back_buffer, CpuDescriptorHandle back_buffer_view);
+    void addSubmit(CommandListType queue, const CommandStream* const* streams, uint32 count);
+    void addSignal(CommandListType queue, uint64 value);
+    void addWait(CommandListType queue, CommandListType signaled_queue, uint64 value);
+    // Ends the capture with size bytes of the upload ring starting at buffer offset offset, the
+    // caller writes them to the returned pointer.
+    uint8* addUploads(const UploadMemory& memory, uint64 offset, uint64 size);
+
+    bool save(const std::string& path) const;
+    // False when the file or data isn't a complete capture of the current version, with valid
+    // queues and well formed command packets.
+    bool load(const std::string& path);
+    bool load(const uint8* data, uint64 size);
+
+    const uint8* getData() const { return data.data(); }
+    const uint8* getUploadData() const { return data.data() + data.size() - header.upload_size; }
+    UploadRemap getUploadRemap() const;
+    uint64 getSize() const { return data.size(); }
+    const FrameCaptureHeader& getHeader() const { return header; }
+
+  private:
+    void addEvent(const Event& event);
+    void writeHeader();
+
+  private:
+    std::vector<uint8> data;
+    FrameCaptureHeader header;
+  };
+
+  // Records into a stream of its own while capturing and into the backend list it wraps when closed.
+  class CaptureCommandList : public CommandRecorder
+  {
+  public:
+    explicit CaptureCommandList(CommandListType type)
+      : CommandRecorder(type)
+    {
+    }
+
+    // The target has to be open.
+    void reset(CommandList& target);
+    CommandList* getTarget() const { return target; }
+
+    void close() override;
+
+  private:
+    CommandStream stream;
+    CommandList* target { nullptr };
+    CommandReplayer replayer;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <common/handle_pool.h>
+#include <memory/tlsf_allocator.h>
+#include <render/command_list.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace engine
+{
+  using HeapId = uint32;
+
+  // Values match D3D12_HEAP_TYPE.
+  enum class HeapType : uint8
+  {
+    Default = 1,
+    Upload = 2,
+    Readback = 3,
+  };
+
+  // Resource heap tier 1 hardware can't mix these in one heap.
+  enum class HeapUsage : uint8
+  {
+    Buffers,
+    Textures,
+    RenderTargets,
+  };
+
+  struct HeapDesc
+  {
+    HeapType type { HeapType::Default };
+    HeapUsage usage { HeapUsage::Buffers };
+    uint64 size { 0 };
+    uint64 alignment { 0 };
+  };
+
+  struct GpuAllocationTag;
+  using GpuAllocation = Handle<GpuAllocationTag>;
+
+  struct GpuHeapRange
+  {
+    HeapId heap { invalid_id };
+    uint64 offset { 0 };
+    uint64 size { 0 };
+  };
+
+  struct GpuAllocationMove
+  {
+    GpuAllocation allocation;
+    GpuHeapRange source;
+    GpuHeapRange destination;
+    // Keeps the source reserved until endDefragmentation.
+    uint32 source_block;
+  };
+
+  // Places resources in large heaps instead of giving each its own. Every heap type and usage has
+  // a pool of heaps, each heap is split by a TlsfAllocator. Heaps are created on demand through the
+  // backend, requests larger than a heap get a dedicated one. Heaps that become empty are released,
+  // except the last one of a pool. Not synchronized.
+  class GpuMemoryAllocator
+  {
+  public:
+    static constexpr uint64 default_heap_size = 64 * 1024 * 1024;
+    // D3D12 placement alignments for resources and MSAA textures.
+    static constexpr uint64 default_placement_alignment = 64 * 1024;
+    static constexpr uint64 msaa_placement_alignment = 4 * 1024 * 1024;
+
+    using CreateHeap = std::function<HeapId(const HeapDesc& desc)>;
+    using DestroyHeap = std::function<void(HeapId heap)>;
+
+    struct PoolStats
+    {
+      uint32 heap_count { 0 };
+      uint32 allocation_count { 0 };
+      uint64 capacity { 0 };
+      uint64 used { 0 };
+      uint64 largest_free_block { 0 };
+    };
+
+    GpuMemoryAllocator() = default;
+    GpuMemoryAllocator(const GpuMemoryAllocator&) = delete;
+    GpuMemoryAllocator& operator=(const GpuMemoryAllocator&) = delete;
+
+    void initialize(CreateHeap create_heap, DestroyHeap destroy_heap, uint64 heap_size = default_heap_size);
+    // Destroys all heaps through the backend. The destructor only drops the bookkeeping, the
+    // backend may already be gone by then.
+    void shutdown();
+
+    // Invalid when the backend couldn't create a heap.
+    GpuAllocation allocate(HeapType type, HeapUsage usage, uint64 size, uint64 alignment = default_placement_alignment);
+    // The GPU must be done with the range.
+    void free(GpuAllocation allocation);
+    // Null for stale handles.
+    const GpuHeapRange* getRange(GpuAllocation allocation) const;
+
+    // Plans moves that empty the least used heaps of a pool into the others, up to max_bytes.
+    // Allocations report their destination right away, sources stay reserved until the caller has
+    // copied the data, rebound the resources and passes the moves to endDefragmentation.
+    std::vector<GpuAllocationMove> beginDefragmentation(HeapType type, HeapUsage usage, uint64 max_bytes);
+    void endDefragmentation(const std::vector<GpuAllocationMove>& moves);
+
+    PoolStats getPoolStats(HeapType type, HeapUsage usage) const;
+
+  private:
+    struct Heap
+    {
+      HeapId id;
+      TlsfAllocator allocator;
+      uint64 alignment;
+      bool dedicated;
+    };
+
+    struct Pool
+    {
+      HeapType type;
+      HeapUsage usage;
+      std::vector<std::unique_ptr<Heap>> heaps;
+    };
+
+    struct Record
+    {
+      Heap* heap;
+      uint32 pool;
+      uint32 block;
+      uint64 alignment;
+      GpuHeapRange range;
+    };
+
+    static constexpr uint32 pool_count = 9;
+
+    static uint32 getPoolIndex(HeapType type, HeapUsage usage) { return (static_cast<uint32>(type) - 1) * 3 + static_cast<uint32>(usage); }
+    Heap* createHeap(uint32 pool, uint64 size, uint64 alignment, uint64 granularity, bool dedicated);
+    void destroyHeap(uint32 pool, Heap* heap);
+    Heap* findHeap(HeapId id, uint32& pool);
+    void freeBlock(uint32 pool, Heap* heap, uint32 block);
+
+  private:
+    CreateHeap create_heap;
+    DestroyHeap destroy_heap;
+    uint64 heap_size { default_heap_size };
+
+    Pool pools[pool_count];
+    HandlePool<Record, GpuAllocationTag> records;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <device_resources.h>
+#include <render/command_recorder.h>
+#include <common/timer.h>
+
+#include <vector>
+
+namespace engine
+{
+  // The null backend only records, submission counts the recorded commands.
+  using NullCommandList = CommandRecorder;
+
+  class NullCommandContext : public CommandContext
+  {
+  public:
+    explicit NullCommandContext(CommandListType type)
+      : command_list(type)
+    {
+    }
+
+    CommandList& getCommandList() override { return command_list; }
+    void reset() override { command_list.reset(&stream); }
+
+  private:
+    CommandStream stream;
+    NullCommandList command_list;
+  };
+
+  // GPU-less backend. Command lists record into in-memory streams and every queue is simulated by a
+  // timeline that completes each submission after a configurable amount of GPU time. Queues run
+  // in parallel, a queue waiting for another one's fence starts its next work no earlier than that.
+  class NullDeviceResources : public DeviceResources
+  {
+  public:
+    struct Settings
+    {
+      std::chrono::nanoseconds gpu_time_per_submit { 0 };
+      std::chrono::nanoseconds gpu_time_per_command { 0 };
+    };
+
+    struct Stats
+    {
+      uint64 frames { 0 };
+      uint64 submits { 0 };
+      uint64 command_lists { 0 };
+      uint64 commands { 0 };
+      uint64 bytes_recorded { 0 };
+      uint64 fence_waits { 0 };
+      std::chrono::nanoseconds fence_wait_time { 0 };
+      uint64 descriptor_copy_calls { 0 };
+      uint64 descriptors_copied { 0 };
+      uint64 queue_waits { 0 };
+      // Simulated GPU time of the work submitted to each queue.
+      std::chrono::nanoseconds queue_busy_time[queue_count] = {};
+    };
+
+    NullDeviceResources();
+    explicit NullDeviceResources(const Settings& settings);
+
+    bool checkTearingSupport() override { return false; }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+    // Allocator behaviour across all frames: how often recording grew a stream and the largest one.
+    uint64 getAllocatorGrowthCount() const;
+    uint64 getPeakAllocatorSize() const;
+
+    // Heaps created for the GpuMemoryAllocator and not destroyed yet.
+    uint32 getHeapCount() const { return heap_count; }
+    const CommandStream& getFrameStream(uint32 frame_index) const { return command_allocators[frame_index]; }
+    uint32 getWidth() const { return width; }
+    uint32 getHeight() const { return height; }
+    // When the queue finishes the work submitted so far.
+    Timer::Clock::time_point getQueueIdleTime(CommandListType queue) const { return queues[getQueueIndex(queue)].gpu_idle_time; }
+
+  protected:
+    void createDeviceResources(const SurfaceDesc& surface) override;
+    void resizeFrameResources(uint32 frame_count) override;
+    CommandList& resetCommandList(uint32 frame_index) override;
+    std::unique_ptr<CommandContext> createCommandContext(CommandListType type) override { return std::make_unique<NullCommandContext>(type); }
+    void executeCommandLists(CommandListType queue, CommandList* const* command_lists, uint32 count) override;
+    void signalQueue(CommandListType queue, uint64 value) override;
+    uint64 getCompletedFenceValue(CommandListType queue) override;
+    void waitForQueue(CommandListType queue, CommandListType signaled_queue, uint64 value) override;
+    void waitForFenceValue(uint64 value) override;
+    void present(uint32 sync_interval, bool allow_tearing) override;
+    void resizeSwapChain(uint32 width, uint32 height) override;
+    uint32 queryCurrentBackBufferIndex() override { return swap_chain_index; }
+    ResourceId getBackBuffer(uint32 index) const override { return index; }
+    CpuDescriptorHandle getBackBufferView(uint32 index) const override { return CpuDescriptorHandle { index + 1ull }; }
+    bool waitForFrameLatencyObject(uint32 timeout_milliseconds) override;
+    // The latency object reads max_frame_latency when it is waited on.
+    void updateMaximumFrameLatency() override {}
+    UploadMemory createUploadMemory(uint64 size) override;
+    HeapId createHeap(const HeapDesc& desc) override;
+    void destroyHeap(HeapId heap) override;
+    DescriptorHeapInfo createDescriptorHeap(const DescriptorHeapDesc& desc) override;
+    void copyDescriptors(DescriptorHeapType type, const DescriptorCopyBatch& batch) override;
+
+  private:
+    struct PendingSignal
+    {
+      uint64 value;
+      Timer::Clock::time_point completion_time;
+    };
+
+    struct Queue
+    {
+      Timer::Clock::time_point gpu_idle_time;
+      std::vector<PendingSignal> pending_signals;
+      uint64 completed_fence_value { 0 };
+    };
+
+    void retireSignals(Queue& queue, Timer::Clock::time_point now);
+
+  private:
+    Settings settings;
+    Stats stats;
+
+    NullCommandList command_list;
+    std::vector<CommandStream> command_allocators;
+    uint32 swap_chain_index { 0 };
+    std::vector<uint8> upload_memory;
+    HeapId next_heap_id { 0 };
+    uint32 heap_count { 0 };
+    DescriptorHeapId next_descriptor_heap_id { 0 };
+
+    Queue queues[queue_count];
+  };
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <memory/tlsf_allocator.h>
+#include <render/command_list.h>
+#include <render/gpu_memory_allocator.h>
+#include <render/resource_state_tracker.h>
+
+#include <functional>
+#include <vector>
+
+namespace engine
+{
+  // Placement of a transient resource. The format is a DXGI_FORMAT value, size and alignment are
+  // what the backend reports for the resource. Buffers leave the texture fields alone.
+  struct TransientResourceDesc
+  {
+    uint32 width { 0 };
+    uint32 height { 0 };
+    uint16 depth_or_array_size { 1 };
+    uint16 mip_levels { 1 };
+    uint32 format { 0 };
+    uint32 sample_count { 1 };
+    HeapUsage usage { HeapUsage::RenderTargets };
+    uint64 size { 0 };
+    uint64 alignment { GpuMemoryAllocator::default_placement_alignment };
+  };
+
+  // One version of a render graph resource, every write makes a new one.
+  struct RenderGraphResource
+  {
+    uint32 version { invalid_id };
+
+    bool isValid() const { return version != invalid_id; }
+  };
+
+  // Device side of running a graph on several queues.
+  class RenderGraphQueues
+  {
+  public:
+    virtual ~RenderGraphQueues() = default;
+
+    // An open list for one batch of passes on the queue.
+    virtual CommandList& acquireCommandList(CommandListType queue) = 0;
+    // Closes and submits the list, with signal set returns the fence value the queue signals after it.
+    virtual uint64 submit(CommandListType queue, CommandList& command_list, bool signal) = 0;
+    // Holds queue back on the GPU until signaled_queue reached value.
+    virtual void wait(CommandListType queue, CommandListType signaled_queue, uint64 value) = 0;
+  };
+
+  class RenderGraph;
+
+  // Declares the reads and writes of the pass RenderGraph::addPass just added.
+  class RenderGraphPassBuilder
+  {
+  public:
+    RenderGraphResource read(RenderGraphResource resource, ResourceState state);
+    // Writes modify the given version, which must be the latest, and return the next one.
+    RenderGraphResource write(RenderGraphResource resource, ResourceState state);
+    // Keeps the pass even when nothing reads what it writes.
+    RenderGraphPassBuilder& setSideEffects();
+    // Runs the pass on the async compute or copy queue, overlapping the graphics queue.
+    RenderGraphPassBuilder& setQueue(CommandListType queue);
+
+  private:
+    friend class RenderGraph;
+
+    RenderGraphPassBuilder(RenderGraph& graph, uint32 pass)
+      : graph(graph)
+      , pass(pass)
+    {
+    }
+
+    RenderGraph& graph;
+    uint32 pass;
+  };
+
+  // Frame graph built again every frame. Passes declare what they read and write, compile then
+  // culls passes nothing depends on, orders the rest topologically, computes the lifetime of every
+  // transient resource and places transients whose lifetimes don't overlap in the same heap memory.
+  // Barriers are computed once per compile with a ResourceStateTracker: transitions are batched
+  // per pass, the transition to a resource's next use starts as a split barrier right after its
+  // previous use, and memory taken over from another transient gets an aliasing barrier.
+  //
+  // Transients start each frame in the state of their first use and are returned to it after their
+  // last use, so realized resources can be kept from frame to frame. The first use must initialize
+  // aliased memory with a clear, discard or full write. Imported resources are left in their final
+  // state. Not synchronized, reset, build and compile on one thread.
+  //
+  // Passes may run on the async compute or copy queue. Compile splits the schedule into batches
+  // per queue and orders every use of a resource after the previous one: on the same queue by
+  // submission order, across queues by waiting for the batch that signals after the earlier use.
+  // Waits are dropped when the queue already waited for a later point of that queue, directly or
+  // through another queue, and the graphics queue joins the other queues before the graph ends.
+  // Transitions an async queue can't record are recorded on the graphics queue before the pass,
+  // split barriers stay on the graphics queue, and transients used by async passes are not aliased.
+  class RenderGraph
+  {
+  public:
+    using ExecuteFunction = std::function<void(CommandList& command_list, const RenderGraph& graph)>;
+    // Creates a transient resource at heap_offset in the heap of desc.usage and returns it.
+    using RealizeFunction = std::function<ResourceId(const char* name, const TransientResourceDesc& desc, ResourceState initial_state, uint64 heap_offset)>;
+
+    static constexpr uint32 heap_usage_count = 3;
+
+    struct Stats
+    {
+      uint32 passes { 0 };
+      uint32 culled_passes { 0 };
+      uint32 transient_resources { 0 };
+      uint32 barriers { 0 };
+      uint32 split_barriers { 0 };
+      uint32 aliasing_barriers { 0 };
+      // Sum of the transient sizes, what they would need without aliasing.
+      uint64 transient_size { 0 };
+      uint64 heap_sizes[heap_usage_count] = {};
+      uint32 batches { 0 };
+      // Uses of a resource on another queue than its previous use, and the waits that remain.
+      uint32 cross_queue_dependencies { 0 };
+      uint32 sync_points { 0 };
+    };
+
+    // Passes submitted together to one queue.
+    struct Batch
+    {
+      CommandListType queue;
+      uint32 unit_begin;
+      uint32 unit_count;
+      uint32 wait_begin;
+      uint32 wait_count;
+      uint32 pass_count;
+      // Another queue waits for it.
+      bool signal;
+    };
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // Forgets passes and resources, keeps the memory for the next frame.
+    void reset();
+
+    RenderGraphResource createResource(const char* name, const TransientResourceDesc& desc);
+    // A resource the graph doesn't own, used from state and left in final_state after the graph.
+    RenderGraphResource importResource(const char* name, ResourceId resource, ResourceState state, ResourceState final_state);
+    RenderGraphPassBuilder addPass(const char* name, ExecuteFunction execute);
+
+    // False when the passes depend on each other in a cycle.
+    bool compile();
+    // Asks for the physical resource of every transient that survived culling.
+    void realize(const RealizeFunction& realize);
+    // Records every pass on one list, whatever queue it asked for.
+    void execute(CommandList& command_list);
+    // Submits the batches in order, with the waits compile kept.
+    void execute(RenderGraphQueues& queues);
+
+    // Physical resource, valid after realize.
+    ResourceId getResource(RenderGraphResource resource) const;
+    // Size the heap of every usage needs after compile.
+    uint64 getHeapSize(HeapUsage usage) const { return stats.heap_sizes[static_cast<uint32>(usage)]; }
+    uint64 getHeapOffset(RenderGraphResource resource) const;
+
+    // Pass indices in execution order.
+    const std::vector<uint32>& getSchedule() const { return schedule; }
+    uint32 getPassCount() const { return static_cast<uint32>(passes.size()); }
+    const char* getPassName(uint32 pass) const { return passes[pass].name; }
+    bool isCulled(uint32 pass) const { return !passes[pass].live; }
+    // Batches in submission order.
+    uint32 getBatchCount() const { return static_cast<uint32>(batches.size()); }
+    const Batch& getBatch(uint32 batch) const { return batches[batch]; }
+    // Batch a scheduled pass runs in.
+    uint32 getPassBatch(uint32 pass) const { return units[passes[pass].unit].batch; }
+    // Barriers recorded before the pass, with virtual resource indices.
+    const ResourceBarrier* getPassBarriers(uint32 pass, uint32& count) const;
+    const Stats& getStats() const { return stats; }
+
+  private:
+    friend class RenderGraphPassBuilder;
+
+    static constexpr uint64 placement_granularity = GpuMemoryAllocator::default_placement_alignment;
+
+    struct Resource
+    {
+      const char* name;
+      TransientResourceDesc desc;
+      ResourceId physical;
+      ResourceState initial_state;
+      ResourceState final_state;
+      bool imported;
+      // Used by a pass on an async queue, lives the whole graph.
+      bool async;
+      uint32 latest_version;
+
+      // Schedule positions of the first and last use, invalid when culled.
+      uint32 first;
+      uint32 last;
+      uint64 offset;
+      uint32 block;
+      bool needs_aliasing;
+      // Transient whose memory it takes over, invalid when it takes over several.
+      uint32 aliased;
+    };
+
+    struct Version
+    {
+      uint32 resource;
+      uint32 producer;
+      uint32 previous;
+      uint32 reader_begin;
+      uint32 reader_count;
+    };
+
+    struct Access
+    {
+      uint32 pass;
+      uint32 resource;
+      // Version read, or version made by a write.
+      uint32 version;
+      ResourceState state;
+      bool write;
+      // Next use of the resource in schedule order.
+      uint32 next;
+    };
+
+    struct Pass
+    {
+      const char* name;
+      ExecuteFunction execute;
+      uint32 first_access;
+      uint32 access_count;
+      CommandListType queue;
+      bool side_effects;
+      bool live;
+      uint32 position;
+      uint32 barrier_begin;
+      uint32 barrier_count;
+      // Barriers recorded on the graphics queue, the pass's queue can't.
+      bool hoisted;
+      uint32 unit;
+    };
+
+    // What one batch records in order: a pass with its barriers or barriers alone.
+    struct Unit
+    {
+      uint32 pass;
+      CommandListType queue;
+      uint32 barrier_begin;
+      uint32 barrier_count;
+      uint32 wait_begin;
+      uint32 wait_count;
+      bool signal;
+      uint32 batch;
+      // Per queue, one past the last unit known to be done when this one is.
+      uint32 clock[queue_count];
+    };
+
+    struct FreedRange
+    {
+      uint32 resource;
+      uint64 begin;
+      uint64 end;
+    };
+
+    uint32 getPlacementFirst(const Resource& resource) const { return resource.async ? 0 : resource.first; }
+    uint32 getPlacementLast(const Resource& resource) const { return resource.async ? static_cast<uint32>(schedule.size()) - 1 : resource.last; }
+
+    RenderGraphResource addResource(const char* name, const TransientResourceDesc& desc, ResourceId physical, ResourceState state, ResourceState final_state, bool imported);
+    uint32 addAccess(uint32 pass, uint32 version, ResourceState state, bool write);
+    void cull();
+    bool sortPasses();
+    void computeLifetimes();
+    void placeResources();
+    void computeBarriers();
+    void buildBatches();
+    uint32 addUnit(uint32 pass, CommandListType queue, uint32 barrier_begin, uint32 barrier_count);
+    void addDependency(uint32 unit, uint32 resource, uint32 (&needed)[queue_count]);
+    void resolveWaits(uint32 unit, uint32 (&needed)[queue_count]);
+    void recordUnit(CommandList& command_list, const Unit& unit);
+    static bool isAllowed(CommandListType queue, const ResourceBarrier& barrier);
+    void submitBarriers(CommandList& command_list, uint32 begin, uint32 count);
+
+  private:
+    std::vector<Resource> resources;
+    std::vector<Version> versions;
+    std::vector<Access> accesses;
+    std::vector<Pass> passes;
+
+    std::vector<uint32> schedule;
+    std::vector<ResourceBarrier> barriers;
+    uint32 final_barrier_begin { 0 };
+    uint32 final_barrier_count { 0 };
+
+    std::vector<Unit> units;
+    std::vector<uint32> waits;
+    std::vector<Batch> batches;
+    std::vector<uint32> batch_units;
+    std::vector<Batch> opened_batches;
+    std::vector<uint64> batch_values;
+    uint32 queue_clocks[queue_count][queue_count] = {};
+
+    // Compile scratch, kept to avoid allocating every frame.
+    std::vector<uint32> stack;
+    std::vector<uint32> readers;
+    std::vector<uint32> edges;
+    std::vector<uint32> successor_begin;
+    std::vector<uint32> successors;
+    std::vector<uint32> in_degree;
+    std::vector<uint32> ready;
+    std::vector<uint32> last_use;
+    std::vector<uint32> first_uses;
+    std::vector<uint32> first_use_begin;
+    std::vector<uint32> last_uses;
+    std::vector<uint32> last_use_begin;
+    std::vector<FreedRange> freed[heap_usage_count];
+    std::vector<ResourceBarrier> submitted;
+    TlsfAllocator allocators[heap_usage_count];
+    ResourceStateTracker tracker;
+
+    Stats stats;
+  };
+}
\ No newline at end of file
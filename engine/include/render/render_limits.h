@@ -0,0 +1,16 @@
+#pragma once
+
+#include <common/types.h>
+
+namespace engine
+{
+  // Upper bounds of the render settings. The config clamps to them, the render classes size their
+  // per-frame arrays by them.
+  struct RenderLimits
+  {
+    static const uint32 max_frame_count = 8;
+    static const uint32 max_swap_chain_buffers = 16;
+    // Frames FenceTimeline keeps the fence values of, which bounds the frame latency.
+    static const uint32 max_frame_latency = 16;
+  };
+}
\ No newline at end of file
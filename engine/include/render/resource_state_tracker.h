@@ -0,0 +1,85 @@
+#pragma once
+
+#include <render/command_list.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+  // Knows the state of every registered resource and its subresources and turns state requirements
+  // into barriers. require only queues what a pass needs, flush emits the batch with one
+  // resourceBarrier call right before the pass records its work. Requirements the resource already
+  // meets are dropped, read states combine, and a resource required twice in one batch keeps a
+  // single barrier to the last state. prepare starts a transition early as a split barrier, the
+  // matching require ends it. Writing an unordered access resource again gets a UAV barrier.
+  // Not synchronized, requirements are resolved in submission order.
+  class ResourceStateTracker
+  {
+  public:
+    struct Stats
+    {
+      uint64 requests { 0 };
+      uint64 barriers { 0 };
+      uint64 elided { 0 };
+      uint64 split_barriers { 0 };
+      uint64 flushes { 0 };
+    };
+
+    // Registering again replaces the known state.
+    void registerResource(ResourceId resource, ResourceState state, uint32 subresource_count = 1);
+    // Drops the barriers queued for it in this batch and ends a split begun in an earlier one.
+    void unregisterResource(ResourceId resource);
+    bool isRegistered(ResourceId resource) const { return resources.count(resource) != 0; }
+    ResourceState getState(ResourceId resource, uint32 subresource = 0) const;
+
+    void require(ResourceId resource, ResourceState state, uint32 subresource = all_subresources);
+    // Begins the transition to state in the next flush, the GPU overlaps it with the work in between.
+    void prepare(ResourceId resource, ResourceState state);
+
+    // Returns the number of barriers emitted.
+    uint32 flush(CommandList& command_list);
+    uint32 flush(std::vector<ResourceBarrier>& barriers);
+    const std::vector<ResourceBarrier>& getPendingBarriers() const { return pending_barriers; }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+  private:
+    static constexpr uint32 no_barrier = ~0u;
+
+    struct Resource
+    {
+      ResourceState state { ResourceState::Common };
+      // Empty while all subresources share state.
+      std::vector<ResourceState> subresource_states;
+      uint32 subresource_count { 1 };
+
+      // Whole resource barrier queued in the current batch, amended by later requirements.
+      uint32 barrier { no_barrier };
+      uint64 barrier_batch { 0 };
+
+      // Split barrier begun but not ended, state is the state before it.
+      bool is_splitting { false };
+      ResourceState split_state { ResourceState::Common };
+      uint32 split_barrier { no_barrier };
+      uint64 split_batch { 0 };
+    };
+
+    static bool isReadOnly(ResourceState state);
+    static bool meets(ResourceState current, ResourceState required);
+
+    Resource& getResource(ResourceId resource);
+    void endSplit(ResourceId id, Resource& resource);
+    void requireWhole(ResourceId id, Resource& resource, ResourceState state);
+    void requireSubresource(ResourceId id, Resource& resource, ResourceState state, uint32 subresource);
+    void emit(const ResourceBarrier& barrier);
+    void removeBarrier(uint32 index);
+
+  private:
+    std::unordered_map<ResourceId, Resource> resources;
+    std::vector<ResourceBarrier> pending_barriers;
+    uint64 batch { 1 };
+    Stats stats;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <common/math.h>
+#include <render/command_list.h>
+
+#include <atomic>
+#include <cstring>
+
+namespace engine
+{
+  // CPU-writable memory the GPU reads from, mapped for the lifetime of the buffer.
+  struct UploadMemory
+  {
+    uint8* cpu_address { nullptr };
+    GpuVirtualAddress gpu_address { 0 };
+    ResourceId resource { invalid_id };
+    uint64 size { 0 };
+  };
+
+  struct UploadAllocation
+  {
+    uint8* cpu_address { nullptr };
+    GpuVirtualAddress gpu_address { 0 };
+    // Buffer and offset for copies.
+    ResourceId resource { invalid_id };
+    uint64 offset { 0 };
+
+    bool isValid() const { return cpu_address != nullptr; }
+  };
+
+  // Sub-allocates per-frame data (constants, dynamic vertices) from one persistently mapped upload
+  // buffer. Any thread may allocate: each one reserves 64 KB pages with an atomic add on the head
+  // and bumps through them, large allocations are reserved directly. endFrame tags everything
+  // reserved so far with the frame's fence value and starts new pages, retire frees the space once
+  // the fence completed. Reservations never wrap around the end of the buffer, the rest is skipped.
+  // When the GPU still owns the space allocate fails instead of waiting.
+  class UploadRing
+  {
+  public:
+    static constexpr uint64 constant_buffer_alignment = 256;
+    // The buffer size must be a power of two of at least max_alignment, its start aligned to it.
+    static constexpr uint64 max_alignment = 64 * 1024;
+    static constexpr uint64 page_size = 64 * 1024;
+    static const uint32 max_pending_frames = 16;
+
+    void initialize(const UploadMemory& memory);
+
+    UploadAllocation allocate(uint64 size, uint64 alignment = constant_buffer_alignment)
+    {
+      ThreadPage& page = thread_page;
+      if (page.tag == frame_tag)
+      {
+        uint64 start = alignUp(page.cursor, alignment);
+        if (start + size <= page.end)
+        {
+          page.cursor = start + size;
+          return makeAllocation(start);
+        }
+      }
+
+      return allocateSlow(size, alignment);
+    }
+
+    // Copies data into a constant buffer aligned allocation.
+    UploadAllocation upload(const void* data, uint64 size, uint64 alignment = constant_buffer_alignment)
+    {
+      UploadAllocation allocation = allocate(size, alignment);
+      if (allocation.isValid())
+      {
+        std::memcpy(allocation.cpu_address, data, size);
+      }
+      return allocation;
+    }
+
+    template<typename T>
+    UploadAllocation upload(const T& data)
+    {
+      return upload(&data, sizeof(T));
+    }
+
+    // Not thread safe, called by the frame loop while no other thread allocates.
+    void endFrame(uint64 fence_value);
+    void retire(uint64 completed_fence_value);
+
+    const UploadMemory& getMemory() const { return memory; }
+    uint64 getCapacity() const { return memory.size; }
+    // Ring positions: the frame being recorded reserved everything from getFrameBegin to getHead.
+    uint64 getFrameBegin() const { return frame_begin; }
+    uint64 getHead() const { return head.load(std::memory_order_relaxed); }
+    // Copies the bytes at positions [begin, end), which may wrap around the end of the buffer.
+    void read(uint64 begin, uint64 end, uint8* destination) const;
+    // Bytes reserved by frames in flight and the frame being recorded, including unused page tails.
+    uint64 getUsed() const { return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed); }
+    uint64 getFailedAllocations() const { return failed_allocations.load(std::memory_order_relaxed); }
+
+  private:
+    struct ThreadPage
+    {
+      uint64 tag { 0 };
+      // Positions on the ring, the buffer offset is the position modulo the buffer size.
+      uint64 cursor { 0 };
+      uint64 end { 0 };
+    };
+
+    struct PendingFrame
+    {
+      uint64 fence_value;
+      uint64 head;
+    };
+
+    UploadAllocation makeAllocation(uint64 position) const
+    {
+      uint64 offset = position & (memory.size - 1);
+
+      UploadAllocation allocation;
+      allocation.cpu_address = memory.cpu_address + offset;
+      allocation.gpu_address = memory.gpu_address + offset;
+      allocation.resource = memory.resource;
+      allocation.offset = offset;
+      return allocation;
+    }
+
+    UploadAllocation allocateSlow(uint64 size, uint64 alignment);
+    // Returns the start position or ~0 when the GPU still owns the space.
+    uint64 reserve(uint64 size);
+
+  private:
+    static thread_local ThreadPage thread_page;
+
+    UploadMemory memory;
+    // Unique across all rings and frames, thread pages with another tag are stale.
+    uint64 frame_tag { 0 };
+
+    // Both only grow, reserved space is only given back by retiring the frame that owns it.
+    alignas(64) std::atomic<uint64> head { 0 };
+    alignas(64) std::atomic<uint64> tail { 0 };
+    std::atomic<uint64> failed_allocations { 0 };
+    uint64 frame_begin { 0 };
+
+    PendingFrame pending_frames[max_pending_frames] = {};
+    uint32 first_pending { 0 };
+    uint32 pending_count { 0 };
+  };
+
+  // Defined inline so the fast path reads it without a TLS wrapper call.
+  inline thread_local UploadRing::ThreadPage UploadRing::thread_page;
+}
\ No newline at end of file
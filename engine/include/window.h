@@ -13,6 +13,8 @@ namespace engine
 
     void initialize(Application* application, HINSTANCE instance, WNDPROC wnd_proc, int cmd_show);
     void setSize(uint32 width, uint32 height);
+    // Resizes the window so its client area gets the given size, WM_SIZE follows. Safe from any thread.
+    void requestClientSize(uint32 width, uint32 height);
     void setFullscreen(bool fullscreen);
     void show();
 
@@ -1,6 +1,11 @@
 #include <application.h>
 #include <window.h>
 #include <config.h>
+#include <render/d3d12_device_resources.h>
+#include <profiler/profiler.h>
+#include <common/log_checked.h>
+
+#include <cassert>
 
 namespace engine
 {
@@ -8,18 +13,41 @@ namespace engine
     : instance(instance)
     , cmd_show(cmd_show)
     , tearing_supported(false)
-    , vsync(false)
+    , worker_count(0)
+    , threaded_rendering(false)
+    , frame_queue_size(2)
   {
     Config config;
     config.Load(config_path);
     auto& settings = config.data.application_settings;
     std::wstring app_name(settings.name.begin(), settings.name.end());
+    worker_count = settings.worker_count;
+    threaded_rendering = settings.threaded_rendering;
+    frame_queue_size = settings.frame_queue_size;
+    trace_path = settings.trace_path;
+    frame_statistics.setReportInterval(settings.stats_report_interval);
+    Log::setAsync(settings.async_logging);
+    if (!settings.binary_log_path.empty() && !Log::setBinaryOutput(settings.binary_log_path))
+    {
+      LOG_WARNING("Can't open binary log %s\n", settings.binary_log_path);
+    }
+    render_settings = config.data.render_settings;
+    pending_render_settings = render_settings;
+    pending_worker_count = worker_count;
+
+    if (settings.config_hot_reload && !config_watcher.start(config_path, config.data))
+    {
+      LOG_WARNING("Can't watch %s for changes\n", config_path);
+    }
 
     window = new Window(app_name, settings.window_width, settings.window_height);
+    device_resources = std::make_unique<D3D12DeviceResources>();
   }
 
   Application::~Application()
   {
+    // Also drains the log when run() was left by an exception.
+    Log::setAsync(false);
     delete window;
     window = nullptr;
   }
@@ -28,59 +56,200 @@ namespace engine
   {
     initialize();
 
-    MSG msg = {};
-    while (msg.message != WM_QUIT)
+    if (threaded_rendering)
+    {
+      runThreaded();
+    }
+    else
     {
-      if (::PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+      MSG msg = {};
+      while (msg.message != WM_QUIT)
       {
-        ::TranslateMessage(&msg);
-        ::DispatchMessage(&msg);
+        if (::PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+        {
+          ::TranslateMessage(&msg);
+          ::DispatchMessage(&msg);
+        }
       }
     }
 
     destroy();
   }
 
+  void Application::runThreaded()
+  {
+    FramePipeline::Callbacks callbacks;
+    callbacks.simulate = [this](FramePacket&) { update(); };
+    callbacks.render = [this](const FramePacket&) { render(); };
+    callbacks.resize = [this](uint32 width, uint32 height) { device_resources->resize(width, height); };
+    // GetMessage only returns for a message, without one a failed pipeline would never be noticed.
+    callbacks.wake_pump = [hwnd = window->getHwnd()]() { ::PostMessage(hwnd, WM_NULL, 0, 0); };
+
+    frame_pipeline = std::make_unique<FramePipeline>(frame_queue_size, callbacks);
+
+    // Rendering no longer depends on WM_PAINT, so the pump can block until the next message arrives.
+    frame_pipeline->run([]()
+    {
+      MSG msg = {};
+      if (::GetMessage(&msg, 0, 0, 0) <= 0)
+      {
+        return false;
+      }
+
+      ::TranslateMessage(&msg);
+      ::DispatchMessage(&msg);
+      return true;
+    });
+
+    frame_pipeline.reset();
+  }
+
   void Application::initialize()
   {
+    PROFILE_THREAD_NAME("main");
+    job_system.initialize(worker_count > 0 ? worker_count : JobSystem::getDefaultWorkerCount());
     window->initialize(this, instance, &Application::wndProc, cmd_show);
-    device_resources.loadPipeline(*window);
-    tearing_supported = device_resources.checkTearingSupport();
+    device_resources->setFramePacing(render_settings.frame_pacing, render_settings.max_frame_latency);
+    device_resources->setSwapChainBufferCount(render_settings.swap_chain_buffer_count);
+    device_resources->setFrameCount(render_settings.frame_count);
+    device_resources->setIdleWork([this]() { return job_system.runPendingJob(); });
+    device_resources->loadPipeline(SurfaceDesc { window->getHwnd(), window->getWidth(), window->getHeight(), window->getUseWarp() });
+    tearing_supported = device_resources->checkTearingSupport();
     window->show();
+    watchConfig();
+    frame_timer.reset();
   }
 
-  void Application::update()
+  void Application::watchConfig()
   {
-    static uint64 frame_counter = 0;
-    static double elapsed_seconds = 0.0;
-    static std::chrono::high_resolution_clock clock;
-    static auto t0 = clock.now();
+    // Callbacks run in update(), on the simulation thread when rendering is threaded.
+    auto applies_after_restart = [](const char* name)
+    {
+      return [name](const auto&, const auto&) { LOG_WARNING("Config: %s applies after a restart\n", name); };
+    };
 
-    frame_counter++;
-    auto t1 = clock.now();
-    auto delta_time = t1 - t0;
-    t0 = t1;
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.render_settings; }, [this](const RenderSettingsData& value, const RenderSettingsData&)
+    {
+      RenderSettingsData validated = value;
+      validateRenderSettings(validated);
+      std::lock_guard<std::mutex> lock(pending_settings_mutex);
+      pending_render_settings = validated;
+      has_pending_settings.store(true, std::memory_order_release);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.worker_count; }, [this](uint32 value, uint32)
+    {
+      std::lock_guard<std::mutex> lock(pending_settings_mutex);
+      pending_worker_count = value;
+      has_pending_settings.store(true, std::memory_order_release);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.window_width; }, [this](uint32, uint32)
+    {
+      window->requestClientSize(config_watcher.get().application_settings.window_width, config_watcher.get().application_settings.window_height);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.window_height; }, [this](uint32, uint32)
+    {
+      window->requestClientSize(config_watcher.get().application_settings.window_width, config_watcher.get().application_settings.window_height);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.stats_report_interval; }, [this](double value, double)
+    {
+      frame_statistics.setReportInterval(value);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.async_logging; }, [](bool value, bool)
+    {
+      Log::setAsync(value);
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.binary_log_path; }, [](const std::string& value, const std::string&)
+    {
+      if (!Log::setBinaryOutput(value))
+      {
+        LOG_WARNING("Can't open binary log %s\n", value);
+      }
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.trace_path; }, [this](const std::string& value, const std::string&)
+    {
+      trace_path = value;
+    });
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.name; }, applies_after_restart("name"));
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.threaded_rendering; }, applies_after_restart("threaded_rendering"));
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.frame_queue_size; }, applies_after_restart("frame_queue_size"));
+    config_watcher.onChange([](const Data& data) -> const auto& { return data.application_settings.config_hot_reload; }, applies_after_restart("config_hot_reload"));
+  }
 
-    elapsed_seconds += delta_time.count() * 1e-9; // nanoseconds to seconds
-    if (elapsed_seconds > 1.0)
+  void Application::applyPendingSettings()
+  {
+    if (!has_pending_settings.exchange(false, std::memory_order_acquire))
     {
-      auto fps = frame_counter / elapsed_seconds;
-      Log::info("FPS: %f\n", fps);
+      return;
+    }
+
+    RenderSettingsData settings;
+    uint32 workers;
+    {
+      std::lock_guard<std::mutex> lock(pending_settings_mutex);
+      settings = pending_render_settings;
+      workers = pending_worker_count;
+    }
 
-      frame_counter = 0;
-      elapsed_seconds = 0.0;
+    if (workers != worker_count)
+    {
+      // Jobs are submitted within a frame, the ones still queued finish before the workers go.
+      job_system.waitForIdle();
+      assert(job_system.isIdle() && "Jobs were submitted while the job system restarts.");
+      worker_count = workers;
+      job_system.shutdown();
+      job_system.initialize(worker_count > 0 ? worker_count : JobSystem::getDefaultWorkerCount());
+    }
+
+    if (settings.frame_pacing == FramePacingMode::WaitableObject && render_settings.frame_pacing != FramePacingMode::WaitableObject)
+    {
+      LOG_WARNING("Config: waitable_object frame pacing applies after a restart\n");
+      settings.frame_pacing = render_settings.frame_pacing;
     }
+    if (settings.frame_pacing != render_settings.frame_pacing || settings.max_frame_latency != render_settings.max_frame_latency)
+    {
+      device_resources->setFramePacing(settings.frame_pacing, settings.max_frame_latency);
+    }
+    if (settings.swap_chain_buffer_count != render_settings.swap_chain_buffer_count)
+    {
+      device_resources->setSwapChainBufferCount(settings.swap_chain_buffer_count);
+    }
+    if (settings.frame_count != render_settings.frame_count)
+    {
+      device_resources->setFrameCount(settings.frame_count);
+    }
+
+    render_settings = settings;
+  }
+
+  void Application::update()
+  {
+    PROFILE_SCOPE("Application::update");
+
+    frame_statistics.addFrame(frame_timer.tick());
+    config_watcher.update();
   }
 
   void Application::render()
   {
-    device_resources.render(true, tearing_supported);
+    PROFILE_SCOPE("Application::render");
+    applyPendingSettings();
+    device_resources->render(render_settings.vsync, tearing_supported);
   }
 
   void Application::destroy()
   {
-    device_resources.flush();
-    CloseHandle(device_resources.getFenceEvent());
+    config_watcher.stop();
+    device_resources->flush();
+    job_system.shutdown();
+
+#if defined(ENGINE_PROFILER)
+    if (!trace_path.empty() && Profiler::exportChromeTrace(trace_path))
+    {
+      LOG_INFO("Profiler trace written to %s\n", trace_path);
+    }
+#endif
+
+    Log::setAsync(false);
   }
 
   void Application::resizeWindow(uint32 width, uint32 height)
@@ -88,8 +257,18 @@ namespace engine
     if (window->getWidth() != width || window->getHeight() != height)
     {
       // Don't allow 0 size swap chain back buffers.
-      window->setSize(std::max(1u, width), std::max(1u, height));
-      device_resources.resize(width, height);
+      width = std::max(1u, width);
+      height = std::max(1u, height);
+      window->setSize(width, height);
+
+      if (frame_pipeline)
+      {
+        frame_pipeline->requestResize(width, height);
+      }
+      else
+      {
+        device_resources->resize(width, height);
+      }
     }
   }
 
@@ -108,7 +287,12 @@ namespace engine
 
     case WM_PAINT:
     {
-      if (application)
+      if (application && application->frame_pipeline)
+      {
+        // The render thread presents on its own, just mark the window as painted.
+        ::ValidateRect(wnd, nullptr);
+      }
+      else if (application)
       {
         application->update();
         application->render();
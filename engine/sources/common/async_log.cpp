@@ -0,0 +1,317 @@
+#include <common/async_log.h>
+#include <common/timer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace engine
+{
+  namespace
+  {
+    std::atomic<uint32> next_instance_id { 1 };
+
+    // Gives the ring back for reuse when its thread exits.
+    struct ThreadRegistration
+    {
+      uint32 instance_id { 0 };
+      std::atomic<bool>* owned { nullptr };
+      void* queue { nullptr };
+
+      ~ThreadRegistration()
+      {
+        if (owned)
+        {
+          owned->store(false, std::memory_order_release);
+        }
+      }
+    };
+
+    thread_local ThreadRegistration thread_registration;
+
+    const auto idle_wait = std::chrono::milliseconds(1);
+  }
+
+  AsyncLog::AsyncLog()
+    : instance_id(next_instance_id.fetch_add(1, std::memory_order_relaxed))
+  {
+  }
+
+  AsyncLog::~AsyncLog()
+  {
+    stop();
+  }
+
+  void AsyncLog::start()
+  {
+    std::lock_guard<std::mutex> lock(registration_mutex);
+    if (running.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    running.store(true, std::memory_order_release);
+    consumer = std::thread(&AsyncLog::consumerMain, this);
+  }
+
+  void AsyncLog::stop()
+  {
+    std::lock_guard<std::mutex> lock(registration_mutex);
+    if (!running.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    // Pairs with beginRecord: a producer either sees the log stopped or is waited for here.
+    running.store(false, std::memory_order_seq_cst);
+    uint32 count = queue_count.load(std::memory_order_acquire);
+    for (uint32 i = 0; i < count; ++i)
+    {
+      while (queues[i]->writing.load(std::memory_order_seq_cst))
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    wake();
+    consumer.join();
+
+    // Producers that saw the log running just before it stopped.
+    drain();
+  }
+
+  bool AsyncLog::push(LogLevel level, const char* format, va_list args)
+  {
+    LogRecord* record = beginRecord(level, format);
+    if (!record)
+    {
+      return false;
+    }
+
+    packLogRecordInline(*record, format, args);
+    commitRecord(record);
+
+    return true;
+  }
+
+  LogRecord* AsyncLog::beginRecord(LogLevel level, const char* format)
+  {
+    ThreadQueue* queue = thread_registration.instance_id == instance_id ? static_cast<ThreadQueue*>(thread_registration.queue) : acquireQueue();
+    if (!queue)
+    {
+      return nullptr;
+    }
+
+    queue->writing.store(true, std::memory_order_seq_cst);
+    if (!running.load(std::memory_order_seq_cst))
+    {
+      queue->writing.store(false, std::memory_order_release);
+      return nullptr;
+    }
+
+    uint64 index = queue->write_index.load(std::memory_order_relaxed);
+    if (index - queue->read_index.load(std::memory_order_acquire) >= records_per_thread)
+    {
+      full_waits.fetch_add(1, std::memory_order_relaxed);
+      wake();
+      while (index - queue->read_index.load(std::memory_order_acquire) >= records_per_thread)
+      {
+        if (!isRunning())
+        {
+          queue->writing.store(false, std::memory_order_release);
+          return nullptr;
+        }
+        std::this_thread::yield();
+      }
+    }
+
+    LogRecord& record = queue->records[index % records_per_thread];
+    record.timestamp = Timer::nowNanoseconds();
+    record.format = format;
+    record.level = level;
+    record.size = 0;
+    record.truncated = false;
+    record.inline_format = false;
+
+    return &record;
+  }
+
+  void AsyncLog::commitRecord(LogRecord* record)
+  {
+    ThreadQueue* queue = static_cast<ThreadQueue*>(thread_registration.queue);
+    assert(record == &queue->records[queue->write_index.load(std::memory_order_relaxed) % records_per_thread]);
+
+    queue->write_index.store(queue->write_index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    queue->writing.store(false, std::memory_order_release);
+
+    if (record->level == LogLevel::Error)
+    {
+      wake();
+    }
+  }
+
+  void AsyncLog::flush()
+  {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    // The cycle running right now may have missed the latest records, wait for the one after it.
+    uint64 target = drain_cycles + 2;
+    wake_requested = true;
+    wake_condition.notify_one();
+    drained_condition.wait(lock, [&]() { return drain_cycles >= target || !isRunning(); });
+  }
+
+  bool AsyncLog::setBinaryOutput(const std::string& path)
+  {
+    if (isRunning())
+    {
+      flush();
+    }
+
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    // Records still in the rings after a stop belong to the previous output.
+    drainLocked();
+
+    if (path.empty())
+    {
+      binary_output.close();
+      return true;
+    }
+
+    return binary_output.open(path);
+  }
+
+  bool AsyncLog::hasBinaryOutput()
+  {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    return binary_output.isOpen();
+  }
+
+  AsyncLog::ThreadQueue* AsyncLog::acquireQueue()
+  {
+    std::lock_guard<std::mutex> lock(registration_mutex);
+
+    ThreadQueue* queue = nullptr;
+    uint32 count = queue_count.load(std::memory_order_relaxed);
+    for (uint32 i = 0; i < count && !queue; ++i)
+    {
+      ThreadQueue* candidate = queues[i].get();
+      bool expected = false;
+      if (candidate->read_index.load(std::memory_order_acquire) == candidate->write_index.load(std::memory_order_relaxed)
+        && candidate->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+      {
+        queue = candidate;
+      }
+    }
+
+    if (!queue && count < max_threads)
+    {
+      queues[count] = std::make_unique<ThreadQueue>();
+      queue = queues[count].get();
+      queue_count.store(count + 1, std::memory_order_release);
+    }
+
+    if (queue)
+    {
+      thread_registration.instance_id = instance_id;
+      thread_registration.owned = &queue->owned;
+      thread_registration.queue = queue;
+    }
+
+    return queue;
+  }
+
+  void AsyncLog::consumerMain()
+  {
+    while (true)
+    {
+      uint32 count = drain();
+
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      drain_cycles++;
+      drained_condition.notify_all();
+
+      if (count == 0)
+      {
+        if (!isRunning())
+        {
+          break;
+        }
+
+        wake_condition.wait_for(lock, idle_wait, [&]() { return wake_requested || !isRunning(); });
+        wake_requested = false;
+      }
+    }
+  }
+
+  uint32 AsyncLog::drain()
+  {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    return drainLocked();
+  }
+
+  uint32 AsyncLog::drainLocked()
+  {
+    uint64 end_indices[max_threads];
+    uint32 count = queue_count.load(std::memory_order_acquire);
+
+    batch.clear();
+    for (uint32 i = 0; i < count; ++i)
+    {
+      ThreadQueue& queue = *queues[i];
+      end_indices[i] = queue.write_index.load(std::memory_order_acquire);
+      for (uint64 index = queue.read_index.load(std::memory_order_relaxed); index < end_indices[i]; ++index)
+      {
+        batch.push_back(&queue.records[index % records_per_thread]);
+      }
+    }
+
+    if (batch.empty())
+    {
+      return 0;
+    }
+
+    // Each ring is ordered already, the merge only interleaves threads.
+    std::stable_sort(batch.begin(), batch.end(), [](const LogRecord* a, const LogRecord* b) { return a->timestamp < b->timestamp; });
+
+    bool binary = binary_output.isOpen();
+    for (const LogRecord* record : batch)
+    {
+      // A failed binary write (disk full) falls back to text rather than losing the record.
+      if (binary && binary_output.write(*record) && record->level == LogLevel::Info)
+      {
+        continue;
+      }
+
+      formatLogRecord(*record, output[record->level == LogLevel::Info ? 0 : 1]);
+    }
+
+    for (uint32 i = 0; i < 2; ++i)
+    {
+      if (!output[i].empty())
+      {
+        FILE* stream = Log::getStream(i == 0 ? LogLevel::Info : LogLevel::Error);
+        fwrite(output[i].data(), 1, output[i].size(), stream);
+        fflush(stream);
+        output[i].clear();
+      }
+    }
+
+    // Only now the producers may reuse the records.
+    for (uint32 i = 0; i < count; ++i)
+    {
+      queues[i]->read_index.store(end_indices[i], std::memory_order_release);
+    }
+
+    uint32 written = static_cast<uint32>(batch.size());
+    written_records.fetch_add(written, std::memory_order_relaxed);
+
+    return written;
+  }
+
+  void AsyncLog::wake()
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    wake_requested = true;
+    wake_condition.notify_one();
+  }
+}
\ No newline at end of file
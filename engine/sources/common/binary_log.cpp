@@ -0,0 +1,264 @@
+#include <common/binary_log.h>
+#include <common/timer.h>
+
+#include <cstring>
+
+namespace engine
+{
+  namespace
+  {
+    const uint32 record_prefix_size = sizeof(uint16) + sizeof(uint8);
+    const uint32 message_header_size = record_prefix_size + 2 * sizeof(uint8) + sizeof(uint32) + sizeof(uint64);
+    const uint32 max_record_size = 0xffff;
+
+    template<typename T>
+    uint8* put(uint8* cursor, const T& value)
+    {
+      memcpy(cursor, &value, sizeof(T));
+      return cursor + sizeof(T);
+    }
+
+    template<typename T>
+    const uint8* get(const uint8* cursor, T& value)
+    {
+      memcpy(&value, cursor, sizeof(T));
+      return cursor + sizeof(T);
+    }
+  }
+
+  constexpr char BinaryLogHeader::magic_value[8];
+
+  BinaryLogWriter::~BinaryLogWriter()
+  {
+    close();
+  }
+
+  bool BinaryLogWriter::open(const std::string& path, uint64 chunk_size)
+  {
+    close();
+
+    this->chunk_size = chunk_size;
+    if (!file.open(path, MappedFile::Mode::Write, chunk_size))
+    {
+      return false;
+    }
+
+    BinaryLogHeader header;
+    memcpy(header.magic, BinaryLogHeader::magic_value, sizeof(header.magic));
+    header.version = BinaryLogHeader::current_version;
+    header.header_size = sizeof(BinaryLogHeader);
+    header.start_timestamp = Timer::nowNanoseconds();
+    memcpy(file.data(), &header, sizeof(header));
+    offset = sizeof(header);
+
+    return true;
+  }
+
+  void BinaryLogWriter::close()
+  {
+    if (!file.isOpen())
+    {
+      return;
+    }
+
+    // Keep one zero byte pair as the end marker.
+    uint64 final_size = offset + record_prefix_size;
+    if (reserve(record_prefix_size))
+    {
+      memset(file.data() + offset, 0, record_prefix_size);
+    }
+    file.close(final_size);
+
+    offset = 0;
+    pointer_ids.clear();
+    text_ids.clear();
+  }
+
+  bool BinaryLogWriter::write(const LogRecord& record)
+  {
+    const uint8* arguments = nullptr;
+    uint32 arguments_size = 0;
+    const char* format = getLogRecordFormat(record, arguments, arguments_size);
+
+    uint32 id = intern(record, format);
+    uint32 size = message_header_size + arguments_size;
+    if (id == ~0u || !reserve(size))
+    {
+      return false;
+    }
+
+    uint8* cursor = file.data() + offset;
+    cursor = put(cursor, static_cast<uint16>(size));
+    cursor = put(cursor, BinaryLogRecordKind::Message);
+    cursor = put(cursor, record.level);
+    cursor = put(cursor, static_cast<uint8>(record.truncated));
+    cursor = put(cursor, id);
+    cursor = put(cursor, record.timestamp);
+    memcpy(cursor, arguments, arguments_size);
+
+    offset += size;
+    message_count++;
+
+    return true;
+  }
+
+  uint32 BinaryLogWriter::intern(const LogRecord& record, const char* format)
+  {
+    if (!record.inline_format)
+    {
+      auto it = pointer_ids.find(format);
+      if (it != pointer_ids.end())
+      {
+        return it->second;
+      }
+    }
+
+    auto [it, inserted] = text_ids.emplace(format, static_cast<uint32>(text_ids.size()));
+    if (inserted && !writeFormat(it->second, format))
+    {
+      text_ids.erase(it);
+      return ~0u;
+    }
+
+    if (!record.inline_format)
+    {
+      pointer_ids.emplace(format, it->second);
+    }
+
+    return it->second;
+  }
+
+  bool BinaryLogWriter::writeFormat(uint32 id, const char* format)
+  {
+    size_t length = std::min<size_t>(strlen(format), max_record_size - record_prefix_size - sizeof(uint32) - 1);
+    uint32 size = static_cast<uint32>(record_prefix_size + sizeof(uint32) + length + 1);
+    if (!reserve(size))
+    {
+      return false;
+    }
+
+    uint8* cursor = file.data() + offset;
+    cursor = put(cursor, static_cast<uint16>(size));
+    cursor = put(cursor, BinaryLogRecordKind::Format);
+    cursor = put(cursor, id);
+    memcpy(cursor, format, length);
+    cursor[length] = '\0';
+
+    offset += size;
+    format_count++;
+
+    return true;
+  }
+
+  bool BinaryLogWriter::reserve(uint64 size)
+  {
+    if (offset + size <= file.size())
+    {
+      return true;
+    }
+
+    return file.resize(file.size() + std::max(chunk_size, size));
+  }
+
+  bool BinaryLogReader::open(const std::string& path)
+  {
+    formats.clear();
+    error.clear();
+
+    if (!file.open(path, MappedFile::Mode::Read))
+    {
+      return fail("can't open " + path);
+    }
+
+    BinaryLogHeader header;
+    if (file.size() < sizeof(header))
+    {
+      return fail("file is too small for a header");
+    }
+
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, BinaryLogHeader::magic_value, sizeof(header.magic)) != 0)
+    {
+      return fail("not a binary log");
+    }
+    if (header.version != BinaryLogHeader::current_version)
+    {
+      return fail("unsupported version " + std::to_string(header.version));
+    }
+
+    offset = header.header_size;
+    start_timestamp = header.start_timestamp;
+
+    return true;
+  }
+
+  bool BinaryLogReader::next(Message& message)
+  {
+    while (file.isOpen() && offset + record_prefix_size <= file.size())
+    {
+      const uint8* cursor = file.data() + offset;
+      uint16 size = 0;
+      BinaryLogRecordKind kind = BinaryLogRecordKind::End;
+      cursor = get(cursor, size);
+      cursor = get(cursor, kind);
+
+      // Preallocated space of a log that was not closed cleanly reads as an end marker as well.
+      if (size == 0 || kind == BinaryLogRecordKind::End)
+      {
+        return false;
+      }
+      if (offset + size > file.size() || size < record_prefix_size)
+      {
+        return fail("record at offset " + std::to_string(offset) + " runs past the end of the file");
+      }
+
+      const uint8* end = file.data() + offset + size;
+      offset += size;
+
+      if (kind == BinaryLogRecordKind::Format)
+      {
+        uint32 id = 0;
+        cursor = get(cursor, id);
+        if (cursor >= end || end[-1] != '\0')
+        {
+          return fail("damaged format record");
+        }
+        formats[id] = reinterpret_cast<const char*>(cursor);
+        continue;
+      }
+
+      if (kind != BinaryLogRecordKind::Message || size < message_header_size)
+      {
+        return fail("unknown record kind " + std::to_string(static_cast<uint32>(kind)));
+      }
+
+      uint8 truncated = 0;
+      uint32 id = 0;
+      cursor = get(cursor, message.level);
+      cursor = get(cursor, truncated);
+      cursor = get(cursor, id);
+      cursor = get(cursor, message.timestamp);
+
+      auto it = formats.find(id);
+      if (it == formats.end())
+      {
+        return fail("message uses unknown format " + std::to_string(id));
+      }
+
+      message.truncated = truncated != 0;
+      message.format = it->second;
+      message.arguments = cursor;
+      message.size = static_cast<uint32>(end - cursor);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  bool BinaryLogReader::fail(const std::string& message)
+  {
+    error = message;
+    return false;
+  }
+}
\ No newline at end of file
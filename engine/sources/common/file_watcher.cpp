@@ -0,0 +1,169 @@
+#include <common/file_watcher.h>
+
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+  namespace
+  {
+    std::string getDirectory(const std::string& path)
+    {
+      std::string directory = std::filesystem::path(path).parent_path().string();
+      return directory.empty() ? std::string(".") : directory;
+    }
+  }
+
+  FileWatcher::~FileWatcher()
+  {
+    stop();
+  }
+
+#if defined(_WIN32)
+  bool FileWatcher::watch(const std::string& path)
+  {
+    stop();
+    this->path = path;
+    file_name = std::filesystem::path(path).filename().string();
+
+    HANDLE handle = ::FindFirstChangeNotificationA(getDirectory(path).c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+
+    change_handle = handle;
+    watching = true;
+    return true;
+  }
+
+  void FileWatcher::stop()
+  {
+    if (change_handle)
+    {
+      ::FindCloseChangeNotification(change_handle);
+      change_handle = nullptr;
+    }
+    watching = false;
+  }
+
+  bool FileWatcher::poll()
+  {
+    // The notification covers the whole directory, not only this file.
+    bool changed = false;
+    while (change_handle && ::WaitForSingleObject(change_handle, 0) == WAIT_OBJECT_0)
+    {
+      changed = true;
+      if (!::FindNextChangeNotification(change_handle))
+      {
+        stop();
+      }
+    }
+
+    return changed;
+  }
+#elif defined(__linux__)
+  bool FileWatcher::watch(const std::string& path)
+  {
+    stop();
+    this->path = path;
+    file_name = std::filesystem::path(path).filename().string();
+
+    inotify_descriptor = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_descriptor < 0)
+    {
+      return false;
+    }
+
+    if (::inotify_add_watch(inotify_descriptor, getDirectory(path).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0)
+    {
+      stop();
+      return false;
+    }
+
+    watching = true;
+    return true;
+  }
+
+  void FileWatcher::stop()
+  {
+    if (inotify_descriptor >= 0)
+    {
+      ::close(inotify_descriptor);
+      inotify_descriptor = -1;
+    }
+    watching = false;
+  }
+
+  bool FileWatcher::poll()
+  {
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+
+    while (inotify_descriptor >= 0)
+    {
+      ssize_t length = ::read(inotify_descriptor, buffer, sizeof(buffer));
+      if (length <= 0)
+      {
+        break;
+      }
+
+      for (ssize_t offset = 0; offset < length;)
+      {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        // Events for other files in the directory are ignored, an overflow may have dropped ours.
+        changed = changed || (event->mask & IN_Q_OVERFLOW) || (event->len > 0 && file_name == event->name);
+        offset += sizeof(inotify_event) + event->len;
+      }
+    }
+
+    return changed;
+  }
+#else
+  bool FileWatcher::watch(const std::string& path)
+  {
+    stop();
+    this->path = path;
+    file_name = std::filesystem::path(path).filename().string();
+
+    std::error_code error;
+    last_size = std::filesystem::file_size(path, error);
+    last_time = error ? 0 : static_cast<int64>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    watching = !error;
+    return watching;
+  }
+
+  void FileWatcher::stop()
+  {
+    watching = false;
+  }
+
+  bool FileWatcher::poll()
+  {
+    if (!watching)
+    {
+      return false;
+    }
+
+    std::error_code error;
+    uint64 size = std::filesystem::file_size(path, error);
+    int64 time = error ? 0 : static_cast<int64>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    if (error || (size == last_size && time == last_time))
+    {
+      return false;
+    }
+
+    last_size = size;
+    last_time = time;
+    return true;
+  }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include <common/json_deserializer.h>
+
+namespace engine
+{
+  std::string JsonIssue::toString() const
+  {
+    // Issues about the file as a whole have no position.
+    std::string text = position.line > 0 ? std::to_string(position.line) + ":" + std::to_string(position.column) + ": " : std::string();
+    if (!path.empty())
+    {
+      text += path + ": ";
+    }
+    return text + message;
+  }
+
+  void JsonDeserializer::mismatch(const char* expected)
+  {
+    // Taken before skipping, the value was peeked already.
+    JsonPosition position = reader.getTokenPosition();
+    reader.skipValue();
+
+    report(JsonIssue::Kind::Type, position, (std::string("expected ") + expected).c_str());
+  }
+
+  void JsonDeserializer::report(JsonIssue::Kind kind, JsonPosition position, const char* message)
+  {
+    JsonIssue issue;
+    issue.kind = kind;
+    issue.position = position;
+    issue.message = message;
+
+    uint32 depth = path_depth < max_path_depth ? path_depth : max_path_depth;
+    for (uint32 i = 0; i < depth; ++i)
+    {
+      if (path[i].key.data())
+      {
+        if (!issue.path.empty())
+        {
+          issue.path += '.';
+        }
+        issue.path.append(path[i].key.data(), path[i].key.size());
+      }
+      else
+      {
+        issue.path += "[" + std::to_string(path[i].index) + "]";
+      }
+    }
+
+    error_count += issue.isError() ? 1 : 0;
+    issues.push_back(std::move(issue));
+  }
+
+  void JsonDeserializer::pushPath(std::string_view key, uint32 index)
+  {
+    // Deeper levels still nest correctly, they are only left out of reported paths.
+    if (path_depth < max_path_depth)
+    {
+      path[path_depth] = { key, index };
+    }
+    path_depth++;
+  }
+
+  void JsonDeserializer::popPath()
+  {
+    path_depth--;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,536 @@
+#include <common/json_reader.h>
+
+#include <cstring>
+
+namespace engine
+{
+  namespace
+  {
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    int32 hexValue(char c)
+    {
+      if (c >= '0' && c <= '9')
+      {
+        return c - '0';
+      }
+      if (c >= 'a' && c <= 'f')
+      {
+        return c - 'a' + 10;
+      }
+      if (c >= 'A' && c <= 'F')
+      {
+        return c - 'A' + 10;
+      }
+      return -1;
+    }
+
+    void appendUtf8(std::string& output, uint32 code_point)
+    {
+      if (code_point < 0x80)
+      {
+        output += static_cast<char>(code_point);
+      }
+      else if (code_point < 0x800)
+      {
+        output += static_cast<char>(0xc0 | (code_point >> 6));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+      }
+      else if (code_point < 0x10000)
+      {
+        output += static_cast<char>(0xe0 | (code_point >> 12));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+      }
+      else
+      {
+        output += static_cast<char>(0xf0 | (code_point >> 18));
+        output += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+      }
+    }
+  }
+
+  JsonReader::JsonReader(const char* data, size_t size)
+    : data(data)
+    , size(size)
+  {
+  }
+
+  JsonValueType JsonReader::peek()
+  {
+    if (hasError() || !skipWhitespace())
+    {
+      return JsonValueType::Invalid;
+    }
+
+    token_position = getPosition(offset);
+    switch (data[offset])
+    {
+    case '{': return JsonValueType::Object;
+    case '[': return JsonValueType::Array;
+    case '"': return JsonValueType::String;
+    case 't': case 'f': return JsonValueType::Bool;
+    case 'n': return JsonValueType::Null;
+    default: return data[offset] == '-' || isDigit(data[offset]) ? JsonValueType::Number : JsonValueType::Invalid;
+    }
+  }
+
+  bool JsonReader::beginObject()
+  {
+    if (!beginToken() || !expect('{'))
+    {
+      return false;
+    }
+
+    expect_first = true;
+    return true;
+  }
+
+  bool JsonReader::nextMember(std::string_view& key)
+  {
+    if (hasError() || !skipWhitespace())
+    {
+      return fail("unexpected end of input in object");
+    }
+
+    if (data[offset] == '}')
+    {
+      offset++;
+      expect_first = false;
+      return false;
+    }
+
+    if (!expect_first && !expect(','))
+    {
+      return false;
+    }
+    expect_first = false;
+
+    if (!skipWhitespace() || data[offset] != '"')
+    {
+      return fail("expected a string key");
+    }
+    if (!readString(key) || !skipWhitespace() || !expect(':'))
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  bool JsonReader::beginArray()
+  {
+    if (!beginToken() || !expect('['))
+    {
+      return false;
+    }
+
+    expect_first = true;
+    return true;
+  }
+
+  bool JsonReader::nextElement()
+  {
+    if (hasError() || !skipWhitespace())
+    {
+      return fail("unexpected end of input in array");
+    }
+
+    if (data[offset] == ']')
+    {
+      offset++;
+      expect_first = false;
+      return false;
+    }
+
+    if (!expect_first && !expect(','))
+    {
+      return false;
+    }
+    expect_first = false;
+
+    return true;
+  }
+
+  bool JsonReader::readNull()
+  {
+    if (!beginToken() || size - offset < 4 || memcmp(data + offset, "null", 4) != 0)
+    {
+      return fail("expected null");
+    }
+
+    offset += 4;
+    return true;
+  }
+
+  bool JsonReader::readBool(bool& value)
+  {
+    if (!beginToken())
+    {
+      return false;
+    }
+
+    if (size - offset >= 4 && memcmp(data + offset, "true", 4) == 0)
+    {
+      value = true;
+      offset += 4;
+      return true;
+    }
+    if (size - offset >= 5 && memcmp(data + offset, "false", 5) == 0)
+    {
+      value = false;
+      offset += 5;
+      return true;
+    }
+
+    return fail("expected true or false");
+  }
+
+  bool JsonReader::readNumber(std::string_view& text)
+  {
+    if (!beginToken())
+    {
+      return false;
+    }
+
+    size_t begin = offset;
+    if (offset < size && data[offset] == '-')
+    {
+      offset++;
+    }
+
+    if (offset < size && data[offset] == '0')
+    {
+      offset++;
+    }
+    else if (offset < size && isDigit(data[offset]))
+    {
+      while (offset < size && isDigit(data[offset]))
+      {
+        offset++;
+      }
+    }
+    else
+    {
+      return fail("expected a number");
+    }
+
+    if (offset < size && data[offset] == '.')
+    {
+      offset++;
+      if (offset >= size || !isDigit(data[offset]))
+      {
+        return fail("expected a digit after the decimal point");
+      }
+      while (offset < size && isDigit(data[offset]))
+      {
+        offset++;
+      }
+    }
+
+    if (offset < size && (data[offset] == 'e' || data[offset] == 'E'))
+    {
+      offset++;
+      if (offset < size && (data[offset] == '+' || data[offset] == '-'))
+      {
+        offset++;
+      }
+      if (offset >= size || !isDigit(data[offset]))
+      {
+        return fail("expected a digit in the exponent");
+      }
+      while (offset < size && isDigit(data[offset]))
+      {
+        offset++;
+      }
+    }
+
+    text = std::string_view(data + begin, offset - begin);
+    return true;
+  }
+
+  bool JsonReader::readString(std::string& value)
+  {
+    std::string_view raw;
+    bool escaped = false;
+    if (!beginToken() || !scanString(raw, escaped))
+    {
+      return false;
+    }
+
+    if (!escaped)
+    {
+      value.assign(raw.data(), raw.size());
+      return true;
+    }
+
+    value.clear();
+    return decodeString(raw, value);
+  }
+
+  bool JsonReader::readString(std::string_view& value)
+  {
+    std::string_view raw;
+    bool escaped = false;
+    if (!beginToken() || !scanString(raw, escaped))
+    {
+      return false;
+    }
+
+    if (!escaped)
+    {
+      value = raw;
+      return true;
+    }
+
+    scratch.clear();
+    if (!decodeString(raw, scratch))
+    {
+      return false;
+    }
+
+    value = scratch;
+    return true;
+  }
+
+  bool JsonReader::skipValue()
+  {
+    return skipValue(0);
+  }
+
+  bool JsonReader::finish()
+  {
+    if (hasError())
+    {
+      return false;
+    }
+
+    if (skipWhitespace())
+    {
+      return fail("unexpected data after the document");
+    }
+
+    return true;
+  }
+
+  bool JsonReader::skipWhitespace()
+  {
+    while (offset < size)
+    {
+      char c = data[offset];
+      if (c == '\n')
+      {
+        line++;
+        line_start = offset + 1;
+      }
+      else if (c != ' ' && c != '\t' && c != '\r')
+      {
+        return true;
+      }
+      offset++;
+    }
+
+    return false;
+  }
+
+  bool JsonReader::expect(char c)
+  {
+    if (offset >= size || data[offset] != c)
+    {
+      char message[] = "expected 'x'";
+      message[10] = c;
+      return fail(message);
+    }
+
+    offset++;
+    return true;
+  }
+
+  bool JsonReader::beginToken()
+  {
+    if (hasError())
+    {
+      return false;
+    }
+    if (!skipWhitespace())
+    {
+      return fail("unexpected end of input");
+    }
+
+    token_position = getPosition(offset);
+    return true;
+  }
+
+  bool JsonReader::scanString(std::string_view& raw, bool& escaped)
+  {
+    if (!expect('"'))
+    {
+      return false;
+    }
+
+    size_t begin = offset;
+    escaped = false;
+    while (offset < size)
+    {
+      char c = data[offset];
+      if (c == '"')
+      {
+        raw = std::string_view(data + begin, offset - begin);
+        offset++;
+        return true;
+      }
+      if (static_cast<unsigned char>(c) < 0x20)
+      {
+        return fail("control character in string");
+      }
+      if (c == '\\')
+      {
+        escaped = true;
+        offset++;
+      }
+      offset++;
+    }
+
+    return fail("unterminated string");
+  }
+
+  bool JsonReader::decodeString(std::string_view raw, std::string& output)
+  {
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+      if (raw[i] != '\\')
+      {
+        output += raw[i];
+        continue;
+      }
+
+      char c = raw[++i];
+      switch (c)
+      {
+      case '"': case '\\': case '/': output += c; break;
+      case 'b': output += '\b'; break;
+      case 'f': output += '\f'; break;
+      case 'n': output += '\n'; break;
+      case 'r': output += '\r'; break;
+      case 't': output += '\t'; break;
+      case 'u':
+      {
+        auto readHex = [&](size_t at, uint32& value)
+        {
+          value = 0;
+          for (size_t j = at; j < at + 4; ++j)
+          {
+            int32 digit = j < raw.size() ? hexValue(raw[j]) : -1;
+            if (digit < 0)
+            {
+              return false;
+            }
+            value = value * 16 + static_cast<uint32>(digit);
+          }
+          return true;
+        };
+
+        uint32 code_point = 0;
+        if (!readHex(i + 1, code_point))
+        {
+          return fail("invalid \\u escape");
+        }
+        i += 4;
+
+        // Surrogate pairs combine into one code point, lone surrogates are kept as written.
+        uint32 low = 0;
+        if (code_point >= 0xd800 && code_point < 0xdc00 && i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u'
+          && readHex(i + 3, low) && low >= 0xdc00 && low < 0xe000)
+        {
+          code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+          i += 6;
+        }
+        appendUtf8(output, code_point);
+        break;
+      }
+      default:
+        return fail("invalid escape sequence");
+      }
+    }
+
+    return true;
+  }
+
+  bool JsonReader::skipValue(uint32 depth)
+  {
+    if (depth >= max_depth)
+    {
+      return fail("nesting is too deep");
+    }
+
+    std::string_view ignored;
+    bool flag = false;
+    switch (peek())
+    {
+    case JsonValueType::Null: return readNull();
+    case JsonValueType::Bool: return readBool(flag);
+    case JsonValueType::Number: return readNumber(ignored);
+    case JsonValueType::String:
+    {
+      bool escaped = false;
+      return beginToken() && scanString(ignored, escaped);
+    }
+    case JsonValueType::Array:
+      if (!beginArray())
+      {
+        return false;
+      }
+      while (nextElement())
+      {
+        if (!skipValue(depth + 1))
+        {
+          return false;
+        }
+      }
+      return !hasError();
+    case JsonValueType::Object:
+      if (!beginObject())
+      {
+        return false;
+      }
+      while (nextMember(ignored))
+      {
+        if (!skipValue(depth + 1))
+        {
+          return false;
+        }
+      }
+      return !hasError();
+    default:
+      if (!hasError())
+      {
+        beginToken();
+      }
+      return fail("expected a value");
+    }
+  }
+
+  bool JsonReader::fail(const char* message)
+  {
+    if (error.empty())
+    {
+      error = message;
+      error_position = getPosition(offset);
+    }
+
+    return false;
+  }
+
+  JsonPosition JsonReader::getPosition(size_t at) const
+  {
+    JsonPosition position;
+    position.line = line;
+    position.column = static_cast<uint32>(at - line_start + 1);
+    return position;
+  }
+}
\ No newline at end of file
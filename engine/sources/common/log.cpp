@@ -1,16 +1,30 @@
 #include <common/log.h>
+#include <common/async_log.h>
 
 #include <cstdarg>
+#include <cstdio>
 #include <cstdlib>
-#include <iostream>
 
 namespace engine
 {
+  namespace
+  {
+    FILE* info_output = nullptr;
+    FILE* error_output = nullptr;
+
+    // Never destroyed, other threads and static destructors may still log during shutdown.
+    AsyncLog& getAsyncLog()
+    {
+      static AsyncLog* async_log = new AsyncLog();
+      return *async_log;
+    }
+  }
+
   void Log::info(const char* format, ...)
   {
     va_list args;
     va_start(args, format);
-    vfprintf(stdout, format, args);
+    write(LogLevel::Info, format, args);
     va_end(args);
   }
 
@@ -18,7 +32,7 @@ namespace engine
   {
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    write(LogLevel::Warning, format, args);
     va_end(args);
   }
 
@@ -26,7 +40,88 @@ namespace engine
   {
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    write(LogLevel::Error, format, args);
     va_end(args);
   }
+
+  void Log::write(LogLevel level, const char* format, va_list args)
+  {
+    AsyncLog& async_log = getAsyncLog();
+    if (async_log.isRunning() && async_log.push(level, format, args))
+    {
+      return;
+    }
+
+    vfprintf(getStream(level), format, args);
+  }
+
+  LogRecord* Log::beginRecord(LogLevel level, const char* format)
+  {
+    AsyncLog& async_log = getAsyncLog();
+    return async_log.isRunning() ? async_log.beginRecord(level, format) : nullptr;
+  }
+
+  void Log::commitRecord(LogRecord* record)
+  {
+    getAsyncLog().commitRecord(record);
+  }
+
+  void Log::writeRecord(const LogRecord& record)
+  {
+    std::string text;
+    formatLogRecord(record, text);
+    fwrite(text.data(), 1, text.size(), getStream(record.level));
+  }
+
+  void Log::setAsync(bool enabled)
+  {
+    if (enabled)
+    {
+      getAsyncLog().start();
+    }
+    else
+    {
+      getAsyncLog().stop();
+      getAsyncLog().setBinaryOutput("");
+    }
+  }
+
+  bool Log::isAsync()
+  {
+    return getAsyncLog().isRunning();
+  }
+
+  void Log::flush()
+  {
+    getAsyncLog().flush();
+    fflush(getStream(LogLevel::Info));
+    fflush(getStream(LogLevel::Error));
+  }
+
+  bool Log::setBinaryOutput(const std::string& path)
+  {
+    if (!path.empty())
+    {
+      getAsyncLog().start();
+    }
+
+    return getAsyncLog().setBinaryOutput(path);
+  }
+
+  void Log::setOutput(FILE* info_stream, FILE* error_stream)
+  {
+    getAsyncLog().flush();
+    info_output = info_stream;
+    error_output = error_stream;
+  }
+
+  FILE* Log::getStream(LogLevel level)
+  {
+    if (level == LogLevel::Info)
+    {
+      return info_output ? info_output : stdout;
+    }
+
+    return error_output ? error_output : stderr;
+  }
 }
\ No newline at end of file
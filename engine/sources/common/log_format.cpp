@@ -0,0 +1,560 @@
+#include <common/log_format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace engine
+{
+  namespace
+  {
+    const ptrdiff_t max_spec_length = 64;
+
+    bool isFlag(char c)
+    {
+      return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0' || c == '\'';
+    }
+
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    LogArgumentType getArgumentType(char conversion, LogArgumentLength length)
+    {
+      switch (conversion)
+      {
+      case 'd': case 'i': case 'c':
+        return LogArgumentType::Int;
+      case 'u': case 'o': case 'x': case 'X':
+        return LogArgumentType::Unsigned;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        return length == LogArgumentLength::LongDouble ? LogArgumentType::LongDouble : LogArgumentType::Double;
+      case 's':
+        return LogArgumentType::String;
+      case 'p':
+        return LogArgumentType::Pointer;
+      case 'n':
+        return LogArgumentType::WriteCount;
+      default:
+        return LogArgumentType::None;
+      }
+    }
+
+    class PayloadReader
+    {
+    public:
+      PayloadReader(const uint8* payload, uint32 size)
+        : payload(payload)
+        , size(size)
+      {
+      }
+
+      template<typename T>
+      bool read(T& value)
+      {
+        if (offset + sizeof(T) > size)
+        {
+          return false;
+        }
+
+        memcpy(&value, payload + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+      }
+
+      bool readString(const char*& text, uint16& length)
+      {
+        if (!read(length) || offset + length > size)
+        {
+          return false;
+        }
+
+        text = reinterpret_cast<const char*>(payload + offset);
+        offset += length;
+        return true;
+      }
+
+    private:
+      const uint8* payload;
+      uint32 size;
+      uint32 offset { 0 };
+    };
+
+    int64 readSigned(va_list& args, LogArgumentLength length)
+    {
+      switch (length)
+      {
+      case LogArgumentLength::Char: return static_cast<signed char>(va_arg(args, int));
+      case LogArgumentLength::Short: return static_cast<short>(va_arg(args, int));
+      case LogArgumentLength::Long: return va_arg(args, long);
+      case LogArgumentLength::LongLong: return va_arg(args, long long);
+      case LogArgumentLength::IntMax: return va_arg(args, intmax_t);
+      case LogArgumentLength::Size: return static_cast<int64>(va_arg(args, size_t));
+      case LogArgumentLength::PtrDiff: return va_arg(args, ptrdiff_t);
+      default: return va_arg(args, int);
+      }
+    }
+
+    uint64 readUnsigned(va_list& args, LogArgumentLength length)
+    {
+      switch (length)
+      {
+      case LogArgumentLength::Char: return static_cast<unsigned char>(va_arg(args, unsigned int));
+      case LogArgumentLength::Short: return static_cast<unsigned short>(va_arg(args, unsigned int));
+      case LogArgumentLength::Long: return va_arg(args, unsigned long);
+      case LogArgumentLength::LongLong: return va_arg(args, unsigned long long);
+      case LogArgumentLength::IntMax: return va_arg(args, uintmax_t);
+      case LogArgumentLength::Size: return va_arg(args, size_t);
+      case LogArgumentLength::PtrDiff: return static_cast<uint64>(va_arg(args, ptrdiff_t));
+      default: return va_arg(args, unsigned int);
+      }
+    }
+
+    template<typename... Arguments>
+    void appendFormatted(std::string& output, const char* spec, Arguments... arguments)
+    {
+      char buffer[256];
+      int length = snprintf(buffer, sizeof(buffer), spec, arguments...);
+      if (length < 0)
+      {
+        return;
+      }
+
+      if (static_cast<size_t>(length) < sizeof(buffer))
+      {
+        output.append(buffer, length);
+        return;
+      }
+
+      size_t offset = output.size();
+      output.resize(offset + length + 1);
+      snprintf(&output[offset], length + 1, spec, arguments...);
+      output.resize(offset + length);
+    }
+
+    void appendNumber(char*& cursor, int64 value)
+    {
+      cursor += snprintf(cursor, 24, "%lld", static_cast<long long>(value));
+    }
+
+    // Rewrites a conversion for the widened packed types: '*' replaced by the packed values and the
+    // length modifier by the one matching the stored type. A negative precision drops the precision.
+    void buildSpec(const LogFormatSpec& spec, int64 width, int64 precision, const char* length, const char* conversion, char* buffer)
+    {
+      char* cursor = buffer;
+      *cursor++ = '%';
+
+      const char* c = spec.begin + 1;
+      while (isFlag(*c))
+      {
+        *cursor++ = *c++;
+      }
+
+      if (*c == '*')
+      {
+        appendNumber(cursor, width);
+        c++;
+      }
+      while (isDigit(*c))
+      {
+        *cursor++ = *c++;
+      }
+
+      if (*c == '.')
+      {
+        char* precision_begin = cursor;
+        *cursor++ = *c++;
+        if (*c == '*')
+        {
+          appendNumber(cursor, precision);
+          c++;
+        }
+        while (isDigit(*c))
+        {
+          *cursor++ = *c++;
+        }
+
+        if (precision < 0)
+        {
+          cursor = precision_begin;
+        }
+      }
+
+      while (*length)
+      {
+        *cursor++ = *length++;
+      }
+      while (*conversion)
+      {
+        *cursor++ = *conversion++;
+      }
+      *cursor = '\0';
+    }
+
+    // Plain "%d", "%llu", "%s"... without flags, width or precision skip snprintf.
+    bool isPlain(const LogFormatSpec& spec)
+    {
+      const char* c = spec.begin + 1;
+      return !isFlag(*c) && !isDigit(*c) && *c != '*' && *c != '.';
+    }
+
+    void appendDecimal(std::string& output, uint64 value, bool negative)
+    {
+      char digits[24];
+      char* cursor = digits + sizeof(digits);
+      do
+      {
+        *--cursor = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+
+      if (negative)
+      {
+        *--cursor = '-';
+      }
+      output.append(cursor, digits + sizeof(digits));
+    }
+  }
+
+  bool findLogFormatSpec(const char* format, LogFormatSpec& spec)
+  {
+    const char* c = strchr(format, '%');
+    if (!c)
+    {
+      return false;
+    }
+
+    spec = LogFormatSpec();
+    spec.begin = c++;
+
+    if (*c == '%')
+    {
+      spec.end = c + 1;
+      return true;
+    }
+
+    while (isFlag(*c))
+    {
+      c++;
+    }
+
+    if (*c == '*')
+    {
+      spec.width_argument = true;
+      c++;
+    }
+    while (isDigit(*c))
+    {
+      c++;
+    }
+
+    if (*c == '.')
+    {
+      c++;
+      if (*c == '*')
+      {
+        spec.precision_argument = true;
+        c++;
+      }
+      while (isDigit(*c))
+      {
+        c++;
+      }
+    }
+
+    switch (*c)
+    {
+    case 'h':
+      spec.length = c[1] == 'h' ? LogArgumentLength::Char : LogArgumentLength::Short;
+      c += c[1] == 'h' ? 2 : 1;
+      break;
+    case 'l':
+      spec.length = c[1] == 'l' ? LogArgumentLength::LongLong : LogArgumentLength::Long;
+      c += c[1] == 'l' ? 2 : 1;
+      break;
+    case 'j': spec.length = LogArgumentLength::IntMax; c++; break;
+    case 'z': spec.length = LogArgumentLength::Size; c++; break;
+    case 't': spec.length = LogArgumentLength::PtrDiff; c++; break;
+    case 'L': spec.length = LogArgumentLength::LongDouble; c++; break;
+    default: break;
+    }
+
+    if (*c == '\0')
+    {
+      spec.end = c;
+      spec.width_argument = false;
+      spec.precision_argument = false;
+      return true;
+    }
+
+    spec.conversion = *c;
+    spec.type = getArgumentType(*c, spec.length);
+    spec.end = c + 1;
+    // Absurdly long conversions are printed as text, it bounds the rewritten spec.
+    if (spec.end - spec.begin > max_spec_length)
+    {
+      spec.type = LogArgumentType::None;
+    }
+    if (spec.type == LogArgumentType::None)
+    {
+      spec.width_argument = false;
+      spec.precision_argument = false;
+    }
+
+    return true;
+  }
+
+  uint32 packLogArguments(const char* format, va_list args, uint8* buffer, uint32 capacity, bool& truncated)
+  {
+    LogPayloadWriter writer(buffer, capacity);
+
+    va_list arguments;
+    va_copy(arguments, args);
+
+    LogFormatSpec spec;
+    while (!writer.isTruncated() && findLogFormatSpec(format, spec))
+    {
+      format = spec.end;
+
+      if (spec.width_argument)
+      {
+        writer.write<int64>(va_arg(arguments, int));
+      }
+      if (spec.precision_argument)
+      {
+        writer.write<int64>(va_arg(arguments, int));
+      }
+
+      switch (spec.type)
+      {
+      case LogArgumentType::Int:
+        writer.write(readSigned(arguments, spec.length));
+        break;
+      case LogArgumentType::Unsigned:
+        writer.write(readUnsigned(arguments, spec.length));
+        break;
+      case LogArgumentType::Double:
+        writer.write(va_arg(arguments, double));
+        break;
+      case LogArgumentType::LongDouble:
+        writer.write(va_arg(arguments, long double));
+        break;
+      case LogArgumentType::String:
+        // Wide strings are not supported, they are logged as empty strings.
+        writer.writeString(spec.length == LogArgumentLength::Long ? (va_arg(arguments, void*), "") : va_arg(arguments, const char*));
+        break;
+      case LogArgumentType::Pointer:
+        writer.write<uint64>(reinterpret_cast<uintptr_t>(va_arg(arguments, void*)));
+        break;
+      case LogArgumentType::WriteCount:
+        va_arg(arguments, void*);
+        break;
+      default:
+        break;
+      }
+    }
+
+    va_end(arguments);
+
+    truncated = writer.isTruncated();
+    return writer.getSize();
+  }
+
+  void formatLogArguments(const char* format, const uint8* payload, uint32 size, bool truncated, std::string& output)
+  {
+    PayloadReader reader(payload, size);
+    char spec_text[128];
+
+    LogFormatSpec spec;
+    while (findLogFormatSpec(format, spec))
+    {
+      output.append(format, spec.begin);
+      format = spec.end;
+
+      if (spec.type == LogArgumentType::None)
+      {
+        // "%%" prints a percent sign, anything malformed is copied as is.
+        if (spec.end - spec.begin == 2 && spec.begin[1] == '%')
+        {
+          output += '%';
+        }
+        else
+        {
+          output.append(spec.begin, spec.end);
+        }
+        continue;
+      }
+
+      int64 width = 0;
+      int64 precision = 0;
+      bool complete = (!spec.width_argument || reader.read(width)) && (!spec.precision_argument || reader.read(precision));
+
+      char conversion[2] = { spec.conversion, '\0' };
+      switch (spec.type)
+      {
+      case LogArgumentType::Int:
+      {
+        int64 value = 0;
+        if ((complete = complete && reader.read(value)))
+        {
+          if (isPlain(spec) && spec.conversion != 'c')
+          {
+            appendDecimal(output, value < 0 ? 0ull - static_cast<uint64>(value) : static_cast<uint64>(value), value < 0);
+          }
+          else if (spec.conversion == 'c')
+          {
+            buildSpec(spec, width, precision, "", conversion, spec_text);
+            appendFormatted(output, spec_text, static_cast<int>(value));
+          }
+          else
+          {
+            buildSpec(spec, width, precision, "ll", conversion, spec_text);
+            appendFormatted(output, spec_text, static_cast<long long>(value));
+          }
+        }
+        break;
+      }
+      case LogArgumentType::Unsigned:
+      {
+        uint64 value = 0;
+        if ((complete = complete && reader.read(value)))
+        {
+          if (isPlain(spec) && spec.conversion == 'u')
+          {
+            appendDecimal(output, value, false);
+          }
+          else
+          {
+            buildSpec(spec, width, precision, "ll", conversion, spec_text);
+            appendFormatted(output, spec_text, static_cast<unsigned long long>(value));
+          }
+        }
+        break;
+      }
+      case LogArgumentType::Double:
+      {
+        double value = 0.0;
+        if ((complete = complete && reader.read(value)))
+        {
+          buildSpec(spec, width, precision, "", conversion, spec_text);
+          appendFormatted(output, spec_text, value);
+        }
+        break;
+      }
+      case LogArgumentType::LongDouble:
+      {
+        long double value = 0.0;
+        if ((complete = complete && reader.read(value)))
+        {
+          buildSpec(spec, width, precision, "L", conversion, spec_text);
+          appendFormatted(output, spec_text, value);
+        }
+        break;
+      }
+      case LogArgumentType::String:
+      {
+        const char* text = nullptr;
+        uint16 length = 0;
+        if ((complete = complete && reader.readString(text, length)) && isPlain(spec))
+        {
+          output.append(text, length);
+        }
+        else if (complete)
+        {
+          // The packed string is not terminated, the precision bounds it.
+          const char* dot = static_cast<const char*>(memchr(spec.begin, '.', spec.end - spec.begin));
+          if (dot && !spec.precision_argument)
+          {
+            precision = atoll(dot + 1);
+          }
+          int visible = static_cast<int>(dot && precision >= 0 ? std::min<int64>(precision, length) : length);
+
+          buildSpec(spec, width, -1, "", ".*s", spec_text);
+          appendFormatted(output, spec_text, visible, text);
+        }
+        break;
+      }
+      case LogArgumentType::Pointer:
+      {
+        uint64 value = 0;
+        if ((complete = complete && reader.read(value)))
+        {
+          buildSpec(spec, width, precision, "", conversion, spec_text);
+          appendFormatted(output, spec_text, reinterpret_cast<void*>(static_cast<uintptr_t>(value)));
+        }
+        break;
+      }
+      default:
+        break;
+      }
+
+      if (!complete)
+      {
+        break;
+      }
+    }
+
+    if (truncated)
+    {
+      output += "[truncated]";
+      // Keep line based output line based.
+      size_t length = strlen(format);
+      if (length > 0 && format[length - 1] == '\n')
+      {
+        output += '\n';
+      }
+      return;
+    }
+
+    output.append(format);
+  }
+
+  void packLogRecordInline(LogRecord& record, const char* format, va_list args)
+  {
+    LogPayloadWriter writer(record.payload, LogRecord::payload_capacity);
+    writer.writeString(format, strlen(format) + 1);
+
+    record.inline_format = true;
+    record.truncated = writer.isTruncated();
+    record.size = static_cast<uint16>(writer.getSize());
+    if (!record.truncated)
+    {
+      bool truncated = false;
+      record.size += static_cast<uint16>(packLogArguments(format, args, record.payload + record.size, LogRecord::payload_capacity - record.size, truncated));
+      record.truncated = truncated;
+    }
+    else
+    {
+      // Cut formats lose the terminator, the last byte becomes one.
+      record.payload[record.size - 1] = '\0';
+    }
+  }
+
+  const char* getLogRecordFormat(const LogRecord& record, const uint8*& arguments, uint32& size)
+  {
+    if (!record.inline_format)
+    {
+      arguments = record.payload;
+      size = record.size;
+      return record.format;
+    }
+
+    uint16 length = 0;
+    memcpy(&length, record.payload, sizeof(length));
+    arguments = record.payload + sizeof(length) + length;
+    size = record.size - sizeof(length) - length;
+    return reinterpret_cast<const char*>(record.payload + sizeof(length));
+  }
+
+  void formatLogRecord(const LogRecord& record, std::string& output)
+  {
+    const uint8* arguments = nullptr;
+    uint32 size = 0;
+    const char* format = getLogRecordFormat(record, arguments, size);
+    formatLogArguments(format, arguments, size, record.truncated, output);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include <common/mapped_file.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+#if defined(_WIN32)
+  bool MappedFile::open(const std::string& path, Mode mode, uint64 size)
+  {
+    close();
+    this->mode = mode;
+
+    DWORD access = mode == Mode::Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    DWORD disposition = mode == Mode::Read ? OPEN_EXISTING : CREATE_ALWAYS;
+    HANDLE file = ::CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    file_handle = file;
+
+    if (mode == Mode::Read)
+    {
+      LARGE_INTEGER file_size;
+      if (!::GetFileSizeEx(file, &file_size))
+      {
+        close();
+        return false;
+      }
+      size = static_cast<uint64>(file_size.QuadPart);
+    }
+
+    mapped_size = size;
+    if (size > 0 && !map())
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool MappedFile::map()
+  {
+    DWORD protection = mode == Mode::Read ? PAGE_READONLY : PAGE_READWRITE;
+    HANDLE mapping = ::CreateFileMappingA(file_handle, nullptr, protection, static_cast<DWORD>(mapped_size >> 32), static_cast<DWORD>(mapped_size), nullptr);
+    if (!mapping)
+    {
+      return false;
+    }
+    mapping_handle = mapping;
+
+    DWORD access = mode == Mode::Read ? FILE_MAP_READ : FILE_MAP_WRITE;
+    data_pointer = static_cast<uint8*>(::MapViewOfFile(mapping, access, 0, 0, 0));
+
+    return data_pointer != nullptr;
+  }
+
+  void MappedFile::unmap()
+  {
+    if (data_pointer)
+    {
+      ::UnmapViewOfFile(data_pointer);
+      data_pointer = nullptr;
+    }
+    if (mapping_handle)
+    {
+      ::CloseHandle(mapping_handle);
+      mapping_handle = nullptr;
+    }
+  }
+
+  bool MappedFile::resize(uint64 size)
+  {
+    if (mode != Mode::Write || !file_handle)
+    {
+      return false;
+    }
+
+    // Growing the mapping object grows the file as well.
+    unmap();
+    mapped_size = size;
+    return map();
+  }
+
+  bool MappedFile::flush()
+  {
+    return data_pointer && ::FlushViewOfFile(data_pointer, 0) && ::FlushFileBuffers(file_handle);
+  }
+
+  void MappedFile::close(uint64 final_size)
+  {
+    unmap();
+
+    if (file_handle)
+    {
+      if (mode == Mode::Write && final_size > 0)
+      {
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(final_size);
+        ::SetFilePointerEx(file_handle, position, nullptr, FILE_BEGIN);
+        ::SetEndOfFile(file_handle);
+      }
+
+      ::CloseHandle(file_handle);
+      file_handle = nullptr;
+    }
+
+    mapped_size = 0;
+  }
+#else
+  bool MappedFile::open(const std::string& path, Mode mode, uint64 size)
+  {
+    close();
+    this->mode = mode;
+
+    file_descriptor = mode == Mode::Read ? ::open(path.c_str(), O_RDONLY) : ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file_descriptor < 0)
+    {
+      return false;
+    }
+
+    if (mode == Mode::Read)
+    {
+      struct stat file_stat;
+      if (::fstat(file_descriptor, &file_stat) != 0)
+      {
+        close();
+        return false;
+      }
+      size = static_cast<uint64>(file_stat.st_size);
+    }
+    else if (::ftruncate(file_descriptor, static_cast<off_t>(size)) != 0)
+    {
+      close();
+      return false;
+    }
+
+    mapped_size = size;
+    if (size > 0 && !map())
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool MappedFile::map()
+  {
+    int protection = mode == Mode::Read ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* address = ::mmap(nullptr, mapped_size, protection, MAP_SHARED, file_descriptor, 0);
+    if (address == MAP_FAILED)
+    {
+      return false;
+    }
+
+    data_pointer = static_cast<uint8*>(address);
+    return true;
+  }
+
+  void MappedFile::unmap()
+  {
+    if (data_pointer)
+    {
+      ::munmap(data_pointer, mapped_size);
+      data_pointer = nullptr;
+    }
+  }
+
+  bool MappedFile::resize(uint64 size)
+  {
+    if (mode != Mode::Write || file_descriptor < 0)
+    {
+      return false;
+    }
+
+    unmap();
+    if (::ftruncate(file_descriptor, static_cast<off_t>(size)) != 0)
+    {
+      return false;
+    }
+
+    mapped_size = size;
+    return map();
+  }
+
+  bool MappedFile::flush()
+  {
+    return data_pointer && ::msync(data_pointer, mapped_size, MS_SYNC) == 0;
+  }
+
+  void MappedFile::close(uint64 final_size)
+  {
+    unmap();
+
+    if (file_descriptor >= 0)
+    {
+      if (mode == Mode::Write && final_size > 0 && ::ftruncate(file_descriptor, static_cast<off_t>(final_size)) != 0)
+      {
+        // The file keeps its preallocated tail, readers stop at the first empty record.
+      }
+
+      ::close(file_descriptor);
+      file_descriptor = -1;
+    }
+
+    mapped_size = 0;
+  }
+#endif
+}
\ No newline at end of file
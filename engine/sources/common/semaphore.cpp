@@ -0,0 +1,74 @@
+#include <common/semaphore.h>
+
+#include <algorithm>
+
+namespace engine
+{
+  namespace
+  {
+    constexpr uint32 spin_count = 256;
+  }
+
+  Semaphore::Semaphore(int32 initial_count)
+    : count(initial_count)
+  {
+  }
+
+  void Semaphore::signal(int32 signal_count)
+  {
+    int32 old_count = count.fetch_add(signal_count, std::memory_order_release);
+    int32 to_release = std::min(-old_count, signal_count);
+    if (to_release <= 0)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      wakeups += to_release;
+    }
+
+    if (to_release == 1)
+    {
+      condition.notify_one();
+    }
+    else
+    {
+      condition.notify_all();
+    }
+  }
+
+  void Semaphore::wait()
+  {
+    for (uint32 i = 0; i < spin_count; ++i)
+    {
+      if (tryWait())
+      {
+        return;
+      }
+    }
+
+    if (count.fetch_sub(1, std::memory_order_acquire) > 0)
+    {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return wakeups > 0; });
+    wakeups--;
+  }
+
+  bool Semaphore::tryWait()
+  {
+    int32 current = count.load(std::memory_order_relaxed);
+    while (current > 0)
+    {
+      if (count.compare_exchange_weak(current, current - 1, std::memory_order_acquire, std::memory_order_relaxed))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+}
\ No newline at end of file
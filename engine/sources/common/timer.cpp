@@ -0,0 +1,35 @@
+#include <common/timer.h>
+
+namespace engine
+{
+  Timer::Timer()
+  {
+    reset();
+  }
+
+  void Timer::reset()
+  {
+    start_time = Clock::now();
+    last_tick_time = start_time;
+    delta_seconds = 0.0;
+  }
+
+  double Timer::tick()
+  {
+    auto now = Clock::now();
+    delta_seconds = std::chrono::duration<double>(now - last_tick_time).count();
+    last_tick_time = now;
+
+    return delta_seconds;
+  }
+
+  double Timer::getElapsedSeconds() const
+  {
+    return std::chrono::duration<double>(Clock::now() - start_time).count();
+  }
+
+  uint64 Timer::nowNanoseconds()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+  }
+}
\ No newline at end of file
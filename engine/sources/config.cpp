@@ -1,14 +1,34 @@
 #include <config.h>
-#include <fstream>
+#include <common/log_checked.h>
+#include <common/math.h>
+#include <render/render_limits.h>
 
 namespace engine
 {
-  bool Config::Load(const std::string& path)
+  namespace
   {
-    std::ifstream file_stream(path);
-    nlohmann::json json_file;
-    file_stream >> json_file;
-    data = json_file.get<Data>();
+    void clampSetting(const char* name, uint32& value, uint32 min, uint32 max)
+    {
+      uint32 clamped = clamp(value, min, max);
+      if (clamped != value)
+      {
+        LOG_WARNING("Config: render_settings.%s %u is outside %u..%u, using %u\n", name, value, min, max, clamped);
+        value = clamped;
+      }
+    }
+  }
+
+  void validateRenderSettings(RenderSettingsData& settings)
+  {
+    clampSetting("frame_count", settings.frame_count, 1, RenderLimits::max_frame_count);
+    clampSetting("swap_chain_buffer_count", settings.swap_chain_buffer_count, 2, RenderLimits::max_swap_chain_buffers);
+    clampSetting("max_frame_latency", settings.max_frame_latency, 1, RenderLimits::max_frame_latency);
+  }
+
+  bool Config::Load(const std::string& path, bool use_cache)
+  {
+    source = loadConfigFile(path, data, use_cache);
+    validateRenderSettings(data.render_settings);
 
     return true;
   }
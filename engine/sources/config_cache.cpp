@@ -0,0 +1,128 @@
+#include <config_cache.h>
+#include <common/log_checked.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace engine
+{
+  constexpr char ConfigCacheHeader::magic_value[8];
+
+  std::string getConfigCachePath(const std::string& path)
+  {
+    return path + ".cache";
+  }
+
+  bool getConfigSourceStamp(const std::string& path, ConfigSourceStamp& stamp)
+  {
+    std::error_code error;
+    uint64 size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+      return false;
+    }
+
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+      return false;
+    }
+
+    stamp.size = size;
+    stamp.time = static_cast<int64>(time.time_since_epoch().count());
+    return true;
+  }
+
+  bool isConfigSourceSettled(const ConfigSourceStamp& stamp)
+  {
+    using FileClock = std::filesystem::file_time_type::clock;
+    auto modified = std::filesystem::file_time_type(std::filesystem::file_time_type::duration(stamp.time));
+    return FileClock::now() - modified >= std::chrono::seconds(1);
+  }
+
+  bool openConfigCache(const std::string& path, uint64 schema_hash, const ConfigSourceStamp& stamp, MappedFile& file, const uint8*& payload, uint64& payload_size)
+  {
+    ConfigCacheHeader header;
+    if (!file.open(path, MappedFile::Mode::Read) || file.size() < sizeof(header))
+    {
+      return false;
+    }
+
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, ConfigCacheHeader::magic_value, sizeof(header.magic)) != 0
+      || header.version != ConfigCacheHeader::current_version
+      || header.header_size != sizeof(header)
+      || header.schema_hash != schema_hash
+      || header.source_size != stamp.size
+      || header.source_time != stamp.time
+      || header.payload_size != file.size() - sizeof(header))
+    {
+      return false;
+    }
+
+    payload = file.data() + sizeof(header);
+    payload_size = header.payload_size;
+    return true;
+  }
+
+  bool writeConfigCache(const std::string& path, uint64 schema_hash, const ConfigSourceStamp& stamp, const std::vector<uint8>& payload)
+  {
+    ConfigCacheHeader header;
+    memcpy(header.magic, ConfigCacheHeader::magic_value, sizeof(header.magic));
+    header.version = ConfigCacheHeader::current_version;
+    header.header_size = sizeof(header);
+    header.schema_hash = schema_hash;
+    header.source_size = stamp.size;
+    header.source_time = stamp.time;
+    header.payload_size = payload.size();
+
+    std::string temporary_path = path + ".tmp";
+    {
+      std::ofstream file_stream(temporary_path, std::ios::binary | std::ios::trunc);
+      file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file_stream.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+      if (!file_stream.flush())
+      {
+        file_stream.close();
+        std::error_code error;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+      }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+      std::filesystem::remove(temporary_path, error);
+      return false;
+    }
+
+    return true;
+  }
+
+  void checkConfigIssues(const std::string& path, const std::vector<JsonIssue>& issues)
+  {
+    std::string errors;
+    for (const JsonIssue& issue : issues)
+    {
+      if (issue.isError())
+      {
+        errors += path + ":" + issue.toString() + "\n";
+      }
+      else
+      {
+        LOG_WARNING("%s:%s\n", path, issue.toString());
+      }
+    }
+
+    if (!errors.empty())
+    {
+      throw std::runtime_error("Can't load config\n" + errors);
+    }
+  }
+}
\ No newline at end of file
@@ -1,343 +1,536 @@
 #include <device_resources.h>
-#include <window.h>
+
+#include <cassert>
+#include <common/log.h>
+#include <common/math.h>
+#include <common/timer.h>
+#include <profiler/profiler.h>
 
 namespace engine
 {
-  void DeviceResources::loadPipeline(const Window& window)
+  void DeviceResources::loadPipeline(const SurfaceDesc& surface)
   {
-    ComPtr<IDXGIAdapter4> dxgi_adapter4 = getAdapter(window.getUseWarp());
-    device = createDevice(dxgi_adapter4);
-    command_queue = createCommandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
-
-    swap_chain = createSwapChain(window.getHwnd(), command_queue, window.getWidth(), window.getHeight(), num_frames);
-    current_back_buffer_index = swap_chain->GetCurrentBackBufferIndex();
+    width = surface.width;
+    height = surface.height;
+    // Before the device, so it can allocate staging descriptors while creating the swap chain.
+    descriptor_allocator.initialize([this](const DescriptorHeapDesc& desc) { return createDescriptorHeap(desc); },
+      [this](DescriptorHeapType type, const DescriptorCopyBatch& batch) { copyDescriptors(type, batch); }, descriptor_settings);
+    createDeviceResources(surface);
+    descriptor_allocator.createShaderVisibleHeaps();
+    bindless_table.initialize(descriptor_allocator.getResourceHeap(), descriptor_settings.bindless_capacity);
+
+    resizeFrameResources(frame_count);
+    command_list_pool.initialize([this](CommandListType type) { return createCommandContext(type); }, frame_count);
+    queue_contexts.resize(frame_count * queue_count);
+    frame_allocator.setFrameCount(frame_count);
+    frame_fence_values.assign(frame_count, 0);
+    upload_ring.initialize(createUploadMemory(upload_buffer_size));
+    gpu_memory_allocator.initialize([this](const HeapDesc& desc) { return createHeap(desc); }, [this](HeapId heap) { destroyHeap(heap); });
+    frame_index = 0;
+    current_back_buffer_index = queryCurrentBackBufferIndex();
+    registerBackBuffers();
 
-    RTV_descriptor_heap = createDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, num_frames);
-    RTV_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    is_initialized = true;
+  }
 
-    updateRenderTargetViews(device, swap_chain, RTV_descriptor_heap);
+  void DeviceResources::setFrameCount(uint32 frames_in_flight)
+  {
+    assert(frames_in_flight > 0 && frames_in_flight <= max_frame_count);
+    assert(frame_command_list == nullptr && "Frame count can't change while a frame is recorded.");
 
-    for (int frame = 0; frame < num_frames; ++frame)
+    if (is_initialized && frames_in_flight != frame_count)
     {
-      command_allocators[frame] = createCommandAllocator(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+      flush();
+      resizeFrameResources(frames_in_flight);
+      command_list_pool.setFrameCount(frames_in_flight);
+      queue_contexts.clear();
+      queue_contexts.resize(frames_in_flight * queue_count);
+      frame_allocator.setFrameCount(frames_in_flight);
+      frame_fence_values.assign(frames_in_flight, fence_timeline.getCompletedValue());
+      frame_index = 0;
     }
-    command_list = createCommandList(device, command_allocators[current_back_buffer_index], D3D12_COMMAND_LIST_TYPE_DIRECT);
 
-    fence = createFence(device);
-    fence_event = createEventHandle();
+    frame_count = frames_in_flight;
+  }
 
-    is_initialized = true;
+  void DeviceResources::setUploadBufferSize(uint64 size)
+  {
+    assert(!is_initialized && "Upload buffer size must be chosen before loadPipeline.");
+    assert(isPowerOfTwo(size) && size >= UploadRing::max_alignment);
+    upload_buffer_size = size;
   }
 
-  void DeviceResources::render(bool vsync, bool tearing_supported)
+  void DeviceResources::setDescriptorSettings(const DescriptorAllocator::Settings& settings)
   {
-    auto command_allocator = command_allocators[current_back_buffer_index];
-    auto back_buffer = back_buffers[current_back_buffer_index];
-    command_allocator->Reset();
-    command_list->Reset(command_allocator.Get(), nullptr);
+    assert(!is_initialized && "Descriptor heaps must be sized before loadPipeline.");
+    assert(settings.resource_persistent_count <= settings.resource_heap_capacity && settings.sampler_persistent_count <= settings.sampler_heap_capacity);
+    assert(settings.bindless_capacity <= settings.resource_persistent_count);
+    descriptor_settings = settings;
+  }
 
-    // Clear the render target.
-    {
-      CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(back_buffer.Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-      command_list->ResourceBarrier(1, &barrier);
+  void DeviceResources::setSwapChainBufferCount(uint32 buffer_count)
+  {
+    assert(buffer_count >= 2 && buffer_count <= max_swap_chain_buffers);
+    assert(frame_command_list == nullptr && "Swap chain can't change while a frame is recorded.");
 
-      FLOAT clear_color[] = { 0.2f, 0.2f, 0.2f, 1.0f };
-      CD3DX12_CPU_DESCRIPTOR_HANDLE rtv(RTV_descriptor_heap->GetCPUDescriptorHandleForHeapStart(), current_back_buffer_index, RTV_descriptor_size);
-      command_list->ClearRenderTargetView(rtv, clear_color, 0, nullptr);
-    }
+    bool changed = buffer_count != swap_chain_buffer_count;
+    swap_chain_buffer_count = buffer_count;
 
-    // Present
+    if (is_initialized && changed)
     {
-      CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(back_buffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-      command_list->ResourceBarrier(1, &barrier);
-      ThrowIfFailed(command_list->Close());
-
-      ID3D12CommandList* const command_lists[] = { command_list.Get() };
-      command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
-      frame_fence_values[current_back_buffer_index] = signal(command_queue, fence, fence_value);
-
-      UINT sync_interval = vsync ? 1 : 0;
-      UINT present_flags = tearing_supported && !vsync ? DXGI_PRESENT_ALLOW_TEARING : 0;
-      ThrowIfFailed(swap_chain->Present(sync_interval, present_flags));
-
-      current_back_buffer_index = swap_chain->GetCurrentBackBufferIndex();
-      waitForFenceValue(fence, frame_fence_values[current_back_buffer_index], fence_event);
+      flush();
+      resizeSwapChain(width, height);
+      current_back_buffer_index = queryCurrentBackBufferIndex();
+      registerBackBuffers();
     }
   }
 
-  void DeviceResources::resize(uint32 width, uint32 height)
+  CommandList& DeviceResources::beginFrame()
   {
-    flush();
+    PROFILE_SCOPE("DeviceResources::beginFrame");
+    assert(is_initialized && frame_command_list == nullptr);
 
-    for (int frame = 0; frame < DeviceResources::num_frames; ++frame)
+    prepareFrame();
+    if (next_capture != nullptr)
     {
-      back_buffers[frame].Reset();
-      frame_fence_values[frame] = frame_fence_values[current_back_buffer_index];
+      capture = next_capture;
+      next_capture = nullptr;
+      capture->reset(getBackBuffer(current_back_buffer_index), getBackBufferView(current_back_buffer_index));
+      capture_lists.clear();
     }
 
-    DXGI_SWAP_CHAIN_DESC swap_chain_desc = {};
-    ThrowIfFailed(swap_chain->GetDesc(&swap_chain_desc));
-    ThrowIfFailed(swap_chain->ResizeBuffers(num_frames, width, height, swap_chain_desc.BufferDesc.Format, swap_chain_desc.Flags));
+    CommandList& command_list = captureCommandList(resetCommandList(frame_index));
+    frame_command_list = &command_list;
 
-    current_back_buffer_index = swap_chain->GetCurrentBackBufferIndex();
-    updateRenderTargetViews(device, swap_chain, RTV_descriptor_heap);
-  }
+    // Clear the render target.
+    resource_state_tracker.require(getBackBuffer(current_back_buffer_index), ResourceState::RenderTarget);
+    resource_state_tracker.flush(command_list);
 
-  void DeviceResources::flush()
-  {
-    flush(command_queue, fence, fence_value, fence_event);
+    const float clear_color[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    command_list.clearRenderTargetView(getBackBufferView(current_back_buffer_index), clear_color);
+
+    return command_list;
   }
 
-  void DeviceResources::enableDebugLayer()
+  CommandList& DeviceResources::acquireCommandList(uint32 order)
   {
-#if defined(_DEBUG)
-    ComPtr<ID3D12Debug> debug_interface;
-    ThrowIfFailed(D3D12GetDebugInterface(IID_PPV_ARGS(&debug_interface)));
-    debug_interface->EnableDebugLayer();
-#endif
+    return captureCommandList(command_list_pool.acquire(order));
   }
 
-  bool DeviceResources::checkTearingSupport()
+  void DeviceResources::endFrame(bool vsync, bool tearing_supported)
   {
-    bool allow_tearing = false;
+    PROFILE_SCOPE("DeviceResources::endFrame");
+    assert(frame_command_list != nullptr);
 
-    ComPtr<IDXGIFactory4> factory4;
-    if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory4))))
+    CommandList& command_list = *frame_command_list;
+    frame_command_list = nullptr;
+
+    // Present, after the lists recorded on other threads if there are any.
+    CommandList* present_list = &command_list;
+    if (command_list_pool.getAcquiredCount() > 0)
     {
-      ComPtr<IDXGIFactory5> factory5;
-      if (SUCCEEDED(factory4.As(&factory5)))
-      {
-        if (FAILED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allow_tearing, sizeof(allow_tearing))))
-        {
-          allow_tearing = false;
-        }
-      }
+      command_list.close();
+      present_list = &acquireCommandList(~0u);
+    }
+
+    resource_state_tracker.require(getBackBuffer(current_back_buffer_index), ResourceState::Present);
+    resource_state_tracker.flush(*present_list);
+    present_list->close();
+    descriptor_allocator.flushCopies();
+
+    submitted_command_lists.assign(1, &command_list);
+    command_list_pool.collect(submitted_command_lists);
+    submitCommandLists(CommandListType::Direct, submitted_command_lists.data(), static_cast<uint32>(submitted_command_lists.size()));
+    if (capture != nullptr)
+    {
+      captureUploads();
+      capture = nullptr;
     }
+    finishFrame(vsync, tearing_supported);
+  }
 
-    return allow_tearing;
+  void DeviceResources::captureNextFrame(FrameCapture& capture)
+  {
+    next_capture = &capture;
   }
 
-  ComPtr<IDXGIAdapter4> DeviceResources::getAdapter(bool use_warp)
+  void DeviceResources::replayFrame(const FrameCapture& capture, bool vsync, bool tearing_supported)
   {
-    ComPtr<IDXGIFactory4> dxgi_factory;
-    uint create_factory_flags = 0;
-#if defined(_DEBUG)
-    create_factory_flags = DXGI_CREATE_FACTORY_DEBUG;
-#endif
-    ThrowIfFailed(CreateDXGIFactory2(create_factory_flags, IID_PPV_ARGS(&dxgi_factory)));
+    PROFILE_SCOPE("DeviceResources::replayFrame");
+    assert(is_initialized && frame_command_list == nullptr);
 
-    ComPtr<IDXGIAdapter1> dxgi_adapter1;
-    ComPtr<IDXGIAdapter4> dxgi_adapter4;
+    prepareFrame();
+    const FrameCaptureHeader& header = capture.getHeader();
+    replayer.setBackBuffer(header.back_buffer, header.back_buffer_view, getBackBuffer(current_back_buffer_index), getBackBufferView(current_back_buffer_index));
 
-    if (use_warp)
+    // Upload the recorded constants and vertices again, the recorded range may be overwritten by now.
+    UploadRemap upload_remap = capture.getUploadRemap();
+    if (upload_remap.size > 0)
     {
-      ThrowIfFailed(dxgi_factory->EnumWarpAdapter(IID_PPV_ARGS(&dxgi_adapter1)));
-      ThrowIfFailed(dxgi_adapter1.As(&dxgi_adapter4));
+      upload_remap.replayed = upload_ring.upload(capture.getUploadData(), upload_remap.size, UploadRing::max_alignment);
+      if (!upload_remap.replayed.isValid())
+      {
+        Log::warning("Upload ring is full, the replayed frame reads the recorded upload data as it is now.\n");
+        upload_remap.size = 0;
+      }
     }
-    else
+    replayer.setUploadRemap(upload_remap);
+    replay_signals.clear();
+
+    FrameCapture::Reader reader(capture);
+    FrameCapture::Event event;
+    bool complete = true;
+    while (complete && reader.next(event))
     {
-      SIZE_T max_dedicated_video_memory = 0;
-      for (uint i = 0; dxgi_factory->EnumAdapters1(i, &dxgi_adapter1) != DXGI_ERROR_NOT_FOUND; ++i)
+      if (event.type == FrameCapture::EventType::Submit)
       {
-        DXGI_ADAPTER_DESC1 dxgi_adapter_desc1;
-        dxgi_adapter1->GetDesc1(&dxgi_adapter_desc1);
-
-        if ((dxgi_adapter_desc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 
-          && SUCCEEDED(D3D12CreateDevice(dxgi_adapter1.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr)) 
-          && dxgi_adapter_desc1.DedicatedVideoMemory > max_dedicated_video_memory)
+        submitted_command_lists.clear();
+        for (uint32 i = 0; i < event.list_count; ++i)
+        {
+          const uint8* data;
+          uint64 size;
+          if (!reader.nextCommandList(data, size))
+          {
+            Log::error("Frame capture ends inside a submit, replay stops there.\n");
+            complete = false;
+            break;
+          }
+
+          CommandList& command_list = acquireQueueCommandList(event.queue);
+          replayer.replay(data, size, command_list);
+          command_list.close();
+          submitted_command_lists.push_back(&command_list);
+        }
+        if (!submitted_command_lists.empty())
         {
-          max_dedicated_video_memory = dxgi_adapter_desc1.DedicatedVideoMemory;
-          ThrowIfFailed(dxgi_adapter1.As(&dxgi_adapter4));
+          executeCommandLists(event.queue, submitted_command_lists.data(), static_cast<uint32>(submitted_command_lists.size()));
+        }
+      }
+      else if (event.type == FrameCapture::EventType::Signal)
+      {
+        replay_signals.push_back({ event.queue, event.value, signalNextValue(event.queue) });
+      }
+      else
+      {
+        // Waits for values signaled before the captured frame have nothing to wait for.
+        for (const ReplaySignal& signal : replay_signals)
+        {
+          if (signal.queue == event.signaled_queue && signal.captured_value == event.value)
+          {
+            waitForQueue(event.queue, event.signaled_queue, signal.value);
+            break;
+          }
         }
       }
     }
 
-    return dxgi_adapter4;
+    finishFrame(vsync, tearing_supported);
   }
 
-  ComPtr<ID3D12Device2> DeviceResources::createDevice(ComPtr<IDXGIAdapter4> adapter)
+  void DeviceResources::captureUploads()
   {
-    ComPtr<ID3D12Device2> d3d12_device2;
-    ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3d12_device2)));
-    
-    // enable debug messages in debug mode
-#if defined(_DEBUG)
-    ComPtr<ID3D12InfoQueue> info_queue;
-    if (SUCCEEDED(d3d12_device2.As(&info_queue)))
+    // Start at a max_alignment boundary, so the replayed copy keeps the alignment of every allocation.
+    uint64 begin = alignDown(upload_ring.getFrameBegin(), UploadRing::max_alignment);
+    uint64 end = upload_ring.getHead();
+    if (end - begin > upload_ring.getCapacity())
     {
-      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
-      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
-      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, TRUE);
-
-      // Suppress whole categories of messages
-      //D3D12_MESSAGE_CATEGORY categories[] = {};
-
-      // Suppress messages based on their severity level
-      D3D12_MESSAGE_SEVERITY severities[] = { D3D12_MESSAGE_SEVERITY_INFO };
-
-      // Suppress individual messages by their ID
-      D3D12_MESSAGE_ID deny_ids[] = {
-          D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
-          D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
-          D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
-      };
-
-      D3D12_INFO_QUEUE_FILTER info_filter = {};
-      //info_filter.DenyList.NumCategories = _countof(categories);
-      //info_filter.DenyList.pCategoryList = categories;
-      info_filter.DenyList.NumSeverities = _countof(severities);
-      info_filter.DenyList.pSeverityList = severities;
-      info_filter.DenyList.NumIDs = _countof(deny_ids);
-      info_filter.DenyList.pIDList = deny_ids;
-
-      ThrowIfFailed(info_queue->PushStorageFilter(&info_filter));
+      Log::warning("Captured frame uploaded more than the upload ring holds, its upload data isn't captured.\n");
+      return;
     }
-#endif
 
-    return d3d12_device2;
+    const UploadMemory& memory = upload_ring.getMemory();
+    upload_ring.read(begin, end, capture->addUploads(memory, begin & (memory.size - 1), end - begin));
   }
 
-  ComPtr<ID3D12CommandQueue> DeviceResources::createCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+  void DeviceResources::prepareFrame()
   {
-    ComPtr<ID3D12CommandQueue> d3d12_command_queue;
-
-    D3D12_COMMAND_QUEUE_DESC desc = {};
-    desc.Type = type;
-    desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
-    desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    desc.NodeMask = 0;
-
-    ThrowIfFailed(device->CreateCommandQueue(&desc, IID_PPV_ARGS(&d3d12_command_queue)));
+    if (frame_pacing != FramePacingMode::Blocking)
+    {
+      waitForFrameLatency();
+    }
 
-    return d3d12_command_queue;
+    frame_allocator.beginFrame(frame_index);
+    upload_ring.retire(fence_timeline.getCompletedValue());
+    descriptor_allocator.retire(fence_timeline.getCompletedValue());
+    bindless_table.retire(fence_timeline.getCompletedValue());
+    command_list_pool.beginFrame(frame_index);
+    for (uint32 queue = 0; queue < queue_count; ++queue)
+    {
+      queue_contexts[frame_index * queue_count + queue].used = 0;
+    }
   }
 
-  ComPtr<IDXGISwapChain4> DeviceResources::createSwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> command_queue, uint32_t width, uint32_t height, uint32_t buffer_count)
+  void DeviceResources::finishFrame(bool vsync, bool tearing_supported)
   {
-    ComPtr<IDXGISwapChain4> dxgi_swap_chain4;
-    ComPtr<IDXGIFactory4> dxgi_factory4;
-    UINT create_factory_flags = 0;
-#if defined(_DEBUG)
-    create_factory_flags = DXGI_CREATE_FACTORY_DEBUG;
-#endif
-
-    ThrowIfFailed(CreateDXGIFactory2(create_factory_flags, IID_PPV_ARGS(&dxgi_factory4)));
-
-    DXGI_SWAP_CHAIN_DESC1 swap_chain_desc = {};
-    swap_chain_desc.Width = width;
-    swap_chain_desc.Height = height;
-    swap_chain_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swap_chain_desc.Stereo = FALSE;
-    swap_chain_desc.SampleDesc = { 1, 0 };
-    swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swap_chain_desc.BufferCount = buffer_count;
-    swap_chain_desc.Scaling = DXGI_SCALING_STRETCH;
-    swap_chain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swap_chain_desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-    // It is recommended to always allow tearing if tearing support is available.
-    swap_chain_desc.Flags = checkTearingSupport() ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
-
-    ComPtr<IDXGISwapChain1> swap_chain1;
-    ThrowIfFailed(dxgi_factory4->CreateSwapChainForHwnd(command_queue.Get(), hwnd, &swap_chain_desc, nullptr, nullptr, &swap_chain1));
-
-    // Disable the Alt+Enter fullscreen toggle feature. Switching to fullscreen
-    // will be handled manually.
-    ThrowIfFailed(dxgi_factory4->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
-
-    ThrowIfFailed(swap_chain1.As(&dxgi_swap_chain4));
-
-    return dxgi_swap_chain4;
+    frame_fence_values[frame_index] = fence_timeline.signalFrame();
+    signalQueue(CommandListType::Direct, frame_fence_values[frame_index]);
+    upload_ring.endFrame(frame_fence_values[frame_index]);
+    descriptor_allocator.endFrame(frame_fence_values[frame_index]);
+    bindless_table.endFrame(frame_fence_values[frame_index]);
+
+    uint32 sync_interval = vsync ? 1 : 0;
+    present(sync_interval, tearing_supported && !vsync);
+
+    current_back_buffer_index = queryCurrentBackBufferIndex();
+    frame_index = (frame_index + 1) % frame_count;
+    if (frame_pacing == FramePacingMode::Blocking)
+    {
+      waitForFenceValueTimed(frame_fence_values[frame_index]);
+    }
   }
 
-  ComPtr<ID3D12DescriptorHeap> DeviceResources::createDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32 num_descriptors)
+  class DeviceResources::FrameQueues : public RenderGraphQueues
   {
-    ComPtr<ID3D12DescriptorHeap> descriptor_heap;
+  public:
+    explicit FrameQueues(DeviceResources& owner)
+      : owner(owner)
+    {
+    }
 
-    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-    desc.NumDescriptors = num_descriptors;
-    desc.Type = type;
+    CommandList& acquireCommandList(CommandListType queue) override
+    {
+      return owner.captureCommandList(owner.acquireQueueCommandList(queue));
+    }
+
+    uint64 submit(CommandListType queue, CommandList& command_list, bool signal) override
+    {
+      // Passes may have staged descriptor tables while recording.
+      command_list.close();
+      owner.descriptor_allocator.flushCopies();
+      CommandList* lists[] = { &command_list };
+      owner.submitCommandLists(queue, lists, 1);
+      return signal ? owner.signalNextValue(queue) : 0;
+    }
+
+    void wait(CommandListType queue, CommandListType signaled_queue, uint64 value) override
+    {
+      if (owner.capture != nullptr)
+      {
+        owner.capture->addWait(queue, signaled_queue, value);
+      }
+      owner.waitForQueue(queue, signaled_queue, value);
+    }
 
-    ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptor_heap)));
+  private:
+    DeviceResources& owner;
+  };
 
-    return descriptor_heap;
+  void DeviceResources::executeRenderGraph(RenderGraph& graph)
+  {
+    PROFILE_SCOPE("DeviceResources::executeRenderGraph");
+    assert(frame_command_list != nullptr);
+
+    // The graph's batches have to follow what the frame recorded so far.
+    FrameQueues queues(*this);
+    queues.submit(CommandListType::Direct, *frame_command_list, false);
+    graph.execute(queues);
+    frame_command_list = &captureCommandList(acquireQueueCommandList(CommandListType::Direct));
   }
 
-  void DeviceResources::updateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swap_chain, ComPtr<ID3D12DescriptorHeap> descriptor_heap)
+  void DeviceResources::render(bool vsync, bool tearing_supported)
   {
-    auto rtv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    PROFILE_SCOPE("DeviceResources::render");
+    beginFrame();
+    endFrame(vsync, tearing_supported);
+  }
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_handle(descriptor_heap->GetCPUDescriptorHandleForHeapStart());
+  void DeviceResources::resize(uint32 width, uint32 height)
+  {
+    PROFILE_SCOPE("DeviceResources::resize");
+    flush();
 
-    for (int i = 0; i < num_frames; ++i)
-    {
-      ComPtr<ID3D12Resource> back_buffer;
-      ThrowIfFailed(swap_chain->GetBuffer(i, IID_PPV_ARGS(&back_buffer)));
+    this->width = width;
+    this->height = height;
+    resizeSwapChain(width, height);
+    current_back_buffer_index = queryCurrentBackBufferIndex();
+    registerBackBuffers();
+  }
 
-      device->CreateRenderTargetView(back_buffer.Get(), nullptr, rtv_handle);
+  void DeviceResources::flush()
+  {
+    PROFILE_SCOPE("DeviceResources::flush");
+    uint64 fence_value_for_signal = signal();
+    waitForFenceValue(fence_value_for_signal);
+    fence_timeline.updateCompleted(fence_value_for_signal);
+  }
 
-      back_buffers[i] = back_buffer;
+  void DeviceResources::setFramePacing(FramePacingMode mode, uint32 max_frame_latency)
+  {
+    assert((!is_initialized || mode != FramePacingMode::WaitableObject || frame_pacing == FramePacingMode::WaitableObject) && "Waitable object pacing must be chosen before loadPipeline.");
+    assert(max_frame_latency > 0);
 
-      rtv_handle.Offset(rtv_descriptor_size);
+    bool latency_changed = max_frame_latency != this->max_frame_latency;
+    frame_pacing = mode;
+    this->max_frame_latency = max_frame_latency;
+    if (is_initialized && latency_changed)
+    {
+      updateMaximumFrameLatency();
     }
   }
 
-  ComPtr<ID3D12CommandAllocator> DeviceResources::createCommandAllocator(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+  void DeviceResources::setIdleWork(std::function<bool()> idle_work)
   {
-    ComPtr<ID3D12CommandAllocator> command_allocator;
-    ThrowIfFailed(device->CreateCommandAllocator(type, IID_PPV_ARGS(&command_allocator)));
+    this->idle_work = std::move(idle_work);
+  }
 
-    return command_allocator;
+  uint32 DeviceResources::getFramesInFlight()
+  {
+    fence_timeline.updateCompleted(getCompletedFenceValue(CommandListType::Direct));
+    return fence_timeline.getFramesInFlight();
   }
 
-  ComPtr<ID3D12GraphicsCommandList> DeviceResources::createCommandList(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandAllocator> command_allocator, D3D12_COMMAND_LIST_TYPE type)
+  uint64 DeviceResources::signal()
   {
-    ComPtr<ID3D12GraphicsCommandList> command_list;
-    ThrowIfFailed(device->CreateCommandList(0, type, command_allocator.Get(), nullptr, IID_PPV_ARGS(&command_list)));
+    uint64 fence_value_for_signal = fence_timeline.signal();
+    signalQueue(CommandListType::Direct, fence_value_for_signal);
 
-    ThrowIfFailed(command_list->Close());
+    return fence_value_for_signal;
+  }
 
-    return command_list;
+  bool DeviceResources::isFenceComplete(uint64 value)
+  {
+    if (fence_timeline.isComplete(value))
+    {
+      return true;
+    }
+
+    fence_timeline.updateCompleted(getCompletedFenceValue(CommandListType::Direct));
+    return fence_timeline.isComplete(value);
+  }
+
+  CommandList& DeviceResources::acquireQueueCommandList(CommandListType queue)
+  {
+    QueueContexts& frame_contexts = queue_contexts[frame_index * queue_count + getQueueIndex(queue)];
+    if (frame_contexts.used == frame_contexts.contexts.size())
+    {
+      frame_contexts.contexts.push_back(createCommandContext(queue));
+    }
+
+    CommandContext& context = *frame_contexts.contexts[frame_contexts.used++];
+    context.reset();
+    return context.getCommandList();
   }
 
-  ComPtr<ID3D12Fence> DeviceResources::createFence(ComPtr<ID3D12Device2> device)
+  CommandList& DeviceResources::captureCommandList(CommandList& command_list)
   {
-    ComPtr<ID3D12Fence> fence;
+    if (capture == nullptr)
+    {
+      return command_list;
+    }
+
+    // Lists may be acquired on several threads, captured frames are rare enough to lock.
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    capture_lists.push_back(std::make_unique<CaptureCommandList>(command_list.getType()));
+    capture_lists.back()->reset(command_list);
+    return *capture_lists.back();
+  }
 
-    ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+  void DeviceResources::submitCommandLists(CommandListType queue, CommandList** command_lists, uint32 count)
+  {
+    if (capture != nullptr)
+    {
+      // The pool hands back the lists it owns, the capture lists wrapping them hold the streams.
+      capture_streams.clear();
+      for (uint32 i = 0; i < count; ++i)
+      {
+        for (const std::unique_ptr<CaptureCommandList>& capture_list : capture_lists)
+        {
+          if (capture_list.get() == command_lists[i] || capture_list->getTarget() == command_lists[i])
+          {
+            capture_streams.push_back(capture_list->getStream());
+            command_lists[i] = capture_list->getTarget();
+            break;
+          }
+        }
+      }
+      assert(capture_streams.size() == count && "Every list of a captured frame has to be a capture list.");
+      capture->addSubmit(queue, capture_streams.data(), count);
+    }
 
-    return fence;
+    executeCommandLists(queue, command_lists, count);
   }
 
-  HANDLE DeviceResources::createEventHandle()
+  uint64 DeviceResources::signalNextValue(CommandListType queue)
   {
-    HANDLE fence_event;
+    uint64 value = queue == CommandListType::Direct ? fence_timeline.signal() : ++queue_fence_values[getQueueIndex(queue)];
+    signalQueue(queue, value);
+    if (capture != nullptr)
+    {
+      capture->addSignal(queue, value);
+    }
 
-    fence_event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
-    assert(fence_event && "Failed to create fence event.");
+    return value;
+  }
 
-    return fence_event;
+  void DeviceResources::registerBackBuffers()
+  {
+    // New swap chain buffers start out presentable.
+    for (uint32 i = 0; i < swap_chain_buffer_count; ++i)
+    {
+      resource_state_tracker.registerResource(getBackBuffer(i), ResourceState::Present);
+    }
   }
 
-  uint64 DeviceResources::signal(ComPtr<ID3D12CommandQueue> command_queue, ComPtr<ID3D12Fence> fence, uint64& fence_value)
+  void DeviceResources::waitForFrameLatency()
   {
-    uint64 fence_value_for_signal = ++fence_value;
-    ThrowIfFailed(command_queue->Signal(fence.Get(), fence_value_for_signal));
+    PROFILE_SCOPE("DeviceResources::waitForFrameLatency");
+    if (frame_pacing == FramePacingMode::WaitableObject)
+    {
+      while (!waitForFrameLatencyObject(0))
+      {
+        if (!runIdleWork())
+        {
+          Timer timer;
+          waitForFrameLatencyObject(infinite_timeout);
+          frame_pacing_stats.blocking_waits++;
+          frame_pacing_stats.blocked_time += timer.getElapsed();
+          break;
+        }
+      }
+    }
 
-    return fence_value_for_signal;
+    // The frame's allocator must have retired and no more than max_frame_latency frames may be queued.
+    uint64 required_value = std::max(frame_fence_values[frame_index], fence_timeline.getFrameLatencyValue(max_frame_latency));
+    while (!isFenceComplete(required_value))
+    {
+      if (!runIdleWork())
+      {
+        waitForFenceValueTimed(required_value);
+      }
+    }
   }
 
-  void DeviceResources::waitForFenceValue(ComPtr<ID3D12Fence> fence, uint64 fence_value, HANDLE fence_event, std::chrono::milliseconds duration)
+  void DeviceResources::waitForFenceValueTimed(uint64 value)
   {
-    if (fence->GetCompletedValue() < fence_value)
+    PROFILE_SCOPE("DeviceResources::waitForFenceValueTimed");
+    if (isFenceComplete(value))
     {
-      ThrowIfFailed(fence->SetEventOnCompletion(fence_value, fence_event));
-      ::WaitForSingleObject(fence_event, static_cast<DWORD>(duration.count()));
+      return;
     }
+
+    Timer timer;
+    waitForFenceValue(value);
+    fence_timeline.updateCompleted(value);
+
+    frame_pacing_stats.blocking_waits++;
+    frame_pacing_stats.blocked_time += timer.getElapsed();
   }
 
-  void DeviceResources::flush(ComPtr<ID3D12CommandQueue> command_queue, ComPtr<ID3D12Fence> fence, uint64& fence_value, HANDLE fence_event)
+  bool DeviceResources::runIdleWork()
   {
-    uint64 fenceValueForSignal = signal(command_queue, fence, fence_value);
-    waitForFenceValue(fence, fenceValueForSignal, fence_event);
+    if (!idle_work)
+    {
+      return false;
+    }
+
+    Timer timer;
+    if (!idle_work())
+    {
+      return false;
+    }
+
+    frame_pacing_stats.idle_work_items++;
+    frame_pacing_stats.idle_work_time += timer.getElapsed();
+    return true;
   }
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <frame_pipeline.h>
+#include <common/timer.h>
+#include <profiler/profiler.h>
+
+namespace engine
+{
+  FramePipeline::FramePipeline(uint32 frame_queue_size, Callbacks callbacks)
+    : callbacks(std::move(callbacks))
+    , queue(frame_queue_size)
+  {
+  }
+
+  FramePipeline::~FramePipeline()
+  {
+    stop();
+  }
+
+  void FramePipeline::run(const std::function<bool()>& pump_events)
+  {
+    start();
+
+    while (running.load(std::memory_order_relaxed) && pump_events())
+    {
+    }
+
+    stop();
+
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+
+  void FramePipeline::requestResize(uint32 width, uint32 height)
+  {
+    pending_resize.store((uint64(width) << 32) | height, std::memory_order_release);
+  }
+
+  void FramePipeline::start()
+  {
+    running = true;
+    simulation_thread = std::thread(&FramePipeline::simulationMain, this);
+    render_thread = std::thread(&FramePipeline::renderMain, this);
+  }
+
+  void FramePipeline::stop()
+  {
+    running = false;
+    queue.close();
+
+    if (simulation_thread.joinable())
+    {
+      simulation_thread.join();
+    }
+    if (render_thread.joinable())
+    {
+      render_thread.join();
+    }
+  }
+
+  void FramePipeline::simulationMain()
+  {
+    PROFILE_THREAD_NAME("simulation");
+
+    try
+    {
+      Timer timer;
+      uint64 frame_number = 0;
+
+      while (running.load(std::memory_order_relaxed))
+      {
+        FramePacket* packet = queue.beginWrite();
+        if (!packet)
+        {
+          break;
+        }
+
+        packet->frame_number = frame_number++;
+        packet->delta_seconds = timer.tick();
+        packet->simulation_time = timer.getElapsedSeconds();
+        callbacks.simulate(*packet);
+
+        queue.endWrite();
+        simulated_frames.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    catch (...)
+    {
+      fail();
+    }
+  }
+
+  void FramePipeline::renderMain()
+  {
+    PROFILE_THREAD_NAME("render");
+
+    try
+    {
+      while (running.load(std::memory_order_relaxed))
+      {
+        FramePacket* packet = queue.beginRead();
+        if (!packet)
+        {
+          break;
+        }
+
+        uint64 size = pending_resize.exchange(0, std::memory_order_acquire);
+        if (size != 0)
+        {
+          callbacks.resize(static_cast<uint32>(size >> 32), static_cast<uint32>(size));
+        }
+
+        callbacks.render(*packet);
+
+        queue.endRead();
+        rendered_frames.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    catch (...)
+    {
+      fail();
+    }
+  }
+
+  void FramePipeline::fail()
+  {
+    {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    }
+
+    running = false;
+    queue.close();
+
+    if (callbacks.wake_pump)
+    {
+      callbacks.wake_pump();
+    }
+  }
+}
\ No newline at end of file
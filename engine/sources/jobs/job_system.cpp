@@ -0,0 +1,311 @@
+#include <jobs/job_system.h>
+#include <common/log_checked.h>
+#include <profiler/profiler.h>
+
+#include <cassert>
+
+namespace engine
+{
+  namespace
+  {
+    // Spin rounds before an idle worker goes to sleep.
+    constexpr uint32 idle_spin_count = 64;
+
+    std::atomic<uint32> next_instance_id { 1 };
+
+    struct ThreadRegistration
+    {
+      uint32 instance_id { 0 };
+      uint32 slot_index { 0 };
+    };
+
+    thread_local ThreadRegistration thread_registration;
+
+    uint32 nextRandom(uint32& state)
+    {
+      // xorshift32
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+  }
+
+  JobSystem::~JobSystem()
+  {
+    shutdown();
+  }
+
+  void JobSystem::initialize(uint32 worker_count)
+  {
+    assert(!running && "Job system is already initialized.");
+
+    instance_id = next_instance_id.fetch_add(1);
+    slot_count = worker_count + max_external_threads;
+    slots.reset(new ThreadSlot[slot_count]);
+    for (uint32 i = 0; i < slot_count; ++i)
+    {
+      slots[i].random_state = 0x9e3779b9u * (i + 1);
+    }
+    registered_slots = worker_count;
+    running = true;
+
+    workers.reserve(worker_count);
+    for (uint32 i = 0; i < worker_count; ++i)
+    {
+      workers.emplace_back(&JobSystem::workerMain, this, i);
+    }
+
+    LOG_INFO("Job system started with %u workers.\n", worker_count);
+  }
+
+  void JobSystem::shutdown()
+  {
+    if (!running)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex);
+      running = false;
+      wake_epoch++;
+    }
+    wake_condition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+      worker.join();
+    }
+    workers.clear();
+
+    // Queued jobs still hold closures and counters somebody may wait on, the calling thread runs
+    // them. They can submit more, so this repeats until a pass finds every deque empty.
+    bool executed = true;
+    while (executed)
+    {
+      executed = false;
+      for (uint32 i = 0; i < slot_count; ++i)
+      {
+        Job* job = nullptr;
+        while (slots[i].deque.steal(job))
+        {
+          execute(job);
+          executed = true;
+        }
+      }
+    }
+
+    // Threads registered with this instance run their jobs inline from now on.
+    instance_id = 0;
+    slots.reset();
+    slot_count = 0;
+  }
+
+  uint32 JobSystem::getDefaultWorkerCount()
+  {
+    return std::max(1u, std::thread::hardware_concurrency()) - 1;
+  }
+
+  void JobSystem::wait(JobCounter& counter)
+  {
+    ThreadSlot* slot = getThreadSlot();
+    while (!counter.isDone())
+    {
+      if (Job* job = slot ? findJob(*slot) : nullptr)
+      {
+        execute(job);
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  bool JobSystem::runPendingJob()
+  {
+    if (!running.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+
+    ThreadSlot* slot = getThreadSlot();
+    Job* job = slot ? findJob(*slot) : nullptr;
+    if (!job)
+    {
+      return false;
+    }
+
+    execute(job);
+    return true;
+  }
+
+  bool JobSystem::isIdle() const
+  {
+    for (uint32 i = 0; i < slot_count; ++i)
+    {
+      for (uint32 job = 0; job < jobs_per_thread; ++job)
+      {
+        if (slots[i].jobs[job].in_use.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void JobSystem::waitForIdle()
+  {
+    while (!isIdle())
+    {
+      if (!runPendingJob())
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  JobSystem::ThreadSlot* JobSystem::getThreadSlot()
+  {
+    if (instance_id == 0)
+    {
+      return nullptr;
+    }
+
+    if (thread_registration.instance_id != instance_id)
+    {
+      uint32 slot_index = registered_slots.fetch_add(1);
+      if (slot_index >= slot_count)
+      {
+        LOG_ERROR("Job system: more than %u threads submit jobs, the jobs of this one run inline\n", max_external_threads);
+        slot_index = invalid_slot;
+      }
+
+      thread_registration.instance_id = instance_id;
+      thread_registration.slot_index = slot_index;
+    }
+
+    return thread_registration.slot_index != invalid_slot ? &slots[thread_registration.slot_index] : nullptr;
+  }
+
+  Job* JobSystem::allocateJob(ThreadSlot& slot)
+  {
+    Job* job = &slot.jobs[slot.next_job++ & (jobs_per_thread - 1)];
+
+    // The pool wrapped around onto a job that is still executing somewhere, help out until it is done.
+    while (job->in_use.load(std::memory_order_acquire))
+    {
+      if (Job* other = findJob(slot))
+      {
+        execute(other);
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    job->in_use.store(true, std::memory_order_relaxed);
+    return job;
+  }
+
+  void JobSystem::submit(ThreadSlot& slot, Job* job)
+  {
+    if (!slot.deque.push(job))
+    {
+      execute(job);
+      return;
+    }
+
+    // Pairs with the fence in workerMain: either the worker sees the job or we see the sleeper.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_workers.load(std::memory_order_relaxed) > 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake_epoch++;
+      }
+      wake_condition.notify_one();
+    }
+  }
+
+  Job* JobSystem::findJob(ThreadSlot& slot)
+  {
+    Job* job = nullptr;
+    if (slot.deque.pop(job))
+    {
+      return job;
+    }
+
+    const uint32 registered = std::min(registered_slots.load(std::memory_order_acquire), slot_count);
+    const uint32 first_victim = nextRandom(slot.random_state) % registered;
+    for (uint32 i = 0; i < registered; ++i)
+    {
+      ThreadSlot& victim = slots[(first_victim + i) % registered];
+      if (&victim != &slot && victim.deque.steal(job))
+      {
+        return job;
+      }
+    }
+
+    return nullptr;
+  }
+
+  void JobSystem::execute(Job* job)
+  {
+    JobCounter* counter = job->counter;
+    job->entry(job->payload);
+    job->in_use.store(false, std::memory_order_release);
+
+    if (counter)
+    {
+      counter->value.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+
+  void JobSystem::workerMain(uint32 slot_index)
+  {
+    PROFILE_THREAD_NAME("job worker");
+    thread_registration.instance_id = instance_id;
+    thread_registration.slot_index = slot_index;
+    ThreadSlot& slot = slots[slot_index];
+
+    uint32 idle_rounds = 0;
+    while (running.load(std::memory_order_relaxed))
+    {
+      if (Job* job = findJob(slot))
+      {
+        execute(job);
+        idle_rounds = 0;
+        continue;
+      }
+
+      if (++idle_rounds < idle_spin_count)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      uint64 epoch = wake_epoch;
+      sleeping_workers.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      // Re-check after announcing ourselves, a job may have been pushed in between.
+      if (Job* job = findJob(slot))
+      {
+        sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+        execute(job);
+        idle_rounds = 0;
+        continue;
+      }
+
+      wake_condition.wait(lock, [&]() { return wake_epoch != epoch || !running.load(std::memory_order_relaxed); });
+      sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+      idle_rounds = 0;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <memory/frame_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  namespace
+  {
+    // Zero is never used, it marks thread pages that were never filled.
+    std::atomic<uint64> next_frame_tag { 1 };
+
+    uint8* newBlock(size_t size)
+    {
+      return static_cast<uint8*>(::operator new(size, std::align_val_t(LinearAllocator::block_alignment)));
+    }
+
+    void deleteBlock(uint8* block)
+    {
+      ::operator delete(block, std::align_val_t(LinearAllocator::block_alignment));
+    }
+  }
+
+  FrameAllocator::FrameAllocator(size_t capacity)
+    : initial_capacity(alignUp(std::max(capacity, page_size), page_size))
+    , frame_tag(next_frame_tag.fetch_add(1, std::memory_order_relaxed))
+  {
+  }
+
+  FrameAllocator::~FrameAllocator()
+  {
+    releaseArenas();
+  }
+
+  void FrameAllocator::setFrameCount(uint32 frame_count)
+  {
+    assert(frame_count > 0);
+
+    // Keeps what the previous frames needed.
+    size_t capacity = initial_capacity;
+    for (uint32 i = 0; i < this->frame_count; ++i)
+    {
+      capacity = std::max(capacity, arenas[i].capacity);
+    }
+    releaseArenas();
+
+    arenas.reset(new Arena[frame_count]);
+    for (uint32 i = 0; i < frame_count; ++i)
+    {
+      arenas[i].block = newBlock(capacity);
+      arenas[i].capacity = capacity;
+    }
+    this->frame_count = frame_count;
+  }
+
+  void FrameAllocator::beginFrame(uint32 frame_index)
+  {
+    assert(frame_index < frame_count);
+
+    current_arena = &arenas[frame_index];
+    resetArena(*current_arena);
+    frame_tag = next_frame_tag.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t FrameAllocator::getUsed() const
+  {
+    return current_arena ? current_arena->offset.load(std::memory_order_relaxed) : 0;
+  }
+
+  size_t FrameAllocator::getPeak() const
+  {
+    size_t peak = 0;
+    for (uint32 i = 0; i < frame_count; ++i)
+    {
+      peak = std::max(peak, std::max(arenas[i].peak, arenas[i].offset.load(std::memory_order_relaxed)));
+    }
+    return peak;
+  }
+
+  void* FrameAllocator::allocateSlow(size_t size, size_t alignment)
+  {
+    assert(current_arena && "FrameAllocator::beginFrame was not called.");
+
+    // Large allocations would waste most of a page, they go to the arena directly.
+    size_t padding = alignment > LinearAllocator::block_alignment ? alignment : 0;
+    if (size + padding > page_size / 4)
+    {
+      uint8* block = allocateFromArena(alignUp(size + padding, LinearAllocator::block_alignment));
+      return reinterpret_cast<uint8*>(alignUp(reinterpret_cast<uintptr_t>(block), alignment));
+    }
+
+    ThreadPage& page = thread_page;
+    page.tag = frame_tag;
+    page.cursor = allocateFromArena(page_size);
+    page.end = page.cursor + page_size;
+
+    uint8* result = reinterpret_cast<uint8*>(alignUp(reinterpret_cast<uintptr_t>(page.cursor), alignment));
+    page.cursor = result + size;
+    return result;
+  }
+
+  uint8* FrameAllocator::allocateFromArena(size_t size)
+  {
+    Arena& arena = *current_arena;
+
+    // The offset keeps counting past the capacity, that is how the next reset learns the peak.
+    size_t offset = arena.offset.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size <= arena.capacity)
+    {
+      return arena.block + offset;
+    }
+
+    uint8* block = newBlock(size);
+    std::lock_guard<std::mutex> lock(arena.overflow_mutex);
+    arena.overflow_blocks.push_back(block);
+    return block;
+  }
+
+  void FrameAllocator::resetArena(Arena& arena)
+  {
+    size_t used = arena.offset.load(std::memory_order_relaxed);
+    arena.peak = std::max(arena.peak, used);
+    arena.offset.store(0, std::memory_order_relaxed);
+
+    if (!arena.overflow_blocks.empty())
+    {
+      for (uint8* block : arena.overflow_blocks)
+      {
+        deleteBlock(block);
+      }
+      arena.overflow_blocks.clear();
+      deleteBlock(arena.block);
+
+      arena.capacity = alignUp(arena.peak + arena.peak / 8, page_size);
+      arena.block = newBlock(arena.capacity);
+    }
+  }
+
+  void FrameAllocator::releaseArenas()
+  {
+    for (uint32 i = 0; i < frame_count; ++i)
+    {
+      for (uint8* block : arenas[i].overflow_blocks)
+      {
+        deleteBlock(block);
+      }
+      deleteBlock(arenas[i].block);
+    }
+    arenas.reset();
+    frame_count = 0;
+    current_arena = nullptr;
+    frame_tag = next_frame_tag.fetch_add(1, std::memory_order_relaxed);
+  }
+}
\ No newline at end of file
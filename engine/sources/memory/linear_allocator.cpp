@@ -0,0 +1,77 @@
+#include <memory/linear_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  namespace
+  {
+    uint8* newBlock(size_t size)
+    {
+      return static_cast<uint8*>(::operator new(size, std::align_val_t(LinearAllocator::block_alignment)));
+    }
+
+    void deleteBlock(uint8* block)
+    {
+      ::operator delete(block, std::align_val_t(LinearAllocator::block_alignment));
+    }
+  }
+
+  LinearAllocator::LinearAllocator(size_t capacity)
+    : block(capacity > 0 ? newBlock(alignUp(capacity, block_alignment)) : nullptr)
+    , capacity(capacity > 0 ? alignUp(capacity, block_alignment) : 0)
+  {
+  }
+
+  LinearAllocator::~LinearAllocator()
+  {
+    for (uint8* retired_block : retired_blocks)
+    {
+      deleteBlock(retired_block);
+    }
+    if (block)
+    {
+      deleteBlock(block);
+    }
+  }
+
+  void LinearAllocator::reset()
+  {
+    peak = std::max(peak, getUsed());
+
+    if (!retired_blocks.empty())
+    {
+      for (uint8* retired_block : retired_blocks)
+      {
+        deleteBlock(retired_block);
+      }
+      retired_blocks.clear();
+      deleteBlock(block);
+
+      // Some headroom for the padding at the end of the chained blocks.
+      capacity = alignUp(peak + peak / 8, block_alignment);
+      block = newBlock(capacity);
+    }
+
+    used = 0;
+    retired_used = 0;
+  }
+
+  void* LinearAllocator::allocateBlock(size_t size, [[maybe_unused]] size_t alignment)
+  {
+    assert(alignment <= block_alignment && (alignment & (alignment - 1)) == 0);
+
+    if (block)
+    {
+      retired_blocks.push_back(block);
+      retired_used += used;
+    }
+
+    capacity = std::max(alignUp(size, block_alignment), std::max(capacity * 2, min_block_size));
+    block = newBlock(capacity);
+    used = size;
+
+    return block;
+  }
+}
\ No newline at end of file
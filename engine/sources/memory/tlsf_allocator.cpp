@@ -0,0 +1,363 @@
+#include <memory/tlsf_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  TlsfAllocator::TlsfAllocator(uint64 capacity, uint64 granularity)
+  {
+    reset(capacity, granularity);
+  }
+
+  void TlsfAllocator::reset(uint64 capacity, uint64 granularity)
+  {
+    assert(isPowerOfTwo(granularity) && capacity >= granularity);
+
+    this->granularity = granularity;
+    granularity_bits = findMostSignificantBit(granularity);
+    this->capacity = alignDown(capacity, granularity);
+    used = 0;
+    allocation_count = 0;
+
+    first_level_bitmap = 0;
+    std::fill(std::begin(second_level_bitmaps), std::end(second_level_bitmaps), 0u);
+    for (auto& free_list : free_lists)
+    {
+      std::fill(std::begin(free_list), std::end(free_list), invalid_block);
+    }
+
+    blocks.clear();
+    unused_blocks.clear();
+    insertFreeBlock(createBlock(0, this->capacity));
+  }
+
+  TlsfAllocator::Allocation TlsfAllocator::allocate(uint64 size, uint64 alignment)
+  {
+    assert(isPowerOfTwo(alignment));
+
+    size = alignUp(std::max(size, uint64(1)), granularity);
+    alignment = std::max(alignment, granularity);
+    // Offsets are multiples of the granularity, so aligning wastes at most this much.
+    uint64 search_size = size + alignment - granularity;
+    if (search_size > capacity)
+    {
+      return Allocation {};
+    }
+
+    uint32 block = findFreeBlock(search_size);
+    if (block == invalid_block)
+    {
+      return Allocation {};
+    }
+    removeFreeBlock(block);
+
+    uint64 padding = alignUp(blocks[block].offset, alignment) - blocks[block].offset;
+    if (padding > 0)
+    {
+      // The front can't merge, the block before a free block is always used.
+      uint32 rest = splitBlock(block, padding);
+      insertFreeBlock(block);
+      block = rest;
+    }
+
+    if (blocks[block].size > size)
+    {
+      insertFreeBlock(splitBlock(block, size));
+    }
+
+    blocks[block].is_free = false;
+    used += size;
+    allocation_count++;
+
+    return Allocation { blocks[block].offset, block };
+  }
+
+  void TlsfAllocator::free(uint32 block)
+  {
+    assert(block < blocks.size() && !blocks[block].is_free);
+
+    used -= blocks[block].size;
+    allocation_count--;
+    blocks[block].is_free = true;
+
+    uint32 next = blocks[block].next_physical;
+    if (next != invalid_block && blocks[next].is_free)
+    {
+      removeFreeBlock(next);
+      mergeBlocks(block, next);
+    }
+
+    uint32 previous = blocks[block].previous_physical;
+    if (previous != invalid_block && blocks[previous].is_free)
+    {
+      removeFreeBlock(previous);
+      mergeBlocks(previous, block);
+      block = previous;
+    }
+
+    insertFreeBlock(block);
+  }
+
+  uint64 TlsfAllocator::getLargestFreeBlock() const
+  {
+    if (first_level_bitmap == 0)
+    {
+      return 0;
+    }
+
+    uint32 first_level = findMostSignificantBit(first_level_bitmap);
+    uint32 second_level = findMostSignificantBit(second_level_bitmaps[first_level]);
+    uint64 largest = 0;
+    for (uint32 block = free_lists[first_level][second_level]; block != invalid_block; block = blocks[block].next_free)
+    {
+      largest = std::max(largest, blocks[block].size);
+    }
+    return largest;
+  }
+
+  uint32 TlsfAllocator::getFreeBlockCount() const
+  {
+    uint32 count = 0;
+    for (const Block& block : blocks)
+    {
+      count += block.is_free && block.size > 0;
+    }
+    return count;
+  }
+
+  bool TlsfAllocator::validate() const
+  {
+    // Physical blocks tile the range, free blocks never touch and every free block is listed
+    // in the class its size maps to.
+    uint64 offset = 0;
+    uint64 used_size = 0;
+    uint32 used_count = 0;
+    uint32 free_count = 0;
+    uint32 previous = invalid_block;
+    uint32 block = 0;
+    while (block != invalid_block)
+    {
+      const Block& current = blocks[block];
+      if (current.offset != offset || current.previous_physical != previous || current.size == 0 || current.size % granularity != 0)
+      {
+        return false;
+      }
+      if (current.is_free)
+      {
+        if (previous != invalid_block && blocks[previous].is_free)
+        {
+          return false;
+        }
+
+        uint32 first_level, second_level;
+        mapping(current.size, first_level, second_level);
+        bool listed = false;
+        for (uint32 free_block = free_lists[first_level][second_level]; free_block != invalid_block && !listed; free_block = blocks[free_block].next_free)
+        {
+          listed = free_block == block;
+        }
+        if (!listed)
+        {
+          return false;
+        }
+        free_count++;
+      }
+      else
+      {
+        used_size += current.size;
+        used_count++;
+      }
+
+      offset += current.size;
+      previous = block;
+      block = current.next_physical;
+    }
+
+    uint32 listed_count = 0;
+    for (uint32 first_level = 0; first_level < first_level_count; ++first_level)
+    {
+      if (((first_level_bitmap >> first_level) & 1) != (second_level_bitmaps[first_level] != 0))
+      {
+        return false;
+      }
+      for (uint32 second_level = 0; second_level < second_level_count; ++second_level)
+      {
+        bool has_blocks = free_lists[first_level][second_level] != invalid_block;
+        if (((second_level_bitmaps[first_level] >> second_level) & 1) != uint32(has_blocks))
+        {
+          return false;
+        }
+        for (uint32 free_block = free_lists[first_level][second_level]; free_block != invalid_block; free_block = blocks[free_block].next_free)
+        {
+          listed_count++;
+        }
+      }
+    }
+
+    return offset == capacity && used_size == used && used_count == allocation_count && listed_count == free_count;
+  }
+
+  void TlsfAllocator::mapping(uint64 size, uint32& first_level, uint32& second_level) const
+  {
+    // Sizes below second_level_count granules get a class each.
+    uint64 units = size >> granularity_bits;
+    if (units < second_level_count)
+    {
+      first_level = 0;
+      second_level = static_cast<uint32>(units);
+      return;
+    }
+
+    uint32 most_significant_bit = findMostSignificantBit(units);
+    first_level = most_significant_bit - second_level_bits + 1;
+    second_level = static_cast<uint32>(units >> (most_significant_bit - second_level_bits)) ^ second_level_count;
+  }
+
+  uint32 TlsfAllocator::findFreeBlock(uint64 size) const
+  {
+    // The class of the size itself may start with a block that fits, like a hole an equally large
+    // allocation left. Checking its head keeps such holes in use at the cost of one compare.
+    uint32 first_level, second_level;
+    mapping(size, first_level, second_level);
+    if (first_level < first_level_count)
+    {
+      uint32 head = free_lists[first_level][second_level];
+      if (head != invalid_block && blocks[head].size >= size)
+      {
+        return head;
+      }
+    }
+
+    // Rounds up to the next class, every block in it or above is large enough.
+    uint64 units = size >> granularity_bits;
+    if (units >= second_level_count)
+    {
+      units += (uint64(1) << (findMostSignificantBit(units) - second_level_bits)) - 1;
+    }
+
+    mapping(units << granularity_bits, first_level, second_level);
+    if (first_level >= first_level_count)
+    {
+      return invalid_block;
+    }
+
+    uint32 second_level_map = second_level_bitmaps[first_level] & (~0u << second_level);
+    if (second_level_map == 0)
+    {
+      uint64 first_level_map = first_level + 1 < first_level_count ? first_level_bitmap & (~uint64(0) << (first_level + 1)) : 0;
+      if (first_level_map == 0)
+      {
+        return invalid_block;
+      }
+
+      first_level = findLeastSignificantBit(first_level_map);
+      second_level_map = second_level_bitmaps[first_level];
+    }
+
+    return free_lists[first_level][findLeastSignificantBit(second_level_map)];
+  }
+
+  void TlsfAllocator::insertFreeBlock(uint32 block)
+  {
+    uint32 first_level, second_level;
+    mapping(blocks[block].size, first_level, second_level);
+
+    uint32 head = free_lists[first_level][second_level];
+    blocks[block].is_free = true;
+    blocks[block].previous_free = invalid_block;
+    blocks[block].next_free = head;
+    if (head != invalid_block)
+    {
+      blocks[head].previous_free = block;
+    }
+
+    free_lists[first_level][second_level] = block;
+    first_level_bitmap |= uint64(1) << first_level;
+    second_level_bitmaps[first_level] |= 1u << second_level;
+  }
+
+  void TlsfAllocator::removeFreeBlock(uint32 block)
+  {
+    Block& removed = blocks[block];
+    if (removed.previous_free != invalid_block)
+    {
+      blocks[removed.previous_free].next_free = removed.next_free;
+    }
+    if (removed.next_free != invalid_block)
+    {
+      blocks[removed.next_free].previous_free = removed.previous_free;
+    }
+
+    uint32 first_level, second_level;
+    mapping(removed.size, first_level, second_level);
+    if (free_lists[first_level][second_level] == block)
+    {
+      free_lists[first_level][second_level] = removed.next_free;
+      if (removed.next_free == invalid_block)
+      {
+        second_level_bitmaps[first_level] &= ~(1u << second_level);
+        if (second_level_bitmaps[first_level] == 0)
+        {
+          first_level_bitmap &= ~(uint64(1) << first_level);
+        }
+      }
+    }
+  }
+
+  uint32 TlsfAllocator::createBlock(uint64 offset, uint64 size)
+  {
+    Block block { offset, size, invalid_block, invalid_block, invalid_block, invalid_block, true };
+    if (!unused_blocks.empty())
+    {
+      uint32 index = unused_blocks.back();
+      unused_blocks.pop_back();
+      blocks[index] = block;
+      return index;
+    }
+
+    blocks.push_back(block);
+    return static_cast<uint32>(blocks.size() - 1);
+  }
+
+  void TlsfAllocator::releaseBlock(uint32 block)
+  {
+    // Kept out of the statistics and validation walks by its zero size.
+    blocks[block].size = 0;
+    blocks[block].is_free = true;
+    unused_blocks.push_back(block);
+  }
+
+  uint32 TlsfAllocator::splitBlock(uint32 block, uint64 size)
+  {
+    uint32 rest = createBlock(blocks[block].offset + size, blocks[block].size - size);
+    Block& first = blocks[block];
+    Block& second = blocks[rest];
+
+    second.previous_physical = block;
+    second.next_physical = first.next_physical;
+    if (first.next_physical != invalid_block)
+    {
+      blocks[first.next_physical].previous_physical = rest;
+    }
+    first.next_physical = rest;
+    first.size = size;
+
+    return rest;
+  }
+
+  void TlsfAllocator::mergeBlocks(uint32 block, uint32 next)
+  {
+    Block& first = blocks[block];
+    const Block& second = blocks[next];
+
+    first.size += second.size;
+    first.next_physical = second.next_physical;
+    if (second.next_physical != invalid_block)
+    {
+      blocks[second.next_physical].previous_physical = block;
+    }
+
+    releaseBlock(next);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include <profiler/frame_statistics.h>
+#include <common/log_checked.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace engine
+{
+  namespace
+  {
+    // Frames before hitch detection starts and how often the median it compares against is refreshed.
+    const uint32 hitch_warmup_frames = 32;
+    const uint32 median_refresh_frames = 32;
+  }
+
+  void FrameStatistics::addFrame(double seconds)
+  {
+    float milliseconds = static_cast<float>(seconds * 1e3);
+
+    if (frame_times.full())
+    {
+      float evicted = frame_times.front();
+      histogram[getBucket(evicted)]--;
+      sum -= evicted;
+    }
+
+    frame_times.push(milliseconds);
+    histogram[getBucket(milliseconds)]++;
+    sum += milliseconds;
+    minimums.push(frame_count, milliseconds);
+    maximums.push(frame_count, milliseconds);
+    frame_count++;
+
+    last_frame_hitch = frame_count > hitch_warmup_frames && milliseconds > hitch_factor * median;
+    if (last_frame_hitch)
+    {
+      hitch_count++;
+    }
+
+    if (frame_count % median_refresh_frames == 0 || frame_count == hitch_warmup_frames)
+    {
+      median = getPercentile(0.5);
+    }
+
+    if (report_interval > 0.0)
+    {
+      time_since_report += seconds;
+      if (time_since_report >= report_interval)
+      {
+        logSummary();
+        time_since_report = 0.0;
+      }
+    }
+  }
+
+  void FrameStatistics::reset()
+  {
+    frame_times.clear();
+    minimums.clear();
+    maximums.clear();
+    std::fill(std::begin(histogram), std::end(histogram), 0);
+    sum = 0.0;
+    frame_count = 0;
+    hitch_count = 0;
+    last_frame_hitch = false;
+    median = 0.0;
+    time_since_report = 0.0;
+  }
+
+  double FrameStatistics::getPercentile(double fraction) const
+  {
+    if (frame_times.empty())
+    {
+      return 0.0;
+    }
+
+    uint32 rank = std::max(1u, static_cast<uint32>(std::ceil(fraction * frame_times.size())));
+    uint32 seen = 0;
+    for (uint32 bucket = 0; bucket < bucket_count; ++bucket)
+    {
+      seen += histogram[bucket];
+      if (seen >= rank)
+      {
+        return std::clamp(getBucketValue(bucket), getMin(), getMax());
+      }
+    }
+
+    return getMax();
+  }
+
+  FrameTimeSummary FrameStatistics::getSummary() const
+  {
+    FrameTimeSummary summary;
+    summary.frames = frame_times.size();
+    summary.min = getMin();
+    summary.average = getAverage();
+    summary.p50 = getPercentile(0.50);
+    summary.p95 = getPercentile(0.95);
+    summary.p99 = getPercentile(0.99);
+    summary.max = getMax();
+    summary.average_fps = summary.average > 0.0 ? 1e3 / summary.average : 0.0;
+    summary.one_percent_low_fps = summary.p99 > 0.0 ? 1e3 / summary.p99 : 0.0;
+    summary.hitches = hitch_count;
+
+    return summary;
+  }
+
+  void FrameStatistics::logSummary() const
+  {
+    FrameTimeSummary summary = getSummary();
+    LOG_INFO("Frame time ms: min %.2f avg %.2f p50 %.2f p95 %.2f p99 %.2f max %.2f | FPS %.1f, 1%% low %.1f | hitches %llu\n",
+      summary.min, summary.average, summary.p50, summary.p95, summary.p99, summary.max,
+      summary.average_fps, summary.one_percent_low_fps, summary.hitches);
+  }
+
+  uint32 FrameStatistics::getBucket(float milliseconds)
+  {
+    if (!(milliseconds > min_bucket_milliseconds))
+    {
+      return 0;
+    }
+
+    uint32 bucket = static_cast<uint32>(std::log2(milliseconds / min_bucket_milliseconds) * buckets_per_octave);
+    return std::min(bucket, bucket_count - 1);
+  }
+
+  double FrameStatistics::getBucketValue(uint32 bucket)
+  {
+    return min_bucket_milliseconds * std::exp2((bucket + 0.5) / buckets_per_octave);
+  }
+}
\ No newline at end of file
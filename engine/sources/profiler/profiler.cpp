@@ -0,0 +1,280 @@
+#include <profiler/profiler.h>
+#include <common/log_checked.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine
+{
+  namespace
+  {
+    struct ThreadProfile
+    {
+      // Threads that used the ring before the current one, events below end_index are theirs.
+      struct Retired
+      {
+        uint32 thread_id;
+        std::string name;
+        uint64 end_index;
+      };
+
+      uint32 thread_id { 0 };
+      std::string name;
+      bool in_use { true };
+      std::vector<Retired> retired;
+      std::atomic<uint64> write_index { 0 };
+      Profiler::Event events[Profiler::events_per_thread];
+    };
+
+    struct Registry
+    {
+      std::mutex mutex;
+      std::vector<std::unique_ptr<ThreadProfile>> threads;
+      uint32 next_thread_id { 0 };
+      uint64 base_ticks { Profiler::now() };
+      uint64 base_nanoseconds { Timer::nowNanoseconds() };
+    };
+
+    Registry& getRegistry()
+    {
+      static Registry registry;
+      return registry;
+    }
+
+    // Drops earlier owners whose events were all overwritten.
+    void pruneRetired(ThreadProfile& profile)
+    {
+      uint64 write_index = profile.write_index.load(std::memory_order_relaxed);
+      uint64 first_index = write_index > Profiler::events_per_thread ? write_index - Profiler::events_per_thread : 0;
+      auto first_kept = std::find_if(profile.retired.begin(), profile.retired.end(), [&](const ThreadProfile::Retired& retired) { return retired.end_index > first_index; });
+      profile.retired.erase(profile.retired.begin(), first_kept);
+    }
+
+    // Hands the ring of an exiting thread to the next new one, its recorded events stay for export.
+    struct ThreadRegistration
+    {
+      ThreadProfile* profile { nullptr };
+      bool rejected { false };
+
+      ~ThreadRegistration()
+      {
+        if (profile)
+        {
+          std::lock_guard<std::mutex> lock(getRegistry().mutex);
+          profile->retired.push_back({ profile->thread_id, std::move(profile->name), profile->write_index.load(std::memory_order_relaxed) });
+          profile->in_use = false;
+          pruneRetired(*profile);
+        }
+      }
+    };
+
+    // Read on every record, kept apart from the registration so it stays a plain thread_local.
+    thread_local ThreadProfile* thread_profile = nullptr;
+    thread_local ThreadRegistration thread_registration;
+
+    ThreadProfile* registerThread()
+    {
+      if (thread_registration.rejected)
+      {
+        return nullptr;
+      }
+
+      Registry& registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      auto free_profile = std::find_if(registry.threads.begin(), registry.threads.end(), [](const auto& profile) { return !profile->in_use; });
+      ThreadProfile* profile = nullptr;
+      if (free_profile != registry.threads.end())
+      {
+        profile = free_profile->get();
+        profile->in_use = true;
+      }
+      else if (registry.threads.size() < Profiler::max_threads)
+      {
+        registry.threads.push_back(std::make_unique<ThreadProfile>());
+        profile = registry.threads.back().get();
+      }
+      else
+      {
+        thread_registration.rejected = true;
+        LOG_WARNING("Profiler: more than %u threads, scopes of the new thread are dropped.\n", uint32(Profiler::max_threads));
+        return nullptr;
+      }
+
+      profile->thread_id = registry.next_thread_id++;
+      profile->name = "thread " + std::to_string(profile->thread_id);
+      thread_profile = profile;
+      thread_registration.profile = profile;
+
+      return profile;
+    }
+
+    // Nanoseconds per tick, measured over the lifetime of the registry.
+    double calibrate(Registry& registry)
+    {
+#if defined(ENGINE_PROFILER_TSC)
+      uint64 ticks = Profiler::now();
+      uint64 nanoseconds = Timer::nowNanoseconds();
+      while (nanoseconds - registry.base_nanoseconds < 10000000)
+      {
+        ticks = Profiler::now();
+        nanoseconds = Timer::nowNanoseconds();
+      }
+
+      return double(nanoseconds - registry.base_nanoseconds) / double(ticks - registry.base_ticks);
+#else
+      return 1.0;
+#endif
+    }
+
+    void writeEscaped(FILE* file, const char* text)
+    {
+      for (; *text; ++text)
+      {
+        if (*text == '"' || *text == '\\')
+        {
+          fputc('\\', file);
+        }
+        fputc(*text, file);
+      }
+    }
+  }
+
+  void Profiler::record(const char* name, uint64 begin, uint64 end)
+  {
+    ThreadProfile* profile = thread_profile;
+    if (!profile)
+    {
+      profile = registerThread();
+      if (!profile)
+      {
+        return;
+      }
+    }
+
+    uint64 index = profile->write_index.load(std::memory_order_relaxed);
+    profile->events[index & (events_per_thread - 1)] = Event { name, begin, end };
+    profile->write_index.store(index + 1, std::memory_order_release);
+  }
+
+  void Profiler::setThreadName(const char* name)
+  {
+    ThreadProfile* profile = thread_profile ? thread_profile : registerThread();
+    if (profile)
+    {
+      std::lock_guard<std::mutex> lock(getRegistry().mutex);
+      profile->name = name;
+    }
+  }
+
+  bool Profiler::exportChromeTrace(const std::string& path)
+  {
+    Registry& registry = getRegistry();
+    double nanoseconds_per_tick = calibrate(registry);
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+      LOG_ERROR("Profiler: can't open %s for writing.\n", path);
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<Event> events;
+    bool first = true;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    auto write_thread_name = [&](uint32 thread_id, const std::string& name)
+    {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", thread_id);
+      writeEscaped(file, name.c_str());
+      fprintf(file, "\"}}");
+      first = false;
+    };
+
+    for (const auto& profile : registry.threads)
+    {
+      // The owner keeps recording, drop whatever it overwrote while the ring was copied.
+      uint64 write_index = profile->write_index.load(std::memory_order_acquire);
+      uint64 first_index = write_index > events_per_thread ? write_index - events_per_thread : 0;
+      events.clear();
+      for (uint64 index = first_index; index < write_index; ++index)
+      {
+        events.push_back(profile->events[index & (events_per_thread - 1)]);
+      }
+
+      uint64 latest_index = profile->write_index.load(std::memory_order_acquire);
+      uint64 valid_index = latest_index > events_per_thread ? latest_index - events_per_thread : 0;
+      size_t skip = static_cast<size_t>(std::min<uint64>(valid_index > first_index ? valid_index - first_index : 0, events.size()));
+
+      // Threads that exited earlier keep their events under their own id.
+      const auto& retired = profile->retired;
+      size_t owner = 0;
+      while (owner < retired.size() && retired[owner].end_index <= first_index + skip)
+      {
+        owner++;
+      }
+      for (size_t i = owner; i < retired.size(); ++i)
+      {
+        write_thread_name(retired[i].thread_id, retired[i].name);
+      }
+      if (profile->in_use)
+      {
+        write_thread_name(profile->thread_id, profile->name);
+      }
+
+      for (size_t i = skip; i < events.size(); ++i)
+      {
+        while (owner < retired.size() && retired[owner].end_index <= first_index + i)
+        {
+          owner++;
+        }
+        uint32 thread_id = owner < retired.size() ? retired[owner].thread_id : profile->thread_id;
+
+        const Event& event = events[i];
+        double begin = event.begin >= registry.base_ticks ? (event.begin - registry.base_ticks) * nanoseconds_per_tick : 0.0;
+        double duration = (event.end - event.begin) * nanoseconds_per_tick;
+
+        fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+        writeEscaped(file, event.name);
+        fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread_id, begin * 1e-3, duration * 1e-3);
+        first = false;
+      }
+    }
+    fprintf(file, "\n]}\n");
+
+    bool succeeded = ferror(file) == 0;
+    fclose(file);
+
+    return succeeded;
+  }
+
+  uint64 Profiler::getEventCount()
+  {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    uint64 count = 0;
+    for (const auto& profile : registry.threads)
+    {
+      count += std::min<uint64>(profile->write_index.load(std::memory_order_acquire), events_per_thread);
+    }
+
+    return count;
+  }
+
+  void Profiler::clear()
+  {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& profile : registry.threads)
+    {
+      profile->write_index.store(0, std::memory_order_release);
+      profile->retired.clear();
+    }
+  }
+}
\ No newline at end of file
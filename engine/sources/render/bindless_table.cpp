@@ -0,0 +1,67 @@
+#include <render/bindless_table.h>
+
+#include <cassert>
+
+namespace engine
+{
+  bool BindlessTable::initialize(ShaderVisibleDescriptorHeap& heap, uint32 capacity)
+  {
+    this->heap = &heap;
+    range = heap.allocatePersistent(capacity);
+    free_slots.clear();
+    pending_removals.clear();
+    if (!range.isValid())
+    {
+      return false;
+    }
+
+    free_slots.reserve(capacity);
+    for (uint32 slot = capacity; slot-- > 0;)
+    {
+      free_slots.push_back(slot);
+    }
+    return true;
+  }
+
+  BindlessIndex BindlessTable::add(CpuDescriptorHandle source)
+  {
+    if (free_slots.empty())
+    {
+      return invalid_id;
+    }
+
+    uint32 slot = free_slots.back();
+    free_slots.pop_back();
+    heap->copy(range, slot, &source, 1);
+    return range.index + slot;
+  }
+
+  void BindlessTable::update(BindlessIndex index, CpuDescriptorHandle source)
+  {
+    assert(index - range.index < range.count);
+    heap->copy(range, index - range.index, &source, 1);
+  }
+
+  void BindlessTable::remove(BindlessIndex index)
+  {
+    assert(index - range.index < range.count);
+    pending_removals.push_back({ untagged_fence_value, index - range.index });
+  }
+
+  void BindlessTable::endFrame(uint64 fence_value)
+  {
+    for (auto removal = pending_removals.rbegin(); removal != pending_removals.rend() && removal->fence_value == untagged_fence_value; ++removal)
+    {
+      removal->fence_value = fence_value;
+    }
+  }
+
+  void BindlessTable::retire(uint64 completed_fence_value)
+  {
+    while (!pending_removals.empty() && pending_removals.front().fence_value <= completed_fence_value)
+    {
+      free_slots.push_back(pending_removals.front().slot);
+      pending_removals.pop_front();
+    }
+  }
+}
\ No newline at end of file
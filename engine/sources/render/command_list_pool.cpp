@@ -0,0 +1,198 @@
+#include <render/command_list_pool.h>
+#include <common/log_checked.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  // Slots of a pool that threads gave back. Outlives the pool while threads still hold slots in it.
+  class CommandListThreadRegistry
+  {
+  public:
+    std::mutex mutex;
+    std::vector<uint32> free_slots;
+    uint32 slot_count { 0 };
+  };
+
+  namespace
+  {
+    std::atomic<uint32> next_instance_id { 1 };
+
+    struct ThreadRegistration
+    {
+      uint32 instance_id { 0 };
+      uint32 thread_index { 0 };
+    };
+
+    struct HeldSlot
+    {
+      std::weak_ptr<CommandListThreadRegistry> registry;
+      uint32 thread_index;
+    };
+
+    // Slots the thread holds in every pool it recorded with, given back when the thread exits.
+    struct ThreadSlots
+    {
+      std::vector<HeldSlot> slots;
+
+      ~ThreadSlots()
+      {
+        for (const HeldSlot& slot : slots)
+        {
+          if (std::shared_ptr<CommandListThreadRegistry> registry = slot.registry.lock())
+          {
+            std::lock_guard<std::mutex> lock(registry->mutex);
+            registry->free_slots.push_back(slot.thread_index);
+          }
+        }
+      }
+    };
+
+    thread_local ThreadRegistration thread_registration;
+    thread_local ThreadSlots thread_slots;
+  }
+
+  void CommandListPool::initialize(CreateContext create_context, uint32 frame_count)
+  {
+    this->create_context = std::move(create_context);
+    instance_id = next_instance_id.fetch_add(1);
+    thread_registry = std::make_shared<CommandListThreadRegistry>();
+    thread_count.store(0, std::memory_order_release);
+    setFrameCount(frame_count);
+  }
+
+  void CommandListPool::setFrameCount(uint32 frame_count)
+  {
+    frames.clear();
+    for (uint32 i = 0; i < frame_count; ++i)
+    {
+      frames.push_back(std::make_unique<Frame>());
+    }
+    frame_index = 0;
+    context_count.store(0, std::memory_order_relaxed);
+  }
+
+  void CommandListPool::beginFrame(uint32 frame_index)
+  {
+    this->frame_index = frame_index;
+
+    Frame& frame = *frames[frame_index];
+    uint32 threads = thread_count.load(std::memory_order_acquire);
+    for (uint32 thread = 0; thread < threads; ++thread)
+    {
+      frame.threads[thread].used = 0;
+    }
+  }
+
+  CommandList& CommandListPool::acquire(uint32 order, CommandListType type)
+  {
+    uint32 thread = getThreadIndex();
+    std::unique_lock<std::mutex> overflow_lock(overflow_mutex, std::defer_lock);
+    if (thread == overflow_thread)
+    {
+      overflow_lock.lock();
+    }
+    ThreadContexts& contexts = frames[frame_index]->threads[thread];
+
+    // Contexts of the requested type that weren't used yet this frame move to the front.
+    auto entry = std::find_if(contexts.entries.begin() + contexts.used, contexts.entries.end(), [type](const Entry& entry) { return entry.type == type; });
+    if (entry == contexts.entries.end())
+    {
+      contexts.entries.push_back(Entry { create_context(type), type, 0 });
+      context_count.fetch_add(1, std::memory_order_relaxed);
+      entry = contexts.entries.end() - 1;
+    }
+    std::iter_swap(entry, contexts.entries.begin() + contexts.used);
+
+    Entry& acquired = contexts.entries[contexts.used++];
+    acquired.order = order;
+    acquired.context->reset();
+    return acquired.context->getCommandList();
+  }
+
+  void CommandListPool::collect(std::vector<CommandList*>& lists)
+  {
+    Frame& frame = *frames[frame_index];
+    uint32 threads = thread_count.load(std::memory_order_acquire);
+
+    submissions.clear();
+    for (uint32 thread = 0; thread < threads; ++thread)
+    {
+      const ThreadContexts& contexts = frame.threads[thread];
+      for (uint32 index = 0; index < contexts.used; ++index)
+      {
+        submissions.push_back({ contexts.entries[index].order, thread, index, &contexts.entries[index].context->getCommandList() });
+      }
+    }
+
+    std::sort(submissions.begin(), submissions.end(), [](const Submission& a, const Submission& b)
+    {
+      return a.order != b.order ? a.order < b.order : a.thread != b.thread ? a.thread < b.thread : a.index < b.index;
+    });
+
+    for (const Submission& submission : submissions)
+    {
+      lists.push_back(submission.list);
+    }
+  }
+
+  uint32 CommandListPool::getAcquiredCount() const
+  {
+    const Frame& frame = *frames[frame_index];
+    uint32 threads = thread_count.load(std::memory_order_acquire);
+
+    uint32 count = 0;
+    for (uint32 thread = 0; thread < threads; ++thread)
+    {
+      count += frame.threads[thread].used;
+    }
+    return count;
+  }
+
+  uint32 CommandListPool::getThreadIndex()
+  {
+    if (thread_registration.instance_id == instance_id)
+    {
+      return thread_registration.thread_index;
+    }
+
+    // Threads keep their slot when they come back after using another pool.
+    uint32 thread_index = overflow_thread;
+    auto held = std::find_if(thread_slots.slots.begin(), thread_slots.slots.end(), [this](const HeldSlot& slot) { return slot.registry.lock() == thread_registry; });
+    if (held != thread_slots.slots.end())
+    {
+      thread_index = held->thread_index;
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(thread_registry->mutex);
+      if (!thread_registry->free_slots.empty())
+      {
+        thread_index = thread_registry->free_slots.back();
+        thread_registry->free_slots.pop_back();
+      }
+      else if (thread_registry->slot_count < max_threads)
+      {
+        thread_index = thread_registry->slot_count++;
+      }
+
+      if (thread_index == overflow_thread)
+      {
+        LOG_ERROR("Command list pool: more than %u threads record at once, this one shares a slot\n", max_threads);
+      }
+      else
+      {
+        // Slots of pools that are gone are dropped with the next registration.
+        thread_slots.slots.erase(std::remove_if(thread_slots.slots.begin(), thread_slots.slots.end(), [](const HeldSlot& slot) { return slot.registry.expired(); }),
+          thread_slots.slots.end());
+        thread_slots.slots.push_back({ thread_registry, thread_index });
+      }
+      thread_count.store(std::max(thread_count.load(std::memory_order_relaxed), thread_index + 1), std::memory_order_release);
+    }
+
+    thread_registration.instance_id = instance_id;
+    thread_registration.thread_index = thread_index;
+    return thread_index;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include <render/command_recorder.h>
+
+#include <cassert>
+
+namespace engine
+{
+  CommandRecorder::CommandRecorder(CommandListType type)
+    : type(type)
+  {
+  }
+
+  void CommandRecorder::reset(CommandStream* allocator)
+  {
+    assert(!is_open && "Command list must be closed before reset.");
+
+    stream = allocator;
+    stream->reset();
+    is_open = true;
+  }
+
+  void CommandRecorder::close()
+  {
+    assert(is_open);
+    is_open = false;
+  }
+
+  void CommandRecorder::resourceBarrier(const ResourceBarrier* barriers, uint32 count)
+  {
+    stream->writeArray(CommandType::ResourceBarrier, barriers, count);
+  }
+
+  void CommandRecorder::clearRenderTargetView(CpuDescriptorHandle rtv, const float color[4])
+  {
+    ClearRenderTargetViewCommand command { rtv, { color[0], color[1], color[2], color[3] } };
+    stream->write(CommandType::ClearRenderTargetView, command);
+  }
+
+  void CommandRecorder::setRenderTargets(const CpuDescriptorHandle* rtvs, uint32 count, const CpuDescriptorHandle* dsv)
+  {
+    SetRenderTargetsCommand command { dsv ? *dsv : CpuDescriptorHandle {}, dsv != nullptr };
+    stream->write(CommandType::SetRenderTargets, command, rtvs, count);
+  }
+
+  void CommandRecorder::setViewport(const Viewport& viewport)
+  {
+    stream->write(CommandType::SetViewport, viewport);
+  }
+
+  void CommandRecorder::setScissorRect(const ScissorRect& rect)
+  {
+    stream->write(CommandType::SetScissorRect, rect);
+  }
+
+  void CommandRecorder::setPipelineState(PipelineId pipeline)
+  {
+    stream->write(CommandType::SetPipelineState, pipeline);
+  }
+
+  void CommandRecorder::setGraphicsRootSignature(RootSignatureId root_signature)
+  {
+    stream->write(CommandType::SetGraphicsRootSignature, root_signature);
+  }
+
+  void CommandRecorder::setGraphicsRootDescriptorTable(uint32 root_index, GpuDescriptorHandle base_descriptor)
+  {
+    SetGraphicsRootDescriptorTableCommand command { root_index, base_descriptor };
+    stream->write(CommandType::SetGraphicsRootDescriptorTable, command);
+  }
+
+  void CommandRecorder::setGraphicsRoot32BitConstants(uint32 root_index, uint32 count, const void* data, uint32 offset)
+  {
+    SetGraphicsRoot32BitConstantsCommand command { root_index, offset };
+    stream->write(CommandType::SetGraphicsRoot32BitConstants, command, static_cast<const uint32*>(data), count);
+  }
+
+  void CommandRecorder::setGraphicsRootConstantBufferView(uint32 root_index, GpuVirtualAddress address)
+  {
+    SetGraphicsRootConstantBufferViewCommand command { root_index, address };
+    stream->write(CommandType::SetGraphicsRootConstantBufferView, command);
+  }
+
+  void CommandRecorder::setPrimitiveTopology(PrimitiveTopology topology)
+  {
+    stream->write(CommandType::SetPrimitiveTopology, topology);
+  }
+
+  void CommandRecorder::setVertexBuffers(uint32 start_slot, const VertexBufferView* views, uint32 count)
+  {
+    SetVertexBuffersCommand command { start_slot };
+    stream->write(CommandType::SetVertexBuffers, command, views, count);
+  }
+
+  void CommandRecorder::setIndexBuffer(const IndexBufferView& view)
+  {
+    stream->write(CommandType::SetIndexBuffer, view);
+  }
+
+  void CommandRecorder::drawInstanced(uint32 vertex_count, uint32 instance_count, uint32 start_vertex, uint32 start_instance)
+  {
+    DrawInstancedCommand command { vertex_count, instance_count, start_vertex, start_instance };
+    stream->write(CommandType::DrawInstanced, command);
+  }
+
+  void CommandRecorder::drawIndexedInstanced(uint32 index_count, uint32 instance_count, uint32 start_index, int32 base_vertex, uint32 start_instance)
+  {
+    DrawIndexedInstancedCommand command { index_count, instance_count, start_index, base_vertex, start_instance };
+    stream->write(CommandType::DrawIndexedInstanced, command);
+  }
+
+  void CommandRecorder::dispatch(uint32 groups_x, uint32 groups_y, uint32 groups_z)
+  {
+    DispatchCommand command { groups_x, groups_y, groups_z };
+    stream->write(CommandType::Dispatch, command);
+  }
+
+  void CommandRecorder::copyBufferRegion(ResourceId dst, uint64 dst_offset, ResourceId src, uint64 src_offset, uint64 size)
+  {
+    CopyBufferRegionCommand command { dst, src, dst_offset, src_offset, size };
+    stream->write(CommandType::CopyBufferRegion, command);
+  }
+
+  void CommandReplayer::setBackBuffer(ResourceId recorded, CpuDescriptorHandle recorded_view, ResourceId replayed, CpuDescriptorHandle replayed_view)
+  {
+    recorded_back_buffer = recorded;
+    this->recorded_view = recorded_view;
+    replayed_back_buffer = replayed;
+    this->replayed_view = replayed_view;
+  }
+
+  GpuVirtualAddress CommandReplayer::remapAddress(GpuVirtualAddress address) const
+  {
+    // Wraps around for addresses below the buffer.
+    uint64 buffer_offset = address - upload.address;
+    if (buffer_offset >= upload.buffer_size)
+    {
+      return address;
+    }
+
+    uint64 offset = getUploadOffset(buffer_offset);
+    return offset < upload.size ? upload.replayed.gpu_address + offset : address;
+  }
+
+  uint32 CommandReplayer::replay(const uint8* data, uint64 size, CommandList& command_list)
+  {
+    CommandStreamReader reader(data, size);
+    CommandHeader header;
+    const uint8* payload;
+    uint32 command_count = 0;
+    while (reader.next(header, payload))
+    {
+      switch (header.type)
+      {
+      case CommandType::ResourceBarrier:
+        barriers.resize(header.count);
+        std::memcpy(barriers.data(), payload, sizeof(ResourceBarrier) * header.count);
+        for (ResourceBarrier& barrier : barriers)
+        {
+          barrier.resource = remap(barrier.resource);
+          barrier.resource_after = remap(barrier.resource_after);
+        }
+        command_list.resourceBarrier(barriers.data(), header.count);
+        break;
+      case CommandType::ClearRenderTargetView:
+      {
+        auto command = CommandStreamReader::read<ClearRenderTargetViewCommand>(payload);
+        command_list.clearRenderTargetView(remap(command.rtv), command.color);
+        break;
+      }
+      case CommandType::SetRenderTargets:
+      {
+        auto command = CommandStreamReader::read<SetRenderTargetsCommand>(payload);
+        render_targets.resize(header.count);
+        std::memcpy(render_targets.data(), payload + sizeof(command), sizeof(CpuDescriptorHandle) * header.count);
+        for (CpuDescriptorHandle& render_target : render_targets)
+        {
+          render_target = remap(render_target);
+        }
+        command_list.setRenderTargets(render_targets.data(), header.count, command.has_dsv ? &command.dsv : nullptr);
+        break;
+      }
+      case CommandType::SetViewport:
+        command_list.setViewport(CommandStreamReader::read<Viewport>(payload));
+        break;
+      case CommandType::SetScissorRect:
+        command_list.setScissorRect(CommandStreamReader::read<ScissorRect>(payload));
+        break;
+      case CommandType::SetPipelineState:
+        command_list.setPipelineState(CommandStreamReader::read<PipelineId>(payload));
+        break;
+      case CommandType::SetGraphicsRootSignature:
+        command_list.setGraphicsRootSignature(CommandStreamReader::read<RootSignatureId>(payload));
+        break;
+      case CommandType::SetGraphicsRootDescriptorTable:
+      {
+        auto command = CommandStreamReader::read<SetGraphicsRootDescriptorTableCommand>(payload);
+        command_list.setGraphicsRootDescriptorTable(command.root_index, command.base_descriptor);
+        break;
+      }
+      case CommandType::SetGraphicsRoot32BitConstants:
+      {
+        // Constants follow an 8 byte payload, they keep the packet's alignment.
+        auto command = CommandStreamReader::read<SetGraphicsRoot32BitConstantsCommand>(payload);
+        command_list.setGraphicsRoot32BitConstants(command.root_index, header.count, payload + sizeof(command), command.offset);
+        break;
+      }
+      case CommandType::SetGraphicsRootConstantBufferView:
+      {
+        auto command = CommandStreamReader::read<SetGraphicsRootConstantBufferViewCommand>(payload);
+        command_list.setGraphicsRootConstantBufferView(command.root_index, remapAddress(command.address));
+        break;
+      }
+      case CommandType::SetPrimitiveTopology:
+        command_list.setPrimitiveTopology(CommandStreamReader::read<PrimitiveTopology>(payload));
+        break;
+      case CommandType::SetVertexBuffers:
+      {
+        auto command = CommandStreamReader::read<SetVertexBuffersCommand>(payload);
+        vertex_buffers.resize(header.count);
+        std::memcpy(vertex_buffers.data(), payload + sizeof(command), sizeof(VertexBufferView) * header.count);
+        for (VertexBufferView& view : vertex_buffers)
+        {
+          view.location = remapAddress(view.location);
+        }
+        command_list.setVertexBuffers(command.start_slot, vertex_buffers.data(), header.count);
+        break;
+      }
+      case CommandType::SetIndexBuffer:
+      {
+        auto view = CommandStreamReader::read<IndexBufferView>(payload);
+        view.location = remapAddress(view.location);
+        command_list.setIndexBuffer(view);
+        break;
+      }
+      case CommandType::DrawInstanced:
+      {
+        auto command = CommandStreamReader::read<DrawInstancedCommand>(payload);
+        command_list.drawInstanced(command.vertex_count, command.instance_count, command.start_vertex, command.start_instance);
+        break;
+      }
+      case CommandType::DrawIndexedInstanced:
+      {
+        auto command = CommandStreamReader::read<DrawIndexedInstancedCommand>(payload);
+        command_list.drawIndexedInstanced(command.index_count, command.instance_count, command.start_index, command.base_vertex, command.start_instance);
+        break;
+      }
+      case CommandType::Dispatch:
+      {
+        auto command = CommandStreamReader::read<DispatchCommand>(payload);
+        command_list.dispatch(command.groups_x, command.groups_y, command.groups_z);
+        break;
+      }
+      case CommandType::CopyBufferRegion:
+      {
+        auto command = CommandStreamReader::read<CopyBufferRegionCommand>(payload);
+        uint64 upload_offset = command.src == upload.resource && command.src_offset < upload.buffer_size ? getUploadOffset(command.src_offset) : upload.size;
+        if (upload_offset < upload.size)
+        {
+          command.src = upload.replayed.resource;
+          command.src_offset = upload.replayed.offset + upload_offset;
+        }
+        command_list.copyBufferRegion(command.dst, command.dst_offset, command.src, command.src_offset, command.size);
+        break;
+      }
+      default:
+        assert(false && "Unknown command in stream.");
+        return command_count;
+      }
+      command_count++;
+    }
+
+    return command_count;
+  }
+}
\ No newline at end of file
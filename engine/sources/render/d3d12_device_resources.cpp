@@ -0,0 +1,705 @@
+#include <render/d3d12_device_resources.h>
+
+namespace engine
+{
+  namespace
+  {
+    constexpr uint32 max_batched_barriers = 32;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE toNative(CpuDescriptorHandle handle)
+    {
+      return D3D12_CPU_DESCRIPTOR_HANDLE { static_cast<SIZE_T>(handle.ptr) };
+    }
+  }
+
+  D3D12CommandList::D3D12CommandList(const D3D12DeviceResources& owner, ComPtr<ID3D12GraphicsCommandList> command_list, CommandListType type)
+    : owner(owner)
+    , command_list(command_list)
+    , type(type)
+  {
+  }
+
+  void D3D12CommandList::reset(ID3D12CommandAllocator* command_allocator)
+  {
+    ThrowIfFailed(command_list->Reset(command_allocator, nullptr));
+  }
+
+  void D3D12CommandList::close()
+  {
+    ThrowIfFailed(command_list->Close());
+  }
+
+  void D3D12CommandList::resourceBarrier(const ResourceBarrier* barriers, uint32 count)
+  {
+    D3D12_RESOURCE_BARRIER native_barriers[max_batched_barriers];
+
+    for (uint32 first = 0; first < count; first += max_batched_barriers)
+    {
+      uint32 batch_size = std::min(count - first, max_batched_barriers);
+      for (uint32 i = 0; i < batch_size; ++i)
+      {
+        const ResourceBarrier& barrier = barriers[first + i];
+        D3D12_RESOURCE_BARRIER& native_barrier = native_barriers[i];
+        native_barrier = {};
+        native_barrier.Type = static_cast<D3D12_RESOURCE_BARRIER_TYPE>(barrier.type);
+        native_barrier.Flags = static_cast<D3D12_RESOURCE_BARRIER_FLAGS>(barrier.flags);
+
+        switch (barrier.type)
+        {
+        case BarrierType::Transition:
+          native_barrier.Transition.pResource = owner.getResource(barrier.resource);
+          native_barrier.Transition.Subresource = barrier.subresource;
+          native_barrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(barrier.state_before);
+          native_barrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(barrier.state_after);
+          break;
+        case BarrierType::Aliasing:
+          native_barrier.Aliasing.pResourceBefore = owner.getResource(barrier.resource);
+          native_barrier.Aliasing.pResourceAfter = owner.getResource(barrier.resource_after);
+          break;
+        case BarrierType::UnorderedAccess:
+          native_barrier.UAV.pResource = owner.getResource(barrier.resource);
+          break;
+        }
+      }
+
+      command_list->ResourceBarrier(batch_size, native_barriers);
+    }
+  }
+
+  void D3D12CommandList::clearRenderTargetView(CpuDescriptorHandle rtv, const float color[4])
+  {
+    command_list->ClearRenderTargetView(toNative(rtv), color, 0, nullptr);
+  }
+
+  void D3D12CommandList::setRenderTargets(const CpuDescriptorHandle* rtvs, uint32 count, const CpuDescriptorHandle* dsv)
+  {
+    assert(count <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE native_rtvs[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    for (uint32 i = 0; i < count; ++i)
+    {
+      native_rtvs[i] = toNative(rtvs[i]);
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE native_dsv = dsv ? toNative(*dsv) : D3D12_CPU_DESCRIPTOR_HANDLE {};
+    command_list->OMSetRenderTargets(count, native_rtvs, FALSE, dsv ? &native_dsv : nullptr);
+  }
+
+  void D3D12CommandList::setViewport(const Viewport& viewport)
+  {
+    D3D12_VIEWPORT native_viewport = { viewport.x, viewport.y, viewport.width, viewport.height, viewport.min_depth, viewport.max_depth };
+    command_list->RSSetViewports(1, &native_viewport);
+  }
+
+  void D3D12CommandList::setScissorRect(const ScissorRect& rect)
+  {
+    D3D12_RECT native_rect = { rect.left, rect.top, rect.right, rect.bottom };
+    command_list->RSSetScissorRects(1, &native_rect);
+  }
+
+  void D3D12CommandList::setPipelineState(PipelineId pipeline)
+  {
+    command_list->SetPipelineState(owner.getPipelineState(pipeline));
+  }
+
+  void D3D12CommandList::setGraphicsRootSignature(RootSignatureId root_signature)
+  {
+    command_list->SetGraphicsRootSignature(owner.getRootSignature(root_signature));
+  }
+
+  void D3D12CommandList::setGraphicsRootDescriptorTable(uint32 root_index, GpuDescriptorHandle base_descriptor)
+  {
+    command_list->SetGraphicsRootDescriptorTable(root_index, D3D12_GPU_DESCRIPTOR_HANDLE { base_descriptor.ptr });
+  }
+
+  void D3D12CommandList::setGraphicsRoot32BitConstants(uint32 root_index, uint32 count, const void* data, uint32 offset)
+  {
+    command_list->SetGraphicsRoot32BitConstants(root_index, count, data, offset);
+  }
+
+  void D3D12CommandList::setGraphicsRootConstantBufferView(uint32 root_index, GpuVirtualAddress address)
+  {
+    command_list->SetGraphicsRootConstantBufferView(root_index, address);
+  }
+
+  void D3D12CommandList::setPrimitiveTopology(PrimitiveTopology topology)
+  {
+    command_list->IASetPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(topology));
+  }
+
+  void D3D12CommandList::setVertexBuffers(uint32 start_slot, const VertexBufferView* views, uint32 count)
+  {
+    assert(count <= D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+
+    D3D12_VERTEX_BUFFER_VIEW native_views[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    for (uint32 i = 0; i < count; ++i)
+    {
+      native_views[i] = { views[i].location, views[i].size, views[i].stride };
+    }
+
+    command_list->IASetVertexBuffers(start_slot, count, native_views);
+  }
+
+  void D3D12CommandList::setIndexBuffer(const IndexBufferView& view)
+  {
+    D3D12_INDEX_BUFFER_VIEW native_view = { view.location, view.size, view.is_32bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT };
+    command_list->IASetIndexBuffer(&native_view);
+  }
+
+  void D3D12CommandList::drawInstanced(uint32 vertex_count, uint32 instance_count, uint32 start_vertex, uint32 start_instance)
+  {
+    command_list->DrawInstanced(vertex_count, instance_count, start_vertex, start_instance);
+  }
+
+  void D3D12CommandList::drawIndexedInstanced(uint32 index_count, uint32 instance_count, uint32 start_index, int32 base_vertex, uint32 start_instance)
+  {
+    command_list->DrawIndexedInstanced(index_count, instance_count, start_index, base_vertex, start_instance);
+  }
+
+  void D3D12CommandList::dispatch(uint32 groups_x, uint32 groups_y, uint32 groups_z)
+  {
+    command_list->Dispatch(groups_x, groups_y, groups_z);
+  }
+
+  void D3D12CommandList::copyBufferRegion(ResourceId dst, uint64 dst_offset, ResourceId src, uint64 src_offset, uint64 size)
+  {
+    command_list->CopyBufferRegion(owner.getResource(dst), dst_offset, owner.getResource(src), src_offset, size);
+  }
+
+  D3D12CommandContext::D3D12CommandContext(D3D12DeviceResources& owner, ComPtr<ID3D12CommandAllocator> command_allocator, std::unique_ptr<D3D12CommandList> command_list)
+    : owner(owner)
+    , command_allocator(command_allocator)
+    , command_list(std::move(command_list))
+  {
+  }
+
+  void D3D12CommandContext::reset()
+  {
+    ThrowIfFailed(command_allocator->Reset());
+    command_list->reset(command_allocator.Get());
+    owner.bindDescriptorHeaps(*command_list);
+  }
+
+  D3D12DeviceResources::~D3D12DeviceResources()
+  {
+    gpu_memory_allocator.shutdown();
+
+    if (fence_event)
+    {
+      ::CloseHandle(fence_event);
+    }
+
+    if (frame_latency_waitable_object)
+    {
+      ::CloseHandle(frame_latency_waitable_object);
+    }
+  }
+
+  void D3D12DeviceResources::createDeviceResources(const SurfaceDesc& surface)
+  {
+    ComPtr<IDXGIAdapter4> dxgi_adapter4 = getAdapter(surface.use_warp);
+    device = createDevice(dxgi_adapter4);
+    const D3D12_COMMAND_LIST_TYPE queue_types[] = { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_COMPUTE, D3D12_COMMAND_LIST_TYPE_COPY };
+    for (uint32 i = 0; i < queue_count; ++i)
+    {
+      command_queues[i] = createCommandQueue(device, queue_types[i]);
+      fences[i] = createFence(device);
+    }
+
+    swap_chain = createSwapChain(static_cast<HWND>(surface.native_window), command_queues[getQueueIndex(CommandListType::Direct)], surface.width, surface.height, swap_chain_buffer_count);
+
+    if (frame_pacing == FramePacingMode::WaitableObject)
+    {
+      ThrowIfFailed(swap_chain->SetMaximumFrameLatency(max_frame_latency));
+      frame_latency_waitable_object = swap_chain->GetFrameLatencyWaitableObject();
+    }
+
+    // Sized for the largest swap chain so the buffer count can change without reallocating the views.
+    back_buffer_views = descriptor_allocator.getStaging(DescriptorHeapType::Rtv).allocate(max_swap_chain_buffers);
+    updateRenderTargetViews(device, swap_chain);
+
+    fence_event = createEventHandle();
+  }
+
+  void D3D12DeviceResources::resizeFrameResources(uint32 frame_count)
+  {
+    command_allocators.resize(frame_count);
+    for (auto& command_allocator : command_allocators)
+    {
+      if (!command_allocator)
+      {
+        command_allocator = createCommandAllocator(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+      }
+    }
+
+    if (!command_list)
+    {
+      auto native_command_list = createCommandList(device, command_allocators[0], D3D12_COMMAND_LIST_TYPE_DIRECT);
+      command_list = std::make_unique<D3D12CommandList>(*this, native_command_list, CommandListType::Direct);
+    }
+  }
+
+  ResourceId D3D12DeviceResources::registerResource(ComPtr<ID3D12Resource> resource)
+  {
+    return resources.create(std::move(resource)).value;
+  }
+
+  PipelineId D3D12DeviceResources::registerPipelineState(ComPtr<ID3D12PipelineState> pipeline_state)
+  {
+    return pipeline_states.create(std::move(pipeline_state)).value;
+  }
+
+  RootSignatureId D3D12DeviceResources::registerRootSignature(ComPtr<ID3D12RootSignature> root_signature)
+  {
+    return root_signatures.create(std::move(root_signature)).value;
+  }
+
+  CommandList& D3D12DeviceResources::resetCommandList(uint32 frame_index)
+  {
+    auto command_allocator = command_allocators[frame_index];
+    command_allocator->Reset();
+    command_list->reset(command_allocator.Get());
+    bindDescriptorHeaps(*command_list);
+
+    return *command_list;
+  }
+
+  std::unique_ptr<CommandContext> D3D12DeviceResources::createCommandContext(CommandListType type)
+  {
+    // Device creation calls are free threaded, recording threads create their own contexts.
+    D3D12_COMMAND_LIST_TYPE native_type = static_cast<D3D12_COMMAND_LIST_TYPE>(type);
+    auto command_allocator = createCommandAllocator(device, native_type);
+    auto native_command_list = createCommandList(device, command_allocator, native_type);
+    return std::make_unique<D3D12CommandContext>(*this, command_allocator, std::make_unique<D3D12CommandList>(*this, native_command_list, type));
+  }
+
+  void D3D12DeviceResources::bindDescriptorHeaps(D3D12CommandList& command_list) const
+  {
+    // Copy lists can't bind descriptor heaps.
+    if (command_list.getType() == CommandListType::Copy)
+    {
+      return;
+    }
+
+    // Shader visible heaps never change, every list binds them once up front.
+    ID3D12DescriptorHeap* const heaps[] = { getDescriptorHeap(descriptor_allocator.getResourceHeap().getHeapInfo().id), getDescriptorHeap(descriptor_allocator.getSamplerHeap().getHeapInfo().id) };
+    command_list.getNative()->SetDescriptorHeaps(2, heaps);
+  }
+
+  void D3D12DeviceResources::executeCommandLists(CommandListType queue, CommandList* const* lists, uint32 count)
+  {
+    std::vector<ID3D12CommandList*> native_lists(count);
+    for (uint32 i = 0; i < count; ++i)
+    {
+      native_lists[i] = static_cast<D3D12CommandList*>(lists[i])->getNative();
+    }
+
+    command_queues[getQueueIndex(queue)]->ExecuteCommandLists(count, native_lists.data());
+  }
+
+  void D3D12DeviceResources::signalQueue(CommandListType queue, uint64 value)
+  {
+    ThrowIfFailed(command_queues[getQueueIndex(queue)]->Signal(fences[getQueueIndex(queue)].Get(), value));
+  }
+
+  uint64 D3D12DeviceResources::getCompletedFenceValue(CommandListType queue)
+  {
+    return fences[getQueueIndex(queue)]->GetCompletedValue();
+  }
+
+  void D3D12DeviceResources::waitForQueue(CommandListType queue, CommandListType signaled_queue, uint64 value)
+  {
+    ThrowIfFailed(command_queues[getQueueIndex(queue)]->Wait(fences[getQueueIndex(signaled_queue)].Get(), value));
+  }
+
+  void D3D12DeviceResources::waitForFenceValue(uint64 value)
+  {
+    waitForFenceValue(fences[getQueueIndex(CommandListType::Direct)], value, fence_event);
+  }
+
+  void D3D12DeviceResources::present(uint32 sync_interval, bool allow_tearing)
+  {
+    UINT present_flags = allow_tearing ? DXGI_PRESENT_ALLOW_TEARING : 0;
+    ThrowIfFailed(swap_chain->Present(sync_interval, present_flags));
+  }
+
+  void D3D12DeviceResources::resizeSwapChain(uint32 width, uint32 height)
+  {
+    for (ResourceId back_buffer_id : back_buffer_ids)
+    {
+      resources.get(ResourceHandle(back_buffer_id))->Reset();
+    }
+
+    DXGI_SWAP_CHAIN_DESC swap_chain_desc = {};
+    ThrowIfFailed(swap_chain->GetDesc(&swap_chain_desc));
+    ThrowIfFailed(swap_chain->ResizeBuffers(swap_chain_buffer_count, width, height, swap_chain_desc.BufferDesc.Format, swap_chain_desc.Flags));
+
+    updateRenderTargetViews(device, swap_chain);
+  }
+
+  uint32 D3D12DeviceResources::queryCurrentBackBufferIndex()
+  {
+    return swap_chain->GetCurrentBackBufferIndex();
+  }
+
+  bool D3D12DeviceResources::waitForFrameLatencyObject(uint32 timeout_milliseconds)
+  {
+    if (!frame_latency_waitable_object)
+    {
+      return true;
+    }
+
+    return ::WaitForSingleObjectEx(frame_latency_waitable_object, timeout_milliseconds, TRUE) == WAIT_OBJECT_0;
+  }
+
+  void D3D12DeviceResources::updateMaximumFrameLatency()
+  {
+    // Only swap chains created with the waitable object flag take the latency from the swap chain.
+    if (frame_latency_waitable_object)
+    {
+      ThrowIfFailed(swap_chain->SetMaximumFrameLatency(max_frame_latency));
+    }
+  }
+
+  UploadMemory D3D12DeviceResources::createUploadMemory(uint64 size)
+  {
+    CD3DX12_HEAP_PROPERTIES heap_properties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+
+    ComPtr<ID3D12Resource> buffer;
+    ThrowIfFailed(device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &buffer_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer)));
+
+    // Upload heaps may stay mapped, the CPU only writes so nothing is read back.
+    void* cpu_address = nullptr;
+    CD3DX12_RANGE read_range(0, 0);
+    ThrowIfFailed(buffer->Map(0, &read_range, &cpu_address));
+
+    UploadMemory memory;
+    memory.cpu_address = static_cast<uint8*>(cpu_address);
+    memory.gpu_address = buffer->GetGPUVirtualAddress();
+    memory.size = size;
+    memory.resource = registerResource(buffer);
+    return memory;
+  }
+
+  HeapId D3D12DeviceResources::createHeap(const HeapDesc& desc)
+  {
+    // Resource heap tier 1 needs one of these, tier 2 accepts them too.
+    D3D12_HEAP_FLAGS flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    if (desc.usage == HeapUsage::Textures)
+    {
+      flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    }
+    else if (desc.usage == HeapUsage::RenderTargets)
+    {
+      flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    }
+
+    CD3DX12_HEAP_DESC heap_desc(desc.size, CD3DX12_HEAP_PROPERTIES(static_cast<D3D12_HEAP_TYPE>(desc.type)), desc.alignment, flags);
+    ComPtr<ID3D12Heap> heap;
+    if (FAILED(device->CreateHeap(&heap_desc, IID_PPV_ARGS(&heap))))
+    {
+      return invalid_id;
+    }
+
+    return heaps.create(std::move(heap)).value;
+  }
+
+  void D3D12DeviceResources::destroyHeap(HeapId heap)
+  {
+    heaps.destroy(HeapHandle(heap));
+  }
+
+  DescriptorHeapInfo D3D12DeviceResources::createDescriptorHeap(const DescriptorHeapDesc& desc)
+  {
+    D3D12_DESCRIPTOR_HEAP_TYPE type = static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(desc.type);
+    ComPtr<ID3D12DescriptorHeap> heap = createDescriptorHeap(device, type, desc.capacity, desc.shader_visible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
+
+    DescriptorHeapInfo info;
+    info.cpu_start = CpuDescriptorHandle { heap->GetCPUDescriptorHandleForHeapStart().ptr };
+    info.gpu_start = GpuDescriptorHandle { desc.shader_visible ? heap->GetGPUDescriptorHandleForHeapStart().ptr : 0 };
+    info.increment = device->GetDescriptorHandleIncrementSize(type);
+    info.capacity = desc.capacity;
+    info.id = descriptor_heaps.create(std::move(heap)).value;
+    return info;
+  }
+
+  void D3D12DeviceResources::copyDescriptors(DescriptorHeapType type, const DescriptorCopyBatch& batch)
+  {
+    static_assert(sizeof(CpuDescriptorHandle) == sizeof(D3D12_CPU_DESCRIPTOR_HANDLE), "Descriptor handles are passed through as is.");
+
+    device->CopyDescriptors(static_cast<UINT>(batch.destination_starts.size()), reinterpret_cast<const D3D12_CPU_DESCRIPTOR_HANDLE*>(batch.destination_starts.data()), batch.destination_sizes.data(),
+      static_cast<UINT>(batch.source_starts.size()), reinterpret_cast<const D3D12_CPU_DESCRIPTOR_HANDLE*>(batch.source_starts.data()), batch.source_sizes.data(), static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(type));
+  }
+
+  DescriptorAllocation D3D12DeviceResources::createShaderResourceView(ResourceId resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+  {
+    DescriptorAllocation view = descriptor_allocator.getStaging(DescriptorHeapType::CbvSrvUav).allocate();
+    if (view.isValid())
+    {
+      device->CreateShaderResourceView(getResource(resource), desc, D3D12_CPU_DESCRIPTOR_HANDLE { static_cast<SIZE_T>(view.cpu.ptr) });
+    }
+    return view;
+  }
+
+  ResourceId D3D12DeviceResources::createPlacedResource(GpuAllocation allocation, uint64 offset, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value)
+  {
+    const GpuHeapRange* range = gpu_memory_allocator.getRange(allocation);
+    assert(range && "Placed resource needs a live allocation.");
+    assert(offset + device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes <= range->size);
+
+    ComPtr<ID3D12Resource> resource;
+    ThrowIfFailed(device->CreatePlacedResource(getHeap(range->heap), range->offset + offset, &desc, initial_state, clear_value, IID_PPV_ARGS(&resource)));
+    return registerResource(resource);
+  }
+
+  CpuDescriptorHandle D3D12DeviceResources::getBackBufferView(uint32 index) const
+  {
+    return back_buffer_views.getCpuHandle(index);
+  }
+
+  void D3D12DeviceResources::enableDebugLayer()
+  {
+#if defined(_DEBUG)
+    ComPtr<ID3D12Debug> debug_interface;
+    ThrowIfFailed(D3D12GetDebugInterface(IID_PPV_ARGS(&debug_interface)));
+    debug_interface->EnableDebugLayer();
+#endif
+  }
+
+  bool D3D12DeviceResources::checkTearingSupport()
+  {
+    bool allow_tearing = false;
+
+    ComPtr<IDXGIFactory4> factory4;
+    if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory4))))
+    {
+      ComPtr<IDXGIFactory5> factory5;
+      if (SUCCEEDED(factory4.As(&factory5)))
+      {
+        if (FAILED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allow_tearing, sizeof(allow_tearing))))
+        {
+          allow_tearing = false;
+        }
+      }
+    }
+
+    return allow_tearing;
+  }
+
+  ComPtr<IDXGIAdapter4> D3D12DeviceResources::getAdapter(bool use_warp)
+  {
+    ComPtr<IDXGIFactory4> dxgi_factory;
+    uint create_factory_flags = 0;
+#if defined(_DEBUG)
+    create_factory_flags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+    ThrowIfFailed(CreateDXGIFactory2(create_factory_flags, IID_PPV_ARGS(&dxgi_factory)));
+
+    ComPtr<IDXGIAdapter1> dxgi_adapter1;
+    ComPtr<IDXGIAdapter4> dxgi_adapter4;
+
+    if (use_warp)
+    {
+      ThrowIfFailed(dxgi_factory->EnumWarpAdapter(IID_PPV_ARGS(&dxgi_adapter1)));
+      ThrowIfFailed(dxgi_adapter1.As(&dxgi_adapter4));
+    }
+    else
+    {
+      SIZE_T max_dedicated_video_memory = 0;
+      for (uint i = 0; dxgi_factory->EnumAdapters1(i, &dxgi_adapter1) != DXGI_ERROR_NOT_FOUND; ++i)
+      {
+        DXGI_ADAPTER_DESC1 dxgi_adapter_desc1;
+        dxgi_adapter1->GetDesc1(&dxgi_adapter_desc1);
+
+        if ((dxgi_adapter_desc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 
+          && SUCCEEDED(D3D12CreateDevice(dxgi_adapter1.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr)) 
+          && dxgi_adapter_desc1.DedicatedVideoMemory > max_dedicated_video_memory)
+        {
+          max_dedicated_video_memory = dxgi_adapter_desc1.DedicatedVideoMemory;
+          ThrowIfFailed(dxgi_adapter1.As(&dxgi_adapter4));
+        }
+      }
+    }
+
+    return dxgi_adapter4;
+  }
+
+  ComPtr<ID3D12Device2> D3D12DeviceResources::createDevice(ComPtr<IDXGIAdapter4> adapter)
+  {
+    ComPtr<ID3D12Device2> d3d12_device2;
+    ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3d12_device2)));
+    
+    // enable debug messages in debug mode
+#if defined(_DEBUG)
+    ComPtr<ID3D12InfoQueue> info_queue;
+    if (SUCCEEDED(d3d12_device2.As(&info_queue)))
+    {
+      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
+      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
+      info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, TRUE);
+
+      // Suppress whole categories of messages
+      //D3D12_MESSAGE_CATEGORY categories[] = {};
+
+      // Suppress messages based on their severity level
+      D3D12_MESSAGE_SEVERITY severities[] = { D3D12_MESSAGE_SEVERITY_INFO };
+
+      // Suppress individual messages by their ID
+      D3D12_MESSAGE_ID deny_ids[] = {
+          D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
+          D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
+          D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
+      };
+
+      D3D12_INFO_QUEUE_FILTER info_filter = {};
+      //info_filter.DenyList.NumCategories = _countof(categories);
+      //info_filter.DenyList.pCategoryList = categories;
+      info_filter.DenyList.NumSeverities = _countof(severities);
+      info_filter.DenyList.pSeverityList = severities;
+      info_filter.DenyList.NumIDs = _countof(deny_ids);
+      info_filter.DenyList.pIDList = deny_ids;
+
+      ThrowIfFailed(info_queue->PushStorageFilter(&info_filter));
+    }
+#endif
+
+    return d3d12_device2;
+  }
+
+  ComPtr<ID3D12CommandQueue> D3D12DeviceResources::createCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+  {
+    ComPtr<ID3D12CommandQueue> d3d12_command_queue;
+
+    D3D12_COMMAND_QUEUE_DESC desc = {};
+    desc.Type = type;
+    desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+    desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    desc.NodeMask = 0;
+
+    ThrowIfFailed(device->CreateCommandQueue(&desc, IID_PPV_ARGS(&d3d12_command_queue)));
+
+    return d3d12_command_queue;
+  }
+
+  ComPtr<IDXGISwapChain4> D3D12DeviceResources::createSwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> command_queue, uint32_t width, uint32_t height, uint32_t buffer_count)
+  {
+    ComPtr<IDXGISwapChain4> dxgi_swap_chain4;
+    ComPtr<IDXGIFactory4> dxgi_factory4;
+    UINT create_factory_flags = 0;
+#if defined(_DEBUG)
+    create_factory_flags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+
+    ThrowIfFailed(CreateDXGIFactory2(create_factory_flags, IID_PPV_ARGS(&dxgi_factory4)));
+
+    DXGI_SWAP_CHAIN_DESC1 swap_chain_desc = {};
+    swap_chain_desc.Width = width;
+    swap_chain_desc.Height = height;
+    swap_chain_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swap_chain_desc.Stereo = FALSE;
+    swap_chain_desc.SampleDesc = { 1, 0 };
+    swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swap_chain_desc.BufferCount = buffer_count;
+    swap_chain_desc.Scaling = DXGI_SCALING_STRETCH;
+    swap_chain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swap_chain_desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+    // It is recommended to always allow tearing if tearing support is available.
+    swap_chain_desc.Flags = checkTearingSupport() ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+    if (frame_pacing == FramePacingMode::WaitableObject)
+    {
+      swap_chain_desc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    }
+
+    ComPtr<IDXGISwapChain1> swap_chain1;
+    ThrowIfFailed(dxgi_factory4->CreateSwapChainForHwnd(command_queue.Get(), hwnd, &swap_chain_desc, nullptr, nullptr, &swap_chain1));
+
+    // Disable the Alt+Enter fullscreen toggle feature. Switching to fullscreen
+    // will be handled manually.
+    ThrowIfFailed(dxgi_factory4->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
+
+    ThrowIfFailed(swap_chain1.As(&dxgi_swap_chain4));
+
+    return dxgi_swap_chain4;
+  }
+
+  ComPtr<ID3D12DescriptorHeap> D3D12DeviceResources::createDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32 num_descriptors, D3D12_DESCRIPTOR_HEAP_FLAGS flags)
+  {
+    ComPtr<ID3D12DescriptorHeap> descriptor_heap;
+
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.NumDescriptors = num_descriptors;
+    desc.Type = type;
+    desc.Flags = flags;
+
+    ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptor_heap)));
+
+    return descriptor_heap;
+  }
+
+  void D3D12DeviceResources::updateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swap_chain)
+  {
+    // Ids of buffers dropped by a smaller swap chain stay registered and are reused if it grows again.
+    while (back_buffer_ids.size() < swap_chain_buffer_count)
+    {
+      back_buffer_ids.push_back(registerResource(nullptr));
+    }
+
+    for (uint32 i = 0; i < swap_chain_buffer_count; ++i)
+    {
+      ComPtr<ID3D12Resource> back_buffer;
+      ThrowIfFailed(swap_chain->GetBuffer(i, IID_PPV_ARGS(&back_buffer)));
+
+      D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle { static_cast<SIZE_T>(back_buffer_views.getCpuHandle(i).ptr) };
+      device->CreateRenderTargetView(back_buffer.Get(), nullptr, rtv_handle);
+
+      *resources.get(ResourceHandle(back_buffer_ids[i])) = back_buffer;
+    }
+  }
+
+  ComPtr<ID3D12CommandAllocator> D3D12DeviceResources::createCommandAllocator(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+  {
+    ComPtr<ID3D12CommandAllocator> command_allocator;
+    ThrowIfFailed(device->CreateCommandAllocator(type, IID_PPV_ARGS(&command_allocator)));
+
+    return command_allocator;
+  }
+
+  ComPtr<ID3D12GraphicsCommandList> D3D12DeviceResources::createCommandList(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandAllocator> command_allocator, D3D12_COMMAND_LIST_TYPE type)
+  {
+    ComPtr<ID3D12GraphicsCommandList> command_list;
+    ThrowIfFailed(device->CreateCommandList(0, type, command_allocator.Get(), nullptr, IID_PPV_ARGS(&command_list)));
+
+    ThrowIfFailed(command_list->Close());
+
+    return command_list;
+  }
+
+  ComPtr<ID3D12Fence> D3D12DeviceResources::createFence(ComPtr<ID3D12Device2> device)
+  {
+    ComPtr<ID3D12Fence> fence;
+
+    ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+
+    return fence;
+  }
+
+  HANDLE D3D12DeviceResources::createEventHandle()
+  {
+    HANDLE fence_event;
+
+    fence_event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+    assert(fence_event && "Failed to create fence event.");
+
+    return fence_event;
+  }
+
+  void D3D12DeviceResources::waitForFenceValue(ComPtr<ID3D12Fence> fence, uint64 fence_value, HANDLE fence_event, std::chrono::milliseconds duration)
+  {
+    if (fence->GetCompletedValue() < fence_value)
+    {
+      ThrowIfFailed(fence->SetEventOnCompletion(fence_value, fence_event));
+      ::WaitForSingleObject(fence_event, static_cast<DWORD>(duration.count()));
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include <render/descriptor_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  void DescriptorCopyBatch::clear()
+  {
+    destination_starts.clear();
+    destination_sizes.clear();
+    source_starts.clear();
+    source_sizes.clear();
+  }
+
+  void StagingDescriptorAllocator::initialize(DescriptorHeapType type, CreateDescriptorHeap create_heap, uint32 heap_capacity)
+  {
+    this->type = type;
+    this->create_heap = std::move(create_heap);
+    this->heap_capacity = heap_capacity;
+    heaps.clear();
+    search_start = 0;
+  }
+
+  DescriptorAllocation StagingDescriptorAllocator::allocate(uint32 count)
+  {
+    assert(count > 0);
+
+    // Starts with the heap that last had space freed, under churn it usually fits there.
+    uint32 heap_count = static_cast<uint32>(heaps.size());
+    for (uint32 i = 0; i < heap_count; ++i)
+    {
+      uint32 heap = (search_start + i) % heap_count;
+      TlsfAllocator::Allocation allocation = heaps[heap].allocator.allocate(count);
+      if (allocation.isValid())
+      {
+        search_start = heap;
+        return makeAllocation(heap, allocation, count);
+      }
+    }
+
+    if (count > heap_capacity)
+    {
+      return DescriptorAllocation {};
+    }
+
+    DescriptorHeapInfo info = create_heap(DescriptorHeapDesc { type, heap_capacity, false });
+    if (info.id == invalid_id)
+    {
+      return DescriptorAllocation {};
+    }
+
+    heaps.push_back(Heap { info, TlsfAllocator(info.capacity, 1) });
+    search_start = static_cast<uint32>(heaps.size() - 1);
+    return makeAllocation(static_cast<uint32>(heaps.size() - 1), heaps.back().allocator.allocate(count), count);
+  }
+
+  void StagingDescriptorAllocator::free(const DescriptorAllocation& allocation)
+  {
+    assert(allocation.heap < heaps.size());
+    heaps[allocation.heap].allocator.free(allocation.block);
+    search_start = allocation.heap;
+  }
+
+  uint32 StagingDescriptorAllocator::getAllocatedCount() const
+  {
+    uint64 count = 0;
+    for (const Heap& heap : heaps)
+    {
+      count += heap.allocator.getUsed();
+    }
+    return static_cast<uint32>(count);
+  }
+
+  uint32 StagingDescriptorAllocator::getFreeRangeCount() const
+  {
+    uint32 count = 0;
+    for (const Heap& heap : heaps)
+    {
+      count += heap.allocator.getFreeBlockCount();
+    }
+    return count;
+  }
+
+  uint32 StagingDescriptorAllocator::getLargestFreeRange() const
+  {
+    uint64 largest = 0;
+    for (const Heap& heap : heaps)
+    {
+      largest = std::max(largest, heap.allocator.getLargestFreeBlock());
+    }
+    return static_cast<uint32>(largest);
+  }
+
+  DescriptorAllocation StagingDescriptorAllocator::makeAllocation(uint32 heap, const TlsfAllocator::Allocation& allocation, uint32 count) const
+  {
+    const DescriptorHeapInfo& info = heaps[heap].info;
+    uint32 index = static_cast<uint32>(allocation.offset);
+
+    DescriptorAllocation result;
+    result.cpu = CpuDescriptorHandle { info.cpu_start.ptr + uint64(index) * info.increment };
+    result.index = index;
+    result.count = count;
+    result.increment = info.increment;
+    result.heap = heap;
+    result.block = allocation.block;
+    return result;
+  }
+
+  void ShaderVisibleDescriptorHeap::initialize(DescriptorHeapType type, const DescriptorHeapInfo& heap, uint32 persistent_count, CopyDescriptors copy_descriptors)
+  {
+    assert(persistent_count <= heap.capacity);
+
+    this->type = type;
+    this->heap = heap;
+    this->copy_descriptors = std::move(copy_descriptors);
+    this->persistent_count = persistent_count;
+    if (persistent_count > 0)
+    {
+      persistent.reset(persistent_count, 1);
+    }
+
+    transient_count = heap.capacity - persistent_count;
+    head = 0;
+    tail = 0;
+    failed_allocations = 0;
+    first_pending = 0;
+    pending_count = 0;
+    batch.clear();
+  }
+
+  DescriptorAllocation ShaderVisibleDescriptorHeap::allocatePersistent(uint32 count)
+  {
+    TlsfAllocator::Allocation allocation = persistent.allocate(count);
+    if (!allocation.isValid())
+    {
+      failed_allocations++;
+      return DescriptorAllocation {};
+    }
+
+    DescriptorAllocation result = makeAllocation(static_cast<uint32>(allocation.offset), count);
+    result.block = allocation.block;
+    return result;
+  }
+
+  void ShaderVisibleDescriptorHeap::freePersistent(const DescriptorAllocation& allocation)
+  {
+    assert(allocation.index < persistent_count);
+    persistent.free(allocation.block);
+  }
+
+  DescriptorAllocation ShaderVisibleDescriptorHeap::allocateTransient(uint32 count)
+  {
+    assert(count > 0);
+    if (count > transient_count)
+    {
+      failed_allocations++;
+      return DescriptorAllocation {};
+    }
+
+    // Tables can't wrap, a table that doesn't fit before the end starts over at the front.
+    uint64 start = head;
+    uint64 offset = start % transient_count;
+    if (offset + count > transient_count)
+    {
+      start += transient_count - offset;
+    }
+
+    if (start + count - tail > transient_count)
+    {
+      failed_allocations++;
+      return DescriptorAllocation {};
+    }
+
+    head = start + count;
+    return makeAllocation(persistent_count + static_cast<uint32>(start % transient_count), count);
+  }
+
+  void ShaderVisibleDescriptorHeap::copy(const DescriptorAllocation& destination, uint32 offset, const CpuDescriptorHandle* sources, uint32 count)
+  {
+    assert(offset + count <= destination.count);
+
+    batch.destination_starts.push_back(destination.getCpuHandle(offset));
+    batch.destination_sizes.push_back(count);
+
+    // Neighbouring sources become one range, views created together usually are.
+    for (uint32 i = 0; i < count; ++i)
+    {
+      if (!batch.source_sizes.empty() && batch.source_starts.back().ptr + uint64(batch.source_sizes.back()) * heap.increment == sources[i].ptr)
+      {
+        batch.source_sizes.back()++;
+      }
+      else
+      {
+        batch.source_starts.push_back(sources[i]);
+        batch.source_sizes.push_back(1);
+      }
+    }
+  }
+
+  DescriptorAllocation ShaderVisibleDescriptorHeap::stageTable(const CpuDescriptorHandle* sources, uint32 count)
+  {
+    DescriptorAllocation table = allocateTransient(count);
+    if (table.isValid())
+    {
+      copy(table, 0, sources, count);
+    }
+    return table;
+  }
+
+  void ShaderVisibleDescriptorHeap::flushCopies()
+  {
+    if (batch.empty())
+    {
+      return;
+    }
+
+    copy_descriptors(type, batch);
+    copy_call_count++;
+    batch.clear();
+  }
+
+  void ShaderVisibleDescriptorHeap::endFrame(uint64 fence_value)
+  {
+    assert(batch.empty() && "Descriptor copies must be flushed before the frame is submitted.");
+
+    if (pending_count == max_pending_frames)
+    {
+      // Retiring the newest frame implies the older one, merging only delays reuse.
+      pending_frames[(first_pending + pending_count - 1) % max_pending_frames] = { fence_value, head };
+      return;
+    }
+
+    pending_frames[(first_pending + pending_count) % max_pending_frames] = { fence_value, head };
+    pending_count++;
+  }
+
+  void ShaderVisibleDescriptorHeap::retire(uint64 completed_fence_value)
+  {
+    while (pending_count > 0 && pending_frames[first_pending].fence_value <= completed_fence_value)
+    {
+      tail = pending_frames[first_pending].head;
+      first_pending = (first_pending + 1) % max_pending_frames;
+      pending_count--;
+    }
+  }
+
+  DescriptorAllocation ShaderVisibleDescriptorHeap::makeAllocation(uint32 index, uint32 count) const
+  {
+    DescriptorAllocation result;
+    result.cpu = CpuDescriptorHandle { heap.cpu_start.ptr + uint64(index) * heap.increment };
+    result.gpu = GpuDescriptorHandle { heap.gpu_start.ptr + uint64(index) * heap.increment };
+    result.index = index;
+    result.count = count;
+    result.increment = heap.increment;
+    return result;
+  }
+
+  void DescriptorAllocator::initialize(CreateDescriptorHeap create_heap, CopyDescriptors copy_descriptors, const Settings& settings)
+  {
+    this->settings = settings;
+    this->create_heap = std::move(create_heap);
+    this->copy_descriptors = std::move(copy_descriptors);
+
+    for (uint32 type = 0; type < 4; ++type)
+    {
+      staging[type].initialize(static_cast<DescriptorHeapType>(type), this->create_heap, settings.staging_heap_capacity);
+    }
+  }
+
+  void DescriptorAllocator::createShaderVisibleHeaps()
+  {
+    DescriptorHeapInfo resources = create_heap(DescriptorHeapDesc { DescriptorHeapType::CbvSrvUav, settings.resource_heap_capacity, true });
+    DescriptorHeapInfo samplers = create_heap(DescriptorHeapDesc { DescriptorHeapType::Sampler, settings.sampler_heap_capacity, true });
+    resource_heap.initialize(DescriptorHeapType::CbvSrvUav, resources, settings.resource_persistent_count, copy_descriptors);
+    sampler_heap.initialize(DescriptorHeapType::Sampler, samplers, settings.sampler_persistent_count, copy_descriptors);
+  }
+
+  void DescriptorAllocator::flushCopies()
+  {
+    resource_heap.flushCopies();
+    sampler_heap.flushCopies();
+  }
+
+  void DescriptorAllocator::endFrame(uint64 fence_value)
+  {
+    resource_heap.endFrame(fence_value);
+    sampler_heap.endFrame(fence_value);
+  }
+
+  void DescriptorAllocator::retire(uint64 completed_fence_value)
+  {
+    resource_heap.retire(completed_fence_value);
+    sampler_heap.retire(completed_fence_value);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include <render/frame_capture.h>
+#include <common/mapped_file.h>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace engine
+{
+  namespace
+  {
+    uint64 getPaddedSize(uint64 size)
+    {
+      return (size + command_stream_alignment - 1) & ~uint64(command_stream_alignment - 1);
+    }
+
+    bool isValidQueue(CommandListType queue)
+    {
+      return queue == CommandListType::Direct || queue == CommandListType::Compute || queue == CommandListType::Copy;
+    }
+
+    // Fixed payload and array element size of every command, as CommandRecorder writes them.
+    bool getCommandLayout(CommandType type, uint32& payload_size, uint32& element_size)
+    {
+      element_size = 0;
+      switch (type)
+      {
+      case CommandType::ResourceBarrier: payload_size = 0; element_size = sizeof(ResourceBarrier); return true;
+      case CommandType::ClearRenderTargetView: payload_size = sizeof(ClearRenderTargetViewCommand); return true;
+      case CommandType::SetRenderTargets: payload_size = sizeof(SetRenderTargetsCommand); element_size = sizeof(CpuDescriptorHandle); return true;
+      case CommandType::SetViewport: payload_size = sizeof(Viewport); return true;
+      case CommandType::SetScissorRect: payload_size = sizeof(ScissorRect); return true;
+      case CommandType::SetPipelineState: payload_size = sizeof(PipelineId); return true;
+      case CommandType::SetGraphicsRootSignature: payload_size = sizeof(RootSignatureId); return true;
+      case CommandType::SetGraphicsRootDescriptorTable: payload_size = sizeof(SetGraphicsRootDescriptorTableCommand); return true;
+      case CommandType::SetGraphicsRoot32BitConstants: payload_size = sizeof(SetGraphicsRoot32BitConstantsCommand); element_size = sizeof(uint32); return true;
+      case CommandType::SetGraphicsRootConstantBufferView: payload_size = sizeof(SetGraphicsRootConstantBufferViewCommand); return true;
+      case CommandType::SetPrimitiveTopology: payload_size = sizeof(PrimitiveTopology); return true;
+      case CommandType::SetVertexBuffers: payload_size = sizeof(SetVertexBuffersCommand); element_size = sizeof(VertexBufferView); return true;
+      case CommandType::SetIndexBuffer: payload_size = sizeof(IndexBufferView); return true;
+      case CommandType::DrawInstanced: payload_size = sizeof(DrawInstancedCommand); return true;
+      case CommandType::DrawIndexedInstanced: payload_size = sizeof(DrawIndexedInstancedCommand); return true;
+      case CommandType::Dispatch: payload_size = sizeof(DispatchCommand); return true;
+      case CommandType::CopyBufferRegion: payload_size = sizeof(CopyBufferRegionCommand); return true;
+      default: return false;
+      }
+    }
+
+    // Every packet has a known type and is as large as its payload and elements, and the last one
+    // ends where the list does.
+    bool isValidCommandList(const uint8* data, uint64 size, uint32& command_count)
+    {
+      uint64 offset = 0;
+      while (offset < size)
+      {
+        CommandHeader header;
+        if (size - offset < sizeof(CommandHeader))
+        {
+          return false;
+        }
+        std::memcpy(&header, data + offset, sizeof(CommandHeader));
+
+        uint32 payload_size, element_size;
+        if (!getCommandLayout(header.type, payload_size, element_size) || header.size != payload_size + uint64(element_size) * header.count)
+        {
+          return false;
+        }
+
+        uint64 packet_size = getPaddedSize(sizeof(CommandHeader) + uint64(header.size));
+        if (packet_size > size - offset)
+        {
+          return false;
+        }
+        offset += packet_size;
+        command_count++;
+      }
+
+      return true;
+    }
+  }
+
+  FrameCapture::Reader::Reader(const FrameCapture& capture)
+    : data(capture.getData())
+    , size(capture.getSize() - capture.getHeader().upload_size)
+    , offset(sizeof(FrameCaptureHeader))
+  {
+  }
+
+  bool FrameCapture::Reader::next(Event& event)
+  {
+    if (offset + sizeof(Event) > size)
+    {
+      return false;
+    }
+
+    std::memcpy(&event, data + offset, sizeof(Event));
+    offset += sizeof(Event);
+    return true;
+  }
+
+  bool FrameCapture::Reader::nextCommandList(const uint8*& list_data, uint64& list_size)
+  {
+    if (offset + sizeof(uint64) > size)
+    {
+      return false;
+    }
+
+    std::memcpy(&list_size, data + offset, sizeof(uint64));
+    if (getPaddedSize(list_size) > size - offset - sizeof(uint64))
+    {
+      return false;
+    }
+
+    list_data = data + offset + sizeof(uint64);
+    offset += sizeof(uint64) + getPaddedSize(list_size);
+    return true;
+  }
+
+  FrameCapture::FrameCapture()
+  {
+    reset(invalid_id, CpuDescriptorHandle {});
+  }
+
+  void FrameCapture::reset(ResourceId back_buffer, CpuDescriptorHandle back_buffer_view)
+  {
+    header = {};
+    std::memcpy(header.magic, FrameCaptureHeader::magic_value, sizeof(header.magic));
+    header.version = FrameCaptureHeader::current_version;
+    header.header_size = sizeof(FrameCaptureHeader);
+    header.back_buffer = back_buffer;
+    header.back_buffer_view = back_buffer_view;
+
+    data.assign(sizeof(FrameCaptureHeader), 0);
+    writeHeader();
+  }
+
+  void FrameCapture::addSubmit(CommandListType queue, const CommandStream* const* streams, uint32 count)
+  {
+    addEvent(Event { EventType::Submit, queue, queue, 0, count, 0 });
+    for (uint32 i = 0; i < count; ++i)
+    {
+      uint64 size = streams[i]->getSize();
+      uint64 offset = data.size();
+      // Streams are padded already, resize zeroes what a partial last packet would leave.
+      data.resize(offset + sizeof(uint64) + getPaddedSize(size));
+      std::memcpy(data.data() + offset, &size, sizeof(uint64));
+      if (size > 0)
+      {
+        std::memcpy(data.data() + offset + sizeof(uint64), streams[i]->getData(), size);
+      }
+      header.command_count += streams[i]->getCommandCount();
+    }
+
+    header.command_list_count += count;
+    writeHeader();
+  }
+
+  void FrameCapture::addSignal(CommandListType queue, uint64 value)
+  {
+    addEvent(Event { EventType::Signal, queue, queue, 0, 0, value });
+    writeHeader();
+  }
+
+  void FrameCapture::addWait(CommandListType queue, CommandListType signaled_queue, uint64 value)
+  {
+    addEvent(Event { EventType::Wait, queue, signaled_queue, 0, 0, value });
+    writeHeader();
+  }
+
+  uint8* FrameCapture::addUploads(const UploadMemory& memory, uint64 offset, uint64 size)
+  {
+    assert(header.upload_size == 0 && "Uploads end the capture.");
+
+    header.upload_resource = memory.resource;
+    header.upload_address = memory.gpu_address;
+    header.upload_buffer_size = memory.size;
+    header.upload_offset = offset;
+    header.upload_size = size;
+    writeHeader();
+
+    data.resize(data.size() + size);
+    return data.data() + data.size() - size;
+  }
+
+  UploadRemap FrameCapture::getUploadRemap() const
+  {
+    UploadRemap remap;
+    remap.resource = header.upload_resource;
+    remap.address = header.upload_address;
+    remap.buffer_size = header.upload_buffer_size;
+    remap.offset = header.upload_offset;
+    remap.size = header.upload_size;
+    return remap;
+  }
+
+  bool FrameCapture::save(const std::string& path) const
+  {
+    std::ofstream file_stream(path, std::ios::binary | std::ios::trunc);
+    file_stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file_stream.flush());
+  }
+
+  bool FrameCapture::load(const std::string& path)
+  {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::Read))
+    {
+      return false;
+    }
+
+    return load(file.data(), file.size());
+  }
+
+  bool FrameCapture::load(const uint8* source, uint64 size)
+  {
+    FrameCaptureHeader loaded;
+    if (size < sizeof(loaded))
+    {
+      return false;
+    }
+
+    std::memcpy(&loaded, source, sizeof(loaded));
+    if (std::memcmp(loaded.magic, FrameCaptureHeader::magic_value, sizeof(loaded.magic)) != 0 || loaded.version != FrameCaptureHeader::current_version
+      || loaded.header_size != sizeof(FrameCaptureHeader))
+    {
+      return false;
+    }
+
+    // The upload range follows the events and lies within a power of two sized buffer.
+    if (loaded.upload_size > size - sizeof(loaded) || loaded.upload_size > loaded.upload_buffer_size
+      || (loaded.upload_buffer_size & (loaded.upload_buffer_size - 1)) != 0 || (loaded.upload_size > 0 && loaded.upload_offset >= loaded.upload_buffer_size))
+    {
+      return false;
+    }
+    const uint64 events_size = size - loaded.upload_size;
+
+    // Walks every event, list and command once, so replaying can trust the capture afterwards.
+    uint64 offset = sizeof(FrameCaptureHeader);
+    uint32 event_count = 0;
+    uint32 list_count = 0;
+    uint32 command_count = 0;
+    while (offset < events_size)
+    {
+      Event event;
+      if (offset + sizeof(Event) > events_size)
+      {
+        return false;
+      }
+      std::memcpy(&event, source + offset, sizeof(Event));
+      offset += sizeof(Event);
+      event_count++;
+
+      if (event.type > EventType::Wait || !isValidQueue(event.queue) || !isValidQueue(event.signaled_queue))
+      {
+        return false;
+      }
+      for (uint32 i = 0; event.type == EventType::Submit && i < event.list_count; ++i)
+      {
+        uint64 list_size;
+        if (offset + sizeof(uint64) > events_size)
+        {
+          return false;
+        }
+        std::memcpy(&list_size, source + offset, sizeof(uint64));
+        if (list_size > events_size - offset - sizeof(uint64) || getPaddedSize(list_size) > events_size - offset - sizeof(uint64))
+        {
+          return false;
+        }
+        if (!isValidCommandList(source + offset + sizeof(uint64), list_size, command_count))
+        {
+          return false;
+        }
+        offset += sizeof(uint64) + getPaddedSize(list_size);
+        list_count++;
+      }
+    }
+
+    if (event_count != loaded.event_count || list_count != loaded.command_list_count || command_count != loaded.command_count)
+    {
+      return false;
+    }
+
+    header = loaded;
+    data.assign(source, source + size);
+    return true;
+  }
+
+  void FrameCapture::addEvent(const Event& event)
+  {
+    assert(header.upload_size == 0 && "Uploads end the capture.");
+
+    uint64 offset = data.size();
+    data.resize(offset + sizeof(Event));
+    std::memcpy(data.data() + offset, &event, sizeof(Event));
+    header.event_count++;
+  }
+
+  void FrameCapture::writeHeader()
+  {
+    std::memcpy(data.data(), &header, sizeof(FrameCaptureHeader));
+  }
+
+  void CaptureCommandList::reset(CommandList& target)
+  {
+    assert(target.getType() == getType());
+    this->target = &target;
+    CommandRecorder::reset(&stream);
+  }
+
+  void CaptureCommandList::close()
+  {
+    CommandRecorder::close();
+    replayer.replay(stream.getData(), stream.getSize(), *target);
+    target->close();
+  }
+}
\ No newline at end of file
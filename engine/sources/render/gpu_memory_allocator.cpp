@@ -0,0 +1,254 @@
+#include <render/gpu_memory_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  void GpuMemoryAllocator::initialize(CreateHeap create_heap, DestroyHeap destroy_heap, uint64 heap_size)
+  {
+    assert(heap_size % msaa_placement_alignment == 0);
+
+    this->create_heap = std::move(create_heap);
+    this->destroy_heap = std::move(destroy_heap);
+    this->heap_size = heap_size;
+
+    const HeapType types[] = { HeapType::Default, HeapType::Upload, HeapType::Readback };
+    const HeapUsage usages[] = { HeapUsage::Buffers, HeapUsage::Textures, HeapUsage::RenderTargets };
+    for (HeapType type : types)
+    {
+      for (HeapUsage usage : usages)
+      {
+        pools[getPoolIndex(type, usage)].type = type;
+        pools[getPoolIndex(type, usage)].usage = usage;
+      }
+    }
+  }
+
+  void GpuMemoryAllocator::shutdown()
+  {
+    for (Pool& pool : pools)
+    {
+      for (const auto& heap : pool.heaps)
+      {
+        destroy_heap(heap->id);
+      }
+      pool.heaps.clear();
+    }
+    records.clear();
+  }
+
+  GpuAllocation GpuMemoryAllocator::allocate(HeapType type, HeapUsage usage, uint64 size, uint64 alignment)
+  {
+    assert(isPowerOfTwo(alignment));
+
+    uint32 pool_index = getPoolIndex(type, usage);
+    Pool& pool = pools[pool_index];
+    // Only render target heaps may hold MSAA textures, they are the only ones that need 4 MB.
+    uint64 pool_alignment = usage == HeapUsage::RenderTargets ? msaa_placement_alignment : default_placement_alignment;
+
+    // What the TLSF of a shared heap searches for, aligning may skip up to alignment - granularity.
+    uint64 search_size = alignUp(size, alignment) + std::max(alignment, default_placement_alignment) - default_placement_alignment;
+
+    Heap* heap = nullptr;
+    TlsfAllocator::Allocation allocation;
+    if (search_size > heap_size || alignment > pool_alignment)
+    {
+      // The only block starts at 0, a granularity of the alignment makes the exact size fit.
+      uint64 granularity = std::max(alignment, default_placement_alignment);
+      heap = createHeap(pool_index, alignUp(size, granularity), std::max(alignment, pool_alignment), granularity, true);
+      allocation = heap ? heap->allocator.allocate(size, alignment) : allocation;
+    }
+    else
+    {
+      for (const auto& candidate : pool.heaps)
+      {
+        if (!candidate->dedicated)
+        {
+          allocation = candidate->allocator.allocate(size, alignment);
+          if (allocation.isValid())
+          {
+            heap = candidate.get();
+            break;
+          }
+        }
+      }
+
+      if (!allocation.isValid())
+      {
+        heap = createHeap(pool_index, heap_size, pool_alignment, default_placement_alignment, false);
+        allocation = heap ? heap->allocator.allocate(size, alignment) : allocation;
+      }
+    }
+
+    if (!allocation.isValid())
+    {
+      // Only a heap created for this allocation can be empty here.
+      if (heap && heap->allocator.isEmpty())
+      {
+        destroyHeap(pool_index, heap);
+      }
+      return GpuAllocation {};
+    }
+
+    GpuHeapRange range { heap->id, allocation.offset, heap->allocator.getSize(allocation.block) };
+    return records.create(Record { heap, pool_index, allocation.block, alignment, range });
+  }
+
+  void GpuMemoryAllocator::free(GpuAllocation allocation)
+  {
+    Record* record = records.get(allocation);
+    if (!record)
+    {
+      return;
+    }
+
+    freeBlock(record->pool, record->heap, record->block);
+    records.destroy(allocation);
+  }
+
+  const GpuHeapRange* GpuMemoryAllocator::getRange(GpuAllocation allocation) const
+  {
+    const Record* record = records.get(allocation);
+    return record ? &record->range : nullptr;
+  }
+
+  std::vector<GpuAllocationMove> GpuMemoryAllocator::beginDefragmentation(HeapType type, HeapUsage usage, uint64 max_bytes)
+  {
+    uint32 pool_index = getPoolIndex(type, usage);
+    std::vector<Heap*> heaps;
+    for (const auto& heap : pools[pool_index].heaps)
+    {
+      if (!heap->dedicated)
+      {
+        heaps.push_back(heap.get());
+      }
+    }
+    std::sort(heaps.begin(), heaps.end(), [](const Heap* a, const Heap* b) { return a->allocator.getUsed() < b->allocator.getUsed(); });
+
+    // The least used heaps are emptied into the fuller ones, a heap is only touched when the
+    // heaps after it have room for all of it.
+    std::vector<GpuAllocationMove> moves;
+    uint64 moved = 0;
+    for (size_t source_index = 0; source_index + 1 < heaps.size(); ++source_index)
+    {
+      Heap* source = heaps[source_index];
+      uint64 free_space = 0;
+      for (size_t i = source_index + 1; i < heaps.size(); ++i)
+      {
+        free_space += heaps[i]->allocator.getCapacity() - heaps[i]->allocator.getUsed();
+      }
+      if (source->allocator.getUsed() > free_space || moved + source->allocator.getUsed() > max_bytes)
+      {
+        break;
+      }
+
+      for (uint32 index = 0; index < records.size(); ++index)
+      {
+        Record& record = records[index];
+        if (record.heap != source)
+        {
+          continue;
+        }
+
+        for (size_t i = heaps.size() - 1; i > source_index; --i)
+        {
+          TlsfAllocator::Allocation allocation = heaps[i]->allocator.allocate(record.range.size, record.alignment);
+          if (allocation.isValid())
+          {
+            GpuHeapRange destination { heaps[i]->id, allocation.offset, heaps[i]->allocator.getSize(allocation.block) };
+            moves.push_back({ records.getHandle(index), record.range, destination, record.block });
+            moved += record.range.size;
+
+            record.heap = heaps[i];
+            record.block = allocation.block;
+            record.range = destination;
+            break;
+          }
+        }
+      }
+    }
+
+    return moves;
+  }
+
+  void GpuMemoryAllocator::endDefragmentation(const std::vector<GpuAllocationMove>& moves)
+  {
+    for (const GpuAllocationMove& move : moves)
+    {
+      uint32 pool_index = 0;
+      Heap* heap = findHeap(move.source.heap, pool_index);
+      assert(heap && "Heap of a pending move was released.");
+      freeBlock(pool_index, heap, move.source_block);
+    }
+  }
+
+  GpuMemoryAllocator::PoolStats GpuMemoryAllocator::getPoolStats(HeapType type, HeapUsage usage) const
+  {
+    PoolStats stats;
+    for (const auto& heap : pools[getPoolIndex(type, usage)].heaps)
+    {
+      stats.heap_count++;
+      stats.allocation_count += heap->allocator.getAllocationCount();
+      stats.capacity += heap->allocator.getCapacity();
+      stats.used += heap->allocator.getUsed();
+      stats.largest_free_block = std::max(stats.largest_free_block, heap->allocator.getLargestFreeBlock());
+    }
+    return stats;
+  }
+
+  GpuMemoryAllocator::Heap* GpuMemoryAllocator::createHeap(uint32 pool_index, uint64 size, uint64 alignment, uint64 granularity, bool dedicated)
+  {
+    Pool& pool = pools[pool_index];
+    HeapDesc desc { pool.type, pool.usage, size, alignment };
+    HeapId id = create_heap(desc);
+    if (id == invalid_id)
+    {
+      return nullptr;
+    }
+
+    pool.heaps.push_back(std::make_unique<Heap>(Heap { id, TlsfAllocator(size, granularity), alignment, dedicated }));
+    return pool.heaps.back().get();
+  }
+
+  GpuMemoryAllocator::Heap* GpuMemoryAllocator::findHeap(HeapId id, uint32& pool_index)
+  {
+    for (pool_index = 0; pool_index < pool_count; ++pool_index)
+    {
+      for (const auto& heap : pools[pool_index].heaps)
+      {
+        if (heap->id == id)
+        {
+          return heap.get();
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  void GpuMemoryAllocator::freeBlock(uint32 pool_index, Heap* heap, uint32 block)
+  {
+    heap->allocator.free(block);
+    if (!heap->allocator.isEmpty())
+    {
+      return;
+    }
+
+    // One empty heap per pool stays around, so a pool that empties and refills doesn't thrash.
+    Pool& pool = pools[pool_index];
+    bool keep = !heap->dedicated && std::count_if(pool.heaps.begin(), pool.heaps.end(), [](const auto& other) { return !other->dedicated; }) == 1;
+    if (keep)
+    {
+      return;
+    }
+
+    destroyHeap(pool_index, heap);
+  }
+
+  void GpuMemoryAllocator::destroyHeap(uint32 pool_index, Heap* heap)
+  {
+    Pool& pool = pools[pool_index];
+    destroy_heap(heap->id);
+    pool.heaps.erase(std::find_if(pool.heaps.begin(), pool.heaps.end(), [heap](const auto& other) { return other.get() == heap; }));
+  }
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <render/null_device_resources.h>
+#include <common/math.h>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace engine
+{
+  NullDeviceResources::NullDeviceResources()
+    : NullDeviceResources(Settings {})
+  {
+  }
+
+  NullDeviceResources::NullDeviceResources(const Settings& settings)
+    : settings(settings)
+    , command_list(CommandListType::Direct)
+  {
+  }
+
+  void NullDeviceResources::createDeviceResources([[maybe_unused]] const SurfaceDesc& surface)
+  {
+    swap_chain_index = 0;
+    for (Queue& queue : queues)
+    {
+      queue.gpu_idle_time = Timer::Clock::now();
+    }
+  }
+
+  void NullDeviceResources::resizeFrameResources(uint32 frame_count)
+  {
+    command_allocators.resize(frame_count);
+  }
+
+  uint64 NullDeviceResources::getAllocatorGrowthCount() const
+  {
+    uint64 growth_count = 0;
+    for (const CommandStream& allocator : command_allocators)
+    {
+      growth_count += allocator.getGrowthCount();
+    }
+
+    return growth_count;
+  }
+
+  uint64 NullDeviceResources::getPeakAllocatorSize() const
+  {
+    uint64 peak_size = 0;
+    for (const CommandStream& allocator : command_allocators)
+    {
+      peak_size = std::max(peak_size, allocator.getCapacity());
+    }
+
+    return peak_size;
+  }
+
+  CommandList& NullDeviceResources::resetCommandList(uint32 frame_index)
+  {
+    command_list.reset(&command_allocators[frame_index]);
+    return command_list;
+  }
+
+  void NullDeviceResources::executeCommandLists(CommandListType queue, CommandList* const* command_lists, uint32 count)
+  {
+    auto gpu_time = settings.gpu_time_per_submit;
+    for (uint32 i = 0; i < count; ++i)
+    {
+      const NullCommandList* list = static_cast<const NullCommandList*>(command_lists[i]);
+      assert(!list->isOpen() && "Command list must be closed before execution.");
+      assert((queue == CommandListType::Direct || list->getType() == queue) && "List type doesn't match the queue.");
+
+      const CommandStream* stream = list->getStream();
+      gpu_time += settings.gpu_time_per_command * stream->getCommandCount();
+      stats.commands += stream->getCommandCount();
+      stats.bytes_recorded += stream->getSize();
+    }
+
+    Queue& target = queues[getQueueIndex(queue)];
+    auto start_time = std::max(Timer::Clock::now(), target.gpu_idle_time);
+    target.gpu_idle_time = start_time + gpu_time;
+    stats.queue_busy_time[getQueueIndex(queue)] += std::chrono::duration_cast<std::chrono::nanoseconds>(gpu_time);
+    stats.submits++;
+    stats.command_lists += count;
+  }
+
+  void NullDeviceResources::signalQueue(CommandListType queue, uint64 value)
+  {
+    Queue& target = queues[getQueueIndex(queue)];
+    target.pending_signals.push_back({ value, target.gpu_idle_time });
+  }
+
+  uint64 NullDeviceResources::getCompletedFenceValue(CommandListType queue)
+  {
+    Queue& target = queues[getQueueIndex(queue)];
+    retireSignals(target, Timer::Clock::now());
+    return target.completed_fence_value;
+  }
+
+  void NullDeviceResources::waitForQueue(CommandListType queue, CommandListType signaled_queue, uint64 value)
+  {
+    Queue& signaled = queues[getQueueIndex(signaled_queue)];
+    retireSignals(signaled, Timer::Clock::now());
+    stats.queue_waits++;
+    if (signaled.completed_fence_value >= value)
+    {
+      return;
+    }
+
+    auto signal = std::find_if(signaled.pending_signals.begin(), signaled.pending_signals.end(), [value](const PendingSignal& pending) { return pending.value >= value; });
+    assert(signal != signaled.pending_signals.end() && "Waiting for a fence value that was never signaled.");
+
+    Queue& waiting = queues[getQueueIndex(queue)];
+    waiting.gpu_idle_time = std::max(waiting.gpu_idle_time, signal->completion_time);
+  }
+
+  void NullDeviceResources::waitForFenceValue(uint64 value)
+  {
+    Queue& direct = queues[getQueueIndex(CommandListType::Direct)];
+    auto now = Timer::Clock::now();
+    retireSignals(direct, now);
+    if (direct.completed_fence_value >= value)
+    {
+      return;
+    }
+
+    auto signal = std::find_if(direct.pending_signals.begin(), direct.pending_signals.end(), [value](const PendingSignal& pending) { return pending.value >= value; });
+    assert(signal != direct.pending_signals.end() && "Waiting for a fence value that was never signaled.");
+
+    std::this_thread::sleep_until(signal->completion_time);
+
+    auto wake_time = Timer::Clock::now();
+    stats.fence_waits++;
+    stats.fence_wait_time += std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - now);
+    retireSignals(direct, std::max(wake_time, signal->completion_time));
+  }
+
+  bool NullDeviceResources::waitForFrameLatencyObject(uint32 timeout_milliseconds)
+  {
+    // Like DXGI: signaled while fewer than max_frame_latency presented frames are queued on the GPU.
+    uint64 value = fence_timeline.getFrameLatencyValue(max_frame_latency);
+    if (timeout_milliseconds == 0)
+    {
+      return getCompletedFenceValue(CommandListType::Direct) >= value;
+    }
+
+    waitForFenceValue(value);
+    return true;
+  }
+
+  UploadMemory NullDeviceResources::createUploadMemory(uint64 size)
+  {
+    // Aligned like a D3D12 buffer, so alignment within the buffer carries over to the pointer.
+    upload_memory.resize(size + UploadRing::max_alignment);
+    uintptr_t address = alignUp(reinterpret_cast<uintptr_t>(upload_memory.data()), static_cast<uintptr_t>(UploadRing::max_alignment));
+
+    // Ids below max_swap_chain_buffers are back buffers.
+    UploadMemory memory;
+    memory.cpu_address = reinterpret_cast<uint8*>(address);
+    memory.gpu_address = 0x100000000ull;
+    memory.resource = max_swap_chain_buffers;
+    memory.size = size;
+    return memory;
+  }
+
+  HeapId NullDeviceResources::createHeap([[maybe_unused]] const HeapDesc& desc)
+  {
+    // Heaps have no memory behind them, placed resources are never touched by the CPU.
+    heap_count++;
+    return next_heap_id++;
+  }
+
+  void NullDeviceResources::destroyHeap([[maybe_unused]] HeapId heap)
+  {
+    assert(heap < next_heap_id && heap_count > 0);
+    heap_count--;
+  }
+
+  DescriptorHeapInfo NullDeviceResources::createDescriptorHeap(const DescriptorHeapDesc& desc)
+  {
+    // Every heap gets its own 4 GB of fake addresses, handles are never dereferenced.
+    DescriptorHeapInfo info;
+    info.id = next_descriptor_heap_id++;
+    info.cpu_start = CpuDescriptorHandle { uint64(info.id + 1) << 32 };
+    info.gpu_start = GpuDescriptorHandle { desc.shader_visible ? info.cpu_start.ptr : 0 };
+    info.increment = 32;
+    info.capacity = desc.capacity;
+    return info;
+  }
+
+  void NullDeviceResources::copyDescriptors([[maybe_unused]] DescriptorHeapType type, const DescriptorCopyBatch& batch)
+  {
+    stats.descriptor_copy_calls++;
+    for (uint32 size : batch.destination_sizes)
+    {
+      stats.descriptors_copied += size;
+    }
+  }
+
+  void NullDeviceResources::present([[maybe_unused]] uint32 sync_interval, [[maybe_unused]] bool allow_tearing)
+  {
+    swap_chain_index = (swap_chain_index + 1) % swap_chain_buffer_count;
+    stats.frames++;
+  }
+
+  void NullDeviceResources::resizeSwapChain([[maybe_unused]] uint32 width, [[maybe_unused]] uint32 height)
+  {
+    swap_chain_index = 0;
+  }
+
+  void NullDeviceResources::retireSignals(Queue& queue, Timer::Clock::time_point now)
+  {
+    auto retired = queue.pending_signals.begin();
+    while (retired != queue.pending_signals.end() && retired->completion_time <= now)
+    {
+      queue.completed_fence_value = retired->value;
+      ++retired;
+    }
+
+    queue.pending_signals.erase(queue.pending_signals.begin(), retired);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,802 @@
+#include <render/render_graph.h>
+#include <common/log.h>
+#include <common/math.h>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace engine
+{
+  RenderGraphResource RenderGraphPassBuilder::read(RenderGraphResource resource, ResourceState state)
+  {
+    graph.addAccess(pass, resource.version, state, false);
+    return resource;
+  }
+
+  RenderGraphResource RenderGraphPassBuilder::write(RenderGraphResource resource, ResourceState state)
+  {
+    return RenderGraphResource { graph.addAccess(pass, resource.version, state, true) };
+  }
+
+  RenderGraphPassBuilder& RenderGraphPassBuilder::setSideEffects()
+  {
+    graph.passes[pass].side_effects = true;
+    return *this;
+  }
+
+  RenderGraphPassBuilder& RenderGraphPassBuilder::setQueue(CommandListType queue)
+  {
+    graph.passes[pass].queue = queue;
+    return *this;
+  }
+
+  void RenderGraph::reset()
+  {
+    resources.clear();
+    versions.clear();
+    accesses.clear();
+    passes.clear();
+    schedule.clear();
+    barriers.clear();
+    final_barrier_begin = 0;
+    final_barrier_count = 0;
+    stats = {};
+  }
+
+  RenderGraphResource RenderGraph::createResource(const char* name, const TransientResourceDesc& desc)
+  {
+    assert(desc.size > 0 && isPowerOfTwo(desc.alignment));
+    return addResource(name, desc, invalid_id, ResourceState::Common, ResourceState::Common, false);
+  }
+
+  RenderGraphResource RenderGraph::importResource(const char* name, ResourceId resource, ResourceState state, ResourceState final_state)
+  {
+    return addResource(name, TransientResourceDesc {}, resource, state, final_state, true);
+  }
+
+  RenderGraphPassBuilder RenderGraph::addPass(const char* name, ExecuteFunction execute)
+  {
+    uint32 pass = static_cast<uint32>(passes.size());
+    passes.push_back(Pass { name, std::move(execute), static_cast<uint32>(accesses.size()), 0, CommandListType::Direct, false, false, invalid_id, 0, 0, false, invalid_id });
+    return RenderGraphPassBuilder(*this, pass);
+  }
+
+  bool RenderGraph::compile()
+  {
+    Stats previous = stats;
+    stats = {};
+    stats.passes = static_cast<uint32>(passes.size());
+
+    cull();
+    if (!sortPasses())
+    {
+      stats = previous;
+      return false;
+    }
+    computeLifetimes();
+    placeResources();
+    computeBarriers();
+    buildBatches();
+    return true;
+  }
+
+  void RenderGraph::realize(const RealizeFunction& realize)
+  {
+    for (Resource& resource : resources)
+    {
+      if (!resource.imported && resource.first != invalid_id)
+      {
+        resource.physical = realize(resource.name, resource.desc, resource.initial_state, resource.offset);
+      }
+    }
+  }
+
+  void RenderGraph::execute(CommandList& command_list)
+  {
+    for (const Unit& unit : units)
+    {
+      recordUnit(command_list, unit);
+    }
+  }
+
+  void RenderGraph::execute(RenderGraphQueues& queues)
+  {
+    batch_values.assign(batches.size(), 0);
+    for (uint32 index = 0; index < batches.size(); ++index)
+    {
+      const Batch& batch = batches[index];
+      for (uint32 i = batch.wait_begin; i < batch.wait_begin + batch.wait_count; ++i)
+      {
+        const Unit& signaled = units[waits[i]];
+        queues.wait(batch.queue, signaled.queue, batch_values[signaled.batch]);
+      }
+
+      CommandList& command_list = queues.acquireCommandList(batch.queue);
+      for (uint32 i = batch.unit_begin; i < batch.unit_begin + batch.unit_count; ++i)
+      {
+        recordUnit(command_list, units[batch_units[i]]);
+      }
+      batch_values[index] = queues.submit(batch.queue, command_list, batch.signal);
+    }
+  }
+
+  ResourceId RenderGraph::getResource(RenderGraphResource resource) const
+  {
+    return resources[versions[resource.version].resource].physical;
+  }
+
+  uint64 RenderGraph::getHeapOffset(RenderGraphResource resource) const
+  {
+    return resources[versions[resource.version].resource].offset;
+  }
+
+  const ResourceBarrier* RenderGraph::getPassBarriers(uint32 pass, uint32& count) const
+  {
+    count = passes[pass].barrier_count;
+    return barriers.data() + passes[pass].barrier_begin;
+  }
+
+  RenderGraphResource RenderGraph::addResource(const char* name, const TransientResourceDesc& desc, ResourceId physical, ResourceState state, ResourceState final_state, bool imported)
+  {
+    uint32 resource = static_cast<uint32>(resources.size());
+    uint32 version = static_cast<uint32>(versions.size());
+    resources.push_back(Resource { name, desc, physical, state, final_state, imported, false, version, invalid_id, invalid_id, 0, TlsfAllocator::invalid_block, false, invalid_id });
+    versions.push_back(Version { resource, invalid_id, invalid_id, 0, 0 });
+    return RenderGraphResource { version };
+  }
+
+  uint32 RenderGraph::addAccess(uint32 pass, uint32 version, ResourceState state, bool write)
+  {
+    assert(version < versions.size());
+    assert(pass + 1 == passes.size() && "Declare accesses right after adding the pass.");
+
+    uint32 resource = versions[version].resource;
+    if (write)
+    {
+      assert(resources[resource].latest_version == version && "Writes must go to the latest version.");
+      uint32 next = static_cast<uint32>(versions.size());
+      versions.push_back(Version { resource, pass, version, 0, 0 });
+      resources[resource].latest_version = next;
+      version = next;
+    }
+
+    accesses.push_back(Access { pass, resource, version, state, write, invalid_id });
+    passes[pass].access_count++;
+    return version;
+  }
+
+  void RenderGraph::cull()
+  {
+    // Everything reachable from passes with side effects and from the writers of imported resources.
+    stack.clear();
+    for (uint32 pass = 0; pass < passes.size(); ++pass)
+    {
+      passes[pass].live = passes[pass].side_effects;
+      passes[pass].position = invalid_id;
+      if (passes[pass].live)
+      {
+        stack.push_back(pass);
+      }
+    }
+    for (const Resource& resource : resources)
+    {
+      uint32 producer = versions[resource.latest_version].producer;
+      if (resource.imported && producer != invalid_id && !passes[producer].live)
+      {
+        passes[producer].live = true;
+        stack.push_back(producer);
+      }
+    }
+
+    while (!stack.empty())
+    {
+      const Pass& pass = passes[stack.back()];
+      stack.pop_back();
+      for (uint32 i = pass.first_access; i < pass.first_access + pass.access_count; ++i)
+      {
+        // A write modifies the version before it.
+        const Access& access = accesses[i];
+        uint32 dependency = access.write ? versions[access.version].previous : access.version;
+        uint32 producer = versions[dependency].producer;
+        if (producer != invalid_id && !passes[producer].live)
+        {
+          passes[producer].live = true;
+          stack.push_back(producer);
+        }
+      }
+    }
+
+    for (const Pass& pass : passes)
+    {
+      stats.culled_passes += !pass.live;
+    }
+  }
+
+  bool RenderGraph::sortPasses()
+  {
+    // Readers of every version, a write has to wait for the readers of the version it modifies.
+    for (Version& version : versions)
+    {
+      version.reader_count = 0;
+    }
+    for (const Access& access : accesses)
+    {
+      if (!access.write && passes[access.pass].live)
+      {
+        versions[access.version].reader_count++;
+      }
+    }
+    uint32 reader_total = 0;
+    for (Version& version : versions)
+    {
+      version.reader_begin = reader_total;
+      reader_total += version.reader_count;
+      version.reader_count = 0;
+    }
+    readers.resize(reader_total);
+    for (const Access& access : accesses)
+    {
+      if (!access.write && passes[access.pass].live)
+      {
+        Version& version = versions[access.version];
+        readers[version.reader_begin + version.reader_count++] = access.pass;
+      }
+    }
+
+    // Edges as (from, to) pairs, then grouped by the pass they start from.
+    edges.clear();
+    for (const Access& access : accesses)
+    {
+      if (!passes[access.pass].live)
+      {
+        continue;
+      }
+
+      uint32 dependency = access.write ? versions[access.version].previous : access.version;
+      uint32 producer = versions[dependency].producer;
+      if (producer != invalid_id && producer != access.pass)
+      {
+        edges.push_back(producer);
+        edges.push_back(access.pass);
+      }
+      if (access.write)
+      {
+        const Version& modified = versions[dependency];
+        for (uint32 i = modified.reader_begin; i < modified.reader_begin + modified.reader_count; ++i)
+        {
+          if (readers[i] != access.pass)
+          {
+            edges.push_back(readers[i]);
+            edges.push_back(access.pass);
+          }
+        }
+      }
+    }
+
+    uint32 pass_count = static_cast<uint32>(passes.size());
+    successor_begin.assign(pass_count + 1, 0);
+    in_degree.assign(pass_count, 0);
+    for (uint32 i = 0; i < edges.size(); i += 2)
+    {
+      successor_begin[edges[i] + 1]++;
+      in_degree[edges[i + 1]]++;
+    }
+    for (uint32 pass = 0; pass < pass_count; ++pass)
+    {
+      successor_begin[pass + 1] += successor_begin[pass];
+    }
+    successors.resize(edges.size() / 2);
+    stack.assign(successor_begin.begin(), successor_begin.end() - 1);
+    for (uint32 i = 0; i < edges.size(); i += 2)
+    {
+      successors[stack[edges[i]]++] = edges[i + 1];
+    }
+
+    // Kahn's algorithm, ready passes run in the order they were added.
+    schedule.clear();
+    ready.clear();
+    uint32 live_count = 0;
+    for (uint32 pass = 0; pass < pass_count; ++pass)
+    {
+      if (passes[pass].live)
+      {
+        live_count++;
+        if (in_degree[pass] == 0)
+        {
+          ready.push_back(pass);
+        }
+      }
+    }
+    std::make_heap(ready.begin(), ready.end(), std::greater<uint32>());
+    while (!ready.empty())
+    {
+      std::pop_heap(ready.begin(), ready.end(), std::greater<uint32>());
+      uint32 pass = ready.back();
+      ready.pop_back();
+
+      passes[pass].position = static_cast<uint32>(schedule.size());
+      schedule.push_back(pass);
+      for (uint32 i = successor_begin[pass]; i < successor_begin[pass + 1]; ++i)
+      {
+        if (--in_degree[successors[i]] == 0)
+        {
+          ready.push_back(successors[i]);
+          std::push_heap(ready.begin(), ready.end(), std::greater<uint32>());
+        }
+      }
+    }
+
+    if (schedule.size() != live_count)
+    {
+      Log::error("Render graph passes depend on each other in a cycle.\n");
+      schedule.clear();
+      return false;
+    }
+    return true;
+  }
+
+  void RenderGraph::computeLifetimes()
+  {
+    for (Resource& resource : resources)
+    {
+      resource.first = invalid_id;
+      resource.last = invalid_id;
+      resource.async = false;
+    }
+
+    // Walks backwards so every access learns the next use of its resource.
+    last_use.assign(resources.size(), invalid_id);
+    for (uint32 position = static_cast<uint32>(schedule.size()); position-- > 0;)
+    {
+      const Pass& pass = passes[schedule[position]];
+      uint32 end = pass.first_access + pass.access_count;
+      for (uint32 i = pass.first_access; i < end; ++i)
+      {
+        Access& access = accesses[i];
+        Resource& resource = resources[access.resource];
+        access.next = last_use[access.resource];
+        resource.async = resource.async || pass.queue != CommandListType::Direct;
+        resource.first = position;
+        if (resource.last == invalid_id)
+        {
+          resource.last = position;
+        }
+      }
+      for (uint32 i = pass.first_access; i < end; ++i)
+      {
+        last_use[accesses[i].resource] = i;
+      }
+    }
+  }
+
+  void RenderGraph::placeResources()
+  {
+    // Transients grouped by the position of their first and last use. The async queues run beside
+    // the graphics queue, what they use can't share memory.
+    uint32 position_count = static_cast<uint32>(schedule.size());
+    first_use_begin.assign(position_count + 1, 0);
+    last_use_begin.assign(position_count + 1, 0);
+    uint64 capacities[heap_usage_count] = {};
+    for (const Resource& resource : resources)
+    {
+      if (!resource.imported && resource.first != invalid_id)
+      {
+        first_use_begin[getPlacementFirst(resource) + 1]++;
+        last_use_begin[getPlacementLast(resource) + 1]++;
+        capacities[static_cast<uint32>(resource.desc.usage)] += alignUp(resource.desc.size, placement_granularity) + resource.desc.alignment;
+        stats.transient_resources++;
+        stats.transient_size += resource.desc.size;
+      }
+    }
+    for (uint32 position = 0; position < position_count; ++position)
+    {
+      first_use_begin[position + 1] += first_use_begin[position];
+      last_use_begin[position + 1] += last_use_begin[position];
+    }
+    first_uses.resize(stats.transient_resources);
+    last_uses.resize(stats.transient_resources);
+    stack.assign(first_use_begin.begin(), first_use_begin.end());
+    ready.assign(last_use_begin.begin(), last_use_begin.end());
+    for (uint32 index = 0; index < resources.size(); ++index)
+    {
+      const Resource& resource = resources[index];
+      if (!resource.imported && resource.first != invalid_id)
+      {
+        first_uses[stack[getPlacementFirst(resource)]++] = index;
+        last_uses[ready[getPlacementLast(resource)]++] = index;
+      }
+    }
+
+    for (uint32 usage = 0; usage < heap_usage_count; ++usage)
+    {
+      freed[usage].clear();
+      if (capacities[usage] > 0)
+      {
+        allocators[usage].reset(capacities[usage], placement_granularity);
+      }
+    }
+
+    for (uint32 position = 0; position < position_count; ++position)
+    {
+      for (uint32 i = first_use_begin[position]; i < first_use_begin[position + 1]; ++i)
+      {
+        Resource& resource = resources[first_uses[i]];
+        uint32 usage = static_cast<uint32>(resource.desc.usage);
+        TlsfAllocator::Allocation allocation = allocators[usage].allocate(resource.desc.size, resource.desc.alignment);
+        assert(allocation.isValid() && "Transient heap capacity covers every resource.");
+        resource.offset = allocation.offset;
+        resource.block = allocation.block;
+        stats.heap_sizes[usage] = std::max(stats.heap_sizes[usage], resource.offset + resource.desc.size);
+
+        // Memory last used by transients that are done gets an aliasing barrier, ranges the new
+        // resource covers completely need no barrier again.
+        uint64 begin = resource.offset;
+        uint64 end = resource.offset + resource.desc.size;
+        resource.needs_aliasing = false;
+        resource.aliased = invalid_id;
+        std::vector<FreedRange>& ranges = freed[usage];
+        for (uint32 range = 0; range < ranges.size();)
+        {
+          if (ranges[range].begin >= end || ranges[range].end <= begin)
+          {
+            range++;
+            continue;
+          }
+
+          resource.aliased = resource.needs_aliasing ? invalid_id : ranges[range].resource;
+          resource.needs_aliasing = true;
+          if (ranges[range].begin >= begin && ranges[range].end <= end)
+          {
+            ranges[range] = ranges.back();
+            ranges.pop_back();
+            continue;
+          }
+          range++;
+        }
+      }
+
+      for (uint32 i = last_use_begin[position]; i < last_use_begin[position + 1]; ++i)
+      {
+        const Resource& resource = resources[last_uses[i]];
+        uint32 usage = static_cast<uint32>(resource.desc.usage);
+        allocators[usage].free(resource.block);
+        freed[usage].push_back(FreedRange { last_uses[i], resource.offset, resource.offset + resource.desc.size });
+      }
+    }
+  }
+
+  void RenderGraph::computeBarriers()
+  {
+    // Resource indices stand in for the physical resources, execute translates them.
+    tracker.resetStats();
+    for (uint32 index = 0; index < resources.size(); ++index)
+    {
+      Resource& resource = resources[index];
+      if (resource.first == invalid_id)
+      {
+        continue;
+      }
+
+      if (!resource.imported)
+      {
+        const Pass& pass = passes[schedule[resource.first]];
+        for (uint32 i = pass.first_access; i < pass.first_access + pass.access_count; ++i)
+        {
+          if (accesses[i].resource == index)
+          {
+            resource.initial_state = accesses[i].state;
+            resource.final_state = accesses[i].state;
+            break;
+          }
+        }
+      }
+      tracker.registerResource(index, resource.initial_state);
+    }
+
+    barriers.clear();
+    for (uint32 position = 0; position < schedule.size(); ++position)
+    {
+      Pass& pass = passes[schedule[position]];
+      pass.barrier_begin = static_cast<uint32>(barriers.size());
+
+      for (uint32 i = first_use_begin[position]; i < first_use_begin[position + 1]; ++i)
+      {
+        const Resource& resource = resources[first_uses[i]];
+        if (resource.needs_aliasing)
+        {
+          barriers.push_back(ResourceBarrier::aliasing(resource.aliased, first_uses[i]));
+          stats.aliasing_barriers++;
+        }
+      }
+
+      // Resources the previous pass used start moving to the state of their next use. Both ends of
+      // a split barrier stay on the graphics queue.
+      if (position > 0 && pass.queue == CommandListType::Direct && passes[schedule[position - 1]].queue == CommandListType::Direct)
+      {
+        const Pass& previous = passes[schedule[position - 1]];
+        for (uint32 i = previous.first_access; i < previous.first_access + previous.access_count; ++i)
+        {
+          const Access& access = accesses[i];
+          if (access.next == invalid_id)
+          {
+            tracker.prepare(access.resource, resources[access.resource].final_state);
+            continue;
+          }
+
+          const Pass& next = passes[accesses[access.next].pass];
+          if (next.position > position && next.queue == CommandListType::Direct)
+          {
+            tracker.prepare(access.resource, accesses[access.next].state);
+          }
+        }
+      }
+
+      for (uint32 i = pass.first_access; i < pass.first_access + pass.access_count; ++i)
+      {
+        tracker.require(accesses[i].resource, accesses[i].state);
+      }
+      tracker.flush(barriers);
+      pass.barrier_count = static_cast<uint32>(barriers.size()) - pass.barrier_begin;
+
+      pass.hoisted = false;
+      for (uint32 i = pass.barrier_begin; i < pass.barrier_begin + pass.barrier_count && !pass.hoisted; ++i)
+      {
+        pass.hoisted = !isAllowed(pass.queue, barriers[i]);
+      }
+    }
+
+    final_barrier_begin = static_cast<uint32>(barriers.size());
+    for (uint32 index = 0; index < resources.size(); ++index)
+    {
+      if (resources[index].first != invalid_id)
+      {
+        tracker.require(index, resources[index].final_state);
+      }
+    }
+    tracker.flush(barriers);
+    final_barrier_count = static_cast<uint32>(barriers.size()) - final_barrier_begin;
+
+    stats.barriers = static_cast<uint32>(barriers.size());
+    stats.split_barriers = static_cast<uint32>(tracker.getStats().split_barriers);
+  }
+
+  void RenderGraph::buildBatches()
+  {
+    // Units in schedule order, each waits for what it needs from the other queues.
+    units.clear();
+    waits.clear();
+    last_use.assign(resources.size(), invalid_id);
+    std::fill(&queue_clocks[0][0], &queue_clocks[0][0] + queue_count * queue_count, 0u);
+
+    for (uint32 index : schedule)
+    {
+      Pass& pass = passes[index];
+      uint32 needed[queue_count];
+      if (pass.hoisted)
+      {
+        // The graphics queue transitions what the pass uses, then the pass waits for it.
+        uint32 unit = addUnit(invalid_id, CommandListType::Direct, pass.barrier_begin, pass.barrier_count);
+        std::fill(std::begin(needed), std::end(needed), invalid_id);
+        for (uint32 i = pass.first_access; i < pass.first_access + pass.access_count; ++i)
+        {
+          addDependency(unit, accesses[i].resource, needed);
+        }
+        resolveWaits(unit, needed);
+      }
+
+      pass.unit = addUnit(index, pass.queue, pass.hoisted ? 0 : pass.barrier_begin, pass.hoisted ? 0 : pass.barrier_count);
+      std::fill(std::begin(needed), std::end(needed), invalid_id);
+      for (uint32 i = pass.first_access; i < pass.first_access + pass.access_count; ++i)
+      {
+        addDependency(pass.unit, accesses[i].resource, needed);
+      }
+      resolveWaits(pass.unit, needed);
+    }
+
+    // The graphics queue ends the graph after every other queue is done.
+    uint32 final_unit = addUnit(invalid_id, CommandListType::Direct, final_barrier_begin, final_barrier_count);
+    uint32 needed[queue_count];
+    std::fill(std::begin(needed), std::end(needed), invalid_id);
+    for (uint32 index = 0; index < resources.size(); ++index)
+    {
+      if (resources[index].first != invalid_id)
+      {
+        addDependency(final_unit, index, needed);
+      }
+    }
+    for (uint32 queue = 1; queue < queue_count; ++queue)
+    {
+      // queue_clocks hold one past the last unit of every queue.
+      uint32 last = queue_clocks[queue][queue];
+      if (last > 0 && (needed[queue] == invalid_id || needed[queue] < last - 1))
+      {
+        needed[queue] = last - 1;
+      }
+    }
+    resolveWaits(final_unit, needed);
+
+    // A queue's units form a batch until one has to wait or another queue waits for one. Batches are
+    // submitted in the order they close, every signal is submitted before its waits.
+    opened_batches.clear();
+    uint32 open[queue_count];
+    std::fill(std::begin(open), std::end(open), invalid_id);
+    stack.clear();
+    for (uint32 index = 0; index < units.size(); ++index)
+    {
+      Unit& unit = units[index];
+      uint32 queue = getQueueIndex(unit.queue);
+      if (open[queue] != invalid_id && unit.wait_count > 0)
+      {
+        stack.push_back(open[queue]);
+        open[queue] = invalid_id;
+      }
+      if (open[queue] == invalid_id)
+      {
+        open[queue] = static_cast<uint32>(opened_batches.size());
+        opened_batches.push_back(Batch { unit.queue, 0, 0, unit.wait_begin, unit.wait_count, 0, false });
+      }
+
+      Batch& batch = opened_batches[open[queue]];
+      unit.batch = open[queue];
+      batch.unit_count++;
+      batch.pass_count += unit.pass != invalid_id;
+      if (unit.signal)
+      {
+        batch.signal = true;
+        stack.push_back(open[queue]);
+        open[queue] = invalid_id;
+      }
+    }
+    // Only the graphics batch with the final unit is left, the join closed the others.
+    for (uint32 queue = 0; queue < queue_count; ++queue)
+    {
+      if (open[queue] != invalid_id)
+      {
+        stack.push_back(open[queue]);
+      }
+    }
+
+    // Renumbers batches in submission order and lists their units.
+    ready.assign(opened_batches.size(), 0);
+    batches.clear();
+    for (uint32 order = 0; order < stack.size(); ++order)
+    {
+      ready[stack[order]] = order;
+      batches.push_back(opened_batches[stack[order]]);
+    }
+    uint32 unit_total = 0;
+    for (Batch& batch : batches)
+    {
+      batch.unit_begin = unit_total;
+      unit_total += batch.unit_count;
+      batch.unit_count = 0;
+    }
+    batch_units.resize(units.size());
+    for (uint32 index = 0; index < units.size(); ++index)
+    {
+      Unit& unit = units[index];
+      unit.batch = ready[unit.batch];
+      Batch& batch = batches[unit.batch];
+      batch_units[batch.unit_begin + batch.unit_count++] = index;
+    }
+
+    stats.batches = static_cast<uint32>(batches.size());
+  }
+
+  uint32 RenderGraph::addUnit(uint32 pass, CommandListType queue, uint32 barrier_begin, uint32 barrier_count)
+  {
+    units.push_back(Unit { pass, queue, barrier_begin, barrier_count, 0, 0, false, invalid_id, {} });
+    return static_cast<uint32>(units.size() - 1);
+  }
+
+  void RenderGraph::addDependency(uint32 unit, uint32 resource, uint32 (&needed)[queue_count])
+  {
+    // Every use of a resource waits for the previous one, on the same queue submission order does.
+    uint32 previous = last_use[resource];
+    last_use[resource] = unit;
+    if (previous == invalid_id || previous == unit || units[previous].queue == units[unit].queue)
+    {
+      return;
+    }
+
+    uint32 queue = getQueueIndex(units[previous].queue);
+    if (needed[queue] == invalid_id || needed[queue] < previous)
+    {
+      needed[queue] = previous;
+    }
+  }
+
+  void RenderGraph::resolveWaits(uint32 unit, uint32 (&needed)[queue_count])
+  {
+    uint32 queue = getQueueIndex(units[unit].queue);
+    uint32* clock = queue_clocks[queue];
+
+    // The latest unit first, waiting for it may cover the other queue already. Inserted in order,
+    // there are at most queue_count entries.
+    uint32 order[queue_count];
+    uint32 count = 0;
+    for (uint32 other = 0; other < queue_count; ++other)
+    {
+      if (needed[other] != invalid_id)
+      {
+        stats.cross_queue_dependencies++;
+        uint32 position = count++;
+        for (; position > 0 && order[position - 1] < needed[other]; --position)
+        {
+          order[position] = order[position - 1];
+        }
+        order[position] = needed[other];
+      }
+    }
+
+    units[unit].wait_begin = static_cast<uint32>(waits.size());
+    for (uint32 i = 0; i < count; ++i)
+    {
+      Unit& signaled = units[order[i]];
+      if (clock[getQueueIndex(signaled.queue)] > order[i])
+      {
+        continue;
+      }
+
+      waits.push_back(order[i]);
+      signaled.signal = true;
+      for (uint32 other = 0; other < queue_count; ++other)
+      {
+        clock[other] = std::max(clock[other], signaled.clock[other]);
+      }
+    }
+    units[unit].wait_count = static_cast<uint32>(waits.size()) - units[unit].wait_begin;
+    stats.sync_points += units[unit].wait_count;
+
+    clock[queue] = unit + 1;
+    std::copy(clock, clock + queue_count, units[unit].clock);
+  }
+
+  void RenderGraph::recordUnit(CommandList& command_list, const Unit& unit)
+  {
+    submitBarriers(command_list, unit.barrier_begin, unit.barrier_count);
+    if (unit.pass != invalid_id && passes[unit.pass].execute)
+    {
+      passes[unit.pass].execute(command_list, *this);
+    }
+  }
+
+  bool RenderGraph::isAllowed(CommandListType queue, const ResourceBarrier& barrier)
+  {
+    constexpr ResourceState compute_states = ResourceState::VertexAndConstantBuffer | ResourceState::UnorderedAccess | ResourceState::NonPixelShaderResource |
+      ResourceState::IndirectArgument | ResourceState::CopyDest | ResourceState::CopySource;
+    constexpr ResourceState copy_states = ResourceState::CopyDest | ResourceState::CopySource;
+
+    if (queue == CommandListType::Direct)
+    {
+      return true;
+    }
+    if (barrier.type != BarrierType::Transition)
+    {
+      return queue == CommandListType::Compute;
+    }
+
+    uint32 allowed = static_cast<uint32>(queue == CommandListType::Compute ? compute_states : copy_states);
+    return ((static_cast<uint32>(barrier.state_before) | static_cast<uint32>(barrier.state_after)) & ~allowed) == 0;
+  }
+
+  void RenderGraph::submitBarriers(CommandList& command_list, uint32 begin, uint32 count)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    submitted.assign(barriers.begin() + begin, barriers.begin() + begin + count);
+    for (ResourceBarrier& barrier : submitted)
+    {
+      barrier.resource = barrier.resource != invalid_id ? resources[barrier.resource].physical : invalid_id;
+      if (barrier.type == BarrierType::Aliasing)
+      {
+        barrier.resource_after = resources[barrier.resource_after].physical;
+      }
+    }
+    command_list.resourceBarrier(submitted.data(), count);
+  }
+}
\ No newline at end of file
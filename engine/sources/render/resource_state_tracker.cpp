@@ -0,0 +1,293 @@
+#include <render/resource_state_tracker.h>
+
+#include <cassert>
+
+namespace engine
+{
+  namespace
+  {
+    constexpr ResourceState read_only_states = ResourceState::VertexAndConstantBuffer | ResourceState::IndexBuffer | ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource |
+      ResourceState::IndirectArgument | ResourceState::CopySource | ResourceState::DepthRead;
+  }
+
+  void ResourceStateTracker::registerResource(ResourceId resource, ResourceState state, uint32 subresource_count)
+  {
+    assert(subresource_count > 0);
+
+    Resource& entry = resources[resource];
+    entry = Resource {};
+    entry.state = state;
+    entry.subresource_count = subresource_count;
+  }
+
+  void ResourceStateTracker::unregisterResource(ResourceId resource)
+  {
+    auto entry = resources.find(resource);
+    if (entry == resources.end())
+    {
+      return;
+    }
+
+    // Barriers queued in this batch would reference a resource that may be gone by the flush, a split
+    // begun in this batch included.
+    for (uint32 i = static_cast<uint32>(pending_barriers.size()); i-- > 0;)
+    {
+      if (pending_barriers[i].resource == resource)
+      {
+        removeBarrier(i);
+      }
+    }
+
+    // A split begun in an earlier batch was already submitted, its BeginOnly needs the EndOnly.
+    const Resource& removed = entry->second;
+    if (removed.is_splitting && removed.split_batch != batch)
+    {
+      emit(ResourceBarrier::transition(resource, removed.state, removed.split_state, all_subresources, BarrierFlags::EndOnly));
+      stats.split_barriers++;
+    }
+    resources.erase(entry);
+  }
+
+  ResourceState ResourceStateTracker::getState(ResourceId resource, uint32 subresource) const
+  {
+    const Resource& entry = resources.at(resource);
+    return entry.subresource_states.empty() ? entry.state : entry.subresource_states[subresource];
+  }
+
+  void ResourceStateTracker::require(ResourceId id, ResourceState state, uint32 subresource)
+  {
+    stats.requests++;
+    Resource& resource = getResource(id);
+    if (resource.is_splitting)
+    {
+      endSplit(id, resource);
+    }
+
+    if (subresource == all_subresources && resource.subresource_states.empty())
+    {
+      requireWhole(id, resource, state);
+      return;
+    }
+
+    if (subresource != all_subresources)
+    {
+      requireSubresource(id, resource, state, subresource);
+      return;
+    }
+
+    // Subresources went separate ways, each one that differs gets its own barrier.
+    for (uint32 i = 0; i < resource.subresource_count; ++i)
+    {
+      if (meets(resource.subresource_states[i], state))
+      {
+        stats.elided++;
+        continue;
+      }
+      emit(ResourceBarrier::transition(id, resource.subresource_states[i], state, i));
+    }
+    resource.subresource_states.clear();
+    resource.state = state;
+  }
+
+  void ResourceStateTracker::prepare(ResourceId id, ResourceState state)
+  {
+    Resource& resource = getResource(id);
+    assert(resource.subresource_states.empty() && "Split barriers cover whole resources.");
+
+    // Nothing to overlap when it already changed state in this batch.
+    if (resource.is_splitting || meets(resource.state, state) || resource.barrier_batch == batch)
+    {
+      return;
+    }
+
+    resource.is_splitting = true;
+    resource.split_state = state;
+    resource.split_barrier = static_cast<uint32>(pending_barriers.size());
+    resource.split_batch = batch;
+    emit(ResourceBarrier::transition(id, resource.state, state, all_subresources, BarrierFlags::BeginOnly));
+    stats.split_barriers++;
+  }
+
+  uint32 ResourceStateTracker::flush(CommandList& command_list)
+  {
+    uint32 count = static_cast<uint32>(pending_barriers.size());
+    if (count > 0)
+    {
+      command_list.resourceBarrier(pending_barriers.data(), count);
+      stats.flushes++;
+    }
+
+    pending_barriers.clear();
+    batch++;
+    return count;
+  }
+
+  uint32 ResourceStateTracker::flush(std::vector<ResourceBarrier>& barriers)
+  {
+    uint32 count = static_cast<uint32>(pending_barriers.size());
+    if (count > 0)
+    {
+      barriers.insert(barriers.end(), pending_barriers.begin(), pending_barriers.end());
+      stats.flushes++;
+    }
+
+    pending_barriers.clear();
+    batch++;
+    return count;
+  }
+
+  bool ResourceStateTracker::isReadOnly(ResourceState state)
+  {
+    return state != ResourceState::Common && (static_cast<uint32>(state) & ~static_cast<uint32>(read_only_states)) == 0;
+  }
+
+  bool ResourceStateTracker::meets(ResourceState current, ResourceState required)
+  {
+    // A combined read state satisfies each of its reads.
+    return current == required || (isReadOnly(current) && isReadOnly(required) && (current & required) == required);
+  }
+
+  ResourceStateTracker::Resource& ResourceStateTracker::getResource(ResourceId resource)
+  {
+    auto entry = resources.find(resource);
+    assert(entry != resources.end() && "Resource state is not tracked.");
+    return entry->second;
+  }
+
+  void ResourceStateTracker::endSplit(ResourceId id, Resource& resource)
+  {
+    resource.is_splitting = false;
+    if (resource.split_batch == batch)
+    {
+      // Nothing ran between begin and end, a plain barrier does the same.
+      pending_barriers[resource.split_barrier].flags = BarrierFlags::None;
+      resource.barrier = resource.split_barrier;
+      resource.barrier_batch = batch;
+    }
+    else
+    {
+      emit(ResourceBarrier::transition(id, resource.state, resource.split_state, all_subresources, BarrierFlags::EndOnly));
+      stats.split_barriers++;
+    }
+    resource.state = resource.split_state;
+  }
+
+  void ResourceStateTracker::requireWhole(ResourceId id, Resource& resource, ResourceState state)
+  {
+    bool queued = resource.barrier_batch == batch && resource.barrier != no_barrier;
+    if (resource.state == ResourceState::UnorderedAccess && state == ResourceState::UnorderedAccess)
+    {
+      // Writes of the previous pass have to finish first, unless a barrier in this batch already waits.
+      if (!queued)
+      {
+        emit(ResourceBarrier::unorderedAccess(id));
+        resource.barrier = static_cast<uint32>(pending_barriers.size() - 1);
+        resource.barrier_batch = batch;
+      }
+      else
+      {
+        stats.elided++;
+      }
+      return;
+    }
+
+    if (meets(resource.state, state))
+    {
+      stats.elided++;
+      return;
+    }
+
+    if (queued && pending_barriers[resource.barrier].type == BarrierType::Transition && pending_barriers[resource.barrier].flags == BarrierFlags::None)
+    {
+      // One barrier per batch, reads needed by the same pass combine.
+      ResourceBarrier& barrier = pending_barriers[resource.barrier];
+      ResourceState state_after = isReadOnly(barrier.state_after) && isReadOnly(state) ? barrier.state_after | state : state;
+      resource.state = state_after;
+      stats.elided++;
+      if (state_after == barrier.state_before)
+      {
+        removeBarrier(resource.barrier);
+        return;
+      }
+      barrier.state_after = state_after;
+      return;
+    }
+
+    emit(ResourceBarrier::transition(id, resource.state, state));
+    resource.barrier = static_cast<uint32>(pending_barriers.size() - 1);
+    resource.barrier_batch = batch;
+    resource.state = state;
+  }
+
+  void ResourceStateTracker::requireSubresource(ResourceId id, Resource& resource, ResourceState state, uint32 subresource)
+  {
+    assert(subresource < resource.subresource_count);
+
+    if (resource.subresource_states.empty())
+    {
+      if (meets(resource.state, state))
+      {
+        stats.elided++;
+        return;
+      }
+      resource.subresource_states.assign(resource.subresource_count, resource.state);
+      // A queued whole resource barrier can't be amended per subresource anymore.
+      resource.barrier = no_barrier;
+    }
+
+    ResourceState& current = resource.subresource_states[subresource];
+    if (meets(current, state))
+    {
+      stats.elided++;
+      return;
+    }
+
+    emit(ResourceBarrier::transition(id, current, state, subresource));
+    current = state;
+
+    for (ResourceState other : resource.subresource_states)
+    {
+      if (other != state)
+      {
+        return;
+      }
+    }
+    resource.subresource_states.clear();
+    resource.state = state;
+  }
+
+  void ResourceStateTracker::emit(const ResourceBarrier& barrier)
+  {
+    pending_barriers.push_back(barrier);
+    stats.barriers++;
+  }
+
+  void ResourceStateTracker::removeBarrier(uint32 index)
+  {
+    auto removed = resources.find(pending_barriers[index].resource);
+    if (removed != resources.end() && removed->second.barrier == index)
+    {
+      removed->second.barrier = no_barrier;
+    }
+
+    // Keeps the order, barriers of one subresource must stay in sequence. Removals are rare.
+    pending_barriers.erase(pending_barriers.begin() + index);
+    stats.barriers--;
+    for (uint32 i = index; i < pending_barriers.size(); ++i)
+    {
+      auto moved = resources.find(pending_barriers[i].resource);
+      if (moved == resources.end())
+      {
+        continue;
+      }
+      if (moved->second.barrier == i + 1)
+      {
+        moved->second.barrier = i;
+      }
+      if (moved->second.split_barrier == i + 1)
+      {
+        moved->second.split_barrier = i;
+      }
+    }
+  }
+}
\ No newline at end of file
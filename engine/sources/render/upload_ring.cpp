@@ -0,0 +1,117 @@
+#include <render/upload_ring.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+  namespace
+  {
+    // Zero is never used, it marks thread pages that were never filled.
+    std::atomic<uint64> next_frame_tag { 1 };
+  }
+
+  void UploadRing::initialize(const UploadMemory& memory)
+  {
+    assert(isPowerOfTwo(memory.size) && memory.size >= max_alignment);
+
+    this->memory = memory;
+    frame_tag = next_frame_tag.fetch_add(1, std::memory_order_relaxed);
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    failed_allocations.store(0, std::memory_order_relaxed);
+    frame_begin = 0;
+    first_pending = 0;
+    pending_count = 0;
+  }
+
+  UploadAllocation UploadRing::allocateSlow(uint64 size, uint64 alignment)
+  {
+    assert(isPowerOfTwo(alignment) && alignment <= max_alignment);
+
+    // Large allocations would waste most of a page, they get a reservation of their own.
+    uint64 padded_size = size + (alignment > constant_buffer_alignment ? alignment - constant_buffer_alignment : 0);
+    if (padded_size > page_size / 4)
+    {
+      uint64 start = reserve(alignUp(padded_size, constant_buffer_alignment));
+      return start != ~0ull ? makeAllocation(alignUp(start, alignment)) : UploadAllocation {};
+    }
+
+    uint64 start = reserve(page_size);
+    if (start == ~0ull)
+    {
+      return UploadAllocation {};
+    }
+
+    ThreadPage& page = thread_page;
+    page.tag = frame_tag;
+    page.cursor = alignUp(start, alignment) + size;
+    page.end = start + page_size;
+    return makeAllocation(alignUp(start, alignment));
+  }
+
+  uint64 UploadRing::reserve(uint64 size)
+  {
+    // The head stays a multiple of constant_buffer_alignment.
+    if (size > memory.size)
+    {
+      failed_allocations.fetch_add(1, std::memory_order_relaxed);
+      return ~0ull;
+    }
+
+    for (;;)
+    {
+      uint64 start = head.fetch_add(size, std::memory_order_relaxed);
+
+      // Space reserved by failed attempts and skipped at the end of the buffer retires with the frame.
+      if (start + size - tail.load(std::memory_order_acquire) > memory.size)
+      {
+        failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return ~0ull;
+      }
+
+      if ((start & (memory.size - 1)) + size <= memory.size)
+      {
+        return start;
+      }
+    }
+  }
+
+  void UploadRing::endFrame(uint64 fence_value)
+  {
+    // Pages reserved so far belong to this frame.
+    frame_tag = next_frame_tag.fetch_add(1, std::memory_order_relaxed);
+
+    uint64 current_head = head.load(std::memory_order_relaxed);
+    frame_begin = current_head;
+    if (pending_count == max_pending_frames)
+    {
+      // Retiring the newest frame implies the older one, merging only delays reuse.
+      pending_frames[(first_pending + pending_count - 1) % max_pending_frames] = { fence_value, current_head };
+      return;
+    }
+
+    pending_frames[(first_pending + pending_count) % max_pending_frames] = { fence_value, current_head };
+    pending_count++;
+  }
+
+  void UploadRing::read(uint64 begin, uint64 end, uint8* destination) const
+  {
+    assert(begin <= end && end - begin <= memory.size);
+
+    uint64 offset = begin & (memory.size - 1);
+    uint64 first_size = std::min(end - begin, memory.size - offset);
+    std::memcpy(destination, memory.cpu_address + offset, first_size);
+    std::memcpy(destination + first_size, memory.cpu_address, end - begin - first_size);
+  }
+
+  void UploadRing::retire(uint64 completed_fence_value)
+  {
+    while (pending_count > 0 && pending_frames[first_pending].fence_value <= completed_fence_value)
+    {
+      tail.store(pending_frames[first_pending].head, std::memory_order_release);
+      first_pending = (first_pending + 1) % max_pending_frames;
+      pending_count--;
+    }
+  }
+}
\ No newline at end of file
@@ -34,6 +34,20 @@ namespace engine
     this->height = height;
   }
 
+  void Window::requestClientSize(uint32 width, uint32 height)
+  {
+    if (fullscreen)
+    {
+      return;
+    }
+
+    RECT client_rect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+    ::AdjustWindowRect(&client_rect, WS_OVERLAPPEDWINDOW, FALSE);
+    // Async so a thread other than the window's never waits for the message loop.
+    ::SetWindowPos(hwnd, nullptr, 0, 0, client_rect.right - client_rect.left, client_rect.bottom - client_rect.top,
+      SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_ASYNCWINDOWPOS);
+  }
+
   void Window::setFullscreen(bool fullscreen)
   {
     if (this->fullscreen != fullscreen)
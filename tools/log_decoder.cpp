@@ -0,0 +1,65 @@
+#include <common/binary_log.h>
+
+#include <cstdio>
+#include <string>
+
+using namespace engine;
+
+// Turns a binary log written by Log::setBinaryOutput back into text, one line per message:
+// seconds since the log was opened, the level letter and the formatted message.
+int main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 3)
+  {
+    fprintf(stderr, "usage: log_decoder <binary log> [output text file]\n");
+    return 2;
+  }
+
+  BinaryLogReader reader;
+  if (!reader.open(argv[1]))
+  {
+    fprintf(stderr, "log_decoder: %s\n", reader.getError().c_str());
+    return 1;
+  }
+
+  FILE* output = argc == 3 ? fopen(argv[2], "w") : stdout;
+  if (!output)
+  {
+    fprintf(stderr, "log_decoder: can't create %s\n", argv[2]);
+    return 1;
+  }
+
+  const char level_letters[] = { 'I', 'W', 'E' };
+  BinaryLogReader::Message message;
+  std::string line;
+  uint64 count = 0;
+
+  while (reader.next(message))
+  {
+    uint32 level = static_cast<uint32>(message.level);
+    double seconds = message.timestamp >= reader.getStartTimestamp() ? (message.timestamp - reader.getStartTimestamp()) * 1e-9 : 0.0;
+
+    line.clear();
+    formatLogArguments(message.format, message.arguments, message.size, message.truncated, line);
+    // Messages usually end in a newline already, the prefix goes in front of every message.
+    fprintf(output, "[%12.6f] %c %s", seconds, level < 3 ? level_letters[level] : '?', line.c_str());
+    if (line.empty() || line.back() != '\n')
+    {
+      fputc('\n', output);
+    }
+    count++;
+  }
+
+  if (output != stdout)
+  {
+    fclose(output);
+  }
+
+  if (!reader.getError().empty())
+  {
+    fprintf(stderr, "log_decoder: stopped after %llu messages, %s\n", count, reader.getError().c_str());
+    return 1;
+  }
+
+  return 0;
+}
\ No newline at end of file